@@ -0,0 +1,335 @@
+﻿#include "stdafx.h"
+#include "AssetCooker.h"
+//=============================================================================
+namespace
+{
+	constexpr std::string_view DatabaseFileName = "AssetCooker.db";
+	constexpr size_t NumSlowestAssets = 10;
+	//-------------------------------------------------------------------------
+	std::string formatMs(double timeMs)
+	{
+		char buffer[32];
+		auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), timeMs, std::chars_format::fixed, 1);
+		return std::string(buffer, end) + " ms";
+	}
+	//-------------------------------------------------------------------------
+	std::string padLeft(std::string_view str, size_t width)
+	{
+		return std::string(str.size() < width ? width - str.size() : 0, ' ') + std::string(str);
+	}
+	//-------------------------------------------------------------------------
+	std::string padRight(std::string_view str, size_t width)
+	{
+		return std::string(str) + std::string(str.size() < width ? width - str.size() : 0, ' ');
+	}
+	//-------------------------------------------------------------------------
+	std::string toLower(std::string str)
+	{
+		std::transform(str.begin(), str.end(), str.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return str;
+	}
+	//-------------------------------------------------------------------------
+	std::optional<AssetType> classify(const std::string& relativePath)
+	{
+		const std::string extension = toLower(std::filesystem::path(relativePath).extension().string());
+		const std::string topDirectory = relativePath.substr(0, relativePath.find('/'));
+
+		if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp")
+			return AssetType::Texture;
+		// блоки тайлов Game3 грузятся через AddObjModel, а не как модели
+		if (extension == ".obj" && topDirectory == "tiles")
+			return AssetType::Tile;
+		if (extension == ".obj" || extension == ".gltf" || extension == ".glb" || extension == ".fbx" || extension == ".dae" || extension == ".3ds")
+			return AssetType::Model;
+		return std::nullopt;
+	}
+	//-------------------------------------------------------------------------
+	std::string_view getCookedExtension(AssetType type)
+	{
+		switch (type)
+		{
+		case AssetType::Model:   return cooked::ModelExtension;
+		case AssetType::Texture: return cooked::TextureExtension;
+		case AssetType::Tile:    return cooked::TileExtension;
+		default: std::unreachable();
+		}
+	}
+} // namespace
+//=============================================================================
+std::string_view GetAssetTypeName(AssetType type) noexcept
+{
+	switch (type)
+	{
+	case AssetType::Model:   return "model";
+	case AssetType::Texture: return "texture";
+	case AssetType::Tile:    return "tile";
+	default: std::unreachable();
+	}
+}
+//=============================================================================
+std::string_view GetTextureUsageName(TextureUsage usage) noexcept
+{
+	switch (usage)
+	{
+	case TextureUsage::Color:  return "color";
+	case TextureUsage::Normal: return "normal";
+	case TextureUsage::Data:   return "data";
+	case TextureUsage::Lookup: return "lookup";
+	default: std::unreachable();
+	}
+}
+//=============================================================================
+std::optional<TextureUsage> GetTextureUsageByName(std::string_view name) noexcept
+{
+	for (TextureUsage usage : { TextureUsage::Color, TextureUsage::Normal, TextureUsage::Data, TextureUsage::Lookup })
+	{
+		if (GetTextureUsageName(usage) == name)
+			return usage;
+	}
+	return std::nullopt;
+}
+//=============================================================================
+std::string_view GetCookSettings(AssetType type) noexcept
+{
+	// те же строки проверяет cooked::IsUpToDate при загрузке
+	switch (type)
+	{
+	case AssetType::Model:   return cooked::ModelSettings;
+	case AssetType::Texture: return cooked::TextureSettings;
+	case AssetType::Tile:    return cooked::TileSettings;
+	default: std::unreachable();
+	}
+}
+//=============================================================================
+void AddCookDependencies(const std::string& fileName, const std::vector<std::string>& dependencies, CookedSource& source)
+{
+	for (const auto& file : dependencies)
+	{
+		CookedDependency dependency = cooked::MakeDependency(file, fileName);
+		if (std::none_of(source.dependencies.begin(), source.dependencies.end(), [&](const CookedDependency& d) { return d.path == dependency.path; }))
+			source.dependencies.push_back(std::move(dependency));
+	}
+}
+//=============================================================================
+bool AssetCooker::Run(const AssetCookerInfo& info)
+{
+	m_info = info;
+	m_assets.clear();
+	m_numFinished = 0;
+
+	std::error_code ec;
+	if (!std::filesystem::is_directory(m_info.dataDirectory, ec))
+	{
+		Error("Data directory not found: " + m_info.dataDirectory.string());
+		return false;
+	}
+
+	const std::filesystem::path databasePath = m_info.dataDirectory / DatabaseFileName;
+	if (!m_info.force)
+		m_database.Load(databasePath);
+
+	scan();
+	m_textureUses.clear();
+
+	unsigned numThreads = m_info.numThreads ? m_info.numThreads : std::max(1u, std::thread::hardware_concurrency());
+	numThreads = static_cast<unsigned>(std::clamp<size_t>(m_assets.size(), 1, numThreads));
+	Info("Cooking " + std::to_string(m_assets.size()) + " assets from " + m_info.dataDirectory.string() + " on " + std::to_string(numThreads) + " threads");
+
+	const auto startTime = std::chrono::steady_clock::now();
+
+	// текстуры после моделей - к ним уже известно, как их используют материалы
+	const size_t firstTexture = static_cast<size_t>(std::find_if(m_assets.begin(), m_assets.end(), [](const Asset& asset) { return asset.type == AssetType::Texture; }) - m_assets.begin());
+	cookAssets(0, firstTexture, numThreads);
+	cookAssets(firstTexture, m_assets.size(), numThreads);
+
+	const double totalTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+	std::set<std::string> assetPaths;
+	for (const auto& asset : m_assets)
+		assetPaths.insert(asset.path);
+	m_database.RemoveMissing(assetPaths);
+	m_database.Save(databasePath);
+
+	printReport(totalTimeMs);
+
+	return std::none_of(m_assets.begin(), m_assets.end(), [](const Asset& asset) { return asset.status == AssetStatus::Failed; });
+}
+//=============================================================================
+void AssetCooker::scan()
+{
+	std::error_code ec;
+	for (auto it = std::filesystem::recursive_directory_iterator(m_info.dataDirectory, ec); !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+	{
+		if (!it->is_regular_file(ec)) continue;
+
+		const std::string relativePath = it->path().lexically_relative(m_info.dataDirectory).generic_string();
+		if (auto type = classify(relativePath); type)
+			m_assets.push_back({ .path = relativePath, .type = *type });
+	}
+
+	// большие файлы первыми - меньше шанс, что в конце один поток долго печет последний тяжелый ассет
+	std::vector<std::pair<uintmax_t, size_t>> sizes(m_assets.size());
+	for (size_t i = 0; i < m_assets.size(); i++)
+		sizes[i] = { std::filesystem::file_size(m_info.dataDirectory / m_assets[i].path, ec), i };
+	std::sort(sizes.begin(), sizes.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+	std::vector<Asset> assets;
+	assets.reserve(m_assets.size());
+	for (const auto& it : sizes)
+		assets.push_back(std::move(m_assets[it.second]));
+	std::stable_partition(assets.begin(), assets.end(), [](const Asset& asset) { return asset.type != AssetType::Texture; });
+	m_assets = std::move(assets);
+}
+//=============================================================================
+void AssetCooker::cookAssets(size_t first, size_t last, unsigned numThreads)
+{
+	std::atomic<size_t> next{ first };
+	std::vector<std::thread> threads;
+	threads.reserve(numThreads);
+	for (unsigned t = 0; t < numThreads; t++)
+	{
+		threads.emplace_back([&]()
+			{
+				// ассеты уже пекутся на всех ядрах - циклы внутри кукеров (мипы, сжатие, obj) идут последовательно
+				MarkWorkerThread();
+				for (size_t i = next++; i < last; i = next++)
+					cookAsset(m_assets[i]);
+			});
+	}
+	for (auto& thread : threads)
+		thread.join();
+}
+//=============================================================================
+void AssetCooker::cookAsset(Asset& asset)
+{
+	const std::string fileName = (m_info.dataDirectory / asset.path).generic_string();
+	const uint64_t settingsHash = cooked::HashString(GetCookSettings(asset.type));
+
+	// назначение текстуры - тоже настройка запекания: сменилось - текстура перепекается. В заголовок запеченного файла
+	// идет только хеш настроек типа, его проверяет cooked::IsUpToDate при загрузке
+	const std::optional<TextureCookRequest> textureRequest = (asset.type == AssetType::Texture) ? getTextureRequest(asset.path) : std::nullopt;
+	const uint64_t recordHash = textureRequest ? cooked::HashString(GetTextureUsageName(textureRequest->usage), settingsHash) : settingsHash;
+
+	if (!m_info.force && m_database.IsUpToDate(m_info.dataDirectory, asset.path, recordHash))
+	{
+		addTextureUses(m_database.GetTextures(asset.path));
+		asset.status = AssetStatus::UpToDate;
+		m_numFinished++;
+		return;
+	}
+
+	// хеш исходника до запекания - если файл поменяют во время работы, в следующий раз он перепечется
+	CookedSource source{ .settingsHash = settingsHash, .dependencies = {} };
+	source.dependencies.push_back(cooked::MakeDependency(fileName, fileName));
+	const std::string_view cookedExtension = getCookedExtension(asset.type);
+	const std::string outputFileName = cooked::GetCookedPath(fileName, cookedExtension);
+
+	const auto startTime = std::chrono::steady_clock::now();
+	CookResult result;
+	switch (asset.type)
+	{
+	case AssetType::Model:   result = CookModel(fileName, outputFileName, source); break;
+	case AssetType::Texture: result = CookTexture(fileName, outputFileName, textureRequest, source); break;
+	case AssetType::Tile:    result = CookTile(fileName, outputFileName, source); break;
+	default: std::unreachable();
+	}
+	asset.timeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	asset.status = result.success ? AssetStatus::Cooked : AssetStatus::Failed;
+
+	const size_t numFinished = ++m_numFinished;
+	Print("[" + std::to_string(numFinished) + "/" + std::to_string(m_assets.size()) + "] " + padLeft(formatMs(asset.timeMs), 12) + "  "
+		+ padRight(GetAssetTypeName(asset.type), 8) + asset.path + (result.success ? "" : "  FAILED"));
+
+	if (!result.success)
+	{
+		m_database.RemoveRecord(asset.path);
+		return;
+	}
+
+	CookRecord record{
+		.settingsHash = recordHash,
+		.output = asset.path + std::string(cookedExtension),
+		.dependencies = {},
+		.textures = {}
+	};
+	// те же хеши, что записаны в заголовок запеченного файла, пути - от каталога данных
+	const std::filesystem::path sourceDirectory = std::filesystem::path(fileName).parent_path();
+	for (const auto& dependency : source.dependencies)
+	{
+		const std::string path = getDataPath(sourceDirectory / dependency.path);
+		if (path.empty()) continue; // вне каталога данных не отслеживается
+		record.dependencies.push_back({ .path = path, .hash = dependency.hash });
+	}
+	for (const auto& texture : result.textures)
+	{
+		if (std::string path = getDataPath(texture.path); !path.empty())
+			record.textures.push_back({ .path = std::move(path), .usage = texture.usage });
+	}
+	addTextureUses(record.textures);
+	m_database.SetRecord(asset.path, std::move(record));
+}
+//=============================================================================
+void AssetCooker::addTextureUses(const std::vector<CookTextureUse>& textures)
+{
+	std::lock_guard lock(m_texturesMutex);
+	for (const auto& texture : textures)
+	{
+		auto [it, inserted] = m_textureUses.try_emplace(texture.path, texture.usage);
+		if (inserted || it->second == texture.usage) continue;
+
+		// от порядка моделей результат не зависит: цвет важнее данных, нормали - данных
+		Warning("Texture " + texture.path + " is used as " + std::string(GetTextureUsageName(it->second)) + " and " + std::string(GetTextureUsageName(texture.usage)) + " by materials");
+		it->second = std::min(it->second, texture.usage);
+	}
+}
+//=============================================================================
+std::optional<TextureCookRequest> AssetCooker::getTextureRequest(const std::string& asset) const
+{
+	std::lock_guard lock(m_texturesMutex);
+	auto it = m_textureUses.find(asset);
+	if (it == m_textureUses.end())
+		return std::nullopt;
+	return TextureCookRequest{ .usage = it->second, .colorSpace = (it->second == TextureUsage::Color) ? ColorSpace::sRGB : ColorSpace::Linear };
+}
+//=============================================================================
+std::string AssetCooker::getDataPath(const std::filesystem::path& fileName) const
+{
+	const std::string path = fileName.lexically_normal().lexically_relative(m_info.dataDirectory.lexically_normal()).generic_string();
+	return path.starts_with("..") ? std::string() : path;
+}
+//=============================================================================
+void AssetCooker::printReport(double totalTimeMs) const
+{
+	size_t numUpToDate = 0, numCooked = 0, numFailed = 0;
+	double cookTimeMs = 0.0;
+	std::vector<const Asset*> cookedAssets;
+	for (const auto& asset : m_assets)
+	{
+		switch (asset.status)
+		{
+		case AssetStatus::UpToDate: numUpToDate++; break;
+		case AssetStatus::Cooked:   numCooked++; cookTimeMs += asset.timeMs; cookedAssets.push_back(&asset); break;
+		case AssetStatus::Failed:   numFailed++; break;
+		default: break;
+		}
+	}
+
+	if (!cookedAssets.empty())
+	{
+		std::sort(cookedAssets.begin(), cookedAssets.end(), [](const Asset* a, const Asset* b) { return a->timeMs > b->timeMs; });
+		Print("Slowest assets:");
+		for (size_t i = 0; i < std::min(NumSlowestAssets, cookedAssets.size()); i++)
+			Print("  " + padLeft(formatMs(cookedAssets[i]->timeMs), 12) + "  " + padRight(GetAssetTypeName(cookedAssets[i]->type), 8) + cookedAssets[i]->path);
+	}
+
+	// сумма времен больше общего - ассеты пеклись параллельно
+	Info("Cooked: " + std::to_string(numCooked) + ", up to date: " + std::to_string(numUpToDate) + ", failed: " + std::to_string(numFailed)
+		+ ". Time: " + formatMs(totalTimeMs) + " (sum of assets " + formatMs(cookTimeMs) + ")");
+
+	for (const auto& asset : m_assets)
+	{
+		if (asset.status == AssetStatus::Failed)
+			Error("Failed to cook " + asset.path);
+	}
+}
+//=============================================================================
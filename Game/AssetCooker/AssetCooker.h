@@ -0,0 +1,54 @@
+﻿#pragma once
+
+#include "CookDatabase.h"
+#include "Cookers.h"
+
+struct AssetCookerInfo final
+{
+	std::filesystem::path dataDirectory{ "data" };
+	unsigned              numThreads{ 0 }; // 0 - по числу ядер
+	bool                  force{ false };  // перепечь все, не глядя в базу
+};
+
+// Обходит каталог данных и запекает ассеты рядом с исходниками (см. NanoCookedAssets.h). Перепекаются только изменившиеся
+class AssetCooker final
+{
+public:
+	// false если хоть один ассет не запекся
+	bool Run(const AssetCookerInfo& info);
+
+private:
+	enum class AssetStatus : uint8_t
+	{
+		Pending,
+		UpToDate,
+		Cooked,
+		Failed
+	};
+
+	struct Asset final
+	{
+		std::string path; // относительно каталога данных, через '/'
+		AssetType   type;
+		AssetStatus status{ AssetStatus::Pending };
+		double      timeMs{ 0.0 };
+	};
+
+	void scan();
+	void cookAssets(size_t first, size_t last, unsigned numThreads);
+	void cookAsset(Asset& asset);
+	// назначение текстур из материалов моделей - запрос на запекание текстуры
+	void addTextureUses(const std::vector<CookTextureUse>& textures);
+	std::optional<TextureCookRequest> getTextureRequest(const std::string& asset) const;
+	// пусто - файл вне каталога данных
+	std::string getDataPath(const std::filesystem::path& fileName) const;
+	void printReport(double totalTimeMs) const;
+
+	AssetCookerInfo    m_info;
+	CookDatabase       m_database;
+	std::vector<Asset> m_assets;
+	std::atomic<size_t> m_numFinished{ 0 };
+
+	mutable std::mutex                            m_texturesMutex;
+	std::unordered_map<std::string, TextureUsage> m_textureUses;
+};
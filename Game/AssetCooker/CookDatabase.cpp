@@ -0,0 +1,174 @@
+﻿#include "stdafx.h"
+#include "CookDatabase.h"
+//=============================================================================
+namespace
+{
+	constexpr std::string_view DatabaseHeader = "# AssetCooker dependency database v2";
+	//-------------------------------------------------------------------------
+	std::string toHex(uint64_t value)
+	{
+		char buffer[16];
+		auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value, 16);
+		return std::string(sizeof(buffer) - static_cast<size_t>(end - buffer), '0') + std::string(buffer, end);
+	}
+	//-------------------------------------------------------------------------
+	bool fromHex(std::string_view str, uint64_t& value)
+	{
+		auto [end, ec] = std::from_chars(str.data(), str.data() + str.size(), value, 16);
+		return ec == std::errc() && end == str.data() + str.size();
+	}
+} // namespace
+//=============================================================================
+bool CookDatabase::Load(const std::filesystem::path& fileName)
+{
+	std::lock_guard lock(m_mutex);
+	m_records.clear();
+
+	std::ifstream file(fileName);
+	if (!file.is_open())
+		return false; // первый запуск
+
+	std::string line;
+	if (!std::getline(file, line) || line != DatabaseHeader)
+	{
+		Warning("Unknown cook database format, all assets will be cooked: " + fileName.string());
+		return false;
+	}
+
+	// asset <path>
+	// settings <hash>
+	// output <path>
+	// dep <hash> <path>
+	// tex <usage> <path>
+	CookRecord* record = nullptr;
+	while (std::getline(file, line))
+	{
+		const size_t space = line.find(' ');
+		if (space == std::string::npos) continue;
+		const std::string_view key = std::string_view(line).substr(0, space);
+		const std::string_view value = std::string_view(line).substr(space + 1);
+
+		if (key == "asset")
+		{
+			record = &m_records[std::string(value)];
+			*record = {};
+		}
+		else if (!record)
+		{
+			continue;
+		}
+		else if (key == "settings")
+		{
+			fromHex(value, record->settingsHash);
+		}
+		else if (key == "output")
+		{
+			record->output = std::string(value);
+		}
+		else if (key == "dep")
+		{
+			const size_t pathStart = value.find(' ');
+			CookDependency dependency;
+			if (pathStart != std::string_view::npos && fromHex(value.substr(0, pathStart), dependency.hash))
+			{
+				dependency.path = std::string(value.substr(pathStart + 1));
+				record->dependencies.emplace_back(std::move(dependency));
+			}
+		}
+		else if (key == "tex")
+		{
+			const size_t pathStart = value.find(' ');
+			if (pathStart == std::string_view::npos) continue;
+			if (auto usage = GetTextureUsageByName(value.substr(0, pathStart)); usage)
+				record->textures.push_back({ .path = std::string(value.substr(pathStart + 1)), .usage = *usage });
+		}
+	}
+
+	return true;
+}
+//=============================================================================
+bool CookDatabase::Save(const std::filesystem::path& fileName) const
+{
+	std::lock_guard lock(m_mutex);
+
+	// отсортировано, чтобы файл не менялся от порядка запекания
+	std::vector<const std::pair<const std::string, CookRecord>*> records;
+	records.reserve(m_records.size());
+	for (const auto& it : m_records)
+		records.push_back(&it);
+	std::sort(records.begin(), records.end(), [](const auto* a, const auto* b) { return a->first < b->first; });
+
+	std::ofstream file(fileName, std::ios::trunc);
+	if (!file.is_open())
+	{
+		Error("Failed to write cook database: " + fileName.string());
+		return false;
+	}
+
+	file << DatabaseHeader << '\n';
+	for (const auto* it : records)
+	{
+		file << "asset " << it->first << '\n';
+		file << "settings " << toHex(it->second.settingsHash) << '\n';
+		file << "output " << it->second.output << '\n';
+		for (const auto& dependency : it->second.dependencies)
+			file << "dep " << toHex(dependency.hash) << ' ' << dependency.path << '\n';
+		for (const auto& texture : it->second.textures)
+			file << "tex " << GetTextureUsageName(texture.usage) << ' ' << texture.path << '\n';
+	}
+
+	return file.good();
+}
+//=============================================================================
+bool CookDatabase::IsUpToDate(const std::filesystem::path& dataDirectory, const std::string& asset, uint64_t settingsHash) const
+{
+	CookRecord record;
+	{
+		std::lock_guard lock(m_mutex);
+		auto it = m_records.find(asset);
+		if (it == m_records.end())
+			return false;
+		record = it->second;
+	}
+
+	if (record.settingsHash != settingsHash || record.dependencies.empty())
+		return false;
+
+	std::error_code ec;
+	if (!std::filesystem::is_regular_file(dataDirectory / record.output, ec))
+		return false;
+
+	// хеши считаются вне блокировки - это самая долгая часть проверки
+	for (const auto& dependency : record.dependencies)
+	{
+		if (cooked::HashFile(dataDirectory / dependency.path) != dependency.hash)
+			return false;
+	}
+	return true;
+}
+//=============================================================================
+void CookDatabase::SetRecord(const std::string& asset, CookRecord&& record)
+{
+	std::lock_guard lock(m_mutex);
+	m_records[asset] = std::move(record);
+}
+//=============================================================================
+void CookDatabase::RemoveRecord(const std::string& asset)
+{
+	std::lock_guard lock(m_mutex);
+	m_records.erase(asset);
+}
+//=============================================================================
+std::vector<CookTextureUse> CookDatabase::GetTextures(const std::string& asset) const
+{
+	std::lock_guard lock(m_mutex);
+	auto it = m_records.find(asset);
+	return (it != m_records.end()) ? it->second.textures : std::vector<CookTextureUse>();
+}
+//=============================================================================
+size_t CookDatabase::RemoveMissing(const std::set<std::string>& assets)
+{
+	std::lock_guard lock(m_mutex);
+	return std::erase_if(m_records, [&](const auto& it) { return !assets.contains(it.first); });
+}
+//=============================================================================
@@ -0,0 +1,44 @@
+﻿#pragma once
+
+#include "Cookers.h"
+
+struct CookDependency final
+{
+	std::string path; // относительно каталога данных
+	uint64_t    hash{ 0 };
+};
+
+struct CookTextureUse final
+{
+	std::string  path; // относительно каталога данных
+	TextureUsage usage{ TextureUsage::Color };
+};
+
+struct CookRecord final
+{
+	uint64_t                    settingsHash{ 0 };
+	std::string                 output;       // относительно каталога данных
+	std::vector<CookDependency> dependencies; // первая - сам исходник
+	std::vector<CookTextureUse> textures;     // у моделей - текстуры материалов, чтобы не перепекать модель ради них
+};
+
+// Текстовый файл с хешами исходников и настроек прошлого запекания. Ассет перепекается, если изменился любой файл, от которого он зависел
+class CookDatabase final
+{
+public:
+	bool Load(const std::filesystem::path& fileName);
+	bool Save(const std::filesystem::path& fileName) const;
+
+	// вызывается из рабочих потоков
+	bool IsUpToDate(const std::filesystem::path& dataDirectory, const std::string& asset, uint64_t settingsHash) const;
+	void SetRecord(const std::string& asset, CookRecord&& record);
+	void RemoveRecord(const std::string& asset);
+	std::vector<CookTextureUse> GetTextures(const std::string& asset) const;
+
+	// удаляет записи ассетов, которых больше нет
+	size_t RemoveMissing(const std::set<std::string>& assets);
+
+private:
+	mutable std::mutex                          m_mutex;
+	std::unordered_map<std::string, CookRecord> m_records;
+};
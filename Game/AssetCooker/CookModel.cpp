@@ -0,0 +1,318 @@
+﻿#include "stdafx.h"
+#include "Cookers.h"
+//=============================================================================
+namespace
+{
+	// те же флаги, что и в Model::Load
+	constexpr unsigned AssimpLoadFlags =
+		aiProcess_JoinIdenticalVertices |
+		aiProcess_Triangulate |
+		aiProcess_GenSmoothNormals |
+		aiProcess_LimitBoneWeights |
+		aiProcess_SplitLargeMeshes |
+		aiProcess_ImproveCacheLocality |
+		aiProcess_RemoveRedundantMaterials |
+		aiProcess_FindDegenerates |
+		aiProcess_FindInvalidData |
+		aiProcess_GenUVCoords |
+		aiProcess_FlipUVs |
+		aiProcess_CalcTangentSpace |
+		aiProcess_SortByPType |
+		aiProcess_OptimizeMeshes;
+	//-------------------------------------------------------------------------
+	// запоминает все файлы, которые открыл Assimp (.mtl, .bin и т.п.) - это зависимости ассета
+	class RecordingIOSystem final : public Assimp::IOSystem
+	{
+	public:
+		bool Exists(const char* file) const override { return m_system.Exists(file); }
+		char getOsSeparator() const override { return m_system.getOsSeparator(); }
+		bool ComparePaths(const char* one, const char* second) const override { return m_system.ComparePaths(one, second); }
+		void Close(Assimp::IOStream* stream) override { m_system.Close(stream); }
+		Assimp::IOStream* Open(const char* file, const char* mode) override
+		{
+			Assimp::IOStream* stream = m_system.Open(file, mode);
+			if (stream) openedFiles.emplace_back(file);
+			return stream;
+		}
+
+		std::vector<std::string> openedFiles;
+
+	private:
+		Assimp::DefaultIOSystem m_system;
+	};
+	//-------------------------------------------------------------------------
+	// перестановка вершин под кеш GPU - запеченный файл грузится как есть
+	void optimizeMesh(CookedMesh& mesh)
+	{
+		if (mesh.indices.empty() || mesh.vertices.empty()) return;
+
+		meshopt_optimizeVertexCache(mesh.indices.data(), mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+
+		std::vector<MeshVertex> vertices(mesh.vertices.size());
+		const size_t numVertices = meshopt_optimizeVertexFetch(vertices.data(), mesh.indices.data(), mesh.indices.size(), mesh.vertices.data(), mesh.vertices.size(), sizeof(MeshVertex));
+		vertices.resize(numVertices);
+		mesh.vertices = std::move(vertices);
+	}
+	//-------------------------------------------------------------------------
+	std::string makeRelative(const std::string& path, const std::string& directory)
+	{
+		if (path.starts_with(directory))
+			return path.substr(directory.size());
+		return path;
+	}
+	//-------------------------------------------------------------------------
+	bool cookOBJ(const std::string& fileName, CookedModel& model, CookResult& result)
+	{
+		// те же настройки, что и в Model::loadOBJ
+		ObjLoadInfo loadInfo{
+			.flipTexCoordV = true,
+			.generateNormals = true,
+			.generateTangents = true,
+			.loadMaterials = true
+		};
+		ObjData data;
+		if (!obj::Load(fileName, data, loadInfo) || data.groups.empty())
+			return false;
+
+		for (const auto& lib : data.materialLibraries)
+		{
+			if (io::Exists(lib))
+				result.dependencies.push_back(lib);
+		}
+
+		const std::string directory = io::GetFileDirectory(fileName);
+		model.materials.reserve(data.materials.size());
+		for (const auto& objMaterial : data.materials)
+		{
+			CookedMaterial& material = model.materials.emplace_back();
+			material.ambientColor = objMaterial.ambientColor;
+			material.diffuseColor = objMaterial.diffuseColor;
+			material.specularColor = objMaterial.specularColor;
+			material.opacity = objMaterial.opacity;
+			material.shininess = objMaterial.shininess;
+
+			auto setTexture = [&](CookedTextureSlot slot, const std::string& path)
+				{
+					if (!path.empty()) material.textures[static_cast<size_t>(slot)] = makeRelative(path, directory);
+				};
+			setTexture(CookedTextureSlot::Diffuse, objMaterial.diffuseMap);
+			setTexture(CookedTextureSlot::Specular, objMaterial.specularMap);
+			setTexture(CookedTextureSlot::Normal, objMaterial.normalMap);
+			setTexture(CookedTextureSlot::Shininess, objMaterial.shininessMap);
+			setTexture(CookedTextureSlot::Emission, objMaterial.emissionMap);
+			setTexture(CookedTextureSlot::Opacity, objMaterial.opacityMap);
+		}
+
+		model.meshes.reserve(data.groups.size());
+		for (auto& group : data.groups)
+		{
+			CookedMesh& mesh = model.meshes.emplace_back();
+			mesh.vertices = std::move(group.mesh.vertices);
+			mesh.indices = std::move(group.mesh.indices);
+			mesh.materialId = group.materialId;
+		}
+		return true;
+	}
+	//-------------------------------------------------------------------------
+	std::string getTexturePath(aiMaterial* material, std::initializer_list<aiTextureType> types)
+	{
+		for (aiTextureType type : types)
+		{
+			if (material->GetTextureCount(type) == 0) continue;
+
+			aiString path;
+			material->GetTexture(type, 0, &path);
+			// как Model::loadMaterialTextures - каталоги из пути отбрасываются, "*N" - встроенная текстура
+			const std::string texPath = path.C_Str();
+			const size_t index = texPath.find_last_of('/');
+			return (index == std::string::npos) ? texPath : texPath.substr(index + 1);
+		}
+		return {};
+	}
+	//-------------------------------------------------------------------------
+	// те же пространства цвета, что у Model при загрузке PBR-материалов
+	TextureUsage getTextureUsage(CookedTextureSlot slot)
+	{
+		switch (slot)
+		{
+		case CookedTextureSlot::Diffuse:
+		case CookedTextureSlot::Emission: return TextureUsage::Color;
+		case CookedTextureSlot::Normal:   return TextureUsage::Normal;
+		default:                          return TextureUsage::Data;
+		}
+	}
+	//-------------------------------------------------------------------------
+	// по назначению в материалах AssetCooker запекает сами текстуры
+	void addTextureReferences(const std::string& fileName, const CookedModel& model, CookResult& result)
+	{
+		const std::filesystem::path directory = std::filesystem::path(fileName).parent_path();
+		for (const auto& material : model.materials)
+		{
+			for (size_t slot = 0; slot < material.textures.size(); slot++)
+			{
+				const std::string& path = material.textures[slot];
+				if (path.empty() || path.starts_with('*')) continue; // встроенные запекаются вместе с моделью
+
+				TextureReference texture{ .path = (directory / path).generic_string(), .usage = getTextureUsage(static_cast<CookedTextureSlot>(slot)) };
+				if (std::none_of(result.textures.begin(), result.textures.end(), [&](const TextureReference& t) { return t.path == texture.path && t.usage == texture.usage; }))
+					result.textures.push_back(std::move(texture));
+			}
+		}
+	}
+	//-------------------------------------------------------------------------
+	void processNode(const aiScene* scene, const aiNode* node, const aiMatrix4x4& parentTransform, bool bakeTransforms, CookedModel& model)
+	{
+		const aiMatrix4x4 transform = parentTransform * node->mTransformation;
+		aiMatrix3x3 normalTransform(transform);
+		normalTransform.Inverse().Transpose();
+
+		for (unsigned i = 0; i < node->mNumMeshes; i++)
+		{
+			const aiMesh* aimesh = scene->mMeshes[node->mMeshes[i]];
+			if (!(aimesh->mPrimitiveTypes & aiPrimitiveType_TRIANGLE)) continue;
+
+			CookedMesh& mesh = model.meshes.emplace_back();
+			mesh.materialId = static_cast<int>(aimesh->mMaterialIndex);
+
+			const bool hasColors = aimesh->HasVertexColors(0);
+			const bool hasNormals = aimesh->HasNormals();
+			const bool hasTexCoords = aimesh->HasTextureCoords(0);
+			const bool hasTangents = aimesh->HasTangentsAndBitangents();
+
+			mesh.vertices.resize(aimesh->mNumVertices);
+			for (unsigned v = 0; v < aimesh->mNumVertices; v++)
+			{
+				MeshVertex& vertex = mesh.vertices[v];
+				aiVector3D position = aimesh->mVertices[v];
+				if (bakeTransforms) position = transform * position;
+				vertex.position = glm::vec3(position.x, position.y, position.z);
+
+				if (hasColors)
+					vertex.color = glm::vec3(aimesh->mColors[0][v].r, aimesh->mColors[0][v].g, aimesh->mColors[0][v].b);
+				if (hasNormals)
+				{
+					aiVector3D normal = aimesh->mNormals[v];
+					if (bakeTransforms) normal = (normalTransform * normal).NormalizeSafe();
+					vertex.normal = glm::vec3(normal.x, normal.y, normal.z);
+				}
+				if (hasTexCoords)
+					vertex.texCoord = glm::vec2(aimesh->mTextureCoords[0][v].x, aimesh->mTextureCoords[0][v].y);
+				if (hasTangents)
+				{
+					aiVector3D tangent = aimesh->mTangents[v];
+					aiVector3D bitangent = aimesh->mBitangents[v];
+					if (bakeTransforms)
+					{
+						tangent = (aiMatrix3x3(transform) * tangent).NormalizeSafe();
+						bitangent = (aiMatrix3x3(transform) * bitangent).NormalizeSafe();
+					}
+					vertex.tangent = glm::vec3(tangent.x, tangent.y, tangent.z);
+					vertex.bitangent = glm::vec3(bitangent.x, bitangent.y, bitangent.z);
+				}
+			}
+
+			mesh.indices.reserve(size_t(aimesh->mNumFaces) * 3);
+			for (unsigned f = 0; f < aimesh->mNumFaces; f++)
+			{
+				const aiFace& face = aimesh->mFaces[f];
+				if (face.mNumIndices != 3) continue;
+				mesh.indices.insert(mesh.indices.end(), face.mIndices, face.mIndices + 3);
+			}
+		}
+
+		for (unsigned i = 0; i < node->mNumChildren; i++)
+			processNode(scene, node->mChildren[i], transform, bakeTransforms, model);
+	}
+	//-------------------------------------------------------------------------
+	bool cookAssimp(const std::string& fileName, bool bakeTransforms, CookedModel& model, CookResult& result)
+	{
+		Assimp::Importer importer;
+		auto* ioSystem = new RecordingIOSystem(); // удаляет Importer
+		importer.SetIOHandler(ioSystem);
+
+		const aiScene* scene = importer.ReadFile(fileName.c_str(), AssimpLoadFlags);
+		for (const auto& file : ioSystem->openedFiles)
+		{
+			if (std::filesystem::path(file) != std::filesystem::path(fileName))
+				result.dependencies.push_back(file);
+		}
+		if (!scene || !scene->HasMeshes() || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+		{
+			Error("Not load mesh: " + fileName + "\n\tError: " + importer.GetErrorString());
+			return false;
+		}
+
+		for (unsigned i = 0; i < scene->mNumTextures; i++)
+		{
+			const aiTexture* texture = scene->mTextures[i];
+			auto& data = model.embeddedTextures.emplace_back();
+			// несжатые встроенные текстуры (mHeight != 0) движок не грузит - оставляются пустыми
+			if (texture->mHeight == 0)
+			{
+				const auto* bytes = reinterpret_cast<const uint8_t*>(texture->pcData);
+				data.assign(bytes, bytes + texture->mWidth);
+			}
+			else
+				Warning("Uncompressed embedded texture is not supported: " + fileName);
+		}
+
+		model.materials.reserve(scene->mNumMaterials);
+		for (unsigned i = 0; i < scene->mNumMaterials; i++)
+		{
+			aiMaterial* aimaterial = scene->mMaterials[i];
+			CookedMaterial& material = model.materials.emplace_back();
+
+			aiColor3D color;
+			if (aimaterial->Get(AI_MATKEY_COLOR_DIFFUSE, color) == AI_SUCCESS) material.diffuseColor = glm::vec3(color.r, color.g, color.b);
+			if (aimaterial->Get(AI_MATKEY_COLOR_SPECULAR, color) == AI_SUCCESS) material.specularColor = glm::vec3(color.r, color.g, color.b);
+			if (aimaterial->Get(AI_MATKEY_COLOR_AMBIENT, color) == AI_SUCCESS) material.ambientColor = glm::vec3(color.r, color.g, color.b);
+			aimaterial->Get(AI_MATKEY_OPACITY, material.opacity);
+			aimaterial->Get(AI_MATKEY_SHININESS, material.shininess);
+
+			auto& textures = material.textures;
+			textures[static_cast<size_t>(CookedTextureSlot::Diffuse)] = getTexturePath(aimaterial, { aiTextureType_DIFFUSE, aiTextureType_BASE_COLOR });
+			textures[static_cast<size_t>(CookedTextureSlot::Specular)] = getTexturePath(aimaterial, { aiTextureType_SPECULAR });
+			textures[static_cast<size_t>(CookedTextureSlot::Normal)] = getTexturePath(aimaterial, { aiTextureType_NORMALS, aiTextureType_HEIGHT });
+			textures[static_cast<size_t>(CookedTextureSlot::Shininess)] = getTexturePath(aimaterial, { aiTextureType_SHININESS });
+			textures[static_cast<size_t>(CookedTextureSlot::Emission)] = getTexturePath(aimaterial, { aiTextureType_EMISSIVE });
+			textures[static_cast<size_t>(CookedTextureSlot::Opacity)] = getTexturePath(aimaterial, { aiTextureType_OPACITY });
+			textures[static_cast<size_t>(CookedTextureSlot::MetallicRoughness)] = getTexturePath(aimaterial, { aiTextureType_METALNESS });
+			textures[static_cast<size_t>(CookedTextureSlot::AO)] = getTexturePath(aimaterial, { aiTextureType_AMBIENT_OCCLUSION, aiTextureType_AMBIENT, aiTextureType_LIGHTMAP });
+		}
+
+		processNode(scene, scene->mRootNode, aiMatrix4x4(), bakeTransforms, model);
+		return !model.meshes.empty();
+	}
+} // namespace
+//=============================================================================
+CookResult CookModel(const std::string& fileName, const std::string& outputFileName, CookedSource& source)
+{
+	CookResult result;
+
+	std::string extension = io::GetFileExtension(fileName);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+	CookedModel model;
+	bool loaded = false;
+	if (extension == ".obj")
+		loaded = cookOBJ(fileName, model, result);
+	if (!loaded)
+	{
+		model = {};
+		// нативный загрузчик glTF запекает трансформы узлов в вершины, Assimp в Model::Load - нет
+		const bool bakeTransforms = extension == ".gltf" || extension == ".glb";
+		loaded = cookAssimp(fileName, bakeTransforms, model, result);
+	}
+	if (!loaded)
+		return result;
+
+	for (auto& mesh : model.meshes)
+		optimizeMesh(mesh);
+	std::erase_if(model.meshes, [](const CookedMesh& mesh) { return mesh.vertices.empty() || mesh.indices.empty(); });
+	addTextureReferences(fileName, model, result);
+
+	AddCookDependencies(fileName, result.dependencies, source);
+	result.success = cooked::SaveModel(outputFileName, model, source);
+	return result;
+}
+//=============================================================================
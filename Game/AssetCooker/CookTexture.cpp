@@ -0,0 +1,97 @@
+﻿#include "stdafx.h"
+#include "Cookers.h"
+//=============================================================================
+namespace
+{
+	bool hasNameTag(const std::string& fileName, std::span<const std::string_view> tags)
+	{
+		std::string name = io::GetFileNameWithoutExtension(fileName);
+		std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+		for (std::string_view tag : tags)
+		{
+			const size_t pos = name.find(tag);
+			// короткие суффиксы вроде "_n" только в конце имени
+			if (pos != std::string::npos && (tag.size() > 3 || pos + tag.size() == name.size()))
+				return true;
+		}
+		return false;
+	}
+	//-------------------------------------------------------------------------
+	// Запасной путь для текстур, которых нет ни в одном материале (тайлы, шум SSAO, таблицы): назначение по соглашению об
+	// именах. Карты нормалей, масок и т.п. хранят не цвет - их мипы усредняются без перевода из sRGB, шум и таблицы
+	// читаются как точные значения - блочное сжатие их портит
+	TextureCookRequest getRequestByName(const std::string& fileName)
+	{
+		constexpr std::string_view LookupTags[] = { "noise", "lut" };
+		constexpr std::string_view NormalTags[] = { "normal", "_nrm", "_norm", "_n" };
+		constexpr std::string_view DataTags[] = { "bump", "height", "specular", "_spec", "rough", "metal", "_ao", "occlusion", "mask" };
+
+		if (hasNameTag(fileName, LookupTags)) return { .usage = TextureUsage::Lookup, .colorSpace = ColorSpace::Linear };
+		if (hasNameTag(fileName, NormalTags)) return { .usage = TextureUsage::Normal, .colorSpace = ColorSpace::Linear };
+		if (hasNameTag(fileName, DataTags))   return { .usage = TextureUsage::Data, .colorSpace = ColorSpace::Linear };
+		return { .usage = TextureUsage::Color, .colorSpace = ColorSpace::sRGB };
+	}
+	//-------------------------------------------------------------------------
+	bool hasTransparency(const std::vector<uint8_t>& pixels, uint32_t components)
+	{
+		if (components != 4) return false;
+		for (size_t i = 3; i < pixels.size(); i += 4)
+		{
+			if (pixels[i] != 255) return true;
+		}
+		return false;
+	}
+} // namespace
+//=============================================================================
+CookResult CookTexture(const std::string& fileName, const std::string& outputFileName, const std::optional<TextureCookRequest>& request, CookedSource& source)
+{
+	CookResult result;
+	const TextureCookRequest settings = request ? *request : getRequestByName(fileName);
+	const bool isLookup = settings.usage == TextureUsage::Lookup;
+
+	int width, height, nrComponents;
+	stbi_uc* pixels = stbi_load(fileName.c_str(), &width, &height, &nrComponents, 0);
+	if (!pixels || nrComponents < 1 || nrComponents > 4 || width <= 0 || height <= 0)
+	{
+		stbi_image_free(pixels);
+		Error("Failed to load texture " + fileName + ": " + std::string(stbi_failure_reason() ? stbi_failure_reason() : "unknown"));
+		return result;
+	}
+
+	CookedTexture texture{
+		.width = static_cast<uint32_t>(width),
+		.height = static_cast<uint32_t>(height),
+		.components = static_cast<uint32_t>(nrComponents),
+		.colorSpace = settings.colorSpace,
+		.format = BlockFormat::None,
+		.mips = {}
+	};
+	// у таблиц и шума соседние texel'и не связаны - резкий фильтр там только добавит звон
+	const MipSettings mipSettings{
+		.filter = isLookup ? MipFilter::Box : MipFilter::Kaiser,
+		.colorSpace = texture.colorSpace,
+		.alphaCutoff = mipmap::IsCutout(pixels, texture.width, texture.height, texture.components) ? mipmap::DefaultAlphaCutoff : 0.0f
+	};
+	texture.mips = mipmap::Generate(pixels, texture.width, texture.height, texture.components, mipSettings);
+	stbi_image_free(pixels);
+
+	// мипы считаются по несжатым пикселям, каждый сжимается отдельно
+	if (!isLookup)
+	{
+		texture.format = bcn::ChooseFormat(texture.components, texture.colorSpace, settings.usage == TextureUsage::Normal, hasTransparency(texture.mips[0], texture.components));
+		uint32_t mipWidth = texture.width;
+		uint32_t mipHeight = texture.height;
+		for (auto& mip : texture.mips)
+		{
+			mip = bcn::Compress(texture.format, mip.data(), mipWidth, mipHeight, texture.components);
+			mipWidth = std::max(1u, mipWidth / 2);
+			mipHeight = std::max(1u, mipHeight / 2);
+		}
+	}
+
+	AddCookDependencies(fileName, result.dependencies, source);
+	result.success = cooked::SaveTexture(outputFileName, texture, source);
+	return result;
+}
+//=============================================================================
@@ -0,0 +1,19 @@
+﻿#include "stdafx.h"
+#include "Cookers.h"
+//=============================================================================
+CookResult CookTile(const std::string& fileName, const std::string& outputFileName, CookedSource& source)
+{
+	CookResult result;
+
+	// с теми же настройками, что и AddObjModel в Game3 - материалы тайлов задаются через TileInfo
+	ObjData data;
+	if (!obj::Load(fileName, data, { .loadMaterials = false }))
+	{
+		Error("Failed to load tile: " + fileName);
+		return result;
+	}
+
+	result.success = cooked::SaveObjData(outputFileName, data, source);
+	return result;
+}
+//=============================================================================
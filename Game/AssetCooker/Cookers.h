@@ -0,0 +1,55 @@
+﻿#pragma once
+
+enum class AssetType : uint8_t
+{
+	Model,
+	Texture,
+	Tile
+};
+
+std::string_view GetAssetTypeName(AssetType type) noexcept;
+// все, что влияет на результат запекания, кроме содержимого файлов (cooked::ModelSettings и т.п.). Меняется - перепекаются все ассеты этого типа
+std::string_view GetCookSettings(AssetType type) noexcept;
+// дописывает прочитанные при запекании файлы в заголовок запеченного файла, повторы пропускаются
+void AddCookDependencies(const std::string& fileName, const std::vector<std::string>& dependencies, CookedSource& source);
+
+// как текстуру используют материалы: от этого зависят пространство цвета мипов и формат сжатия
+enum class TextureUsage : uint8_t
+{
+	Color,  // диффузный цвет, свечение - sRGB
+	Normal, // BC5, без перевода из sRGB
+	Data,   // маски, блеск, металличность, AO - линейные
+	Lookup  // шум и таблицы - без фильтров и сжатия. Материалы такие не дают, только имя файла
+};
+
+std::string_view GetTextureUsageName(TextureUsage usage) noexcept;
+std::optional<TextureUsage> GetTextureUsageByName(std::string_view name) noexcept;
+
+struct TextureCookRequest final
+{
+	TextureUsage usage{ TextureUsage::Color };
+	ColorSpace   colorSpace{ ColorSpace::sRGB };
+};
+
+// текстура из материала модели
+struct TextureReference final
+{
+	std::string  path; // как dependencies - путь к файлу, а не относительно модели
+	TextureUsage usage{ TextureUsage::Color };
+};
+
+struct CookResult final
+{
+	bool                          success{ false };
+	std::vector<std::string>      dependencies; // прочитанные файлы помимо самого исходника (.mtl, .bin и т.п.)
+	std::vector<TextureReference> textures;     // только у моделей
+};
+
+// source - настройки и исходник, зависимости cooker дописывает сам перед сохранением
+// CookModel.cpp
+CookResult CookModel(const std::string& fileName, const std::string& outputFileName, CookedSource& source);
+// CookTexture.cpp
+// request - назначение из материалов моделей. Без него (текстуру не использует ни одна модель) оно угадывается по имени файла
+CookResult CookTexture(const std::string& fileName, const std::string& outputFileName, const std::optional<TextureCookRequest>& request, CookedSource& source);
+// CookTile.cpp
+CookResult CookTile(const std::string& fileName, const std::string& outputFileName, CookedSource& source);
@@ -0,0 +1,35 @@
+﻿#include "stdafx.h"
+#include "AssetCooker.h"
+//=============================================================================
+#if defined(_MSC_VER)
+#	pragma comment( lib, "3rdparty.lib" )
+#	pragma comment( lib, "Engine.lib" )
+#endif
+//=============================================================================
+// AssetCooker [dataDirectory] [-j threads] [-f]
+int main(int argc, char* argv[])
+{
+	AssetCookerInfo info;
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string_view arg = argv[i];
+		if (arg == "-f" || arg == "--force")
+			info.force = true;
+		else if (arg == "-j" && i + 1 < argc)
+			info.numThreads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+		else if (arg == "-h" || arg == "--help")
+		{
+			Print("Usage: AssetCooker [dataDirectory] [-j threads] [-f]");
+			Print("  dataDirectory  default 'data'");
+			Print("  -j threads     worker threads, default - number of cores");
+			Print("  -f, --force    cook all assets, ignore dependency database");
+			return 0;
+		}
+		else
+			info.dataDirectory = arg;
+	}
+
+	AssetCooker cooker;
+	return cooker.Run(info) ? 0 : 1;
+}
+//=============================================================================
@@ -0,0 +1,17 @@
+﻿#pragma once
+
+#include "3rdparty/3rdpartyConfig.h"
+#include "Engine/stdafx.h"
+
+#include <mutex>
+
+#include <assimp/DefaultIOSystem.h>
+
+#include <Engine/NanoCore.h>
+#include <Engine/NanoIO.h>
+#include <Engine/NanoLog.h>
+#include <Engine/NanoMath.h>
+
+#include <Engine/NanoObjLoader.h>
+#include <Engine/NanoCookedAssets.h>
+#include <Engine/NanoMipmap.h>
\ No newline at end of file
@@ -24,6 +24,7 @@ void Framebuffer::Destroy()
 	m_info.colorAttachments.clear();
 	m_info.depthAttachment = {};
 	m_info.width = m_info.height = 0;
+	m_info.layers = 1;
 }
 //=============================================================================
 void Framebuffer::Bind()
@@ -89,6 +90,11 @@ void Framebuffer::BindDepthTexture(size_t slot) const
 			glActiveTexture(GL_TEXTURE0 + slot);
 			glBindTexture(GL_TEXTURE_2D, m_depthAttachmentId->id);
 		}
+		else if (m_depthAttachmentId->type == AttachmentType::TextureArray)
+		{
+			glActiveTexture(GL_TEXTURE0 + slot);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, m_depthAttachmentId->id);
+		}
 		else
 		{
 			glActiveTexture(GL_TEXTURE0 + slot);
@@ -101,6 +107,63 @@ void Framebuffer::BindDepthTexture(size_t slot) const
 	}
 }
 //=============================================================================
+void Framebuffer::CopyDepth(const Framebuffer& source)
+{
+	assert(m_depthAttachmentId && source.m_depthAttachmentId && m_depthAttachmentId->type == source.m_depthAttachmentId->type);
+	assert(m_info.width == source.m_info.width && m_info.height == source.m_info.height && m_info.layers == source.m_info.layers);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, source.m_fbo);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_fbo);
+
+	const int numLayers = getNumDepthLayers();
+	if (numLayers == 1)
+		glBlitFramebuffer(0, 0, m_info.width, m_info.height, 0, 0, m_info.width, m_info.height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	else
+	{
+		// у слоистого вложения blit видит только слой 0 - слои копируются по одному
+		for (int layer = 0; layer < numLayers; layer++)
+		{
+			source.attachDepthLayer(GL_READ_FRAMEBUFFER, layer);
+			attachDepthLayer(GL_DRAW_FRAMEBUFFER, layer);
+			glBlitFramebuffer(0, 0, m_info.width, m_info.height, 0, 0, m_info.width, m_info.height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+		}
+		source.attachDepthLayer(GL_READ_FRAMEBUFFER, -1);
+		attachDepthLayer(GL_DRAW_FRAMEBUFFER, -1);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+}
+//=============================================================================
+void Framebuffer::CopyDepth(const Framebuffer& source, int x, int y, int width, int height)
+{
+	assert(m_depthAttachmentId && source.m_depthAttachmentId && m_depthAttachmentId->type == source.m_depthAttachmentId->type);
+	assert(m_info.width == source.m_info.width && m_info.height == source.m_info.height && getNumDepthLayers() == 1);
+
+	// blit отсекается scissor
+	const GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+	if (scissor) glDisable(GL_SCISSOR_TEST);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, source.m_fbo);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_fbo);
+	glBlitFramebuffer(x, y, x + width, y + height, x, y, x + width, y + height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+
+	if (scissor) glEnable(GL_SCISSOR_TEST);
+}
+//=============================================================================
+void Framebuffer::ClearDepth(int layer)
+{
+	if (layer < 0 || getNumDepthLayers() == 1)
+	{
+		glClear(GL_DEPTH_BUFFER_BIT);
+		return;
+	}
+
+	attachDepthLayer(GL_FRAMEBUFFER, layer);
+	glClear(GL_DEPTH_BUFFER_BIT);
+	attachDepthLayer(GL_FRAMEBUFFER, -1);
+}
+//=============================================================================
 bool Framebuffer::initializeAttachments()
 {
 	glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
@@ -150,6 +213,10 @@ bool Framebuffer::initializeAttachments()
 		{
 			createDepthCubeMapTextureAttachment(depthCfg);
 		}
+		else if (depthCfg.type == AttachmentType::TextureArray)
+		{
+			createDepthTextureArrayAttachment(depthCfg);
+		}
 		else if (depthCfg.type == AttachmentType::RenderBuffer)
 		{
 			createDepthRenderbufferAttachment(depthCfg);
@@ -212,7 +279,7 @@ void Framebuffer::cleanupAttachments()
 	{
 		if (m_depthAttachmentId->id)
 		{
-			if (m_depthAttachmentId->type == AttachmentType::Texture || m_depthAttachmentId->type == AttachmentType::TextureCubeMap)
+			if (m_depthAttachmentId->type == AttachmentType::Texture || m_depthAttachmentId->type == AttachmentType::TextureCubeMap || m_depthAttachmentId->type == AttachmentType::TextureArray)
 				glDeleteTextures(1, &m_depthAttachmentId->id);
 			else if (m_depthAttachmentId->type == AttachmentType::RenderBuffer)			
 				glDeleteRenderbuffers(1, &m_depthAttachmentId->id);
@@ -231,12 +298,12 @@ void Framebuffer::createColorTextureAttachment(size_t index, const ColorAttachme
 	if (cfg.multisample)
 	{
 		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, tex);
-		glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, cfg.samples, getInternalFormat(cfg.format, cfg.dataType, cfg.colorSpace), m_info.width, m_info.height, GL_TRUE);
+		glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, cfg.samples, getInternalFormat(cfg), m_info.width, m_info.height, GL_TRUE);
 	}
 	else
 	{
 		glBindTexture(GL_TEXTURE_2D, tex);
-		glTexImage2D(GL_TEXTURE_2D, 0, getInternalFormat(cfg.format, cfg.dataType, cfg.colorSpace), m_info.width, m_info.height, 0, GetColorFormatGL(cfg.format), EnumToValue(cfg.dataType), nullptr);
+		glTexImage2D(GL_TEXTURE_2D, 0, getInternalFormat(cfg), m_info.width, m_info.height, 0, GetColorFormatGL(cfg.format), EnumToValue(cfg.dataType), nullptr);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	}
@@ -257,7 +324,7 @@ void Framebuffer::createColorCubeMapTextureAttachment(size_t index, const ColorA
 	glBindTexture(GL_TEXTURE_CUBE_MAP, tex);
 	for (int i = 0; i < 6; ++i)
 	{
-		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, getInternalFormat(cfg.format, cfg.dataType, cfg.colorSpace), m_info.width, m_info.height, 0, GetColorFormatGL(cfg.format), EnumToValue(cfg.dataType), nullptr);
+		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, getInternalFormat(cfg), m_info.width, m_info.height, 0, GetColorFormatGL(cfg.format), EnumToValue(cfg.dataType), nullptr);
 	}
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -276,11 +343,11 @@ void Framebuffer::createColorRenderbufferAttachment(size_t index, const ColorAtt
 	glBindRenderbuffer(GL_RENDERBUFFER, rb);
 	if (cfg.multisample)
 	{
-		glRenderbufferStorageMultisample(GL_RENDERBUFFER, cfg.samples, getInternalFormat(cfg.format, cfg.dataType, cfg.colorSpace), m_info.width, m_info.height);
+		glRenderbufferStorageMultisample(GL_RENDERBUFFER, cfg.samples, getInternalFormat(cfg), m_info.width, m_info.height);
 	}
 	else
 	{
-		glRenderbufferStorage(GL_RENDERBUFFER, getInternalFormat(cfg.format, cfg.dataType, cfg.colorSpace), m_info.width, m_info.height);
+		glRenderbufferStorage(GL_RENDERBUFFER, getInternalFormat(cfg), m_info.width, m_info.height);
 	}
 	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + index, GL_RENDERBUFFER, rb);
 	m_colorAttachmentsId.emplace_back(ColorAttachmentId{ .id = rb, .type = cfg.type });
@@ -293,21 +360,29 @@ void Framebuffer::createDepthTextureAttachment(const DepthAttachment& cfg)
 	{
 		glGenTextures(1, &tex);
 		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, tex);
-		glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, cfg.samples, GL_DEPTH_COMPONENT32, m_info.width, m_info.height, GL_TRUE);
+		glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, cfg.samples, cfg.stencil ? GL_DEPTH24_STENCIL8 : GL_DEPTH_COMPONENT32, m_info.width, m_info.height, GL_TRUE);
 	}
 	else
 	{
 		glGenTextures(1, &tex);
 		glBindTexture(GL_TEXTURE_2D, tex);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32, m_info.width, m_info.height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		if (cfg.stencil)
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, m_info.width, m_info.height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
+		else
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32, m_info.width, m_info.height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, cfg.shadowCompare ? GL_LINEAR : GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, cfg.shadowCompare ? GL_LINEAR : GL_NEAREST);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
 		float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
 		glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
+		if (cfg.shadowCompare)
+		{
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+		}
 	}
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, (cfg.multisample ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D), tex, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, cfg.stencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT, (cfg.multisample ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D), tex, 0);
 	m_depthAttachmentId = DepthAttachmentId{ .id = tex, .type = cfg.type };
 }
 //=============================================================================
@@ -338,6 +413,37 @@ void Framebuffer::createDepthCubeMapTextureAttachment(const DepthAttachment& cfg
 	m_depthAttachmentId = DepthAttachmentId{ .id = tex, .type = cfg.type };
 }
 //=============================================================================
+void Framebuffer::createDepthTextureArrayAttachment(const DepthAttachment& cfg)
+{
+	if (cfg.multisample)
+	{
+		Fatal("Multisample depth texture arrays are not supported");
+		return;
+	}
+	GLuint tex{ 0 };
+	glGenTextures(1, &tex);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, tex);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT32, m_info.width, m_info.height, m_info.layers, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, cfg.shadowCompare ? GL_LINEAR : GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, cfg.shadowCompare ? GL_LINEAR : GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColor);
+	if (cfg.shadowCompare)
+	{
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	}
+
+	// все слои сразу - слой выбирает gl_Layer
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, tex, 0);
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	m_depthAttachmentId = DepthAttachmentId{ .id = tex, .type = cfg.type };
+}
+//=============================================================================
 void Framebuffer::createDepthRenderbufferAttachment(const DepthAttachment& cfg)
 {
 	GLuint rb = 0;
@@ -345,24 +451,87 @@ void Framebuffer::createDepthRenderbufferAttachment(const DepthAttachment& cfg)
 	glBindRenderbuffer(GL_RENDERBUFFER, rb);
 	if (cfg.multisample)
 	{
-		glRenderbufferStorageMultisample(GL_RENDERBUFFER, cfg.samples, GL_DEPTH_COMPONENT32, m_info.width, m_info.height);
+		glRenderbufferStorageMultisample(GL_RENDERBUFFER, cfg.samples, cfg.stencil ? GL_DEPTH24_STENCIL8 : GL_DEPTH_COMPONENT32, m_info.width, m_info.height);
 	}
 	else
 	{
-		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT32, m_info.width, m_info.height);
+		glRenderbufferStorage(GL_RENDERBUFFER, cfg.stencil ? GL_DEPTH24_STENCIL8 : GL_DEPTH_COMPONENT32, m_info.width, m_info.height);
 	}
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rb);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, cfg.stencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rb);
 	m_depthAttachmentId = DepthAttachmentId{ .id = rb, .type = cfg.type };
 }
 //=============================================================================
-GLenum Framebuffer::getInternalFormat(ColorFormat format, DataType dataType, ColorSpace colorSpace)
+void Framebuffer::attachDepthLayer(GLenum target, int layer) const
+{
+	const GLuint tex = m_depthAttachmentId->id;
+	if (layer < 0)
+		glFramebufferTexture(target, GL_DEPTH_ATTACHMENT, tex, 0);
+	else if (m_depthAttachmentId->type == AttachmentType::TextureCubeMap)
+		glFramebufferTexture2D(target, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + layer, tex, 0);
+	else
+		glFramebufferTextureLayer(target, GL_DEPTH_ATTACHMENT, tex, 0, layer);
+}
+//=============================================================================
+int Framebuffer::getNumDepthLayers() const
+{
+	if (!m_depthAttachmentId) return 0;
+	switch (m_depthAttachmentId->type)
+	{
+	case AttachmentType::TextureCubeMap: return 6;
+	case AttachmentType::TextureArray:   return m_info.layers;
+	default:                             return 1;
+	}
+}
+//=============================================================================
+GLenum Framebuffer::getInternalFormat(const ColorAttachment& cfg)
 {
-	if (colorSpace == ColorSpace::sRGB && dataType == DataType::Float)
+	const ColorFormat format = cfg.format;
+	const DataType dataType = cfg.dataType;
+	const ColorSpace colorSpace = cfg.colorSpace;
+
+	if (colorSpace == ColorSpace::sRGB && (dataType == DataType::Float || cfg.precision != ColorPrecision::Default))
 	{
-		Fatal("sRGB is not supported with float data type in OpenGL 3.3");
+		Fatal("sRGB is supported only with 8-bit unsigned color formats");
 		return 0;
 	}
 
+	if (cfg.precision == ColorPrecision::Half)
+	{
+		if (dataType != DataType::Float)
+		{
+			Fatal("Half precision color attachment requires float data type");
+			return 0;
+		}
+		switch (format)
+		{
+		case ColorFormat::Red:  return GL_R16F;
+		case ColorFormat::RG:   return GL_RG16F;
+		case ColorFormat::RGB:  return GL_RGB16F;
+		case ColorFormat::RGBA: return GL_RGBA16F;
+		default: break;
+		}
+	}
+	else if (cfg.precision == ColorPrecision::RGB10A2)
+	{
+		if (format != ColorFormat::RGB && format != ColorFormat::RGBA)
+		{
+			Fatal("RGB10A2 color attachment requires RGB or RGBA format");
+			return 0;
+		}
+		return GL_RGB10_A2;
+	}
+	else if (cfg.precision == ColorPrecision::Norm16)
+	{
+		switch (format)
+		{
+		case ColorFormat::Red:  return GL_R16;
+		case ColorFormat::RG:   return GL_RG16;
+		case ColorFormat::RGB:  return GL_RGB16;
+		case ColorFormat::RGBA: return GL_RGBA16;
+		default: break;
+		}
+	}
+
 	switch (format)
 	{
 	case ColorFormat::Red:  return (dataType == DataType::Float) ? GL_R32F : GL_R8;
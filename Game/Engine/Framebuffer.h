@@ -6,20 +6,30 @@
 #pragma region [ NEW Framebuffer ]
 
 // TODO: тест CubeMap fbo
-// TODO: я использую GL_RGB32F, а можно сделать вариант чтобы можно было выбирать GL_RGB16F
 
 enum class AttachmentType : uint8_t
 {
 	Texture,
 	TextureCubeMap,
+	TextureArray, // только глубина, FramebufferInfo::layers слоев. Выбор слоя - gl_Layer в геометрическом шейдере
 	RenderBuffer
 };
 
+// точность каналов цветового вложения
+enum class ColorPrecision : uint8_t
+{
+	Default, // 8 бит, Float - 32 бита
+	Half,    // 16 бит float (GL_RGB16F...), только DataType::Float
+	RGB10A2, // GL_RGB10_A2: 10 бит на цвет, 2 на альфу, формат RGB или RGBA
+	Norm16   // 16 бит unorm (GL_RG16...), например нормали в октаэдрической упаковке
+};
+
 struct ColorAttachment final
 {
 	AttachmentType type{ AttachmentType::Texture };
 	ColorFormat    format{ ColorFormat::RGBA };
 	DataType       dataType{ DataType::UnsignedByte };
+	ColorPrecision precision{ ColorPrecision::Default };
 	ColorSpace     colorSpace{ ColorSpace::Linear };
 	bool           multisample{ false };
 	int            samples{ 4 };
@@ -42,6 +52,8 @@ struct DepthAttachment final
 	AttachmentType type{ AttachmentType::RenderBuffer };
 	bool           multisample{ false };
 	int            samples{ 4 };
+	bool           shadowCompare{ false }; // для sampler*Shadow: сравнение с глубиной и линейная фильтрация (аппаратный PCF 2x2)
+	bool           stencil{ false }; // GL_DEPTH24_STENCIL8 вместо GL_DEPTH_COMPONENT32, только Texture и RenderBuffer
 };
 
 struct FramebufferInfo final
@@ -50,6 +62,7 @@ struct FramebufferInfo final
 	std::optional<DepthAttachment> depthAttachment = std::nullopt;
 	uint16_t                       width{ 1 };
 	uint16_t                       height{ 1 };
+	uint16_t                       layers{ 1 };
 };
 
 class Framebuffer final
@@ -76,6 +89,13 @@ public:
 	void BindColorTexture(size_t colorAttachment, size_t slot) const;
 	void BindDepthTexture(size_t slot) const;
 
+	// копирует глубину буфера того же размера и типа (все слои и грани). После вызова привязан этот буфер
+	void CopyDepth(const Framebuffer& source);
+	// копирует прямоугольник глубины 2D буфера того же размера (тайл атласа). После вызова привязан этот буфер
+	void CopyDepth(const Framebuffer& source, int x, int y, int width, int height);
+	// очищает глубину одного слоя массива или грани кубической карты, layer < 0 - все. Буфер должен быть привязан
+	void ClearDepth(int layer = -1);
+
 private:
 	bool initializeAttachments();
 	void cleanupAttachments();
@@ -86,9 +106,13 @@ private:
 
 	void createDepthTextureAttachment(const DepthAttachment& cfg);
 	void createDepthCubeMapTextureAttachment(const DepthAttachment& cfg);
+	void createDepthTextureArrayAttachment(const DepthAttachment& cfg);
 	void createDepthRenderbufferAttachment(const DepthAttachment& cfg);
+	// к target (GL_READ_FRAMEBUFFER/GL_DRAW_FRAMEBUFFER) с привязанным этим буфером - один слой глубины, layer < 0 - все
+	void attachDepthLayer(GLenum target, int layer) const;
+	int getNumDepthLayers() const;
 
-	GLenum getInternalFormat(ColorFormat format, DataType dataType, ColorSpace colorSpace);
+	GLenum getInternalFormat(const ColorAttachment& cfg);
 
 	GLuint                           m_fbo{ 0 };
 	FramebufferInfo                  m_info;
@@ -0,0 +1,711 @@
+﻿#include "stdafx.h"
+#include "NanoAABBTree.h"
+//=============================================================================
+namespace
+{
+	constexpr uint32_t NumBuildBins = 16;
+	constexpr uint32_t AllPlanesMask = (1u << Frustum::NumPlanes) - 1;
+	//-------------------------------------------------------------------------
+	AABB combine(const AABB& a, const AABB& b)
+	{
+		return AABB(glm::min(a.min, b.min), glm::max(a.max, b.max));
+	}
+	//-------------------------------------------------------------------------
+	float area(const AABB& box)
+	{
+		const glm::vec3 d = box.max - box.min;
+		return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+	}
+	//-------------------------------------------------------------------------
+	bool contains(const AABB& outer, const AABB& inner)
+	{
+		return glm::all(glm::lessThanEqual(outer.min, inner.min)) && glm::all(glm::greaterThanEqual(outer.max, inner.max));
+	}
+	//-------------------------------------------------------------------------
+	bool overlaps(const AABB& a, const AABB& b)
+	{
+		return glm::all(glm::lessThanEqual(a.min, b.max)) && glm::all(glm::greaterThanEqual(a.max, b.min));
+	}
+	//-------------------------------------------------------------------------
+	float distanceSquared(const AABB& box, const glm::vec3& point)
+	{
+		const glm::vec3 d = glm::max(glm::max(box.min - point, point - box.max), glm::vec3(0.0f));
+		return glm::dot(d, d);
+	}
+	//-------------------------------------------------------------------------
+	// расстояние до входа луча в бокс, отрицательное - промах
+	float rayBoxDistance(const AABB& box, const glm::vec3& origin, const glm::vec3& invDirection, float maxDistance)
+	{
+		const glm::vec3 t1 = (box.min - origin) * invDirection;
+		const glm::vec3 t2 = (box.max - origin) * invDirection;
+		const glm::vec3 tNear = glm::min(t1, t2);
+		const glm::vec3 tFar = glm::max(t1, t2);
+		const float enter = std::max({ tNear.x, tNear.y, tNear.z, 0.0f });
+		const float exit = std::min({ tFar.x, tFar.y, tFar.z, maxDistance });
+		return enter <= exit ? enter : -1.0f;
+	}
+} // namespace
+//=============================================================================
+int32_t AABBTree::CreateProxy(const AABB& box, uint32_t userData)
+{
+	const int32_t proxyId = allocateNode();
+	Node& node = m_nodes[proxyId];
+	const glm::vec3 margin = glm::vec3(FatMargin) + box.GetSize() * FatMarginScale;
+	node.fatBox = AABB(box.min - margin, box.max + margin);
+	node.box = box;
+	node.userData = userData;
+	node.height = 0;
+	insertLeaf(proxyId);
+	m_numProxies++;
+	return proxyId;
+}
+//=============================================================================
+void AABBTree::DestroyProxy(int32_t proxyId)
+{
+	assert(m_nodes[proxyId].IsLeaf());
+	removeLeaf(proxyId);
+	freeNode(proxyId);
+	m_numProxies--;
+}
+//=============================================================================
+bool AABBTree::MoveProxy(int32_t proxyId, const AABB& box, const glm::vec3& displacement)
+{
+	Node& node = m_nodes[proxyId];
+	node.box = box;
+	if (contains(node.fatBox, box))
+		return false;
+
+	removeLeaf(proxyId);
+
+	// запас вперед по движению - на пару кадров
+	const glm::vec3 margin = glm::vec3(FatMargin) + box.GetSize() * FatMarginScale;
+	const glm::vec3 predicted = displacement * 2.0f;
+	node.fatBox = AABB(box.min - margin + glm::min(predicted, glm::vec3(0.0f)), box.max + margin + glm::max(predicted, glm::vec3(0.0f)));
+	insertLeaf(proxyId);
+	return true;
+}
+//=============================================================================
+void AABBTree::Build(std::span<const AABB> boxes, std::span<const uint32_t> userData, std::vector<int32_t>& proxies)
+{
+	assert(boxes.size() == userData.size());
+	Clear();
+
+	proxies.resize(boxes.size());
+	for (size_t i = 0; i < boxes.size(); i++)
+	{
+		proxies[i] = allocateNode();
+		Node& node = m_nodes[proxies[i]];
+		node.fatBox = boxes[i];
+		node.box = boxes[i];
+		node.userData = userData[i];
+		node.height = 0;
+	}
+	m_numProxies = boxes.size();
+	if (boxes.empty()) return;
+
+	std::vector<int32_t> leaves = proxies;
+	m_root = buildRange(leaves);
+	m_nodes[m_root].parent = NullNode;
+}
+//=============================================================================
+void AABBTree::Clear()
+{
+	m_nodes.clear();
+	m_root = NullNode;
+	m_freeList = NullNode;
+	m_numProxies = 0;
+}
+//=============================================================================
+void AABBTree::QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& userData) const
+{
+	if (m_root == NullNode) return;
+
+	m_stack.clear();
+	m_stack.emplace_back(m_root, AllPlanesMask);
+	while (!m_stack.empty())
+	{
+		const auto [nodeId, parentMask] = m_stack.back();
+		m_stack.pop_back();
+		const Node& node = m_nodes[nodeId];
+		const AABB& box = node.IsLeaf() ? node.box : node.fatBox;
+
+		// плоскость, целиком содержащая бокс, не проверяется у потомков
+		uint32_t mask = parentMask;
+		bool outside = false;
+		for (uint32_t p = 0; p < Frustum::NumPlanes && !outside; p++)
+		{
+			if (!(mask & (1u << p))) continue;
+			const glm::vec4& plane = frustum.GetPlane(p);
+			const glm::vec3 positive{ plane.x >= 0.0f ? box.max.x : box.min.x, plane.y >= 0.0f ? box.max.y : box.min.y, plane.z >= 0.0f ? box.max.z : box.min.z };
+			const glm::vec3 negative{ plane.x >= 0.0f ? box.min.x : box.max.x, plane.y >= 0.0f ? box.min.y : box.max.y, plane.z >= 0.0f ? box.min.z : box.max.z };
+			if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f)
+				outside = true;
+			else if (glm::dot(glm::vec3(plane), negative) + plane.w >= 0.0f)
+				mask &= ~(1u << p);
+		}
+		if (outside || (mask && !overlaps(box, frustum.GetBounds())))
+			continue;
+
+		if (node.IsLeaf())
+			userData.push_back(node.userData);
+		else if (mask == 0)
+			collectLeaves(nodeId, userData);
+		else
+		{
+			m_stack.emplace_back(node.child1, mask);
+			m_stack.emplace_back(node.child2, mask);
+		}
+	}
+}
+//=============================================================================
+void AABBTree::QuerySphere(const glm::vec3& center, float radius, std::vector<uint32_t>& userData) const
+{
+	if (m_root == NullNode) return;
+
+	const float radiusSquared = radius * radius;
+	m_stack.clear();
+	m_stack.emplace_back(m_root, 0u);
+	while (!m_stack.empty())
+	{
+		const int32_t nodeId = m_stack.back().first;
+		m_stack.pop_back();
+		const Node& node = m_nodes[nodeId];
+		const AABB& box = node.IsLeaf() ? node.box : node.fatBox;
+		if (distanceSquared(box, center) > radiusSquared)
+			continue;
+
+		if (node.IsLeaf())
+		{
+			userData.push_back(node.userData);
+			continue;
+		}
+		// дальний угол внутри сферы - внутри все поддерево
+		const glm::vec3 farthest = glm::max(glm::abs(box.min - center), glm::abs(box.max - center));
+		if (glm::dot(farthest, farthest) <= radiusSquared)
+			collectLeaves(nodeId, userData);
+		else
+		{
+			m_stack.emplace_back(node.child1, 0u);
+			m_stack.emplace_back(node.child2, 0u);
+		}
+	}
+}
+//=============================================================================
+void AABBTree::QueryOverlap(const AABB& box, std::vector<uint32_t>& userData) const
+{
+	if (m_root == NullNode) return;
+
+	m_stack.clear();
+	m_stack.emplace_back(m_root, 0u);
+	while (!m_stack.empty())
+	{
+		const int32_t nodeId = m_stack.back().first;
+		m_stack.pop_back();
+		const Node& node = m_nodes[nodeId];
+		if (!overlaps(node.IsLeaf() ? node.box : node.fatBox, box))
+			continue;
+
+		if (node.IsLeaf())
+			userData.push_back(node.userData);
+		else
+		{
+			m_stack.emplace_back(node.child1, 0u);
+			m_stack.emplace_back(node.child2, 0u);
+		}
+	}
+}
+//=============================================================================
+void AABBTree::RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, const std::function<float(uint32_t userData, float distance)>& callback) const
+{
+	if (m_root == NullNode) return;
+
+	glm::vec3 invDirection;
+	for (glm::length_t i = 0; i < 3; i++)
+		invDirection[i] = direction[i] != 0.0f ? 1.0f / direction[i] : std::numeric_limits<float>::max();
+
+	m_stack.clear();
+	m_stack.emplace_back(m_root, 0u);
+	while (!m_stack.empty())
+	{
+		const int32_t nodeId = m_stack.back().first;
+		m_stack.pop_back();
+		const Node& node = m_nodes[nodeId];
+		const float distance = rayBoxDistance(node.IsLeaf() ? node.box : node.fatBox, origin, invDirection, maxDistance);
+		if (distance < 0.0f)
+			continue;
+
+		if (node.IsLeaf())
+		{
+			maxDistance = callback(node.userData, distance);
+			if (maxDistance <= 0.0f) return;
+		}
+		else
+		{
+			m_stack.emplace_back(node.child1, 0u);
+			m_stack.emplace_back(node.child2, 0u);
+		}
+	}
+}
+//=============================================================================
+float AABBTree::GetAreaRatio() const
+{
+	if (m_root == NullNode) return 0.0f;
+
+	const float rootArea = area(m_nodes[m_root].fatBox);
+	if (rootArea <= 0.0f) return 0.0f;
+
+	float totalArea = 0.0f;
+	for (const auto& node : m_nodes)
+	{
+		if (node.height > 0)
+			totalArea += area(node.fatBox);
+	}
+	return totalArea / rootArea;
+}
+//=============================================================================
+int32_t AABBTree::allocateNode()
+{
+	if (m_freeList == NullNode)
+	{
+		m_nodes.emplace_back();
+		return static_cast<int32_t>(m_nodes.size() - 1);
+	}
+
+	const int32_t nodeId = m_freeList;
+	m_freeList = m_nodes[nodeId].parent;
+	m_nodes[nodeId] = Node{};
+	return nodeId;
+}
+//=============================================================================
+void AABBTree::freeNode(int32_t nodeId)
+{
+	m_nodes[nodeId].parent = m_freeList;
+	m_nodes[nodeId].child1 = NullNode;
+	m_nodes[nodeId].child2 = NullNode;
+	m_nodes[nodeId].height = -1;
+	m_freeList = nodeId;
+}
+//=============================================================================
+void AABBTree::insertLeaf(int32_t leaf)
+{
+	if (m_root == NullNode)
+	{
+		m_root = leaf;
+		m_nodes[leaf].parent = NullNode;
+		return;
+	}
+
+	// спуск к соседу: цена - площадь нового родителя плюс рост площади всех предков
+	const AABB leafBox = m_nodes[leaf].fatBox;
+	int32_t index = m_root;
+	while (!m_nodes[index].IsLeaf())
+	{
+		const Node& node = m_nodes[index];
+		const float combinedArea = area(combine(node.fatBox, leafBox));
+		const float cost = 2.0f * combinedArea;
+		const float inheritanceCost = 2.0f * (combinedArea - area(node.fatBox));
+
+		auto childCost = [&](int32_t childId)
+			{
+				const Node& child = m_nodes[childId];
+				const float newArea = area(combine(leafBox, child.fatBox));
+				return (child.IsLeaf() ? newArea : newArea - area(child.fatBox)) + inheritanceCost;
+			};
+		const float cost1 = childCost(node.child1);
+		const float cost2 = childCost(node.child2);
+		if (cost < cost1 && cost < cost2)
+			break;
+		index = cost1 < cost2 ? node.child1 : node.child2;
+	}
+
+	const int32_t sibling = index;
+	const int32_t oldParent = m_nodes[sibling].parent;
+	const int32_t newParent = allocateNode();
+	Node& parent = m_nodes[newParent];
+	parent.parent = oldParent;
+	parent.fatBox = combine(leafBox, m_nodes[sibling].fatBox);
+	parent.height = m_nodes[sibling].height + 1;
+	parent.child1 = sibling;
+	parent.child2 = leaf;
+	m_nodes[sibling].parent = newParent;
+	m_nodes[leaf].parent = newParent;
+
+	if (oldParent == NullNode)
+		m_root = newParent;
+	else if (m_nodes[oldParent].child1 == sibling)
+		m_nodes[oldParent].child1 = newParent;
+	else
+		m_nodes[oldParent].child2 = newParent;
+
+	refitAncestors(oldParent);
+}
+//=============================================================================
+void AABBTree::removeLeaf(int32_t leaf)
+{
+	if (leaf == m_root)
+	{
+		m_root = NullNode;
+		return;
+	}
+
+	const int32_t parent = m_nodes[leaf].parent;
+	const int32_t grandParent = m_nodes[parent].parent;
+	const int32_t sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+	if (grandParent == NullNode)
+	{
+		m_root = sibling;
+		m_nodes[sibling].parent = NullNode;
+		freeNode(parent);
+		return;
+	}
+
+	if (m_nodes[grandParent].child1 == parent)
+		m_nodes[grandParent].child1 = sibling;
+	else
+		m_nodes[grandParent].child2 = sibling;
+	m_nodes[sibling].parent = grandParent;
+	freeNode(parent);
+
+	refitAncestors(grandParent);
+}
+//=============================================================================
+void AABBTree::refitAncestors(int32_t nodeId)
+{
+	while (nodeId != NullNode)
+	{
+		Node& node = m_nodes[nodeId];
+		node.fatBox = combine(m_nodes[node.child1].fatBox, m_nodes[node.child2].fatBox);
+		node.height = 1 + std::max(m_nodes[node.child1].height, m_nodes[node.child2].height);
+		rotate(nodeId);
+		nodeId = node.parent;
+	}
+}
+//=============================================================================
+void AABBTree::rotate(int32_t nodeId)
+{
+	// у узла A с детьми B и C внук меняется местами с дядей, если это уменьшает площадь перестроенного ребенка.
+	// Бокс A не меняется - в нем те же листья
+	Node& a = m_nodes[nodeId];
+	const int32_t b = a.child1;
+	const int32_t c = a.child2;
+	Node& nodeB = m_nodes[b];
+	Node& nodeC = m_nodes[c];
+	if (nodeB.IsLeaf() && nodeC.IsLeaf())
+		return;
+
+	enum class Rotation : uint8_t { None, BF, BG, CD, CE };
+	Rotation best = Rotation::None;
+	float bestReduction = 0.0f;
+	auto consider = [&](Rotation rotation, float reduction)
+		{
+			if (reduction > bestReduction)
+			{
+				bestReduction = reduction;
+				best = rotation;
+			}
+		};
+
+	if (!nodeC.IsLeaf())
+	{
+		const float areaC = area(nodeC.fatBox);
+		consider(Rotation::BF, areaC - area(combine(nodeB.fatBox, m_nodes[nodeC.child2].fatBox)));
+		consider(Rotation::BG, areaC - area(combine(m_nodes[nodeC.child1].fatBox, nodeB.fatBox)));
+	}
+	if (!nodeB.IsLeaf())
+	{
+		const float areaB = area(nodeB.fatBox);
+		consider(Rotation::CD, areaB - area(combine(nodeC.fatBox, m_nodes[nodeB.child2].fatBox)));
+		consider(Rotation::CE, areaB - area(combine(m_nodes[nodeB.child1].fatBox, nodeC.fatBox)));
+	}
+
+	// swapped - внук, который поднимается на место дяди; inner - ребенок A, в который уходит дядя
+	auto apply = [&](int32_t uncle, int32_t inner, bool grandChild1)
+		{
+			Node& innerNode = m_nodes[inner];
+			const int32_t swapped = grandChild1 ? innerNode.child1 : innerNode.child2;
+			if (grandChild1) innerNode.child1 = uncle; else innerNode.child2 = uncle;
+			if (a.child1 == uncle) a.child1 = swapped; else a.child2 = swapped;
+			m_nodes[uncle].parent = inner;
+			m_nodes[swapped].parent = nodeId;
+			innerNode.fatBox = combine(m_nodes[innerNode.child1].fatBox, m_nodes[innerNode.child2].fatBox);
+			innerNode.height = 1 + std::max(m_nodes[innerNode.child1].height, m_nodes[innerNode.child2].height);
+			a.height = 1 + std::max(m_nodes[a.child1].height, m_nodes[a.child2].height);
+		};
+
+	switch (best)
+	{
+	case Rotation::None: break;
+	case Rotation::BF: apply(b, c, true); break;
+	case Rotation::BG: apply(b, c, false); break;
+	case Rotation::CD: apply(c, b, true); break;
+	case Rotation::CE: apply(c, b, false); break;
+	default: std::unreachable();
+	}
+}
+//=============================================================================
+int32_t AABBTree::buildRange(std::span<int32_t> leaves)
+{
+	if (leaves.size() == 1)
+		return leaves[0];
+
+	AABB centerBounds;
+	for (const int32_t leaf : leaves)
+		centerBounds.CombinePoint(m_nodes[leaf].box.GetCenter());
+	const glm::vec3 extent = centerBounds.GetSize();
+	const glm::length_t axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+	size_t splitCount = 0;
+	if (extent[axis] > 0.0f)
+	{
+		// SAH по корзинам центров: разрез с минимумом площадь * число листьев слева и справа
+		const float binScale = NumBuildBins / extent[axis];
+		auto binOf = [&](int32_t leaf)
+			{
+				const float offset = (m_nodes[leaf].box.GetCenter()[axis] - centerBounds.min[axis]) * binScale;
+				return std::min(static_cast<uint32_t>(offset), NumBuildBins - 1);
+			};
+
+		std::array<AABB, NumBuildBins> binBoxes;
+		std::array<size_t, NumBuildBins> binCounts{};
+		for (const int32_t leaf : leaves)
+		{
+			const uint32_t bin = binOf(leaf);
+			binBoxes[bin].CombineAABB(m_nodes[leaf].box);
+			binCounts[bin]++;
+		}
+
+		std::array<float, NumBuildBins> rightCost{};
+		AABB rightBox;
+		size_t rightCount = 0;
+		for (uint32_t i = NumBuildBins - 1; i > 0; i--)
+		{
+			rightBox.CombineAABB(binBoxes[i]);
+			rightCount += binCounts[i];
+			rightCost[i] = rightCount ? area(rightBox) * static_cast<float>(rightCount) : 0.0f;
+		}
+
+		float bestCost = std::numeric_limits<float>::max();
+		uint32_t bestSplit = 0;
+		AABB leftBox;
+		size_t leftCount = 0;
+		for (uint32_t i = 1; i < NumBuildBins; i++)
+		{
+			leftBox.CombineAABB(binBoxes[i - 1]);
+			leftCount += binCounts[i - 1];
+			if (leftCount == 0 || leftCount == leaves.size()) continue;
+			const float cost = area(leftBox) * static_cast<float>(leftCount) + rightCost[i];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestSplit = i;
+			}
+		}
+
+		if (bestSplit > 0)
+		{
+			const auto middle = std::partition(leaves.begin(), leaves.end(), [&](int32_t leaf) { return binOf(leaf) < bestSplit; });
+			splitCount = static_cast<size_t>(middle - leaves.begin());
+		}
+	}
+	if (splitCount == 0 || splitCount == leaves.size())
+	{
+		// центры совпадают или все в одной корзине - пополам по медиане
+		splitCount = leaves.size() / 2;
+		std::nth_element(leaves.begin(), leaves.begin() + splitCount, leaves.end(),
+			[&](int32_t l, int32_t r) { return m_nodes[l].box.GetCenter()[axis] < m_nodes[r].box.GetCenter()[axis]; });
+	}
+
+	const int32_t child1 = buildRange(leaves.first(splitCount));
+	const int32_t child2 = buildRange(leaves.subspan(splitCount));
+	const int32_t nodeId = allocateNode();
+	Node& node = m_nodes[nodeId];
+	node.child1 = child1;
+	node.child2 = child2;
+	node.fatBox = combine(m_nodes[child1].fatBox, m_nodes[child2].fatBox);
+	node.height = 1 + std::max(m_nodes[child1].height, m_nodes[child2].height);
+	m_nodes[child1].parent = nodeId;
+	m_nodes[child2].parent = nodeId;
+	return nodeId;
+}
+//=============================================================================
+void AABBTree::collectLeaves(int32_t nodeId, std::vector<uint32_t>& userData) const
+{
+	const Node& node = m_nodes[nodeId];
+	if (node.IsLeaf())
+	{
+		userData.push_back(node.userData);
+		return;
+	}
+	collectLeaves(node.child1, userData);
+	collectLeaves(node.child2, userData);
+}
+//=============================================================================
+void SceneTree::Update(const void* key, uint32_t id, const AABB& worldBox, bool isStatic)
+{
+	if (culling::IsEmpty(worldBox)) return; // не рисуется - удалится в EndUpdate
+
+	auto [it, inserted] = m_objects.try_emplace(key);
+	Object& object = it->second;
+	if (!inserted && object.isStatic != isStatic)
+	{
+		if (object.isStatic)
+		{
+			if (object.proxyId != AABBTree::NullNode) m_staticTree.DestroyProxy(object.proxyId);
+			m_staticVersion++;
+		}
+		else
+			m_dynamicTree.DestroyProxy(object.proxyId);
+		object.proxyId = AABBTree::NullNode;
+	}
+
+	if (isStatic)
+	{
+		// новый или сдвинутый статический объект - дерево соберется заново в EndUpdate
+		if (object.proxyId == AABBTree::NullNode || object.box.min != worldBox.min || object.box.max != worldBox.max)
+			m_staticDirty = true;
+		else
+			m_staticTree.SetUserData(object.proxyId, id);
+	}
+	else if (object.proxyId == AABBTree::NullNode)
+		object.proxyId = m_dynamicTree.CreateProxy(worldBox, id);
+	else
+	{
+		m_dynamicTree.MoveProxy(object.proxyId, worldBox, worldBox.GetCenter() - object.box.GetCenter());
+		m_dynamicTree.SetUserData(object.proxyId, id);
+	}
+
+	object.box = worldBox;
+	object.id = id;
+	object.frame = m_frame;
+	object.isStatic = isStatic;
+}
+//=============================================================================
+void SceneTree::EndUpdate()
+{
+	for (auto it = m_objects.begin(); it != m_objects.end();)
+	{
+		const Object& object = it->second;
+		if (object.frame == m_frame)
+		{
+			++it;
+			continue;
+		}
+
+		if (!object.isStatic)
+			m_dynamicTree.DestroyProxy(object.proxyId);
+		else
+		{
+			if (object.proxyId != AABBTree::NullNode && !m_staticDirty)
+				m_staticTree.DestroyProxy(object.proxyId);
+			m_staticVersion++;
+		}
+		it = m_objects.erase(it);
+	}
+
+	if (m_staticDirty)
+	{
+		std::vector<Object*> statics;
+		std::vector<AABB> boxes;
+		std::vector<uint32_t> ids;
+		for (auto& [key, object] : m_objects)
+		{
+			if (!object.isStatic) continue;
+			statics.push_back(&object);
+			boxes.push_back(object.box);
+			ids.push_back(object.id);
+		}
+
+		std::vector<int32_t> proxies;
+		m_staticTree.Build(boxes, ids, proxies);
+		for (size_t i = 0; i < statics.size(); i++)
+			statics[i]->proxyId = proxies[i];
+		m_staticDirty = false;
+		m_staticVersion++;
+	}
+
+	m_flatCull = m_objects.size() < FlatCullThreshold;
+	m_boxes.Resize(0);
+	if (m_flatCull)
+	{
+		uint32_t maxId = 0;
+		for (const auto& [key, object] : m_objects)
+			maxId = std::max(maxId, object.id);
+		m_boxes.Resize(m_objects.empty() ? 0 : maxId + 1);
+		for (const auto& [key, object] : m_objects)
+			m_boxes.Set(object.id, object.box);
+	}
+
+	m_frame++;
+}
+//=============================================================================
+void SceneTree::Clear()
+{
+	m_objects.clear();
+	m_staticTree.Clear();
+	m_dynamicTree.Clear();
+	m_boxes.Resize(0);
+	m_flatCull = false;
+	m_staticDirty = false;
+	m_staticVersion++;
+}
+//=============================================================================
+void SceneTree::Cull(const Frustum& frustum, std::vector<uint32_t>& visible, CullingView view, SceneObjects objects) const
+{
+	if (m_flatCull && objects == SceneObjects::All)
+	{
+		culling::Cull(frustum, m_boxes, visible, view);
+		return;
+	}
+
+	visible.clear();
+	if (objects != SceneObjects::Dynamic) m_staticTree.QueryFrustum(frustum, visible);
+	if (objects != SceneObjects::Static) m_dynamicTree.QueryFrustum(frustum, visible);
+	finishQuery(visible, view);
+}
+//=============================================================================
+void SceneTree::Cull(const glm::vec3& center, float radius, std::vector<uint32_t>& visible, CullingView view, SceneObjects objects) const
+{
+	if (m_flatCull && objects == SceneObjects::All)
+	{
+		culling::Cull(center, radius, m_boxes, visible, view);
+		return;
+	}
+
+	visible.clear();
+	if (objects != SceneObjects::Dynamic) m_staticTree.QuerySphere(center, radius, visible);
+	if (objects != SceneObjects::Static) m_dynamicTree.QuerySphere(center, radius, visible);
+	finishQuery(visible, view);
+}
+//=============================================================================
+void SceneTree::QueryOverlap(const AABB& box, std::vector<uint32_t>& ids) const
+{
+	ids.clear();
+	m_staticTree.QueryOverlap(box, ids);
+	m_dynamicTree.QueryOverlap(box, ids);
+	std::sort(ids.begin(), ids.end());
+}
+//=============================================================================
+bool SceneTree::RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, uint32_t& hitId, float& hitDistance) const
+{
+	bool hit = false;
+	hitDistance = maxDistance;
+	auto closest = [&](uint32_t id, float distance)
+		{
+			hit = true;
+			hitId = id;
+			hitDistance = distance;
+			return distance; // дальше ищутся только более близкие
+		};
+	m_staticTree.RayCast(origin, direction, hitDistance, closest);
+	m_dynamicTree.RayCast(origin, direction, hitDistance, closest);
+	return hit;
+}
+//=============================================================================
+void SceneTree::finishQuery(std::vector<uint32_t>& visible, CullingView view) const
+{
+	// порядок кадра - проходы рисуют объекты в том же порядке, что без дерева
+	std::sort(visible.begin(), visible.end());
+	culling::AddStats(view, m_objects.size(), visible.size());
+}
+//=============================================================================
@@ -0,0 +1,265 @@
+﻿#include "stdafx.h"
+#include "NanoClusteredLighting.h"
+#include "NanoCore.h"
+#include "NanoLog.h"
+//=============================================================================
+namespace
+{
+	// меньше - распределение в одном потоке, запуск потоков дороже
+	constexpr size_t ParallelMinLights = 64;
+	constexpr size_t InitialLights = 1024;
+	constexpr size_t InitialIndices = 16 * 1024;
+} // namespace
+//=============================================================================
+static_assert(sizeof(ClusteredLight) == 3 * sizeof(glm::vec4));
+//=============================================================================
+ClusteredLight ClusteredLight::Point(const glm::vec3& position, const glm::vec3& color, float range)
+{
+	return { .position = position, .range = range, .color = color };
+}
+//=============================================================================
+ClusteredLight ClusteredLight::Spot(const glm::vec3& position, const glm::vec3& direction, const glm::vec3& color, float range, float cutOff, float outerCutOff)
+{
+	const float scale = 1.0f / std::max(cutOff - outerCutOff, 0.0001f);
+	return { .position = position, .range = range, .color = color, .spotScale = scale, .direction = glm::normalize(direction), .spotOffset = -outerCutOff * scale };
+}
+//=============================================================================
+float ClusteredLight::GetRange(const glm::vec3& color, float cutoff)
+{
+	return std::sqrt(std::max(glm::compMax(color), 0.0f) / cutoff);
+}
+//=============================================================================
+bool LightClusters::Init()
+{
+	GLint maxTexels = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+	m_maxTexels = static_cast<size_t>(maxTexels);
+
+	glGenTextures(1, &m_lightsTexture);
+	glGenTextures(1, &m_clustersTexture);
+	glGenTextures(1, &m_indicesTexture);
+
+	if (!reserveBuffer(m_lightsBuffer, m_lightsTexture, GL_RGBA32F, m_lightsCapacity, InitialLights * sizeof(ClusteredLight)) ||
+		!reserveBuffer(m_clustersBuffer, m_clustersTexture, GL_RG32UI, m_clustersCapacity, NumClusters * sizeof(glm::uvec2)) ||
+		!reserveBuffer(m_indicesBuffer, m_indicesTexture, GL_R16UI, m_indicesCapacity, InitialIndices * sizeof(uint16_t)))
+	{
+		Error("LightClusters: failed to create buffers");
+		return false;
+	}
+
+	m_clusters.assign(NumClusters, glm::uvec2(0));
+	return true;
+}
+//=============================================================================
+void LightClusters::Close()
+{
+	if (m_lightsTexture) glDeleteTextures(1, &m_lightsTexture);
+	if (m_clustersTexture) glDeleteTextures(1, &m_clustersTexture);
+	if (m_indicesTexture) glDeleteTextures(1, &m_indicesTexture);
+	if (m_lightsBuffer.handle) glDeleteBuffers(1, &m_lightsBuffer.handle);
+	if (m_clustersBuffer.handle) glDeleteBuffers(1, &m_clustersBuffer.handle);
+	if (m_indicesBuffer.handle) glDeleteBuffers(1, &m_indicesBuffer.handle);
+	*this = {};
+}
+//=============================================================================
+void LightClusters::Update(std::span<const ClusteredLight> lights, const glm::mat4& view, const glm::mat4& proj, float zNear, float zFar)
+{
+	assert(m_lightsTexture && zNear < FirstSliceDepth && FirstSliceDepth < zFar);
+
+	if (proj != m_proj || zNear != m_zNear || zFar != m_zFar)
+		updateClusterBounds(proj, zNear, zFar);
+
+	m_numLights = std::min({ lights.size(), MaxLights, m_maxTexels / 3 });
+
+	// сферы в пространстве вида и диапазоны срезов. Источник целиком вне глубин вида - пустой диапазон
+	m_viewSpheres.resize(m_numLights);
+	m_lightSlices.resize(m_numLights);
+	for (size_t i = 0; i < m_numLights; i++)
+	{
+		const glm::vec3 center = view * glm::vec4(lights[i].position, 1.0f);
+		const float radius = lights[i].range;
+		const float depth = -center.z;
+		m_viewSpheres[i] = glm::vec4(center, radius);
+		if (depth + radius < zNear || depth - radius > zFar)
+			m_lightSlices[i] = glm::uvec2(1, 0);
+		else
+			m_lightSlices[i] = glm::uvec2(getSlice(std::max(depth - radius, zNear)), getSlice(std::min(depth + radius, zFar)));
+	}
+
+	// срезы независимы - каждый пишет только свои кластеры
+	if (m_numLights >= ParallelMinLights)
+		ParallelFor(GridZ, [this](size_t z) { assignSlice(static_cast<uint32_t>(z)); });
+	else
+	{
+		for (uint32_t z = 0; z < GridZ; z++)
+			assignSlice(z);
+	}
+
+	// списки срезов подряд в одном буфере индексов
+	m_indices.clear();
+	for (uint32_t z = 0; z < GridZ; z++)
+	{
+		const Slice& slice = m_slices[z];
+		const uint32_t base = static_cast<uint32_t>(m_indices.size());
+		for (uint32_t c = 0; c < GridX * GridY; c++)
+		{
+			const uint32_t offset = base + slice.offsets[c];
+			// за пределом буфера текстуры индексы не читаются
+			const uint32_t count = static_cast<uint32_t>(std::min<size_t>(slice.counts[c], m_maxTexels - std::min<size_t>(offset, m_maxTexels)));
+			m_clusters[z * GridX * GridY + c] = glm::uvec2(offset, count);
+		}
+		m_indices.insert(m_indices.end(), slice.indices.begin(), slice.indices.end());
+	}
+	if (m_indices.size() > m_maxTexels)
+		m_indices.resize(m_maxTexels);
+
+	if (!reserveBuffer(m_lightsBuffer, m_lightsTexture, GL_RGBA32F, m_lightsCapacity, m_numLights * sizeof(ClusteredLight)) ||
+		!reserveBuffer(m_indicesBuffer, m_indicesTexture, GL_R16UI, m_indicesCapacity, m_indices.size() * sizeof(uint16_t)))
+	{
+		Error("LightClusters: failed to resize buffers");
+		m_numLights = 0;
+		m_indices.clear();
+		m_clusters.assign(NumClusters, glm::uvec2(0));
+	}
+
+	if (m_numLights > 0)
+		BufferSubData(m_lightsBuffer, BufferTarget::Array, 0, static_cast<GLsizeiptr>(m_numLights * sizeof(ClusteredLight)), lights.data());
+	BufferSubData(m_clustersBuffer, BufferTarget::Array, 0, static_cast<GLsizeiptr>(NumClusters * sizeof(glm::uvec2)), m_clusters.data());
+	if (!m_indices.empty())
+		BufferSubData(m_indicesBuffer, BufferTarget::Array, 0, static_cast<GLsizeiptr>(m_indices.size() * sizeof(uint16_t)), m_indices.data());
+}
+//=============================================================================
+void LightClusters::Bind(unsigned lightsUnit, unsigned clustersUnit, unsigned indicesUnit) const
+{
+	glActiveTexture(GL_TEXTURE0 + lightsUnit);
+	glBindTexture(GL_TEXTURE_BUFFER, m_lightsTexture);
+	glActiveTexture(GL_TEXTURE0 + clustersUnit);
+	glBindTexture(GL_TEXTURE_BUFFER, m_clustersTexture);
+	glActiveTexture(GL_TEXTURE0 + indicesUnit);
+	glBindTexture(GL_TEXTURE_BUFFER, m_indicesTexture);
+}
+//=============================================================================
+void LightClusters::updateClusterBounds(const glm::mat4& proj, float zNear, float zFar)
+{
+	m_proj = proj;
+	m_zNear = zNear;
+	m_zFar = zFar;
+	m_sliceScale = static_cast<float>(GridZ - 1) / std::log(zFar / FirstSliceDepth);
+	m_sliceBias = -std::log(FirstSliceDepth) * m_sliceScale;
+
+	// углы кластера: NDC тайла на ближней и дальней глубине среза
+	m_clusterBounds.resize(NumClusters);
+	for (uint32_t z = 0; z < GridZ; z++)
+	{
+		const float depths[2] = { getSliceDepth(z), getSliceDepth(z + 1) };
+		for (uint32_t y = 0; y < GridY; y++)
+		{
+			const float ndcY[2] = { -1.0f + 2.0f * y / GridY, -1.0f + 2.0f * (y + 1) / GridY };
+			for (uint32_t x = 0; x < GridX; x++)
+			{
+				const float ndcX[2] = { -1.0f + 2.0f * x / GridX, -1.0f + 2.0f * (x + 1) / GridX };
+				glm::vec3 corners[8];
+				for (int i = 0; i < 8; i++)
+				{
+					const float depth = depths[i >> 2];
+					corners[i] = glm::vec3(ndcX[i & 1] * depth / proj[0][0], ndcY[(i >> 1) & 1] * depth / proj[1][1], -depth);
+				}
+				m_clusterBounds[(z * GridY + y) * GridX + x] = AABB(corners, 8);
+			}
+		}
+	}
+}
+//=============================================================================
+float LightClusters::getSliceDepth(uint32_t slice) const
+{
+	// срез 0 - от ближней плоскости до FirstSliceDepth, остальные - геометрическая прогрессия до zFar
+	if (slice == 0) return m_zNear;
+	if (slice == GridZ) return m_zFar;
+	return FirstSliceDepth * std::exp(static_cast<float>(slice - 1) / m_sliceScale);
+}
+//=============================================================================
+uint32_t LightClusters::getSlice(float depth) const
+{
+	if (depth < FirstSliceDepth) return 0;
+	return std::min(static_cast<uint32_t>(std::max(std::log(depth) * m_sliceScale + m_sliceBias, 0.0f)) + 1, GridZ - 1);
+}
+//=============================================================================
+void LightClusters::assignSlice(uint32_t z)
+{
+	Slice& slice = m_slices[z];
+	slice.pairs.clear();
+
+	const float sliceNear = getSliceDepth(z);
+	const float sliceFar = getSliceDepth(z + 1);
+	const float scaleX = m_proj[0][0];
+	const float scaleY = m_proj[1][1];
+
+	for (size_t i = 0; i < m_numLights; i++)
+	{
+		if (z < m_lightSlices[i].x || z > m_lightSlices[i].y) continue;
+
+		const glm::vec4& sphere = m_viewSpheres[i];
+		const float depth = -sphere.z;
+		const float d0 = std::max(depth - sphere.w, sliceNear);
+		const float d1 = std::min(depth + sphere.w, sliceFar);
+		if (d0 > d1) continue;
+
+		// бокс сферы в пределах среза: x/d и y/d крайние на его углах - тайлы экрана, которые он может задеть
+		const float x0 = std::min((sphere.x - sphere.w) / d0, (sphere.x - sphere.w) / d1) * scaleX;
+		const float x1 = std::max((sphere.x + sphere.w) / d0, (sphere.x + sphere.w) / d1) * scaleX;
+		const float y0 = std::min((sphere.y - sphere.w) / d0, (sphere.y - sphere.w) / d1) * scaleY;
+		const float y1 = std::max((sphere.y + sphere.w) / d0, (sphere.y + sphere.w) / d1) * scaleY;
+		if (x1 < -1.0f || x0 > 1.0f || y1 < -1.0f || y0 > 1.0f) continue;
+
+		const int tx0 = std::clamp(static_cast<int>(std::floor((x0 + 1.0f) * 0.5f * GridX)), 0, static_cast<int>(GridX) - 1);
+		const int tx1 = std::clamp(static_cast<int>(std::floor((x1 + 1.0f) * 0.5f * GridX)), 0, static_cast<int>(GridX) - 1);
+		const int ty0 = std::clamp(static_cast<int>(std::floor((y0 + 1.0f) * 0.5f * GridY)), 0, static_cast<int>(GridY) - 1);
+		const int ty1 = std::clamp(static_cast<int>(std::floor((y1 + 1.0f) * 0.5f * GridY)), 0, static_cast<int>(GridY) - 1);
+
+		const glm::vec3 center(sphere);
+		const float radiusSq = sphere.w * sphere.w;
+		for (int ty = ty0; ty <= ty1; ty++)
+		{
+			for (int tx = tx0; tx <= tx1; tx++)
+			{
+				const uint32_t local = static_cast<uint32_t>(ty) * GridX + static_cast<uint32_t>(tx);
+				const AABB& box = m_clusterBounds[z * GridX * GridY + local];
+				const glm::vec3 offset = center - glm::clamp(center, box.min, box.max);
+				if (glm::dot(offset, offset) <= radiusSq)
+					slice.pairs.emplace_back(static_cast<uint16_t>(local), static_cast<uint16_t>(i));
+			}
+		}
+	}
+
+	// сортировка подсчетом по кластеру - индексы кластера подряд, источники в исходном порядке
+	slice.counts.fill(0);
+	for (const auto& pair : slice.pairs)
+		slice.counts[pair.first]++;
+	uint32_t offset = 0;
+	for (uint32_t c = 0; c < GridX * GridY; c++)
+	{
+		slice.offsets[c] = offset;
+		offset += slice.counts[c];
+	}
+	slice.indices.resize(slice.pairs.size());
+	std::array<uint32_t, GridX * GridY> cursor = slice.offsets;
+	for (const auto& pair : slice.pairs)
+		slice.indices[cursor[pair.first]++] = pair.second;
+}
+//=============================================================================
+bool LightClusters::reserveBuffer(BufferHandle& buffer, GLuint texture, GLenum format, size_t& capacity, size_t size)
+{
+	if (buffer.handle && size <= capacity) return true;
+
+	if (buffer.handle) glDeleteBuffers(1, &buffer.handle);
+	capacity = std::max(size, capacity * 2);
+	buffer = CreateBuffer(BufferTarget::Array, BufferUsage::StreamDraw, capacity, nullptr);
+	if (!buffer.handle) return false;
+
+	const GLuint currentTexture = GetCurrentTexture(GL_TEXTURE_BUFFER);
+	glBindTexture(GL_TEXTURE_BUFFER, texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, format, buffer.handle);
+	glBindTexture(GL_TEXTURE_BUFFER, currentTexture);
+	return true;
+}
+//=============================================================================
@@ -0,0 +1,99 @@
+﻿#pragma once
+
+#include "NanoMath.h"
+#include "NanoOpenGL3.h"
+#include "OGLBuffer.h"
+
+// Источник для кластерного освещения, в мировых координатах. В буфере текстуры - три texel RGBA32F на источник
+struct ClusteredLight final
+{
+	glm::vec3 position{ 0.0f };
+	float     range{ 1.0f };      // дальше свет не доходит, затухание сведено к нулю к этой границе
+	glm::vec3 color{ 1.0f };
+	float     spotScale{ 0.0f };  // конус: saturate(dot(-L, direction) * spotScale + spotOffset). Точечный - 0 и 1
+	glm::vec3 direction{ 0.0f, -1.0f, 0.0f };
+	float     spotOffset{ 1.0f };
+
+	static ClusteredLight Point(const glm::vec3& position, const glm::vec3& color, float range);
+	// cutOff/outerCutOff - косинусы внутреннего и внешнего углов
+	static ClusteredLight Spot(const glm::vec3& position, const glm::vec3& direction, const glm::vec3& color, float range, float cutOff, float outerCutOff);
+	// расстояние, на котором освещенность 1/d^2 падает до cutoff
+	static float GetRange(const glm::vec3& color, float cutoff = 0.02f);
+};
+
+// Кластерное прямое освещение: пирамида вида делится на сетку GridX x GridY тайлов экрана и GridZ срезов глубины
+// (первый - до FirstSliceDepth, дальше экспоненциально до zFar). Каждый кадр источники распределяются по кластерам на CPU,
+// срезы - параллельно на всех ядрах. Шейдер по gl_FragCoord и глубине вида находит кластер и перебирает только его источники.
+// В шейдер идут три буфера текстур: источники (samplerBuffer), кластеры - смещение и число индексов (usamplerBuffer RG32UI),
+// индексы источников (usamplerBuffer R16UI). Код выборки - data/shaders/clusteredLights.glsl
+class LightClusters final
+{
+public:
+	static constexpr uint32_t GridX = 16;
+	static constexpr uint32_t GridY = 9;
+	static constexpr uint32_t GridZ = 24;
+	static constexpr uint32_t NumClusters = GridX * GridY * GridZ;
+	static constexpr size_t   MaxLights = 65535; // индекс - 16 бит
+	static constexpr float    FirstSliceDepth = 1.0f;
+
+	bool Init();
+	void Close();
+
+	// проекция - симметричная перспектива, zNear/zFar - ее плоскости. Больше MaxLights - лишние отбрасываются
+	void Update(std::span<const ClusteredLight> lights, const glm::mat4& view, const glm::mat4& proj, float zNear, float zFar);
+
+	// источники, кластеры и индексы в текстурные блоки lightsUnit, clustersUnit, indicesUnit
+	void Bind(unsigned lightsUnit, unsigned clustersUnit, unsigned indicesUnit) const;
+
+	// uniform clusterDepthParams: глубина первого среза, масштаб и смещение log(глубины) для номера среза
+	glm::vec3 GetDepthParams() const { return glm::vec3(FirstSliceDepth, m_sliceScale, m_sliceBias); }
+	// uniform clusterTileScale: тайлов на пиксель
+	static glm::vec2 GetTileScale(uint16_t width, uint16_t height) { return glm::vec2(GridX / static_cast<float>(width), GridY / static_cast<float>(height)); }
+
+	size_t GetNumLights() const { return m_numLights; }
+	size_t GetNumLightIndices() const { return m_indices.size(); }
+
+private:
+	// индексы одного среза: пары (кластер в срезе, источник), затем отсортированы по кластеру
+	struct Slice final
+	{
+		std::vector<std::pair<uint16_t, uint16_t>> pairs;
+		std::vector<uint16_t>                      indices;
+		std::array<uint32_t, GridX * GridY>        offsets;
+		std::array<uint32_t, GridX * GridY>        counts;
+	};
+
+	void updateClusterBounds(const glm::mat4& proj, float zNear, float zFar);
+	float getSliceDepth(uint32_t slice) const;
+	uint32_t getSlice(float depth) const;
+	void assignSlice(uint32_t z);
+	// буфер не меньше size байт, при пересоздании заново привязывается к текстуре
+	bool reserveBuffer(BufferHandle& buffer, GLuint texture, GLenum format, size_t& capacity, size_t size);
+
+	BufferHandle                m_lightsBuffer{};
+	BufferHandle                m_clustersBuffer{};
+	BufferHandle                m_indicesBuffer{};
+	GLuint                      m_lightsTexture{ 0 };
+	GLuint                      m_clustersTexture{ 0 };
+	GLuint                      m_indicesTexture{ 0 };
+	size_t                      m_lightsCapacity{ 0 };
+	size_t                      m_clustersCapacity{ 0 };
+	size_t                      m_indicesCapacity{ 0 };
+	size_t                      m_maxTexels{ 0 };
+
+	// границы кластеров в пространстве вида, пересчитываются при смене проекции
+	glm::mat4                   m_proj{ 0.0f };
+	float                       m_zNear{ 0.0f };
+	float                       m_zFar{ 0.0f };
+	float                       m_sliceScale{ 0.0f };
+	float                       m_sliceBias{ 0.0f };
+	std::vector<AABB>           m_clusterBounds;
+
+	// кадр: сферы источников в пространстве вида и их срезы
+	std::vector<glm::vec4>      m_viewSpheres;
+	std::vector<glm::uvec2>     m_lightSlices;
+	std::array<Slice, GridZ>    m_slices;
+	std::vector<glm::uvec2>     m_clusters; // смещение и число индексов
+	std::vector<uint16_t>       m_indices;
+	size_t                      m_numLights{ 0 };
+};
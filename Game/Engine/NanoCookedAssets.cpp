@@ -0,0 +1,522 @@
+﻿#include "stdafx.h"
+#include "NanoCookedAssets.h"
+#include "NanoLog.h"
+#include "NanoIO.h"
+//=============================================================================
+namespace
+{
+	constexpr uint32_t MakeFourCC(char a, char b, char c, char d)
+	{
+		return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) | (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+	}
+
+	// при изменении раскладки поднимать версию - старые файлы будут отвергнуты и перепечены
+	constexpr uint32_t ModelMagic = MakeFourCC('N', 'M', 'S', 'H');
+	constexpr uint32_t ModelVersion = 2;
+	constexpr uint32_t TextureMagic = MakeFourCC('N', 'T', 'E', 'X');
+	constexpr uint32_t TextureVersion = 3;
+	constexpr uint32_t TileMagic = MakeFourCC('N', 'T', 'I', 'L');
+	constexpr uint32_t TileVersion = 2;
+
+	struct CookedFormat final
+	{
+		uint32_t         magic;
+		uint32_t         version;
+		std::string_view settings;
+	};
+	constexpr CookedFormat CookedFormats[] = {
+		{ ModelMagic,   ModelVersion,   cooked::ModelSettings },
+		{ TextureMagic, TextureVersion, cooked::TextureSettings },
+		{ TileMagic,    TileVersion,    cooked::TileSettings },
+	};
+	//-------------------------------------------------------------------------
+	class BinaryWriter final
+	{
+	public:
+		template<typename T>
+		void Write(const T& value)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			WriteBytes(&value, sizeof(T));
+		}
+		template<typename T>
+		void WriteArray(std::span<const T> values)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			Write(static_cast<uint64_t>(values.size()));
+			WriteBytes(values.data(), values.size_bytes());
+		}
+		void WriteString(std::string_view str)
+		{
+			WriteArray(std::span<const char>(str.data(), str.size()));
+		}
+		void WriteBytes(const void* data, size_t size)
+		{
+			const auto* bytes = static_cast<const uint8_t*>(data);
+			m_data.insert(m_data.end(), bytes, bytes + size);
+		}
+
+		// пишет во временный файл и переименовывает, чтобы прерванная запись не оставила битый файл
+		bool Save(const std::string& fileName) const
+		{
+			const std::string tempName = fileName + ".tmp";
+			{
+				std::ofstream file(tempName, std::ios::binary | std::ios::trunc);
+				if (!file.is_open())
+				{
+					Error("Failed to create file: " + tempName);
+					return false;
+				}
+				file.write(reinterpret_cast<const char*>(m_data.data()), static_cast<std::streamsize>(m_data.size()));
+				if (!file.good())
+				{
+					Error("Failed to write file: " + tempName);
+					return false;
+				}
+			}
+			std::error_code ec;
+			std::filesystem::rename(tempName, fileName, ec);
+			if (ec)
+			{
+				Error("Failed to rename " + tempName + ": " + ec.message());
+				std::filesystem::remove(tempName, ec);
+				return false;
+			}
+			return true;
+		}
+
+	private:
+		std::vector<uint8_t> m_data;
+	};
+	//-------------------------------------------------------------------------
+	class BinaryReader final
+	{
+	public:
+		explicit BinaryReader(std::span<const uint8_t> data) : m_data(data) {}
+
+		template<typename T>
+		bool Read(T& value)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			return ReadBytes(&value, sizeof(T));
+		}
+		template<typename T>
+		bool ReadArray(std::vector<T>& values)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			uint64_t count = 0;
+			if (!Read(count) || count > (m_data.size() - m_offset) / sizeof(T))
+				return false;
+			values.resize(static_cast<size_t>(count));
+			return ReadBytes(values.data(), values.size() * sizeof(T));
+		}
+		bool ReadString(std::string& str)
+		{
+			uint64_t count = 0;
+			if (!Read(count) || count > m_data.size() - m_offset)
+				return false;
+			str.assign(reinterpret_cast<const char*>(m_data.data() + m_offset), static_cast<size_t>(count));
+			m_offset += static_cast<size_t>(count);
+			return true;
+		}
+		bool ReadBytes(void* data, size_t size)
+		{
+			if (size > m_data.size() - m_offset)
+				return false;
+			if (size > 0) std::memcpy(data, m_data.data() + m_offset, size);
+			m_offset += size;
+			return true;
+		}
+
+		// пропускает байтовый массив, не читая его - страницы отображенного файла не подгружаются
+		bool SkipArray(size_t expectedCount)
+		{
+			uint64_t count = 0;
+			if (!Read(count) || count != expectedCount || count > m_data.size() - m_offset)
+				return false;
+			m_offset += static_cast<size_t>(count);
+			return true;
+		}
+
+		// каждый элемент занимает хотя бы байт - защита от огромных счетчиков в битом файле
+		bool ReadCount(uint32_t& count)
+		{
+			return Read(count) && count <= m_data.size() - m_offset;
+		}
+
+		bool ReadHeader(uint32_t magic, uint32_t version)
+		{
+			uint32_t fileMagic = 0, fileVersion = 0;
+			return Read(fileMagic) && Read(fileVersion) && fileMagic == magic && fileVersion == version;
+		}
+
+	private:
+		std::span<const uint8_t> m_data;
+		size_t                   m_offset{ 0 };
+	};
+	//-------------------------------------------------------------------------
+	int64_t getWriteTime(const std::filesystem::path& path)
+	{
+		std::error_code ec;
+		const auto time = std::filesystem::last_write_time(path, ec);
+		return ec ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+	}
+	//-------------------------------------------------------------------------
+	void writeSource(BinaryWriter& writer, const CookedSource& source)
+	{
+		writer.Write(source.settingsHash);
+		writer.Write(static_cast<uint32_t>(source.dependencies.size()));
+		for (const auto& dependency : source.dependencies)
+		{
+			writer.WriteString(dependency.path);
+			writer.Write(dependency.hash);
+			writer.Write(dependency.size);
+			writer.Write(dependency.writeTime);
+		}
+	}
+	//-------------------------------------------------------------------------
+	bool readSource(BinaryReader& reader, CookedSource& source)
+	{
+		uint32_t count = 0;
+		bool ok = reader.Read(source.settingsHash) && reader.ReadCount(count);
+		if (ok) source.dependencies.resize(count);
+		for (size_t i = 0; ok && i < source.dependencies.size(); i++)
+		{
+			CookedDependency& dependency = source.dependencies[i];
+			ok = reader.ReadString(dependency.path)
+				&& reader.Read(dependency.hash)
+				&& reader.Read(dependency.size)
+				&& reader.Read(dependency.writeTime);
+		}
+		return ok;
+	}
+	//-------------------------------------------------------------------------
+	bool isDependencyUpToDate(const CookedDependency& dependency, const std::filesystem::path& directory)
+	{
+		const std::filesystem::path path = directory / dependency.path;
+		std::error_code ec;
+		const uintmax_t size = std::filesystem::file_size(path, ec);
+		if (ec || size != dependency.size)
+			return false;
+		// хеш всего файла - только если время записи поменялось (checkout, копирование)
+		return getWriteTime(path) == dependency.writeTime || cooked::HashFile(path) == dependency.hash;
+	}
+	//-------------------------------------------------------------------------
+	void writeMeshData(BinaryWriter& writer, const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices)
+	{
+		writer.WriteArray(std::span<const MeshVertex>(vertices));
+		writer.WriteArray(std::span<const uint32_t>(indices));
+	}
+	//-------------------------------------------------------------------------
+	bool readMeshData(BinaryReader& reader, std::vector<MeshVertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		if (!reader.ReadArray(vertices) || !reader.ReadArray(indices))
+			return false;
+		for (uint32_t index : indices)
+		{
+			if (index >= vertices.size())
+				return false;
+		}
+		return true;
+	}
+} // namespace
+//=============================================================================
+std::string cooked::GetCookedPath(const std::string& sourcePath, std::string_view extension)
+{
+	return sourcePath + std::string(extension);
+}
+//=============================================================================
+uint64_t cooked::HashBytes(std::span<const uint8_t> data, uint64_t seed) noexcept
+{
+	constexpr uint64_t Prime = 1099511628211ull;
+	uint64_t hash = seed;
+	for (uint8_t byte : data)
+	{
+		hash ^= byte;
+		hash *= Prime;
+	}
+	return hash;
+}
+//=============================================================================
+uint64_t cooked::HashString(std::string_view str, uint64_t seed) noexcept
+{
+	return HashBytes({ reinterpret_cast<const uint8_t*>(str.data()), str.size() }, seed);
+}
+//=============================================================================
+uint64_t cooked::HashFile(const std::filesystem::path& path)
+{
+	std::error_code ec;
+	if (!std::filesystem::is_regular_file(path, ec))
+		return 0;
+	if (std::filesystem::file_size(path, ec) == 0)
+		return HashBytes({});
+
+	io::MappedFile file;
+	if (!file.Open(path))
+		return 0;
+	return HashBytes(file.GetData());
+}
+//=============================================================================
+CookedDependency cooked::MakeDependency(const std::string& fileName, const std::string& sourcePath)
+{
+	const std::filesystem::path path = std::filesystem::path(fileName).lexically_normal();
+	const std::filesystem::path directory = std::filesystem::path(sourcePath).lexically_normal().parent_path();
+
+	CookedDependency dependency;
+	dependency.path = (directory.empty() ? path : path.lexically_relative(directory)).generic_string();
+	if (dependency.path.empty()) dependency.path = path.generic_string(); // другой диск - путь как есть
+
+	std::error_code ec;
+	const uintmax_t size = std::filesystem::file_size(path, ec);
+	dependency.size = ec ? 0 : static_cast<uint64_t>(size);
+	dependency.writeTime = getWriteTime(path);
+	dependency.hash = HashFile(path);
+	return dependency;
+}
+//=============================================================================
+bool cooked::IsUpToDate(const std::string& sourcePath, const std::string& cookedPath)
+{
+	std::error_code ec;
+	if (!std::filesystem::is_regular_file(cookedPath, ec))
+		return false;
+	if (!std::filesystem::is_regular_file(sourcePath, ec))
+		return true; // исходника может и не быть - тогда берется запеченный
+
+	io::MappedFile file;
+	if (!file.Open(cookedPath))
+		return false;
+
+	// заголовок одинаковый у всех форматов, данные дальше не читаются
+	BinaryReader reader(file.GetData());
+	uint32_t magic = 0, version = 0;
+	if (!reader.Read(magic) || !reader.Read(version))
+		return false;
+	const auto format = std::find_if(std::begin(CookedFormats), std::end(CookedFormats), [&](const CookedFormat& f) { return f.magic == magic; });
+	if (format == std::end(CookedFormats) || format->version != version)
+		return false;
+
+	CookedSource source;
+	if (!readSource(reader, source) || source.dependencies.empty() || source.settingsHash != HashString(format->settings))
+		return false;
+
+	const std::filesystem::path directory = std::filesystem::path(sourcePath).parent_path();
+	return std::all_of(source.dependencies.begin(), source.dependencies.end(), [&](const CookedDependency& dependency) { return isDependencyUpToDate(dependency, directory); });
+}
+//=============================================================================
+bool cooked::SaveModel(const std::string& fileName, const CookedModel& model, const CookedSource& source)
+{
+	BinaryWriter writer;
+	writer.Write(ModelMagic);
+	writer.Write(ModelVersion);
+	writeSource(writer, source);
+
+	writer.Write(static_cast<uint32_t>(model.embeddedTextures.size()));
+	for (const auto& texture : model.embeddedTextures)
+		writer.WriteArray(std::span<const uint8_t>(texture));
+
+	writer.Write(static_cast<uint32_t>(model.materials.size()));
+	for (const auto& material : model.materials)
+	{
+		writer.Write(material.ambientColor);
+		writer.Write(material.diffuseColor);
+		writer.Write(material.specularColor);
+		writer.Write(material.opacity);
+		writer.Write(material.shininess);
+		for (const auto& texture : material.textures)
+			writer.WriteString(texture);
+	}
+
+	writer.Write(static_cast<uint32_t>(model.meshes.size()));
+	for (const auto& mesh : model.meshes)
+	{
+		writer.Write(static_cast<int32_t>(mesh.materialId));
+		writeMeshData(writer, mesh.vertices, mesh.indices);
+	}
+
+	return writer.Save(fileName);
+}
+//=============================================================================
+bool cooked::LoadModel(const std::string& fileName, CookedModel& outModel)
+{
+	outModel = {};
+
+	io::MappedFile file;
+	if (!file.Open(fileName))
+		return false;
+
+	BinaryReader reader(file.GetData());
+	CookedSource source;
+	if (!reader.ReadHeader(ModelMagic, ModelVersion) || !readSource(reader, source))
+	{
+		Warning("Cooked model has unknown format or version: " + fileName);
+		return false;
+	}
+
+	uint32_t count = 0;
+	bool ok = reader.ReadCount(count);
+	if (ok) outModel.embeddedTextures.resize(count);
+	for (size_t i = 0; ok && i < outModel.embeddedTextures.size(); i++)
+		ok = reader.ReadArray(outModel.embeddedTextures[i]);
+
+	ok = ok && reader.ReadCount(count);
+	if (ok) outModel.materials.resize(count);
+	for (size_t i = 0; ok && i < outModel.materials.size(); i++)
+	{
+		CookedMaterial& material = outModel.materials[i];
+		ok = reader.Read(material.ambientColor)
+			&& reader.Read(material.diffuseColor)
+			&& reader.Read(material.specularColor)
+			&& reader.Read(material.opacity)
+			&& reader.Read(material.shininess);
+		for (size_t t = 0; ok && t < material.textures.size(); t++)
+			ok = reader.ReadString(material.textures[t]);
+	}
+
+	ok = ok && reader.ReadCount(count);
+	if (ok) outModel.meshes.resize(count);
+	for (size_t i = 0; ok && i < outModel.meshes.size(); i++)
+	{
+		CookedMesh& mesh = outModel.meshes[i];
+		int32_t materialId = -1;
+		ok = reader.Read(materialId) && readMeshData(reader, mesh.vertices, mesh.indices)
+			&& materialId >= -1 && materialId < static_cast<int32_t>(outModel.materials.size());
+		mesh.materialId = materialId;
+	}
+
+	if (!ok)
+	{
+		Error("Cooked model is corrupted: " + fileName);
+		outModel = {};
+	}
+	return ok;
+}
+//=============================================================================
+bool cooked::SaveTexture(const std::string& fileName, const CookedTexture& texture, const CookedSource& source)
+{
+	assert(texture.components >= 1 && texture.components <= 4);
+	assert(!texture.mips.empty());
+
+	BinaryWriter writer;
+	writer.Write(TextureMagic);
+	writer.Write(TextureVersion);
+	writeSource(writer, source);
+	writer.Write(texture.width);
+	writer.Write(texture.height);
+	writer.Write(texture.components);
+	writer.Write(static_cast<uint32_t>(texture.colorSpace));
+	writer.Write(static_cast<uint32_t>(texture.format));
+	writer.Write(static_cast<uint32_t>(texture.mips.size()));
+	for (const auto& mip : texture.mips)
+		writer.WriteArray(std::span<const uint8_t>(mip));
+
+	return writer.Save(fileName);
+}
+//=============================================================================
+bool cooked::LoadTexture(const std::string& fileName, CookedTexture& outTexture, uint32_t firstMip, uint32_t lastMip)
+{
+	outTexture = {};
+
+	io::MappedFile file;
+	if (!file.Open(fileName))
+		return false;
+
+	BinaryReader reader(file.GetData());
+	CookedSource source;
+	if (!reader.ReadHeader(TextureMagic, TextureVersion) || !readSource(reader, source))
+	{
+		Warning("Cooked texture has unknown format or version: " + fileName);
+		return false;
+	}
+
+	uint32_t colorSpace = 0, format = 0, numMips = 0;
+	bool ok = reader.Read(outTexture.width)
+		&& reader.Read(outTexture.height)
+		&& reader.Read(outTexture.components)
+		&& reader.Read(colorSpace)
+		&& reader.Read(format)
+		&& reader.Read(numMips)
+		&& outTexture.width > 0 && outTexture.height > 0
+		&& outTexture.components >= 1 && outTexture.components <= 4
+		&& format <= static_cast<uint32_t>(BlockFormat::BC7)
+		&& numMips > 0 && numMips <= 32;
+	outTexture.colorSpace = (colorSpace == static_cast<uint32_t>(ColorSpace::sRGB)) ? ColorSpace::sRGB : ColorSpace::Linear;
+	outTexture.format = static_cast<BlockFormat>(format);
+
+	if (ok) outTexture.mips.resize(numMips);
+	uint32_t width = outTexture.width, height = outTexture.height;
+	for (size_t i = 0; ok && i < outTexture.mips.size(); i++)
+	{
+		const size_t mipSize = (outTexture.format == BlockFormat::None)
+			? size_t(width) * height * outTexture.components
+			: bcn::GetCompressedSize(outTexture.format, width, height);
+		if (i >= firstMip && i <= lastMip)
+			ok = reader.ReadArray(outTexture.mips[i]) && outTexture.mips[i].size() == mipSize;
+		else
+			ok = reader.SkipArray(mipSize);
+		width = std::max(1u, width / 2);
+		height = std::max(1u, height / 2);
+	}
+
+	if (!ok)
+	{
+		Error("Cooked texture is corrupted: " + fileName);
+		outTexture = {};
+	}
+	return ok;
+}
+//=============================================================================
+bool cooked::SaveObjData(const std::string& fileName, const ObjData& data, const CookedSource& source)
+{
+	BinaryWriter writer;
+	writer.Write(TileMagic);
+	writer.Write(TileVersion);
+	writeSource(writer, source);
+
+	writer.Write(static_cast<uint32_t>(data.groups.size()));
+	for (const auto& group : data.groups)
+	{
+		writer.WriteString(group.objectName);
+		writer.Write(static_cast<int32_t>(group.materialId));
+		writeMeshData(writer, group.mesh.vertices, group.mesh.indices);
+	}
+
+	return writer.Save(fileName);
+}
+//=============================================================================
+bool cooked::LoadObjData(const std::string& fileName, ObjData& outData)
+{
+	outData = {};
+
+	io::MappedFile file;
+	if (!file.Open(fileName))
+		return false;
+
+	BinaryReader reader(file.GetData());
+	CookedSource source;
+	if (!reader.ReadHeader(TileMagic, TileVersion) || !readSource(reader, source))
+	{
+		Warning("Cooked tile has unknown format or version: " + fileName);
+		return false;
+	}
+
+	uint32_t count = 0;
+	bool ok = reader.ReadCount(count);
+	if (ok) outData.groups.resize(count);
+	for (size_t i = 0; ok && i < outData.groups.size(); i++)
+	{
+		ObjGroup& group = outData.groups[i];
+		int32_t materialId = -1;
+		ok = reader.ReadString(group.objectName)
+			&& reader.Read(materialId)
+			&& readMeshData(reader, group.mesh.vertices, group.mesh.indices);
+		group.materialId = materialId;
+	}
+
+	if (!ok)
+	{
+		Error("Cooked tile is corrupted: " + fileName);
+		outData = {};
+	}
+	return ok;
+}
+//=============================================================================
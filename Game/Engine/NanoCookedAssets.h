@@ -0,0 +1,109 @@
+﻿#pragma once
+
+#include "NanoObjLoader.h"
+#include "NanoTextureCompression.h"
+
+// Бинарные форматы, которые пишет AssetCooker. Лежат рядом с исходником: "model.obj" -> "model.obj.nmesh"
+
+enum class CookedTextureSlot : uint8_t
+{
+	Diffuse,
+	Specular,
+	Normal,
+	Shininess,
+	Emission,
+	Opacity,
+	MetallicRoughness,
+	AO,
+	Count
+};
+
+struct CookedMaterial final
+{
+	glm::vec3 ambientColor{ 1.0f };
+	glm::vec3 diffuseColor{ 1.0f };
+	glm::vec3 specularColor{ 1.0f };
+	float     opacity{ 1.0f };
+	float     shininess{ 64.0f };
+
+	// путь относительно каталога модели или "*N" - встроенная текстура N из CookedModel::embeddedTextures
+	std::array<std::string, static_cast<size_t>(CookedTextureSlot::Count)> textures;
+};
+
+struct CookedMesh final
+{
+	std::vector<MeshVertex> vertices;
+	std::vector<uint32_t>   indices;
+	int                     materialId{ -1 }; // индекс в CookedModel::materials
+};
+
+struct CookedModel final
+{
+	std::vector<CookedMesh>           meshes;
+	std::vector<CookedMaterial>       materials;
+	std::vector<std::vector<uint8_t>> embeddedTextures; // png/jpg как были в исходнике
+};
+
+struct CookedTexture final
+{
+	uint32_t   width{ 0 };
+	uint32_t   height{ 0 };
+	uint32_t    components{ 0 }; // 1-4, как у stbi_load
+	ColorSpace  colorSpace{ ColorSpace::Linear }; // в каком пространстве считались мипы
+	BlockFormat format{ BlockFormat::None };
+	std::vector<std::vector<uint8_t>> mips; // от самого большого, плотно упакованы пиксели или блоки 4x4
+};
+
+// файл, из которого запекался ассет
+struct CookedDependency final
+{
+	std::string path;          // относительно каталога исходника
+	uint64_t    hash{ 0 };     // HashFile
+	uint64_t    size{ 0 };
+	int64_t     writeTime{ 0 }; // размер и время записи совпали - файл не перечитывается для хеша
+};
+
+// заголовок каждого запеченного файла: с чем и из чего он запекался
+struct CookedSource final
+{
+	uint64_t                      settingsHash{ 0 }; // HashString(настройки типа ассета)
+	std::vector<CookedDependency> dependencies;      // первая - сам исходник
+};
+
+namespace cooked
+{
+	constexpr std::string_view ModelExtension = ".nmesh";
+	constexpr std::string_view TextureExtension = ".ntex";
+	constexpr std::string_view TileExtension = ".ntile";
+
+	// все, что влияет на результат запекания, кроме содержимого файлов. При изменении кода запекания или соглашений импорта менять
+	// строку - запеченные файлы со старой будут отвергнуты и перепечены
+	constexpr std::string_view ModelSettings = "model v2: obj(flipV, normals, tangents), assimp(Model::Load flags), meshopt vcache+vfetch";
+	constexpr std::string_view TextureSettings = "texture v4: kaiser mips in linear space (noise/lut box), alpha coverage for cutouts, srgb and usage from materials (by name otherwise), bcn (normal BC5, 1ch BC4, srgb BC7, linear BC1/BC3, noise/lut raw)";
+	constexpr std::string_view TileSettings = "tile v2: obj(no materials)";
+
+	// FNV-1a 64
+	uint64_t HashBytes(std::span<const uint8_t> data, uint64_t seed = 14695981039346656037ull) noexcept;
+	uint64_t HashString(std::string_view str, uint64_t seed = 14695981039346656037ull) noexcept;
+	// 0 если файл не открылся
+	uint64_t HashFile(const std::filesystem::path& path);
+
+	// путь в зависимости - относительно каталога sourcePath
+	CookedDependency MakeDependency(const std::string& fileName, const std::string& sourcePath);
+
+	std::string GetCookedPath(const std::string& sourcePath, std::string_view extension);
+	// запеченный файл есть, запекался с текущими настройками, а исходник и остальные зависимости из его заголовка не изменились.
+	// Без исходника берется запеченный
+	bool IsUpToDate(const std::string& sourcePath, const std::string& cookedPath);
+
+	bool SaveModel(const std::string& fileName, const CookedModel& model, const CookedSource& source);
+	bool LoadModel(const std::string& fileName, CookedModel& outModel);
+
+	bool SaveTexture(const std::string& fileName, const CookedTexture& texture, const CookedSource& source);
+	// мипы вне [firstMip, lastMip] остаются пустыми - для потоковой подгрузки. firstMip больше числа мипов - только заголовок
+	bool LoadTexture(const std::string& fileName, CookedTexture& outTexture, uint32_t firstMip = 0, uint32_t lastMip = std::numeric_limits<uint32_t>::max());
+
+	// заготовки блоков тайлов Game3 - группы obj без материалов
+	bool SaveObjData(const std::string& fileName, const ObjData& data, const CookedSource& source);
+	bool LoadObjData(const std::string& fileName, ObjData& outData);
+} // namespace cooked
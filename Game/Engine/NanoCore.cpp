@@ -1,2 +1,127 @@
 ﻿#include "stdafx.h"
-#include "NanoCore.h"
\ No newline at end of file
+#include "NanoCore.h"
+//=============================================================================
+namespace
+{
+	thread_local bool isWorkerThread = false;
+	//-------------------------------------------------------------------------
+	// Постоянные потоки для ParallelFor. Вызывающий поток работает вместе с ними, поэтому потоков на один меньше ядер
+	class WorkerPool final
+	{
+	public:
+		WorkerPool()
+		{
+			const unsigned numWorkers = std::max(1u, std::thread::hardware_concurrency()) - 1;
+			m_threads.reserve(numWorkers);
+			for (unsigned t = 0; t < numWorkers; t++)
+				m_threads.emplace_back([this]() { workerLoop(); });
+		}
+		~WorkerPool()
+		{
+			{
+				std::lock_guard lock(m_mutex);
+				m_stop = true;
+			}
+			m_wake.notify_all();
+			for (auto& thread : m_threads)
+				thread.join();
+		}
+
+		size_t GetNumWorkers() const noexcept { return m_threads.size(); }
+
+		// false - пул занят другим вызовом
+		bool Run(size_t count, const std::function<void(size_t)>& func)
+		{
+			std::unique_lock runLock(m_runMutex, std::try_to_lock);
+			if (!runLock.owns_lock())
+				return false;
+
+			Job job{ .func = &func, .count = count };
+			{
+				std::lock_guard lock(m_mutex);
+				m_job = &job;
+				m_generation++;
+			}
+			m_wake.notify_all();
+
+			execute(job);
+
+			// задание снимается только когда присоединившиеся потоки из него вышли
+			std::unique_lock lock(m_mutex);
+			m_done.wait(lock, [&]() { return job.numActive == 0; });
+			m_job = nullptr;
+			return true;
+		}
+
+	private:
+		struct Job final
+		{
+			const std::function<void(size_t)>* func{ nullptr };
+			size_t                             count{ 0 };
+			std::atomic<size_t>                next{ 0 };
+			size_t                             numActive{ 0 }; // под m_mutex
+		};
+
+		static void execute(Job& job)
+		{
+			for (size_t i = job.next++; i < job.count; i = job.next++)
+				(*job.func)(i);
+		}
+
+		void workerLoop()
+		{
+			isWorkerThread = true;
+			uint64_t generation = 0;
+			while (true)
+			{
+				Job* job = nullptr;
+				{
+					std::unique_lock lock(m_mutex);
+					m_wake.wait(lock, [&]() { return m_stop || (m_job && m_generation != generation); });
+					if (m_stop) return;
+					generation = m_generation;
+					job = m_job;
+					job->numActive++;
+				}
+
+				execute(*job);
+
+				{
+					std::lock_guard lock(m_mutex);
+					if (--job->numActive == 0)
+						m_done.notify_one();
+				}
+			}
+		}
+
+		std::vector<std::thread> m_threads;
+		std::mutex               m_runMutex; // одно задание за раз
+		std::mutex               m_mutex;
+		std::condition_variable  m_wake;
+		std::condition_variable  m_done;
+		Job*                     m_job{ nullptr };
+		uint64_t                 m_generation{ 0 };
+		bool                     m_stop{ false };
+	};
+	//-------------------------------------------------------------------------
+	WorkerPool& getWorkerPool()
+	{
+		static WorkerPool pool;
+		return pool;
+	}
+} // namespace
+//=============================================================================
+void ParallelFor(size_t count, const std::function<void(size_t)>& func)
+{
+	if (count > 1 && !isWorkerThread && getWorkerPool().GetNumWorkers() > 0 && getWorkerPool().Run(count, func))
+		return;
+
+	for (size_t i = 0; i < count; i++)
+		func(i);
+}
+//=============================================================================
+void MarkWorkerThread() noexcept
+{
+	isWorkerThread = true;
+}
+//=============================================================================
@@ -44,4 +44,11 @@ struct Hash<std::tuple<TT...>>
 		HashValueImpl<std::tuple<TT...>>::Apply(seed, tt);
 		return seed;
 	}
-};
\ No newline at end of file
+};
+
+// Вызывает func(i) для i из [0, count) на всех ядрах. Возвращается когда все вызовы завершены.
+// Потоки общего пула создаются при первом вызове и живут до выхода. Из рабочего потока (пула или помеченного MarkWorkerThread)
+// и пока пул занят другим вызовом цикл выполняется последовательно в вызывающем потоке
+void ParallelFor(size_t count, const std::function<void(size_t)>& func);
+// для своих потоков, которые уже заняли все ядра (AssetCooker): вложенные ParallelFor в них не распараллеливаются
+void MarkWorkerThread() noexcept;
\ No newline at end of file
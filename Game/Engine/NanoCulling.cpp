@@ -0,0 +1,378 @@
+﻿#include "stdafx.h"
+#include "NanoCulling.h"
+//=============================================================================
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#	include <emmintrin.h>
+#	define NANO_CULL_SSE2 1
+#endif
+#if defined(__AVX2__)
+#	include <immintrin.h>
+#	define NANO_CULL_AVX2 1
+#endif
+//=============================================================================
+namespace
+{
+	constexpr float EmptyExtent = -std::numeric_limits<float>::max(); // не -inf: 0 * -inf дало бы NaN в тесте плоскости
+
+	std::array<CullingStats, 3> stats;
+	std::vector<uint32_t> maskScratch;
+	//-------------------------------------------------------------------------
+	void maskToIndices(const std::vector<uint32_t>& mask, size_t count, std::vector<uint32_t>& indices)
+	{
+		indices.clear();
+		for (size_t word = 0; word < mask.size(); word++)
+		{
+			for (uint32_t bits = mask[word]; bits; bits &= bits - 1)
+			{
+				const size_t id = word * 32 + static_cast<size_t>(std::countr_zero(bits));
+				if (id < count)
+					indices.push_back(static_cast<uint32_t>(id));
+			}
+		}
+	}
+	//-------------------------------------------------------------------------
+	// плоскости и центр/половина AABB углов пирамиды - то, что нужно ядрам теста
+	struct FrustumTestData final
+	{
+		std::array<glm::vec4, Frustum::NumPlanes> planes;
+		std::array<glm::vec3, Frustum::NumPlanes> absNormals;
+		glm::vec3 boundsCenter;
+		glm::vec3 boundsExtent;
+	};
+	//-------------------------------------------------------------------------
+	FrustumTestData getTestData(const Frustum& frustum)
+	{
+		FrustumTestData data;
+		for (size_t p = 0; p < Frustum::NumPlanes; p++)
+		{
+			data.planes[p] = frustum.GetPlane(p);
+			data.absNormals[p] = glm::abs(glm::vec3(data.planes[p]));
+		}
+		data.boundsCenter = frustum.GetBounds().GetCenter();
+		data.boundsExtent = frustum.GetBounds().GetSize() * 0.5f;
+		return data;
+	}
+#if !NANO_CULL_SSE2
+	//-------------------------------------------------------------------------
+	// бокс снаружи плоскости, если снаружи ее p-вершина: dot(n, c) + dot(|n|, e) + w < 0
+	uint32_t testFrustumScalar(const FrustumTestData& data, const AABBBatch& boxes, size_t i)
+	{
+		const glm::vec3 c(boxes.GetCenter(0)[i], boxes.GetCenter(1)[i], boxes.GetCenter(2)[i]);
+		const glm::vec3 e(boxes.GetExtent(0)[i], boxes.GetExtent(1)[i], boxes.GetExtent(2)[i]);
+		for (size_t p = 0; p < Frustum::NumPlanes; p++)
+		{
+			if (glm::dot(glm::vec3(data.planes[p]), c) + glm::dot(data.absNormals[p], e) + data.planes[p].w < 0.0f)
+				return 0;
+		}
+		const glm::vec3 d = glm::abs(c - data.boundsCenter);
+		const glm::vec3 r = e + data.boundsExtent;
+		return (d.x <= r.x && d.y <= r.y && d.z <= r.z) ? 1u : 0u;
+	}
+	//-------------------------------------------------------------------------
+	uint32_t testSphereScalar(const glm::vec3& center, float radiusSquared, const AABBBatch& boxes, size_t i)
+	{
+		const glm::vec3 c(boxes.GetCenter(0)[i], boxes.GetCenter(1)[i], boxes.GetCenter(2)[i]);
+		const glm::vec3 e(boxes.GetExtent(0)[i], boxes.GetExtent(1)[i], boxes.GetExtent(2)[i]);
+		const glm::vec3 d = glm::max(glm::abs(c - center) - e, glm::vec3(0.0f));
+		return glm::dot(d, d) <= radiusSquared ? 1u : 0u;
+	}
+#endif
+	//-------------------------------------------------------------------------
+#if NANO_CULL_SSE2
+	inline __m128 absSSE(__m128 v)
+	{
+		return _mm_and_ps(v, _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff)));
+	}
+#endif
+#if NANO_CULL_SSE2 && !NANO_CULL_AVX2
+	//-------------------------------------------------------------------------
+	// 4 бокса: 4 бита видимости
+	uint32_t testFrustumSSE(const FrustumTestData& data, const AABBBatch& boxes, size_t i)
+	{
+		const __m128 cx = _mm_loadu_ps(boxes.GetCenter(0) + i);
+		const __m128 cy = _mm_loadu_ps(boxes.GetCenter(1) + i);
+		const __m128 cz = _mm_loadu_ps(boxes.GetCenter(2) + i);
+		const __m128 ex = _mm_loadu_ps(boxes.GetExtent(0) + i);
+		const __m128 ey = _mm_loadu_ps(boxes.GetExtent(1) + i);
+		const __m128 ez = _mm_loadu_ps(boxes.GetExtent(2) + i);
+
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (size_t p = 0; p < Frustum::NumPlanes; p++)
+		{
+			const glm::vec4& plane = data.planes[p];
+			const glm::vec3& absNormal = data.absNormals[p];
+			__m128 d = _mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane.x)), _mm_set1_ps(plane.w));
+			d = _mm_add_ps(d, _mm_mul_ps(cy, _mm_set1_ps(plane.y)));
+			d = _mm_add_ps(d, _mm_mul_ps(cz, _mm_set1_ps(plane.z)));
+			d = _mm_add_ps(d, _mm_mul_ps(ex, _mm_set1_ps(absNormal.x)));
+			d = _mm_add_ps(d, _mm_mul_ps(ey, _mm_set1_ps(absNormal.y)));
+			d = _mm_add_ps(d, _mm_mul_ps(ez, _mm_set1_ps(absNormal.z)));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(d, _mm_setzero_ps()));
+		}
+		inside = _mm_and_ps(inside, _mm_cmple_ps(absSSE(_mm_sub_ps(cx, _mm_set1_ps(data.boundsCenter.x))), _mm_add_ps(ex, _mm_set1_ps(data.boundsExtent.x))));
+		inside = _mm_and_ps(inside, _mm_cmple_ps(absSSE(_mm_sub_ps(cy, _mm_set1_ps(data.boundsCenter.y))), _mm_add_ps(ey, _mm_set1_ps(data.boundsExtent.y))));
+		inside = _mm_and_ps(inside, _mm_cmple_ps(absSSE(_mm_sub_ps(cz, _mm_set1_ps(data.boundsCenter.z))), _mm_add_ps(ez, _mm_set1_ps(data.boundsExtent.z))));
+		return static_cast<uint32_t>(_mm_movemask_ps(inside));
+	}
+	//-------------------------------------------------------------------------
+	uint32_t testSphereSSE(const glm::vec3& center, float radiusSquared, const AABBBatch& boxes, size_t i)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 dx = _mm_max_ps(_mm_sub_ps(absSSE(_mm_sub_ps(_mm_loadu_ps(boxes.GetCenter(0) + i), _mm_set1_ps(center.x))), _mm_loadu_ps(boxes.GetExtent(0) + i)), zero);
+		const __m128 dy = _mm_max_ps(_mm_sub_ps(absSSE(_mm_sub_ps(_mm_loadu_ps(boxes.GetCenter(1) + i), _mm_set1_ps(center.y))), _mm_loadu_ps(boxes.GetExtent(1) + i)), zero);
+		const __m128 dz = _mm_max_ps(_mm_sub_ps(absSSE(_mm_sub_ps(_mm_loadu_ps(boxes.GetCenter(2) + i), _mm_set1_ps(center.z))), _mm_loadu_ps(boxes.GetExtent(2) + i)), zero);
+		const __m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(distanceSquared, _mm_set1_ps(radiusSquared))));
+	}
+#endif
+	//-------------------------------------------------------------------------
+#if NANO_CULL_AVX2
+	inline __m256 absAVX(__m256 v)
+	{
+		return _mm256_and_ps(v, _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff)));
+	}
+	//-------------------------------------------------------------------------
+	// 8 боксов: 8 бит видимости
+	uint32_t testFrustumAVX(const FrustumTestData& data, const AABBBatch& boxes, size_t i)
+	{
+		const __m256 cx = _mm256_loadu_ps(boxes.GetCenter(0) + i);
+		const __m256 cy = _mm256_loadu_ps(boxes.GetCenter(1) + i);
+		const __m256 cz = _mm256_loadu_ps(boxes.GetCenter(2) + i);
+		const __m256 ex = _mm256_loadu_ps(boxes.GetExtent(0) + i);
+		const __m256 ey = _mm256_loadu_ps(boxes.GetExtent(1) + i);
+		const __m256 ez = _mm256_loadu_ps(boxes.GetExtent(2) + i);
+
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (size_t p = 0; p < Frustum::NumPlanes; p++)
+		{
+			const glm::vec4& plane = data.planes[p];
+			const glm::vec3& absNormal = data.absNormals[p];
+			__m256 d = _mm256_add_ps(_mm256_mul_ps(cx, _mm256_set1_ps(plane.x)), _mm256_set1_ps(plane.w));
+			d = _mm256_add_ps(d, _mm256_mul_ps(cy, _mm256_set1_ps(plane.y)));
+			d = _mm256_add_ps(d, _mm256_mul_ps(cz, _mm256_set1_ps(plane.z)));
+			d = _mm256_add_ps(d, _mm256_mul_ps(ex, _mm256_set1_ps(absNormal.x)));
+			d = _mm256_add_ps(d, _mm256_mul_ps(ey, _mm256_set1_ps(absNormal.y)));
+			d = _mm256_add_ps(d, _mm256_mul_ps(ez, _mm256_set1_ps(absNormal.z)));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_GE_OQ));
+		}
+		inside = _mm256_and_ps(inside, _mm256_cmp_ps(absAVX(_mm256_sub_ps(cx, _mm256_set1_ps(data.boundsCenter.x))), _mm256_add_ps(ex, _mm256_set1_ps(data.boundsExtent.x)), _CMP_LE_OQ));
+		inside = _mm256_and_ps(inside, _mm256_cmp_ps(absAVX(_mm256_sub_ps(cy, _mm256_set1_ps(data.boundsCenter.y))), _mm256_add_ps(ey, _mm256_set1_ps(data.boundsExtent.y)), _CMP_LE_OQ));
+		inside = _mm256_and_ps(inside, _mm256_cmp_ps(absAVX(_mm256_sub_ps(cz, _mm256_set1_ps(data.boundsCenter.z))), _mm256_add_ps(ez, _mm256_set1_ps(data.boundsExtent.z)), _CMP_LE_OQ));
+		return static_cast<uint32_t>(_mm256_movemask_ps(inside));
+	}
+	//-------------------------------------------------------------------------
+	uint32_t testSphereAVX(const glm::vec3& center, float radiusSquared, const AABBBatch& boxes, size_t i)
+	{
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 dx = _mm256_max_ps(_mm256_sub_ps(absAVX(_mm256_sub_ps(_mm256_loadu_ps(boxes.GetCenter(0) + i), _mm256_set1_ps(center.x))), _mm256_loadu_ps(boxes.GetExtent(0) + i)), zero);
+		const __m256 dy = _mm256_max_ps(_mm256_sub_ps(absAVX(_mm256_sub_ps(_mm256_loadu_ps(boxes.GetCenter(1) + i), _mm256_set1_ps(center.y))), _mm256_loadu_ps(boxes.GetExtent(1) + i)), zero);
+		const __m256 dz = _mm256_max_ps(_mm256_sub_ps(absAVX(_mm256_sub_ps(_mm256_loadu_ps(boxes.GetCenter(2) + i), _mm256_set1_ps(center.z))), _mm256_loadu_ps(boxes.GetExtent(2) + i)), zero);
+		const __m256 distanceSquared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+		return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(distanceSquared, _mm256_set1_ps(radiusSquared), _CMP_LE_OQ)));
+	}
+#endif
+} // namespace
+//=============================================================================
+void Frustum::Set(const glm::mat4& viewProj)
+{
+	GetFrustumPlanes(viewProj, m_planes.data());
+	for (auto& plane : m_planes)
+		plane /= glm::length(glm::vec3(plane));
+
+	glm::vec4 corners[8];
+	GetFrustumCorners(viewProj, corners);
+	m_bounds = AABB();
+	for (const auto& corner : corners)
+		m_bounds.CombinePoint(glm::vec3(corner));
+}
+//=============================================================================
+bool Frustum::IsVisible(const AABB& box) const
+{
+	// p-вершина: угол бокса, дальше всех по нормали плоскости. Если и он снаружи - снаружи весь бокс
+	for (const auto& plane : m_planes)
+	{
+		const glm::vec3 p{
+			plane.x >= 0.0f ? box.max.x : box.min.x,
+			plane.y >= 0.0f ? box.max.y : box.min.y,
+			plane.z >= 0.0f ? box.max.z : box.min.z };
+		if (glm::dot(glm::vec3(plane), p) + plane.w < 0.0f)
+			return false;
+	}
+
+	return box.max.x >= m_bounds.min.x && box.min.x <= m_bounds.max.x
+		&& box.max.y >= m_bounds.min.y && box.min.y <= m_bounds.max.y
+		&& box.max.z >= m_bounds.min.z && box.min.z <= m_bounds.max.z;
+}
+//=============================================================================
+bool Frustum::IsVisible(const glm::vec3& center, float radius) const
+{
+	for (const auto& plane : m_planes)
+	{
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+			return false;
+	}
+	return true;
+}
+//=============================================================================
+void AABBBatch::Resize(size_t count)
+{
+	for (size_t i = count; i < m_size; i++)
+		SetEmpty(i);
+
+	const size_t paddedCount = (count + BatchWidth - 1) / BatchWidth * BatchWidth;
+	for (size_t axis = 0; axis < 3; axis++)
+	{
+		m_center[axis].resize(paddedCount, 0.0f);
+		m_extent[axis].resize(paddedCount, EmptyExtent);
+	}
+	m_size = count;
+}
+//=============================================================================
+void AABBBatch::Set(size_t id, const AABB& localBox, const glm::mat4& transform)
+{
+	if (culling::IsEmpty(localBox))
+	{
+		SetEmpty(id);
+		return;
+	}
+
+	const glm::vec3 localCenter = localBox.GetCenter();
+	const glm::vec3 localExtent = localBox.GetSize() * 0.5f;
+	alignas(16) float center[4], extent[4];
+#if NANO_CULL_SSE2
+	const __m128 column0 = _mm_loadu_ps(&transform[0][0]);
+	const __m128 column1 = _mm_loadu_ps(&transform[1][0]);
+	const __m128 column2 = _mm_loadu_ps(&transform[2][0]);
+	const __m128 column3 = _mm_loadu_ps(&transform[3][0]);
+	__m128 c = _mm_add_ps(_mm_mul_ps(column0, _mm_set1_ps(localCenter.x)), column3);
+	c = _mm_add_ps(c, _mm_mul_ps(column1, _mm_set1_ps(localCenter.y)));
+	c = _mm_add_ps(c, _mm_mul_ps(column2, _mm_set1_ps(localCenter.z)));
+	__m128 e = _mm_mul_ps(absSSE(column0), _mm_set1_ps(localExtent.x));
+	e = _mm_add_ps(e, _mm_mul_ps(absSSE(column1), _mm_set1_ps(localExtent.y)));
+	e = _mm_add_ps(e, _mm_mul_ps(absSSE(column2), _mm_set1_ps(localExtent.z)));
+	_mm_store_ps(center, c);
+	_mm_store_ps(extent, e);
+#else
+	const glm::vec3 c = glm::vec3(transform * glm::vec4(localCenter, 1.0f));
+	const glm::vec3 e = glm::mat3(glm::abs(glm::vec3(transform[0])), glm::abs(glm::vec3(transform[1])), glm::abs(glm::vec3(transform[2]))) * localExtent;
+	for (glm::length_t axis = 0; axis < 3; axis++)
+	{
+		center[axis] = c[axis];
+		extent[axis] = e[axis];
+	}
+#endif
+	if (m_extent[0][id] < 0.0f) m_numValid++;
+	for (size_t axis = 0; axis < 3; axis++)
+	{
+		m_center[axis][id] = center[axis];
+		m_extent[axis][id] = extent[axis];
+	}
+}
+//=============================================================================
+void AABBBatch::Set(size_t id, const AABB& worldBox)
+{
+	if (culling::IsEmpty(worldBox))
+	{
+		SetEmpty(id);
+		return;
+	}
+
+	const glm::vec3 center = worldBox.GetCenter();
+	const glm::vec3 extent = worldBox.GetSize() * 0.5f;
+	if (m_extent[0][id] < 0.0f) m_numValid++;
+	for (glm::length_t axis = 0; axis < 3; axis++)
+	{
+		m_center[axis][id] = center[axis];
+		m_extent[axis][id] = extent[axis];
+	}
+}
+//=============================================================================
+void AABBBatch::SetEmpty(size_t id)
+{
+	if (m_extent[0][id] >= 0.0f) m_numValid--;
+	for (size_t axis = 0; axis < 3; axis++)
+	{
+		m_center[axis][id] = 0.0f;
+		m_extent[axis][id] = EmptyExtent;
+	}
+}
+//=============================================================================
+AABB AABBBatch::Get(size_t id) const
+{
+	if (m_extent[0][id] < 0.0f) return AABB();
+
+	const glm::vec3 center(m_center[0][id], m_center[1][id], m_center[2][id]);
+	const glm::vec3 extent(m_extent[0][id], m_extent[1][id], m_extent[2][id]);
+	return AABB(center - extent, center + extent);
+}
+//=============================================================================
+void culling::TestFrustum(const Frustum& frustum, const AABBBatch& boxes, std::vector<uint32_t>& mask)
+{
+	const FrustumTestData data = getTestData(frustum);
+	mask.assign((boxes.GetSize() + 31) / 32, 0u);
+	for (size_t i = 0; i < boxes.GetSize(); i += AABBBatch::BatchWidth)
+	{
+#if NANO_CULL_AVX2
+		const uint32_t bits = testFrustumAVX(data, boxes, i);
+#elif NANO_CULL_SSE2
+		const uint32_t bits = testFrustumSSE(data, boxes, i) | (testFrustumSSE(data, boxes, i + 4) << 4);
+#else
+		uint32_t bits = 0;
+		for (size_t j = 0; j < AABBBatch::BatchWidth; j++)
+			bits |= testFrustumScalar(data, boxes, i + j) << j;
+#endif
+		mask[i / 32] |= bits << (i % 32);
+	}
+}
+//=============================================================================
+void culling::TestSphere(const glm::vec3& center, float radius, const AABBBatch& boxes, std::vector<uint32_t>& mask)
+{
+	const float radiusSquared = radius * radius;
+	mask.assign((boxes.GetSize() + 31) / 32, 0u);
+	for (size_t i = 0; i < boxes.GetSize(); i += AABBBatch::BatchWidth)
+	{
+#if NANO_CULL_AVX2
+		const uint32_t bits = testSphereAVX(center, radiusSquared, boxes, i);
+#elif NANO_CULL_SSE2
+		const uint32_t bits = testSphereSSE(center, radiusSquared, boxes, i) | (testSphereSSE(center, radiusSquared, boxes, i + 4) << 4);
+#else
+		uint32_t bits = 0;
+		for (size_t j = 0; j < AABBBatch::BatchWidth; j++)
+			bits |= testSphereScalar(center, radiusSquared, boxes, i + j) << j;
+#endif
+		mask[i / 32] |= bits << (i % 32);
+	}
+}
+//=============================================================================
+void culling::Cull(const Frustum& frustum, const AABBBatch& worldBoxes, std::vector<uint32_t>& visible, CullingView view)
+{
+	TestFrustum(frustum, worldBoxes, maskScratch);
+	maskToIndices(maskScratch, worldBoxes.GetSize(), visible);
+	AddStats(view, worldBoxes.GetNumValid(), visible.size());
+}
+//=============================================================================
+void culling::Cull(const glm::vec3& center, float radius, const AABBBatch& worldBoxes, std::vector<uint32_t>& visible, CullingView view)
+{
+	TestSphere(center, radius, worldBoxes, maskScratch);
+	maskToIndices(maskScratch, worldBoxes.GetSize(), visible);
+	AddStats(view, worldBoxes.GetNumValid(), visible.size());
+}
+//=============================================================================
+void culling::AddStats(CullingView view, size_t numTested, size_t numVisible)
+{
+	CullingStats& viewStats = stats[static_cast<size_t>(view)];
+	viewStats.numViews++;
+	viewStats.numTested += numTested;
+	viewStats.numVisible += numVisible;
+}
+//=============================================================================
+void culling::ResetStats()
+{
+	stats.fill({});
+}
+//=============================================================================
+const CullingStats& culling::GetStats(CullingView view)
+{
+	return stats[static_cast<size_t>(view)];
+}
+//=============================================================================
@@ -0,0 +1,91 @@
+﻿#pragma once
+
+#include "NanoMath.h"
+
+// Усеченная пирамида вида. Плоскости из viewProj (Gribb/Hartmann), нормализованы, нормали смотрят внутрь
+class Frustum final
+{
+public:
+	enum Plane : uint8_t { Left, Right, Bottom, Top, Near, Far, NumPlanes };
+
+	Frustum() = default;
+	explicit Frustum(const glm::mat4& viewProj) { Set(viewProj); }
+
+	void Set(const glm::mat4& viewProj);
+
+	// консервативно: false - бокс точно вне пирамиды
+	bool IsVisible(const AABB& box) const;
+	bool IsVisible(const glm::vec3& center, float radius) const;
+
+	const glm::vec4& GetPlane(size_t id) const { return m_planes[id]; }
+	const AABB& GetBounds() const { return m_bounds; }
+
+private:
+	std::array<glm::vec4, NumPlanes> m_planes;
+	AABB                             m_bounds; // AABB углов пирамиды - отсекает большие боксы у ребер, которые проходят тест плоскостей
+};
+
+// Мировые боксы в SoA (центр и половина размера отдельными массивами по осям) для пакетных тестов.
+// Массивы дополнены пустыми боксами до кратного BatchWidth, ядра работают без хвостов
+class AABBBatch final
+{
+public:
+	static constexpr size_t BatchWidth = 8; // ширина AVX2
+
+	void Resize(size_t count);
+
+	// Arvo (SSE): центр переносится матрицей, половина размера - модулем ее 3x3 части
+	void Set(size_t id, const AABB& localBox, const glm::mat4& transform);
+	void Set(size_t id, const AABB& worldBox);
+	// пустой бокс не проходит ни один тест и не считается в статистике (скрытый объект, нет модели)
+	void SetEmpty(size_t id);
+	AABB Get(size_t id) const;
+
+	size_t GetSize() const { return m_size; }
+	size_t GetNumValid() const { return m_numValid; }
+
+	const float* GetCenter(size_t axis) const { return m_center[axis].data(); }
+	const float* GetExtent(size_t axis) const { return m_extent[axis].data(); }
+
+private:
+	size_t                            m_size{ 0 };
+	size_t                            m_numValid{ 0 };
+	std::array<std::vector<float>, 3> m_center;
+	std::array<std::vector<float>, 3> m_extent; // у пустых -FLT_MAX
+};
+
+enum class CullingView : uint8_t
+{
+	Camera,
+	Shadow,
+	Occlusion // объекты, прошедшие пирамиду камеры, против программного буфера глубины
+};
+
+// счетчики за текущий кадр по всем видам одного типа, для оверлея
+struct CullingStats final
+{
+	size_t numViews{ 0 };
+	size_t numTested{ 0 };
+	size_t numVisible{ 0 };
+};
+
+namespace culling
+{
+	// пустой бокс (min > max) - объект не рисуется (скрыт, нет модели) и не проверяется
+	inline bool IsEmpty(const AABB& box) { return box.min.x > box.max.x; }
+
+	// бит i в mask[i / 32] - бокс i пересекает пирамиду (6 плоскостей и AABB ее углов). SSE по 4 бокса, AVX2 по 8
+	void TestFrustum(const Frustum& frustum, const AABBBatch& boxes, std::vector<uint32_t>& mask);
+	// бит i - бокс i пересекает сферу
+	void TestSphere(const glm::vec3& center, float radius, const AABBBatch& boxes, std::vector<uint32_t>& mask);
+
+	// worldBoxes - мировые AABB всех объектов сцены (Model::GetAABB * modelMat), считаются один раз на кадр и общие для всех видов.
+	// В visible пишутся индексы прошедших проверку по возрастанию
+	void Cull(const Frustum& frustum, const AABBBatch& worldBoxes, std::vector<uint32_t>& visible, CullingView view);
+	// сфера влияния источника без направления (точечный свет)
+	void Cull(const glm::vec3& center, float radius, const AABBBatch& worldBoxes, std::vector<uint32_t>& visible, CullingView view);
+
+	void AddStats(CullingView view, size_t numTested, size_t numVisible);
+	void ResetStats();
+	const CullingStats& GetStats(CullingView view);
+} // namespace culling
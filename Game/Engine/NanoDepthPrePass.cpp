@@ -0,0 +1,43 @@
+﻿#include "stdafx.h"
+#include "NanoDepthPrePass.h"
+//=============================================================================
+void DepthPrePassSelector::Init(DepthPrePassMode mode)
+{
+	m_samples.Init(GL_SAMPLES_PASSED);
+	SetMode(mode);
+}
+//=============================================================================
+void DepthPrePassSelector::Close()
+{
+	m_samples.Close();
+	*this = {};
+}
+//=============================================================================
+void DepthPrePassSelector::SetMode(DepthPrePassMode mode)
+{
+	m_mode = mode;
+	m_enabled = mode == DepthPrePassMode::On;
+}
+//=============================================================================
+bool DepthPrePassSelector::IsEnabled()
+{
+	if (m_mode != DepthPrePassMode::Auto)
+		return m_mode == DepthPrePassMode::On;
+
+	// запас между порогами - проход не переключается каждый кадр около одного значения
+	if (m_overdraw > EnableOverdraw)
+		m_enabled = true;
+	else if (m_overdraw > 0.0 && m_overdraw < DisableOverdraw)
+		m_enabled = false;
+	return m_enabled;
+}
+//=============================================================================
+void DepthPrePassSelector::EndMeasure(uint32_t numPixels)
+{
+	m_samples.End();
+	// результат и размер кадра - из одного из прошлых кадров, при смене размера погрешность на несколько кадров
+	if (m_samples.HasResult() && m_numPixels > 0)
+		m_overdraw = static_cast<double>(m_samples.GetResult()) / static_cast<double>(m_numPixels);
+	m_numPixels = numPixels;
+}
+//=============================================================================
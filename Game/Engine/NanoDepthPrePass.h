@@ -0,0 +1,45 @@
+﻿#pragma once
+
+#include "NanoGPUTimer.h"
+
+// Предварительный проход глубины: сначала только глубина (позиции и альфа-тест), затем основной проход с GL_EQUAL
+// без записи глубины - дорогое освещение считается один раз на пиксель. Выгоден при большой перерисовке,
+// иначе только удваивает работу с вершинами
+enum class DepthPrePassMode : uint8_t
+{
+	Off,
+	On,
+	Auto // по измеренной перерисовке
+};
+
+// Решение о проходе на кадр. Перерисовка - фрагменты, прошедшие тест глубины в первом проходе с записью глубины
+// (предварительном или основном), на пиксель кадра, по запросу GL_SAMPLES_PASSED с задержкой в несколько кадров.
+// В Auto проход включается выше EnableOverdraw и выключается ниже DisableOverdraw
+class DepthPrePassSelector final
+{
+public:
+	static constexpr double EnableOverdraw = 1.5;
+	static constexpr double DisableOverdraw = 1.2;
+
+	void Init(DepthPrePassMode mode = DepthPrePassMode::Auto);
+	void Close();
+
+	void SetMode(DepthPrePassMode mode);
+	DepthPrePassMode GetMode() const { return m_mode; }
+
+	// вызывать раз в кадр до прохода
+	bool IsEnabled();
+
+	// вокруг первого прохода с записью глубины
+	void BeginMeasure() { m_samples.Begin(); }
+	void EndMeasure(uint32_t numPixels);
+	// 0 - еще не измерена
+	double GetOverdraw() const { return m_overdraw; }
+
+private:
+	GPUQueryRing     m_samples;
+	DepthPrePassMode m_mode{ DepthPrePassMode::Auto };
+	uint32_t         m_numPixels{ 0 };
+	double           m_overdraw{ 0.0 };
+	bool             m_enabled{ false };
+};
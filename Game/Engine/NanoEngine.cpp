@@ -50,6 +50,8 @@ bool engine::Init(uint16_t width, uint16_t height, std::string_view title)
 
 	if (!textures::Init())
 		return false;
+	if (!fullscreenQuad::Init())
+		return false;
 
 	deltaTime = 0.0f;
 	previousTime = std::chrono::high_resolution_clock::now();
@@ -59,6 +61,8 @@ bool engine::Init(uint16_t width, uint16_t height, std::string_view title)
 //=============================================================================
 void engine::Close() noexcept
 {
+	fullscreenQuad::Close();
+	models::Close();
 	textures::Close();
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplRgfw_Shutdown();
@@ -93,6 +97,10 @@ void engine::BeginFrame()
 		}
 	}
 
+	// мипы, запрошенные рендером прошлого кадра
+	textures::UpdateStreaming();
+	culling::ResetStats();
+
 	// Start a new ImGUi frame
 	ImGui_ImplOpenGL3_NewFrame();
 	ImGui_ImplRgfw_NewFrame();
@@ -113,6 +121,9 @@ void engine::EndFrame()
 
 	window::Swap();
 	input::Update();
+
+	// модели, которые за кадр отпустили все объекты
+	models::ReleaseUnused();
 }
 //=============================================================================
 void engine::DrawFPS()
@@ -122,13 +133,32 @@ void engine::DrawFPS()
 		ImGui::SetNextWindowPos({ v->WorkPos.x + v->WorkSize.x - 15.0f, v->WorkPos.y + 15.0f }, ImGuiCond_Always, { 1.0f, 0.0f });
 	}
 	ImGui::SetNextWindowBgAlpha(0.30f);
-	ImGui::SetNextWindowSize(ImVec2(ImGui::CalcTextSize("FPS : _______").x, 0));
+	ImGui::SetNextWindowSize(ImVec2(ImGui::CalcTextSize("Tex : ______/______ MB").x, 0));
 	if (ImGui::Begin("##FPS", nullptr,
 		ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings |
 		ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav | ImGuiWindowFlags_NoMove))
 	{
 		ImGui::Text("FPS : %i", (int)framesPerSecond);
 		ImGui::Text("Ms  : %.1f", framesPerSecond > 0 ? 1000.0 / framesPerSecond : 0);
+		const TextureMemoryStats textureStats = textures::GetMemoryStats();
+		ImGui::Text("Tex : %zu/%zu MB", textureStats.residentBytes >> 20, textureStats.budgetBytes >> 20);
+		if (textureStats.numStreaming > 0)
+			ImGui::Text("Strm: %zu", textureStats.numStreaming);
+		// видимо/отсечено за кадр, тени - сумма по всем видам источников
+		const CullingStats& cameraStats = culling::GetStats(CullingView::Camera);
+		const CullingStats& shadowStats = culling::GetStats(CullingView::Shadow);
+		const CullingStats& occlusionStats = culling::GetStats(CullingView::Occlusion);
+		if (cameraStats.numViews > 0)
+			ImGui::Text("Cam : %zu/%zu cull", cameraStats.numVisible, cameraStats.numTested - cameraStats.numVisible);
+		if (shadowStats.numViews > 0)
+			ImGui::Text("Shdw: %zu/%zu cull", shadowStats.numVisible, shadowStats.numTested - shadowStats.numVisible);
+		if (occlusionStats.numViews > 0)
+			ImGui::Text("Occl: %zu/%zu cull", occlusionStats.numVisible, occlusionStats.numTested - occlusionStats.numVisible);
+		for (const GPUTimer* timer : gpuTimers::GetTimers())
+		{
+			if (timer->HasResult())
+				ImGui::Text("%s: %.2f ms", timer->GetName().c_str(), timer->GetTimeMs());
+		}
 	}
 	ImGui::End();
 }
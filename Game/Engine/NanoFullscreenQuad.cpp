@@ -0,0 +1,56 @@
+﻿#include "stdafx.h"
+#include "NanoFullscreenQuad.h"
+#include "NanoLog.h"
+#include "OGLBuffer.h"
+#include "OGLVertexAttribute.h"
+//=============================================================================
+namespace
+{
+	GLuint       vao{ 0 };
+	BufferHandle vbo{ 0 };
+} // namespace
+//=============================================================================
+bool fullscreenQuad::Init()
+{
+	const QuadVertex vertices[] = {
+		{glm::vec2(-1.0f,  1.0f), glm::vec2(0.0f, 1.0f)},
+		{glm::vec2(-1.0f, -1.0f), glm::vec2(0.0f, 0.0f)},
+		{glm::vec2( 1.0f, -1.0f), glm::vec2(1.0f, 0.0f)},
+		{glm::vec2( 1.0f, -1.0f), glm::vec2(1.0f, 0.0f)},
+		{glm::vec2( 1.0f,  1.0f), glm::vec2(1.0f, 1.0f)},
+		{glm::vec2(-1.0f,  1.0f), glm::vec2(0.0f, 1.0f)},
+	};
+
+	GLuint currentVBO = GetCurrentBuffer(BufferTarget::Array);
+	vbo = CreateBuffer(BufferTarget::Array, BufferUsage::StaticDraw, sizeof(vertices), vertices);
+	glBindBuffer(GL_ARRAY_BUFFER, currentVBO);
+	if (!vbo.handle)
+	{
+		Error("Failed to create fullscreen quad buffer");
+		return false;
+	}
+
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo.handle);
+	QuadVertex::SetVertexAttributes();
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, currentVBO);
+
+	return true;
+}
+//=============================================================================
+void fullscreenQuad::Close()
+{
+	glDeleteVertexArrays(1, &vao);
+	glDeleteBuffers(1, &vbo.handle);
+	vao = 0;
+	vbo = {};
+}
+//=============================================================================
+void fullscreenQuad::Draw()
+{
+	glBindVertexArray(vao);
+	glDrawArrays(GL_TRIANGLES, 0, 6);
+}
+//=============================================================================
@@ -0,0 +1,14 @@
+﻿#pragma once
+
+#include "NanoOpenGL3.h"
+
+// Общий для проходов постобработки полноэкранный квад: QuadVertex, позиция - атрибут 0, uv - атрибут 1.
+// Создается в engine::Init
+namespace fullscreenQuad
+{
+	bool Init();
+	void Close();
+
+	// программа и цель уже установлены
+	void Draw();
+} // namespace fullscreenQuad
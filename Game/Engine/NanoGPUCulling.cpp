@@ -0,0 +1,201 @@
+﻿#include "stdafx.h"
+#include "NanoGPUCulling.h"
+#include "NanoLog.h"
+#include "OGLContext.h"
+//=============================================================================
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#	define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_QUERY_BUFFER
+#	define GL_QUERY_BUFFER 0x9192
+#endif
+//=============================================================================
+namespace
+{
+	// DrawElementsIndirectCommand. DrawArraysIndirectCommand (count, instanceCount, first, baseInstance) читает из нее первые 16 байт
+	struct DrawCommand final
+	{
+		uint32_t count;
+		uint32_t instanceCount;
+		uint32_t firstIndex;
+		int32_t  baseVertex;
+		uint32_t baseInstance;
+	};
+
+	constexpr const char* FeedbackVaryings[] = { "outColumn0", "outColumn1", "outColumn2", "outColumn3" };
+} // namespace
+//=============================================================================
+bool GPUInstanceCulling::Init(size_t maxInstances)
+{
+	assert(maxInstances > 0);
+
+	// матрица - 4 texel буфера текстуры. Гарантировано GL 3.3 только 65536 texel
+	GLint maxTexels = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+	if (maxInstances * 4 > static_cast<size_t>(maxTexels))
+	{
+		Warning("GPUInstanceCulling: max instances limited to " + std::to_string(maxTexels / 4));
+		maxInstances = static_cast<size_t>(maxTexels / 4);
+	}
+	m_maxInstances = maxInstances;
+
+	m_program = LoadTransformFeedbackProgram("data/shaders/gpuCulling/vertex.glsl", "data/shaders/gpuCulling/geometry.glsl", FeedbackVaryings);
+	if (!m_program.handle)
+	{
+		Error("GPU culling shader failed!");
+		return false;
+	}
+	m_frustumPlanesId = GetUniformLocation(m_program, "frustumPlanes");
+	m_localSphereId = GetUniformLocation(m_program, "localSphere");
+	assert(m_frustumPlanesId > -1 && m_localSphereId > -1);
+
+	const size_t bufferSize = m_maxInstances * sizeof(glm::mat4);
+	m_inputBuffer = CreateBuffer(BufferTarget::Array, BufferUsage::StaticDraw, bufferSize, nullptr);
+	m_outputBuffer = CreateBuffer(BufferTarget::Array, BufferUsage::DynamicCopy, bufferSize, nullptr);
+
+	const GLuint currentVBO = GetCurrentBuffer(BufferTarget::Array);
+	glGenVertexArrays(1, &m_vao);
+	glBindVertexArray(m_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, m_inputBuffer.handle);
+	const VertexAttribute attributes[] =
+	{
+		{.type = DataType::Float, .count = 4, .offset = (void*)(0 * sizeof(glm::vec4))},
+		{.type = DataType::Float, .count = 4, .offset = (void*)(1 * sizeof(glm::vec4))},
+		{.type = DataType::Float, .count = 4, .offset = (void*)(2 * sizeof(glm::vec4))},
+		{.type = DataType::Float, .count = 4, .offset = (void*)(3 * sizeof(glm::vec4))},
+	};
+	SpecifyVertexAttributes(sizeof(glm::mat4), attributes);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, currentVBO);
+
+	const GLuint currentTexture = GetCurrentTexture(GL_TEXTURE_BUFFER);
+	glGenTextures(1, &m_outputTexture);
+	glBindTexture(GL_TEXTURE_BUFFER, m_outputTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_outputBuffer.handle);
+	glBindTexture(GL_TEXTURE_BUFFER, currentTexture);
+
+	glGenQueries(1, &m_query);
+
+	m_indirect = OGLContext::IsDrawIndirectSupported() && OGLContext::IsQueryBufferSupported();
+	if (m_indirect)
+	{
+		const std::vector<DrawCommand> commands(MaxCommands, DrawCommand{});
+		m_commandBuffer = CreateBuffer(BufferTarget::Array, BufferUsage::DynamicDraw, commands.size() * sizeof(DrawCommand), commands.data());
+		m_commandCounts.assign(MaxCommands, 0);
+	}
+
+	return true;
+}
+//=============================================================================
+void GPUInstanceCulling::Close()
+{
+	if (m_query) glDeleteQueries(1, &m_query);
+	if (m_outputTexture) glDeleteTextures(1, &m_outputTexture);
+	if (m_vao) glDeleteVertexArrays(1, &m_vao);
+	if (m_inputBuffer.handle) glDeleteBuffers(1, &m_inputBuffer.handle);
+	if (m_outputBuffer.handle) glDeleteBuffers(1, &m_outputBuffer.handle);
+	if (m_commandBuffer.handle) glDeleteBuffers(1, &m_commandBuffer.handle);
+	if (m_program.handle) glDeleteProgram(m_program.handle);
+	*this = {};
+}
+//=============================================================================
+void GPUInstanceCulling::SetInstances(std::span<const glm::mat4> transforms)
+{
+	assert(m_inputBuffer.handle);
+	if (transforms.size() > m_maxInstances)
+		Warning("GPUInstanceCulling: too many instances " + std::to_string(transforms.size()));
+
+	m_numInstances = std::min(transforms.size(), m_maxInstances);
+	if (m_numInstances > 0)
+		BufferSubData(m_inputBuffer, BufferTarget::Array, 0, static_cast<GLsizeiptr>(m_numInstances * sizeof(glm::mat4)), transforms.data());
+}
+//=============================================================================
+void GPUInstanceCulling::Cull(const Frustum& frustum, const AABB& localBox, CullingView view)
+{
+	assert(m_program.handle);
+
+	// прошлый результат, если GPU уже его посчитал - только для статистики, отрисовка его не ждет
+	if (m_indirect && m_queryPending)
+	{
+		GLuint available = GL_FALSE;
+		glGetQueryObjectuiv(m_query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available)
+		{
+			GLuint numVisible = 0;
+			glGetQueryObjectuiv(m_query, GL_QUERY_RESULT, &numVisible);
+			m_numVisible = numVisible;
+		}
+	}
+
+	std::array<glm::vec4, Frustum::NumPlanes> planes;
+	for (size_t i = 0; i < planes.size(); i++)
+		planes[i] = frustum.GetPlane(i);
+	const glm::vec3 center = (localBox.min + localBox.max) * 0.5f;
+	const float radius = glm::length(localBox.max - localBox.min) * 0.5f;
+
+	GLint currentProgram = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
+
+	glUseProgram(m_program.handle);
+	SetUniform(m_frustumPlanesId, std::span<const glm::vec4>(planes));
+	SetUniform(m_localSphereId, glm::vec4(center, radius));
+
+	glEnable(GL_RASTERIZER_DISCARD);
+	glBindVertexArray(m_vao);
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, m_outputBuffer.handle);
+	glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, m_query);
+	glBeginTransformFeedback(GL_POINTS);
+	glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(m_numInstances));
+	glEndTransformFeedback();
+	glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+	glBindVertexArray(0);
+	glDisable(GL_RASTERIZER_DISCARD);
+
+	glUseProgram(static_cast<GLuint>(currentProgram));
+
+	if (m_indirect)
+		m_queryPending = true;
+	else
+	{
+		GLuint numVisible = 0;
+		glGetQueryObjectuiv(m_query, GL_QUERY_RESULT, &numVisible);
+		m_numVisible = numVisible;
+	}
+
+	culling::AddStats(view, m_numInstances, m_numVisible);
+}
+//=============================================================================
+void GPUInstanceCulling::BindInstances(unsigned unit) const
+{
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_BUFFER, m_outputTexture);
+}
+//=============================================================================
+void GPUInstanceCulling::Draw(const Mesh& mesh, size_t commandId, GLenum mode)
+{
+	if (!m_indirect)
+	{
+		mesh.Draw(mode, static_cast<unsigned>(m_numVisible));
+		return;
+	}
+
+	assert(commandId < MaxCommands);
+	const GLintptr offset = static_cast<GLintptr>(commandId * sizeof(DrawCommand));
+	const uint32_t count = mesh.GetIndexCount() > 0 ? mesh.GetIndexCount() : mesh.GetVertexCount();
+	if (m_commandCounts[commandId] != count)
+	{
+		BufferSubData(m_commandBuffer, BufferTarget::Array, offset, sizeof(uint32_t), &count);
+		m_commandCounts[commandId] = count;
+	}
+
+	// результат запроса пишется в instanceCount на GPU, после окончания прохода отсечения
+	glBindBuffer(GL_QUERY_BUFFER, m_commandBuffer.handle);
+	glGetQueryObjectuiv(m_query, GL_QUERY_RESULT, reinterpret_cast<GLuint*>(offset + offsetof(DrawCommand, instanceCount)));
+	glBindBuffer(GL_QUERY_BUFFER, 0);
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer.handle);
+	mesh.DrawIndirect(mode, static_cast<size_t>(offset));
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+//=============================================================================
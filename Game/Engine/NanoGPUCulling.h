@@ -0,0 +1,59 @@
+﻿#pragma once
+
+#include "NanoCulling.h"
+#include "NanoRenderMesh.h"
+
+// Отсечение экземпляров пирамидой вида на GPU (GL 3.3), без отправки матриц с CPU каждый кадр.
+// Мировые матрицы экземпляров лежат в буфере вершин, проход рисует их точками с GL_RASTERIZER_DISCARD: вершинный шейдер
+// проверяет мировую сферу экземпляра, геометрический пропускает только видимые, transform feedback плотно пишет их матрицы
+// в выходной буфер. Шейдер отрисовки читает матрицу как samplerBuffer: texelFetch(buffer, gl_InstanceID * 4 + столбец).
+//
+// Число видимых экземпляров:
+//  - GL 4.4+ (draw indirect и query buffer): результат запроса копируется на GPU в instanceCount команд, CPU не ждет;
+//  - GL 3.3: читается на CPU сразу после прохода отсечения (ожидание только этого прохода), затем Mesh::Draw(mode, count)
+class GPUInstanceCulling final
+{
+public:
+	// команд indirect на меш модели, commandId в Draw - индекс меша
+	static constexpr size_t MaxCommands = 64;
+
+	bool Init(size_t maxInstances);
+	void Close();
+
+	// вызывать только при изменении набора. Больше maxInstances - лишние отбрасываются
+	void SetInstances(std::span<const glm::mat4> transforms);
+
+	// localBox - бокс модели в ее координатах, проверяется описанная сфера. Меняет текущий VAO, программа восстанавливается
+	void Cull(const Frustum& frustum, const AABB& localBox, CullingView view = CullingView::Camera);
+
+	// выходной буфер в текстурный блок unit (samplerBuffer, RGBA32F)
+	void BindInstances(unsigned unit) const;
+	// рисует меш для экземпляров, прошедших последний Cull
+	void Draw(const Mesh& mesh, size_t commandId, GLenum mode = GL_TRIANGLES);
+
+	bool IsIndirect() const { return m_indirect; }
+	size_t GetMaxInstances() const { return m_maxInstances; }
+	size_t GetNumInstances() const { return m_numInstances; }
+	// в режиме indirect - результат одного из прошлых кадров, читается без ожидания GPU
+	size_t GetNumVisible() const { return m_numVisible; }
+
+private:
+	ProgramHandle         m_program{};
+	int                   m_frustumPlanesId{ -1 };
+	int                   m_localSphereId{ -1 };
+
+	GLuint                m_vao{ 0 };
+	BufferHandle          m_inputBuffer{};  // все матрицы
+	BufferHandle          m_outputBuffer{}; // прошедшие отсечение, пишется transform feedback
+	GLuint                m_outputTexture{ 0 };
+	GLuint                m_query{ 0 };
+	bool                  m_queryPending{ false };
+
+	bool                  m_indirect{ false };
+	BufferHandle          m_commandBuffer{};
+	std::vector<uint32_t> m_commandCounts; // count команд в буфере, 0 - команда еще не задана
+
+	size_t                m_maxInstances{ 0 };
+	size_t                m_numInstances{ 0 };
+	size_t                m_numVisible{ 0 };
+};
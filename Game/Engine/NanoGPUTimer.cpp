@@ -0,0 +1,72 @@
+﻿#include "stdafx.h"
+#include "NanoGPUTimer.h"
+//=============================================================================
+namespace
+{
+	std::vector<const GPUTimer*> timers;
+} // namespace
+//=============================================================================
+void GPUQueryRing::Init(GLenum target)
+{
+	m_target = target;
+	glGenQueries(static_cast<GLsizei>(NumQueries), m_queries.data());
+}
+//=============================================================================
+void GPUQueryRing::Close()
+{
+	if (m_queries[0])
+		glDeleteQueries(static_cast<GLsizei>(NumQueries), m_queries.data());
+	*this = {};
+}
+//=============================================================================
+void GPUQueryRing::Begin()
+{
+	const GLuint query = m_queries[m_current];
+	if (m_pending[m_current])
+	{
+		GLint available = 0;
+		glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available)
+		{
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &m_result);
+			m_hasResult = true;
+		}
+	}
+	glBeginQuery(m_target, query);
+}
+//=============================================================================
+void GPUQueryRing::End()
+{
+	glEndQuery(m_target);
+	m_pending[m_current] = true;
+	m_current = (m_current + 1) % NumQueries;
+}
+//=============================================================================
+void GPUQueryRing::Reset()
+{
+	m_pending.fill(false);
+	m_result = 0;
+	m_hasResult = false;
+}
+//=============================================================================
+bool GPUTimer::Init(std::string_view name)
+{
+	m_name = name;
+	m_queries.Init(GL_TIME_ELAPSED);
+	timers.push_back(this);
+	return true;
+}
+//=============================================================================
+void GPUTimer::Close()
+{
+	std::erase(timers, this);
+	m_queries.Close();
+	m_name.clear();
+	m_running = false;
+}
+//=============================================================================
+const std::vector<const GPUTimer*>& gpuTimers::GetTimers()
+{
+	return timers;
+}
+//=============================================================================
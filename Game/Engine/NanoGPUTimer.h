@@ -0,0 +1,61 @@
+﻿#pragma once
+
+#include "NanoOpenGL3.h"
+
+// Кольцо запросов GL одного типа (GL_TIME_ELAPSED, GL_SAMPLES_PASSED...) на участок кадра. Результат читается
+// через NumQueries кадров, когда готов, - без ожидания GPU. Запросы одного типа не вкладываются
+class GPUQueryRing final
+{
+public:
+	static constexpr size_t NumQueries = 4; // кадров задержки до чтения результата
+
+	void Init(GLenum target);
+	void Close();
+
+	// читает готовый результат слота, запрос которого отправлен NumQueries кадров назад
+	void Begin();
+	void End();
+	void Reset();
+
+	bool HasResult() const { return m_hasResult; }
+	GLuint64 GetResult() const { return m_result; }
+
+private:
+	std::array<GLuint, NumQueries> m_queries{};
+	std::array<bool, NumQueries>   m_pending{};
+	size_t                         m_current{ 0 };
+	GLenum                         m_target{ 0 };
+	GLuint64                       m_result{ 0 };
+	bool                           m_hasResult{ false };
+};
+
+// Время участка кадра на GPU по запросам GL_TIME_ELAPSED. Между Begin и End не должно быть другого таймера.
+// Инициализированные таймеры выводятся в оверлее engine::DrawFPS
+class GPUTimer final
+{
+public:
+	bool Init(std::string_view name);
+	void Close();
+
+	// End без Begin пропускается - участок мог оборваться на пропущенном проходе
+	void Begin() { if (!m_running) { m_queries.Begin(); m_running = true; } }
+	void End() { if (m_running) { m_queries.End(); m_running = false; } }
+	bool IsRunning() const { return m_running; }
+	// сбрасывает результат, например когда участок перестал рисоваться - таймер пропадает из оверлея до следующего замера
+	void Reset() { m_queries.Reset(); }
+
+	void SetName(std::string_view name) { m_name = name; }
+	const std::string& GetName() const { return m_name; }
+	bool HasResult() const { return m_queries.HasResult(); }
+	double GetTimeMs() const { return static_cast<double>(m_queries.GetResult()) * 1e-6; }
+
+private:
+	GPUQueryRing m_queries;
+	std::string  m_name;
+	bool         m_running{ false };
+};
+
+namespace gpuTimers
+{
+	const std::vector<const GPUTimer*>& GetTimers();
+} // namespace gpuTimers
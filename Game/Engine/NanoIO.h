@@ -13,4 +13,28 @@ namespace io
 
 	std::string LoadFile(const std::filesystem::path& path);
 	std::vector<char> LoadBinaryFile(const std::filesystem::path& path);
+
+	// Файл, отображенный в память только для чтения. Данные не копируются, читаются страницами по мере обращения
+	class MappedFile final
+	{
+	public:
+		MappedFile() = default;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		~MappedFile();
+
+		bool Open(const std::filesystem::path& path);
+		void Close();
+
+		bool IsOpen() const noexcept { return m_data != nullptr; }
+		std::span<const uint8_t> GetData() const noexcept { return { m_data, m_size }; }
+
+	private:
+		const uint8_t* m_data{ nullptr };
+		size_t         m_size{ 0 };
+#if defined(_WIN32)
+		void*          m_file{ nullptr };
+		void*          m_mapping{ nullptr };
+#endif
+	};
 } // namespace io
\ No newline at end of file
@@ -1,7 +1,10 @@
-#include "stdafx.h"
+﻿#include "stdafx.h"
 //=============================================================================
 void Print(const std::string& msg)
 {
+	// пишут и рабочие потоки ParallelFor и AssetCooker'а - строки не должны перемешиваться
+	static std::mutex mutex;
+	std::lock_guard lock(mutex);
 	puts(msg.c_str());
 }
 //=============================================================================
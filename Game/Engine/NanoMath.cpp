@@ -1,6 +1,11 @@
 ﻿#include "stdafx.h"
 #include "NanoMath.h"
 //=============================================================================
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#	include <emmintrin.h>
+#	define NANO_MATH_SSE2 1
+#endif
+//=============================================================================
 glm::mat4 GetTransformMatrix(const glm::vec3& position, const glm::vec3& rotation, float scale)
 {
 	glm::mat4 transform(1.0f);
@@ -12,6 +17,51 @@ glm::mat4 GetTransformMatrix(const glm::vec3& position, const glm::vec3& rotatio
 	return transform;
 }
 //=============================================================================
+AABB ComputeAABB(const glm::vec3* positions, size_t count, size_t stride)
+{
+	if (count == 0) return AABB();
+
+	const auto* bytes = reinterpret_cast<const uint8_t*>(positions);
+	auto position = [&](size_t i) { return reinterpret_cast<const float*>(bytes + i * stride); };
+
+	AABB box;
+	size_t i = 0;
+#if NANO_MATH_SSE2
+	// читается 4 float на позицию - четвертый из следующей вершины, поэтому последняя вершина считается отдельно.
+	// Четыре независимые пары min/max, чтобы не ждать задержку minps на каждой вершине
+	__m128 min0 = _mm_set1_ps(std::numeric_limits<float>::max()), min1 = min0, min2 = min0, min3 = min0;
+	__m128 max0 = _mm_set1_ps(std::numeric_limits<float>::lowest()), max1 = max0, max2 = max0, max3 = max0;
+	const size_t numLoads = count - 1;
+	for (; i + 4 <= numLoads; i += 4)
+	{
+		const __m128 p0 = _mm_loadu_ps(position(i + 0));
+		const __m128 p1 = _mm_loadu_ps(position(i + 1));
+		const __m128 p2 = _mm_loadu_ps(position(i + 2));
+		const __m128 p3 = _mm_loadu_ps(position(i + 3));
+		min0 = _mm_min_ps(min0, p0); max0 = _mm_max_ps(max0, p0);
+		min1 = _mm_min_ps(min1, p1); max1 = _mm_max_ps(max1, p1);
+		min2 = _mm_min_ps(min2, p2); max2 = _mm_max_ps(max2, p2);
+		min3 = _mm_min_ps(min3, p3); max3 = _mm_max_ps(max3, p3);
+	}
+	for (; i < numLoads; i++)
+	{
+		const __m128 p = _mm_loadu_ps(position(i));
+		min0 = _mm_min_ps(min0, p); max0 = _mm_max_ps(max0, p);
+	}
+	alignas(16) float vmin[4], vmax[4];
+	_mm_store_ps(vmin, _mm_min_ps(_mm_min_ps(min0, min1), _mm_min_ps(min2, min3)));
+	_mm_store_ps(vmax, _mm_max_ps(_mm_max_ps(max0, max1), _mm_max_ps(max2, max3)));
+	box.min = glm::vec3(vmin[0], vmin[1], vmin[2]);
+	box.max = glm::vec3(vmax[0], vmax[1], vmax[2]);
+#endif
+	for (; i < count; i++)
+	{
+		const float* p = position(i);
+		box.CombinePoint(glm::vec3(p[0], p[1], p[2]));
+	}
+	return box;
+}
+//=============================================================================
 void AABB::Set(const std::vector<glm::vec3>& vertexData, const std::vector<uint32_t>& indexData)
 {
 	if (indexData.size() > 0)
@@ -108,22 +108,15 @@ public:
 			&& max.z > point.z && min.z < point.z;
 	}
 
+	// Arvo: центр переносится матрицей, половина размера - модулем ее 3x3 части. Для аффинных матриц тот же бокс, что по 8 углам
 	void Transform(const glm::mat4& transform)
 	{
-		glm::vec3 corners[] =
-		{
-			glm::vec3(min.x, min.y, min.z),
-			glm::vec3(min.x, max.y, min.z),
-			glm::vec3(min.x, min.y, max.z),
-			glm::vec3(min.x, max.y, max.z),
-			glm::vec3(max.x, min.y, min.z),
-			glm::vec3(max.x, max.y, min.z),
-			glm::vec3(max.x, min.y, max.z),
-			glm::vec3(max.x, max.y, max.z),
-		};
-		for (auto& v : corners)
-			v = glm::vec3(transform * glm::vec4(v, 1.0f));
-		*this = AABB(corners, 8);
+		if (min.x > max.x) return; // пустой
+
+		const glm::vec3 center = glm::vec3(transform * glm::vec4(GetCenter(), 1.0f));
+		const glm::vec3 extent = glm::mat3(glm::abs(glm::vec3(transform[0])), glm::abs(glm::vec3(transform[1])), glm::abs(glm::vec3(transform[2]))) * (GetSize() * 0.5f);
+		min = center - extent;
+		max = center + extent;
 	}
 	AABB GetTransformed(const glm::mat4& t) const
 	{
@@ -145,6 +138,9 @@ public:
 	glm::vec3 max{ -std::numeric_limits<float>::max() };
 };
 
+// min/max по потоку позиций. stride - шаг в байтах (позиция внутри вершины). Считается на SSE, без обхода индексов
+AABB ComputeAABB(const glm::vec3* positions, size_t count, size_t stride = sizeof(glm::vec3));
+
 inline AABB CombineBoxes(const std::vector<AABB>& boxes)
 {
 	std::vector<glm::vec3> allPoints;
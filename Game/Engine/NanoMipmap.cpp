@@ -0,0 +1,375 @@
+﻿#include "stdafx.h"
+#include "NanoMipmap.h"
+#include "NanoCore.h"
+//=============================================================================
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#	include <emmintrin.h>
+#	define NANO_MIP_SSE2 1
+#endif
+#if defined(__AVX2__)
+#	include <immintrin.h>
+#	define NANO_MIP_AVX2 1
+#endif
+//=============================================================================
+namespace
+{
+	constexpr size_t MinFloatsPerTask = 16 * 1024; // меньше нет смысла отдавать потоку
+	constexpr float KaiserWidth = 3.0f;            // радиус фильтра в пикселях мипа
+	constexpr float KaiserAlpha = 4.0f;
+	constexpr uint32_t AlphaSearchSteps = 12;
+	constexpr size_t LinearToSrgbSteps = 4096;
+	// доля пикселей с альфой около 0 или 255, начиная с которой текстура считается под alpha test
+	constexpr float CutoutBinaryFraction = 0.9f;
+
+	struct FloatImage final
+	{
+		uint32_t width{ 0 };
+		uint32_t height{ 0 };
+		uint32_t components{ 0 };
+		std::vector<float> pixels;
+	};
+
+	// фильтр по одной оси: для каждого пикселя мипа numTaps индексов исходника (прижатых к краю) и нормированных весов
+	struct FilterTaps final
+	{
+		uint32_t numTaps{ 0 };
+		std::vector<uint32_t> indices;
+		std::vector<float> weights;
+	};
+	//-------------------------------------------------------------------------
+	void parallelRows(uint32_t numRows, size_t floatsPerRow, const std::function<void(uint32_t)>& func)
+	{
+		const uint32_t rowsPerTask = std::max(1u, static_cast<uint32_t>(MinFloatsPerTask / std::max<size_t>(1, floatsPerRow)));
+		const size_t numTasks = (numRows + rowsPerTask - 1) / rowsPerTask;
+		ParallelFor(numTasks, [&](size_t task)
+			{
+				const uint32_t firstRow = static_cast<uint32_t>(task) * rowsPerTask;
+				const uint32_t lastRow = std::min(firstRow + rowsPerTask, numRows);
+				for (uint32_t y = firstRow; y < lastRow; y++)
+					func(y);
+			});
+	}
+	//-------------------------------------------------------------------------
+	float srgbToLinear(float c)
+	{
+		return (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+	}
+	//-------------------------------------------------------------------------
+	const std::array<float, 256>& getSrgbToLinearTable()
+	{
+		static const std::array<float, 256> table = []()
+			{
+				std::array<float, 256> result{};
+				for (size_t i = 0; i < result.size(); i++)
+					result[i] = srgbToLinear(static_cast<float>(i) / 255.0f);
+				return result;
+			}();
+		return table;
+	}
+	//-------------------------------------------------------------------------
+	// середины между соседними кодами sRGB, переведенные в линейное пространство
+	const std::array<float, 255>& getLinearToSrgbThresholds()
+	{
+		static const std::array<float, 255> table = []()
+			{
+				std::array<float, 255> result{};
+				for (size_t i = 0; i < result.size(); i++)
+					result[i] = srgbToLinear((static_cast<float>(i) + 0.5f) / 255.0f);
+				return result;
+			}();
+		return table;
+	}
+	//-------------------------------------------------------------------------
+	// код sRGB для c = i / LinearToSrgbSteps - с него начинается поиск по порогам
+	const std::array<uint8_t, LinearToSrgbSteps + 1>& getLinearToSrgbTable()
+	{
+		static const std::array<uint8_t, LinearToSrgbSteps + 1> table = []()
+			{
+				const auto& thresholds = getLinearToSrgbThresholds();
+				std::array<uint8_t, LinearToSrgbSteps + 1> result{};
+				for (size_t i = 0; i < result.size(); i++)
+				{
+					const float c = static_cast<float>(i) / static_cast<float>(LinearToSrgbSteps);
+					result[i] = static_cast<uint8_t>(std::upper_bound(thresholds.begin(), thresholds.end(), c) - thresholds.begin());
+				}
+				return result;
+			}();
+		return table;
+	}
+	//-------------------------------------------------------------------------
+	// то же округление, что и у (pow(c, 1/2.4)...) * 255 + 0.5, но без pow. Между соседними шагами таблицы не больше пары кодов
+	uint8_t linearToSrgb(float c)
+	{
+		c = std::clamp(c, 0.0f, 1.0f);
+		const auto& thresholds = getLinearToSrgbThresholds();
+		uint32_t code = getLinearToSrgbTable()[static_cast<size_t>(c * static_cast<float>(LinearToSrgbSteps))];
+		while (code < thresholds.size() && c > thresholds[code])
+			code++;
+		return static_cast<uint8_t>(code);
+	}
+	//-------------------------------------------------------------------------
+	uint8_t linearToUnorm(float c)
+	{
+		return static_cast<uint8_t>(std::clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+	//-------------------------------------------------------------------------
+	float besselI0(float x)
+	{
+		float sum = 1.0f, term = 1.0f;
+		for (int k = 1; k < 32 && term > sum * 1e-7f; k++)
+		{
+			const float t = x * 0.5f / static_cast<float>(k);
+			term *= t * t;
+			sum += term;
+		}
+		return sum;
+	}
+	//-------------------------------------------------------------------------
+	// x - расстояние в пикселях мипа
+	float kaiserSinc(float x)
+	{
+		if (std::abs(x) >= KaiserWidth)
+			return 0.0f;
+		const float sinc = (x == 0.0f) ? 1.0f : std::sin(std::numbers::pi_v<float> * x) / (std::numbers::pi_v<float> * x);
+		const float r = x / KaiserWidth;
+		return sinc * besselI0(KaiserAlpha * std::sqrt(1.0f - r * r)) / besselI0(KaiserAlpha);
+	}
+	//-------------------------------------------------------------------------
+	FilterTaps makeFilterTaps(uint32_t srcSize, uint32_t dstSize, MipFilter filter)
+	{
+		FilterTaps taps;
+		if (srcSize == dstSize)
+		{
+			taps.numTaps = 1;
+			taps.indices.resize(dstSize);
+			std::iota(taps.indices.begin(), taps.indices.end(), 0u);
+			taps.weights.assign(dstSize, 1.0f);
+			return taps;
+		}
+
+		// пиксель i исходника занимает [i, i + 1), пиксель мипа - scale пикселей исходника
+		const float scale = static_cast<float>(srcSize) / static_cast<float>(dstSize);
+		const float radius = (filter == MipFilter::Box) ? 0.5f * scale : KaiserWidth * scale;
+		for (uint32_t dst = 0; dst < dstSize; dst++)
+		{
+			const float center = (static_cast<float>(dst) + 0.5f) * scale;
+			taps.numTaps = std::max(taps.numTaps, static_cast<uint32_t>(std::ceil(center + radius) - std::floor(center - radius)));
+		}
+
+		taps.indices.resize(size_t(dstSize) * taps.numTaps);
+		taps.weights.resize(size_t(dstSize) * taps.numTaps);
+		for (uint32_t dst = 0; dst < dstSize; dst++)
+		{
+			const float center = (static_cast<float>(dst) + 0.5f) * scale;
+			const int first = static_cast<int>(std::floor(center - radius));
+			uint32_t* indices = &taps.indices[size_t(dst) * taps.numTaps];
+			float* weights = &taps.weights[size_t(dst) * taps.numTaps];
+			float sum = 0.0f;
+			for (uint32_t k = 0; k < taps.numTaps; k++)
+			{
+				const int src = first + static_cast<int>(k);
+				const float weight = (filter == MipFilter::Box)
+					? std::max(0.0f, std::min(static_cast<float>(src + 1), center + radius) - std::max(static_cast<float>(src), center - radius))
+					: kaiserSinc((static_cast<float>(src) + 0.5f - center) / scale);
+				indices[k] = static_cast<uint32_t>(std::clamp(src, 0, static_cast<int>(srcSize) - 1));
+				weights[k] = weight;
+				sum += weight;
+			}
+			for (uint32_t k = 0; k < taps.numTaps; k++)
+				weights[k] /= sum;
+		}
+		return taps;
+	}
+	//-------------------------------------------------------------------------
+	// dst[i] += src[i] * weight
+	void addScaledRow(float* dst, const float* src, float weight, size_t count)
+	{
+		size_t i = 0;
+#if NANO_MIP_AVX2
+		const __m256 weight8 = _mm256_set1_ps(weight);
+		for (; i + 8 <= count; i += 8)
+			_mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_mul_ps(_mm256_loadu_ps(src + i), weight8)));
+#endif
+#if NANO_MIP_SSE2
+		const __m128 weight4 = _mm_set1_ps(weight);
+		for (; i + 4 <= count; i += 4)
+			_mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), weight4)));
+#endif
+		for (; i < count; i++)
+			dst[i] += src[i] * weight;
+	}
+	//-------------------------------------------------------------------------
+	void filterRowHorizontal(float* dst, const float* src, const FilterTaps& taps, uint32_t dstWidth, uint32_t components)
+	{
+		for (uint32_t x = 0; x < dstWidth; x++)
+		{
+			const uint32_t* indices = &taps.indices[size_t(x) * taps.numTaps];
+			const float* weights = &taps.weights[size_t(x) * taps.numTaps];
+#if NANO_MIP_SSE2
+			if (components == 4)
+			{
+				__m128 sum = _mm_setzero_ps();
+				for (uint32_t k = 0; k < taps.numTaps; k++)
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(src + size_t(indices[k]) * 4), _mm_set1_ps(weights[k])));
+				_mm_storeu_ps(dst + size_t(x) * 4, sum);
+				continue;
+			}
+#endif
+			for (uint32_t c = 0; c < components; c++)
+			{
+				float sum = 0.0f;
+				for (uint32_t k = 0; k < taps.numTaps; k++)
+					sum += src[size_t(indices[k]) * components + c] * weights[k];
+				dst[size_t(x) * components + c] = sum;
+			}
+		}
+	}
+	//-------------------------------------------------------------------------
+	// сначала по вертикали - по горизонтали фильтруется уже вдвое меньше строк
+	FloatImage resample(const FloatImage& src, uint32_t dstWidth, uint32_t dstHeight, MipFilter filter)
+	{
+		const uint32_t components = src.components;
+		const FilterTaps tapsX = makeFilterTaps(src.width, dstWidth, filter);
+		const FilterTaps tapsY = makeFilterTaps(src.height, dstHeight, filter);
+		const size_t srcRowSize = size_t(src.width) * components;
+		const size_t dstRowSize = size_t(dstWidth) * components;
+
+		FloatImage dst{ .width = dstWidth, .height = dstHeight, .components = components, .pixels = {} };
+		dst.pixels.resize(dstRowSize * dstHeight);
+		parallelRows(dstHeight, srcRowSize * tapsY.numTaps, [&](uint32_t y)
+			{
+				std::vector<float> row(srcRowSize, 0.0f);
+				for (uint32_t k = 0; k < tapsY.numTaps; k++)
+				{
+					const size_t tap = size_t(y) * tapsY.numTaps + k;
+					addScaledRow(row.data(), &src.pixels[size_t(tapsY.indices[tap]) * srcRowSize], tapsY.weights[tap], srcRowSize);
+				}
+				filterRowHorizontal(&dst.pixels[size_t(y) * dstRowSize], row.data(), tapsX, dstWidth, components);
+			});
+		return dst;
+	}
+	//-------------------------------------------------------------------------
+	FloatImage toFloat(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t components, uint32_t colorComponents)
+	{
+		const auto& toLinear = getSrgbToLinearTable();
+		const size_t rowSize = size_t(width) * components;
+
+		FloatImage image{ .width = width, .height = height, .components = components, .pixels = {} };
+		image.pixels.resize(rowSize * height);
+		parallelRows(height, rowSize, [&](uint32_t y)
+			{
+				const uint8_t* src = pixels + size_t(y) * rowSize;
+				float* dst = &image.pixels[size_t(y) * rowSize];
+				for (uint32_t x = 0; x < width; x++, src += components, dst += components)
+				{
+					for (uint32_t c = 0; c < components; c++)
+						dst[c] = (c < colorComponents) ? toLinear[src[c]] : static_cast<float>(src[c]) * (1.0f / 255.0f);
+				}
+			});
+		return image;
+	}
+	//-------------------------------------------------------------------------
+	std::vector<uint8_t> toPixels(const FloatImage& image, uint32_t colorComponents, float alphaScale)
+	{
+		const uint32_t components = image.components;
+		const size_t rowSize = size_t(image.width) * components;
+
+		std::vector<uint8_t> pixels(image.pixels.size());
+		parallelRows(image.height, rowSize, [&](uint32_t y)
+			{
+				const float* src = &image.pixels[size_t(y) * rowSize];
+				uint8_t* dst = &pixels[size_t(y) * rowSize];
+				for (uint32_t x = 0; x < image.width; x++, src += components, dst += components)
+				{
+					for (uint32_t c = 0; c < components; c++)
+					{
+						if (c < colorComponents)
+							dst[c] = linearToSrgb(src[c]);
+						else
+							dst[c] = linearToUnorm((c == 3) ? src[c] * alphaScale : src[c]);
+					}
+				}
+			});
+		return pixels;
+	}
+	//-------------------------------------------------------------------------
+	float getAlphaCoverage(const FloatImage& image, float alphaRef)
+	{
+		size_t numPassed = 0;
+		for (size_t i = 3; i < image.pixels.size(); i += 4)
+		{
+			if (image.pixels[i] > alphaRef)
+				numPassed++;
+		}
+		return static_cast<float>(numPassed) / static_cast<float>(size_t(image.width) * image.height);
+	}
+	//-------------------------------------------------------------------------
+	// На мелких мипах фильтр размывает альфу и объект под alpha test "тает". Подбирается порог alphaRef, при котором
+	// доля прошедших пикселей как у исходника; масштаб cutoff / alphaRef переносит этот порог на cutoff шейдера
+	float findAlphaScale(const FloatImage& image, float cutoff, float targetCoverage)
+	{
+		// на мипе исходная доля меньше одного пикселя (или нулевая) - сохранять нечего, иначе поиск уводит порог к 0
+		if (targetCoverage * static_cast<float>(size_t(image.width) * image.height) < 1.0f)
+			return 1.0f;
+
+		float low = 0.0f, high = 1.0f;
+		float lowCoverage = 1.0f, highCoverage = 0.0f;
+		for (uint32_t step = 0; step < AlphaSearchSteps; step++)
+		{
+			const float alphaRef = 0.5f * (low + high);
+			const float coverage = getAlphaCoverage(image, alphaRef);
+			if (coverage > targetCoverage)
+			{
+				low = alphaRef;
+				lowCoverage = coverage;
+			}
+			else
+			{
+				high = alphaRef;
+				highCoverage = coverage;
+			}
+		}
+		// у мелких мипов доля меняется скачками - берется ближайшая к исходной сторона скачка
+		const float alphaRef = (lowCoverage - targetCoverage < targetCoverage - highCoverage && low > 0.0f) ? low : high;
+		return cutoff / alphaRef;
+	}
+} // namespace
+//=============================================================================
+bool mipmap::IsCutout(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t components)
+{
+	if (components != 4) return false;
+
+	const size_t numPixels = size_t(width) * height;
+	size_t numBinary = 0, numTransparent = 0;
+	for (size_t i = 0; i < numPixels; i++)
+	{
+		const uint8_t alpha = pixels[i * 4 + 3];
+		if (alpha < 16) numTransparent++;
+		if (alpha < 16 || alpha > 239) numBinary++;
+	}
+	return numTransparent > 0 && static_cast<float>(numBinary) >= CutoutBinaryFraction * static_cast<float>(numPixels);
+}
+//=============================================================================
+std::vector<std::vector<uint8_t>> mipmap::Generate(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t components, const MipSettings& settings)
+{
+	assert(pixels && width > 0 && height > 0 && components >= 1 && components <= 4);
+
+	std::vector<std::vector<uint8_t>> mips;
+	mips.emplace_back(pixels, pixels + size_t(width) * height * components);
+
+	// в sRGB только цвет. 1-2 канала грузятся как R8/RG8 - всегда линейные
+	const uint32_t colorComponents = (settings.colorSpace == ColorSpace::sRGB && components >= 3) ? 3 : 0;
+	const bool preserveCoverage = settings.alphaCutoff > 0.0f && components == 4;
+
+	FloatImage image = toFloat(pixels, width, height, components, colorComponents);
+	const float coverage = preserveCoverage ? getAlphaCoverage(image, settings.alphaCutoff) : 0.0f;
+	while (image.width > 1 || image.height > 1)
+	{
+		image = resample(image, std::max(1u, image.width / 2), std::max(1u, image.height / 2), settings.filter);
+		// масштаб только для записи - следующий мип фильтруется из исходной альфы
+		const float alphaScale = preserveCoverage ? findAlphaScale(image, settings.alphaCutoff, coverage) : 1.0f;
+		mips.push_back(toPixels(image, colorComponents, alphaScale));
+	}
+	return mips;
+}
+//=============================================================================
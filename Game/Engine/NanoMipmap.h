@@ -0,0 +1,29 @@
+﻿#pragma once
+
+#include "NanoOpenGL3.h"
+
+enum class MipFilter : uint8_t
+{
+	Box,   // усреднение по площади - быстро, для загрузки в рантайме
+	Kaiser // sinc с окном Кайзера - резче бокса, для AssetCooker'а
+};
+
+struct MipSettings final
+{
+	MipFilter  filter{ MipFilter::Box };
+	ColorSpace colorSpace{ ColorSpace::Linear }; // sRGB - цвет фильтруется в линейном пространстве. Альфа всегда линейная
+	float      alphaCutoff{ 0.0f };              // больше 0 - на всех мипах сохраняется доля пикселей с альфой выше порога
+};
+
+// Построение мипов на CPU вместо glGenerateMipmap: одинаково на всех драйверах и с правильной фильтрацией sRGB
+namespace mipmap
+{
+	// порог alpha test в шейдерах (alphaTestThreshold)
+	constexpr float DefaultAlphaCutoff = 0.1f;
+
+	// альфа почти везде 0 или 255 - текстура под alpha test, а не полупрозрачная
+	bool IsCutout(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t components);
+
+	// цепочка до 1x1, [0] - копия исходника. Каждый мип фильтруется из float предыдущего, без промежуточного округления до 8 бит. Строки делятся между ядрами
+	std::vector<std::vector<uint8_t>> Generate(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t components, const MipSettings& settings);
+} // namespace mipmap
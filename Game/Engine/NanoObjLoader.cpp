@@ -0,0 +1,549 @@
+﻿#include "stdafx.h"
+#include "NanoObjLoader.h"
+#include "NanoCore.h"
+#include "NanoLog.h"
+#include "NanoIO.h"
+//=============================================================================
+namespace
+{
+	constexpr size_t MinChunkSize = 512 * 1024; // меньше нет смысла делить на потоки
+
+	// Индексы уже 0-based. Отрицательный индекс в файле считается от конца массива, а в куске конец массива известен
+	// только локально - такой индекс хранится относительно начала куска и помечается битом в relative
+	struct ObjFaceVertex final
+	{
+		int32_t v{ -1 };
+		int32_t vt{ -1 };
+		int32_t vn{ -1 };
+		uint8_t relative{ 0 };
+	};
+
+	// Смена o/g/usemtl внутри куска. nullopt - значение наследуется от предыдущего сегмента (в том числе из прошлого куска)
+	struct ObjSegment final
+	{
+		std::optional<std::string> objectName;
+		std::optional<std::string> materialName;
+		size_t                     firstTriangle{ 0 };
+	};
+
+	struct ObjChunk final
+	{
+		std::vector<glm::vec3>     positions;
+		std::vector<glm::vec3>     colors;
+		std::vector<glm::vec3>     normals;
+		std::vector<glm::vec2>     texCoords;
+		std::vector<ObjFaceVertex> faceVertices; // по 3 на треугольник
+		std::vector<ObjSegment>    segments;
+		std::vector<std::string>   materialLibs;
+		bool                       hasColors{ false };
+	};
+
+	struct ObjRun final
+	{
+		size_t chunk;
+		size_t firstTriangle;
+		size_t lastTriangle;
+	};
+
+	struct ObjVertexKey final
+	{
+		bool operator==(const ObjVertexKey&) const noexcept = default;
+
+		int32_t v;
+		int32_t vt;
+		int32_t vn;
+	};
+
+	struct ObjVertexKeyHash final
+	{
+		std::size_t operator()(const ObjVertexKey& k) const noexcept
+		{
+			std::size_t seed = 0;
+			HashCombine(seed, k.v, k.vt, k.vn);
+			return seed;
+		}
+	};
+	//-------------------------------------------------------------------------
+	inline bool isSpace(char c) { return c == ' ' || c == '\t'; }
+	inline bool isEndLine(char c) { return c == '\n' || c == '\r'; }
+	//-------------------------------------------------------------------------
+	inline const char* skipSpaces(const char* p, const char* end)
+	{
+		while (p < end && isSpace(*p)) p++;
+		return p;
+	}
+	//-------------------------------------------------------------------------
+	inline const char* skipLine(const char* p, const char* end)
+	{
+		while (p < end && *p != '\n') p++;
+		return p < end ? p + 1 : end;
+	}
+	//-------------------------------------------------------------------------
+	inline const char* parseFloat(const char* p, const char* end, float& value)
+	{
+		p = skipSpaces(p, end);
+		if (p < end && *p == '+') p++;
+		auto [ptr, ec] = std::from_chars(p, end, value);
+		return ec == std::errc() ? ptr : nullptr;
+	}
+	//-------------------------------------------------------------------------
+	inline const char* parseInt(const char* p, const char* end, int32_t& value)
+	{
+		if (p < end && *p == '+') p++;
+		auto [ptr, ec] = std::from_chars(p, end, value);
+		return ec == std::errc() ? ptr : nullptr;
+	}
+	//-------------------------------------------------------------------------
+	// имя до конца строки без завершающих пробелов
+	inline std::string_view parseName(const char* p, const char* end)
+	{
+		p = skipSpaces(p, end);
+		const char* last = p;
+		while (last < end && !isEndLine(*last)) last++;
+		while (last > p && isSpace(*(last - 1))) last--;
+		return std::string_view(p, static_cast<size_t>(last - p));
+	}
+	//-------------------------------------------------------------------------
+	inline bool startsWithKeyword(const char* p, const char* end, std::string_view keyword)
+	{
+		const size_t size = keyword.size();
+		return static_cast<size_t>(end - p) > size && std::string_view(p, size) == keyword && isSpace(p[size]);
+	}
+	//-------------------------------------------------------------------------
+	inline int32_t resolveIndex(int32_t index, size_t localCount, uint8_t& relative, uint8_t bit)
+	{
+		if (index > 0) return index - 1;
+		if (index < 0)
+		{
+			relative |= bit;
+			return static_cast<int32_t>(localCount) + index;
+		}
+		return -1;
+	}
+	//-------------------------------------------------------------------------
+	ObjSegment& getSegmentForChange(ObjChunk& chunk)
+	{
+		const size_t numTriangles = chunk.faceVertices.size() / 3;
+		if (chunk.segments.back().firstTriangle != numTriangles)
+			chunk.segments.push_back({ .objectName = std::nullopt, .materialName = std::nullopt, .firstTriangle = numTriangles });
+		return chunk.segments.back();
+	}
+	//-------------------------------------------------------------------------
+	void parseChunk(const char* p, const char* end, ObjChunk& chunk)
+	{
+		chunk.segments.push_back({});
+
+		std::vector<ObjFaceVertex> polygon;
+		while (p < end)
+		{
+			p = skipSpaces(p, end);
+			if (p >= end) break;
+
+			const char c = *p;
+			if (c == 'v' && p + 1 < end)
+			{
+				if (isSpace(p[1]))
+				{
+					glm::vec3 pos(0.0f);
+					const char* n = parseFloat(p + 2, end, pos.x);
+					if (n) n = parseFloat(n, end, pos.y);
+					if (n) n = parseFloat(n, end, pos.z);
+					if (n)
+					{
+						chunk.positions.push_back(pos);
+						// необязательный цвет вершины: v x y z r g b
+						glm::vec3 color(1.0f);
+						const char* cn = parseFloat(n, end, color.x);
+						if (cn) cn = parseFloat(cn, end, color.y);
+						if (cn) cn = parseFloat(cn, end, color.z);
+						if (cn)
+						{
+							if (!chunk.hasColors)
+							{
+								chunk.colors.resize(chunk.positions.size() - 1, glm::vec3(1.0f));
+								chunk.hasColors = true;
+							}
+						}
+						else color = glm::vec3(1.0f);
+						if (chunk.hasColors) chunk.colors.push_back(color);
+					}
+				}
+				else if (p[1] == 't' && p + 2 < end && isSpace(p[2]))
+				{
+					glm::vec2 uv(0.0f);
+					const char* n = parseFloat(p + 3, end, uv.x);
+					if (n && !parseFloat(n, end, uv.y)) uv.y = 0.0f;
+					chunk.texCoords.push_back(uv);
+				}
+				else if (p[1] == 'n' && p + 2 < end && isSpace(p[2]))
+				{
+					glm::vec3 normal(0.0f);
+					const char* n = parseFloat(p + 3, end, normal.x);
+					if (n) n = parseFloat(n, end, normal.y);
+					if (n) n = parseFloat(n, end, normal.z);
+					chunk.normals.push_back(normal);
+				}
+			}
+			else if (c == 'f' && p + 1 < end && isSpace(p[1]))
+			{
+				polygon.clear();
+				const char* n = p + 1;
+				while (true)
+				{
+					n = skipSpaces(n, end);
+					if (n >= end || isEndLine(*n) || *n == '#') break;
+
+					ObjFaceVertex fv;
+					int32_t index = 0;
+					const char* next = parseInt(n, end, index);
+					if (!next) break;
+					fv.v = resolveIndex(index, chunk.positions.size(), fv.relative, 1);
+					n = next;
+					if (n < end && *n == '/')
+					{
+						n++;
+						if (n < end && *n != '/')
+						{
+							if ((next = parseInt(n, end, index)))
+							{
+								fv.vt = resolveIndex(index, chunk.texCoords.size(), fv.relative, 2);
+								n = next;
+							}
+						}
+						if (n < end && *n == '/')
+						{
+							n++;
+							if ((next = parseInt(n, end, index)))
+							{
+								fv.vn = resolveIndex(index, chunk.normals.size(), fv.relative, 4);
+								n = next;
+							}
+						}
+					}
+					polygon.push_back(fv);
+					// пропуск мусора до следующего пробела
+					while (n < end && !isSpace(*n) && !isEndLine(*n)) n++;
+				}
+
+				// triangle fan
+				for (size_t i = 2; i < polygon.size(); i++)
+				{
+					chunk.faceVertices.push_back(polygon[0]);
+					chunk.faceVertices.push_back(polygon[i - 1]);
+					chunk.faceVertices.push_back(polygon[i]);
+				}
+			}
+			else if ((c == 'o' || c == 'g') && p + 1 < end && isSpace(p[1]))
+			{
+				getSegmentForChange(chunk).objectName = std::string(parseName(p + 1, end));
+			}
+			else if (startsWithKeyword(p, end, "usemtl"))
+			{
+				getSegmentForChange(chunk).materialName = std::string(parseName(p + 6, end));
+			}
+			else if (startsWithKeyword(p, end, "mtllib"))
+			{
+				chunk.materialLibs.emplace_back(parseName(p + 6, end));
+			}
+
+			p = skipLine(p, end);
+		}
+	}
+	//-------------------------------------------------------------------------
+	std::string parseMapName(std::string_view line)
+	{
+		// опции вида "-bm 1.0 file.png" - имя файла последнее
+		const size_t pos = line.find_last_of(" \t");
+		return std::string(pos == std::string_view::npos ? line : line.substr(pos + 1));
+	}
+	//-------------------------------------------------------------------------
+	void loadMaterialLib(const std::string& fileName, const std::string& directory, std::vector<ObjMaterial>& materials)
+	{
+		if (!io::Exists(fileName))
+		{
+			Warning("OBJ material library not found: " + fileName);
+			return;
+		}
+		const std::string text = io::LoadFile(fileName);
+		const char* p = text.data();
+		const char* end = text.data() + text.size();
+
+		ObjMaterial* material = nullptr;
+		auto readColor = [&](const char* n, glm::vec3& color)
+			{
+				const char* r = parseFloat(n, end, color.x);
+				if (r) r = parseFloat(r, end, color.y);
+				if (r) r = parseFloat(r, end, color.z);
+				else color.y = color.z = color.x;
+			};
+
+		while (p < end)
+		{
+			p = skipSpaces(p, end);
+			if (startsWithKeyword(p, end, "newmtl"))
+			{
+				material = &materials.emplace_back();
+				material->name = std::string(parseName(p + 6, end));
+			}
+			else if (material)
+			{
+				if (startsWithKeyword(p, end, "Ka"))      readColor(p + 2, material->ambientColor);
+				else if (startsWithKeyword(p, end, "Kd")) readColor(p + 2, material->diffuseColor);
+				else if (startsWithKeyword(p, end, "Ks")) readColor(p + 2, material->specularColor);
+				else if (startsWithKeyword(p, end, "Ke")) readColor(p + 2, material->emissionColor);
+				else if (startsWithKeyword(p, end, "Ns")) parseFloat(p + 2, end, material->shininess);
+				else if (startsWithKeyword(p, end, "d"))  parseFloat(p + 1, end, material->opacity);
+				else if (startsWithKeyword(p, end, "Tr"))
+				{
+					float transparency = 0.0f;
+					if (parseFloat(p + 2, end, transparency)) material->opacity = 1.0f - transparency;
+				}
+				else if (startsWithKeyword(p, end, "map_Kd"))   material->diffuseMap = directory + parseMapName(parseName(p + 6, end));
+				else if (startsWithKeyword(p, end, "map_Ks"))   material->specularMap = directory + parseMapName(parseName(p + 6, end));
+				else if (startsWithKeyword(p, end, "map_Ns"))   material->shininessMap = directory + parseMapName(parseName(p + 6, end));
+				else if (startsWithKeyword(p, end, "map_Ke"))   material->emissionMap = directory + parseMapName(parseName(p + 6, end));
+				else if (startsWithKeyword(p, end, "map_d"))    material->opacityMap = directory + parseMapName(parseName(p + 5, end));
+				else if (startsWithKeyword(p, end, "map_Bump") || startsWithKeyword(p, end, "map_bump"))
+					material->normalMap = directory + parseMapName(parseName(p + 8, end));
+				else if (startsWithKeyword(p, end, "bump") || startsWithKeyword(p, end, "norm"))
+					material->normalMap = directory + parseMapName(parseName(p + 4, end));
+			}
+			p = skipLine(p, end);
+		}
+	}
+	//-------------------------------------------------------------------------
+	void generateNormals(MeshInfo& mesh, const std::vector<bool>& hasNormal)
+	{
+		for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+		{
+			auto& v0 = mesh.vertices[mesh.indices[i + 0]];
+			auto& v1 = mesh.vertices[mesh.indices[i + 1]];
+			auto& v2 = mesh.vertices[mesh.indices[i + 2]];
+			// без нормализации - вклад грани пропорционален площади
+			const glm::vec3 n = glm::cross(v1.position - v0.position, v2.position - v0.position);
+			if (!hasNormal[mesh.indices[i + 0]]) v0.normal += n;
+			if (!hasNormal[mesh.indices[i + 1]]) v1.normal += n;
+			if (!hasNormal[mesh.indices[i + 2]]) v2.normal += n;
+		}
+		for (size_t i = 0; i < mesh.vertices.size(); i++)
+		{
+			if (!hasNormal[i] && glm::dot(mesh.vertices[i].normal, mesh.vertices[i].normal) > 0.0f)
+				mesh.vertices[i].normal = glm::normalize(mesh.vertices[i].normal);
+		}
+	}
+	//-------------------------------------------------------------------------
+	void generateTangents(MeshInfo& mesh)
+	{
+		for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+		{
+			auto& v0 = mesh.vertices[mesh.indices[i + 0]];
+			auto& v1 = mesh.vertices[mesh.indices[i + 1]];
+			auto& v2 = mesh.vertices[mesh.indices[i + 2]];
+
+			const glm::vec3 e1 = v1.position - v0.position, e2 = v2.position - v0.position;
+			const glm::vec2 d1 = v1.texCoord - v0.texCoord, d2 = v2.texCoord - v0.texCoord;
+			const float det = d1.x * d2.y - d2.x * d1.y;
+			if (std::abs(det) < 1e-12f) continue;
+			const float r = 1.0f / det;
+			const glm::vec3 tangent = (e1 * d2.y - e2 * d1.y) * r;
+			const glm::vec3 bitangent = (e2 * d1.x - e1 * d2.x) * r;
+			v0.tangent += tangent; v1.tangent += tangent; v2.tangent += tangent;
+			v0.bitangent += bitangent; v1.bitangent += bitangent; v2.bitangent += bitangent;
+		}
+		for (auto& v : mesh.vertices)
+		{
+			glm::vec3 tangent = v.tangent - v.normal * glm::dot(v.normal, v.tangent);
+			if (glm::dot(tangent, tangent) < 1e-12f)
+			{
+				v.tangent = v.bitangent = glm::vec3(0.0f);
+				continue;
+			}
+			tangent = glm::normalize(tangent);
+			const float handedness = glm::dot(glm::cross(v.normal, tangent), v.bitangent) < 0.0f ? -1.0f : 1.0f;
+			v.tangent = tangent;
+			v.bitangent = glm::cross(v.normal, tangent) * handedness;
+		}
+	}
+} // namespace
+//=============================================================================
+bool obj::Load(const std::string& fileName, ObjData& outData, const ObjLoadInfo& loadInfo)
+{
+	outData = {};
+
+	io::MappedFile file;
+	if (!file.Open(fileName))
+		return false;
+
+	const char* data = reinterpret_cast<const char*>(file.GetData().data());
+	const char* dataEnd = data + file.GetData().size();
+	const size_t size = file.GetData().size();
+
+	// 1. Деление на куски по границам строк
+	const size_t maxChunks = std::max(1u, std::thread::hardware_concurrency());
+	const size_t numChunks = std::clamp<size_t>(size / MinChunkSize, 1, maxChunks);
+	std::vector<const char*> bounds(numChunks + 1, dataEnd);
+	bounds[0] = data;
+	for (size_t i = 1; i < numChunks; i++)
+	{
+		const char* p = std::max(data + size * i / numChunks, bounds[i - 1]);
+		bounds[i] = skipLine(p, dataEnd);
+	}
+
+	// 2. Параллельный разбор
+	std::vector<ObjChunk> chunks(numChunks);
+	ParallelFor(numChunks, [&](size_t i) { parseChunk(bounds[i], bounds[i + 1], chunks[i]); });
+
+	// 3. Склейка атрибутов и перевод относительных индексов в глобальные
+	size_t numPositions = 0, numNormals = 0, numTexCoords = 0;
+	bool hasColors = false;
+	std::vector<std::array<size_t, 3>> offsets(numChunks);
+	for (size_t i = 0; i < numChunks; i++)
+	{
+		offsets[i] = { numPositions, numTexCoords, numNormals };
+		numPositions += chunks[i].positions.size();
+		numTexCoords += chunks[i].texCoords.size();
+		numNormals += chunks[i].normals.size();
+		hasColors = hasColors || chunks[i].hasColors;
+	}
+
+	std::vector<glm::vec3> positions, colors, normals;
+	std::vector<glm::vec2> texCoords;
+	positions.reserve(numPositions);
+	normals.reserve(numNormals);
+	texCoords.reserve(numTexCoords);
+	if (hasColors) colors.reserve(numPositions);
+	for (auto& chunk : chunks)
+	{
+		positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+		normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+		texCoords.insert(texCoords.end(), chunk.texCoords.begin(), chunk.texCoords.end());
+		if (hasColors)
+		{
+			if (chunk.hasColors) colors.insert(colors.end(), chunk.colors.begin(), chunk.colors.end());
+			else colors.resize(colors.size() + chunk.positions.size(), glm::vec3(1.0f));
+		}
+		chunk.positions = {};
+		chunk.normals = {};
+		chunk.texCoords = {};
+		chunk.colors = {};
+	}
+
+	ParallelFor(numChunks, [&](size_t i)
+		{
+			const auto& offset = offsets[i];
+			for (auto& fv : chunks[i].faceVertices)
+			{
+				if (fv.relative & 1) fv.v += static_cast<int32_t>(offset[0]);
+				if (fv.relative & 2) fv.vt += static_cast<int32_t>(offset[1]);
+				if (fv.relative & 4) fv.vn += static_cast<int32_t>(offset[2]);
+			}
+		});
+
+	// 4. Материалы
+	const std::string directory = io::GetFileDirectory(fileName);
+	std::unordered_map<std::string, int> materialIds;
+	for (const auto& chunk : chunks)
+	{
+		for (const auto& lib : chunk.materialLibs)
+			outData.materialLibraries.push_back(directory + lib);
+	}
+	if (loadInfo.loadMaterials)
+	{
+		for (const auto& lib : outData.materialLibraries)
+			loadMaterialLib(lib, directory, outData.materials);
+		for (size_t i = 0; i < outData.materials.size(); i++)
+			materialIds.try_emplace(outData.materials[i].name, static_cast<int>(i));
+	}
+
+	// 5. Группировка по (o/g, usemtl) с сохранением порядка появления
+	std::map<std::pair<std::string, std::string>, size_t> groupIds;
+	std::vector<std::vector<ObjRun>> groupRuns;
+	std::string currentObject, currentMaterial;
+	for (size_t c = 0; c < numChunks; c++)
+	{
+		const auto& segments = chunks[c].segments;
+		const size_t numTriangles = chunks[c].faceVertices.size() / 3;
+		for (size_t s = 0; s < segments.size(); s++)
+		{
+			if (segments[s].objectName) currentObject = *segments[s].objectName;
+			if (segments[s].materialName) currentMaterial = *segments[s].materialName;
+
+			const size_t first = segments[s].firstTriangle;
+			const size_t last = (s + 1 < segments.size()) ? segments[s + 1].firstTriangle : numTriangles;
+			if (first == last) continue;
+
+			auto [it, inserted] = groupIds.try_emplace({ currentObject, currentMaterial }, outData.groups.size());
+			if (inserted)
+			{
+				auto& group = outData.groups.emplace_back();
+				group.objectName = currentObject;
+				auto mat = materialIds.find(currentMaterial);
+				group.materialId = (mat != materialIds.end()) ? mat->second : -1;
+				groupRuns.emplace_back();
+			}
+			groupRuns[it->second].push_back({ .chunk = c, .firstTriangle = first, .lastTriangle = last });
+		}
+	}
+
+	// 6. Параллельная сборка MeshInfo по группам с объединением одинаковых вершин
+	ParallelFor(outData.groups.size(), [&](size_t g)
+		{
+			MeshInfo& mesh = outData.groups[g].mesh;
+			size_t numFaceVertices = 0;
+			for (const auto& run : groupRuns[g])
+				numFaceVertices += (run.lastTriangle - run.firstTriangle) * 3;
+
+			std::unordered_map<ObjVertexKey, uint32_t, ObjVertexKeyHash> vertexCache;
+			vertexCache.reserve(numFaceVertices);
+			mesh.indices.reserve(numFaceVertices);
+			std::vector<bool> hasNormal;
+
+			for (const auto& run : groupRuns[g])
+			{
+				const auto& faceVertices = chunks[run.chunk].faceVertices;
+				for (size_t t = run.firstTriangle; t < run.lastTriangle; t++)
+				{
+					const ObjFaceVertex* tri = &faceVertices[t * 3];
+					if (tri[0].v < 0 || tri[1].v < 0 || tri[2].v < 0 ||
+						static_cast<size_t>(tri[0].v) >= positions.size() ||
+						static_cast<size_t>(tri[1].v) >= positions.size() ||
+						static_cast<size_t>(tri[2].v) >= positions.size())
+						continue;
+
+					for (size_t k = 0; k < 3; k++)
+					{
+						const ObjFaceVertex& fv = tri[k];
+						const ObjVertexKey key{ fv.v, fv.vt, fv.vn };
+						auto [it, inserted] = vertexCache.try_emplace(key, static_cast<uint32_t>(mesh.vertices.size()));
+						if (inserted)
+						{
+							MeshVertex vertex;
+							vertex.position = positions[static_cast<size_t>(fv.v)];
+							if (hasColors) vertex.color = colors[static_cast<size_t>(fv.v)];
+							if (fv.vt >= 0 && static_cast<size_t>(fv.vt) < texCoords.size())
+							{
+								vertex.texCoord = texCoords[static_cast<size_t>(fv.vt)];
+								if (loadInfo.flipTexCoordV) vertex.texCoord.y = 1.0f - vertex.texCoord.y;
+							}
+							const bool validNormal = fv.vn >= 0 && static_cast<size_t>(fv.vn) < normals.size();
+							if (validNormal)
+								vertex.normal = normals[static_cast<size_t>(fv.vn)];
+							mesh.vertices.push_back(vertex);
+							hasNormal.push_back(validNormal);
+						}
+						mesh.indices.push_back(it->second);
+					}
+				}
+			}
+
+			if (loadInfo.generateNormals && std::find(hasNormal.begin(), hasNormal.end(), false) != hasNormal.end())
+				generateNormals(mesh, hasNormal);
+			if (loadInfo.generateTangents && !texCoords.empty())
+				generateTangents(mesh);
+		});
+
+	std::erase_if(outData.groups, [](const ObjGroup& group) { return group.mesh.vertices.empty(); });
+
+	return true;
+}
+//=============================================================================
\ No newline at end of file
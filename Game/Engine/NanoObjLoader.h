@@ -0,0 +1,51 @@
+﻿#pragma once
+
+#include "NanoRenderMesh.h"
+
+// Материал из .mtl. Текстуры - пути относительно каталога obj файла (уже с каталогом)
+struct ObjMaterial final
+{
+	std::string name;
+	glm::vec3   ambientColor{ 1.0f };
+	glm::vec3   diffuseColor{ 1.0f };
+	glm::vec3   specularColor{ 0.0f };
+	glm::vec3   emissionColor{ 0.0f };
+	float       shininess{ 0.0f };
+	float       opacity{ 1.0f };
+
+	std::string diffuseMap;
+	std::string specularMap;
+	std::string normalMap;
+	std::string shininessMap;
+	std::string emissionMap;
+	std::string opacityMap;
+};
+
+// Непрерывный набор граней с одним объектом (o/g) и одним материалом (usemtl). material в MeshInfo не заполняется
+struct ObjGroup final
+{
+	std::string objectName;
+	int         materialId{ -1 }; // индекс в ObjData::materials
+	MeshInfo    mesh;
+};
+
+struct ObjData final
+{
+	std::vector<ObjGroup>    groups;
+	std::vector<ObjMaterial> materials;
+	std::vector<std::string> materialLibraries; // .mtl файлы из mtllib (с каталогом), даже если материалы не грузились
+};
+
+struct ObjLoadInfo final
+{
+	bool flipTexCoordV{ false };    // как aiProcess_FlipUVs
+	bool generateNormals{ false };  // если в файле нет нормалей
+	bool generateTangents{ false };
+	bool loadMaterials{ true };
+};
+
+namespace obj
+{
+	// Файл отображается в память и разбирается параллельно кусками по строкам, группы собираются тоже параллельно
+	bool Load(const std::string& fileName, ObjData& outData, const ObjLoadInfo& loadInfo = {});
+} // namespace obj
\ No newline at end of file
@@ -0,0 +1,485 @@
+﻿#include "stdafx.h"
+#include "NanoOcclusion.h"
+#include "NanoCore.h"
+//=============================================================================
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#	include <emmintrin.h>
+#	define NANO_OCCLUSION_SSE2 1
+#endif
+//=============================================================================
+namespace
+{
+	constexpr size_t   TrianglesPerTask = 4096;
+	constexpr uint32_t FullCoverage = ~0u;
+	constexpr float    GuardBand = 4.0f; // треугольники обрезаются по |x|, |y| <= GuardBand * w - точность уравнений ребер
+	constexpr size_t   MaxClipVertices = 3 + 5;
+
+	// плоскости отсечения в пространстве отсечения, внутри - dot >= 0
+	const std::array<glm::vec4, 5> ClipPlanes = {
+		glm::vec4(0.0f, 0.0f, 1.0f, 1.0f),        // ближняя: z >= -w
+		glm::vec4(-1.0f, 0.0f, 0.0f, GuardBand),
+		glm::vec4(1.0f, 0.0f, 0.0f, GuardBand),
+		glm::vec4(0.0f, -1.0f, 0.0f, GuardBand),
+		glm::vec4(0.0f, 1.0f, 0.0f, GuardBand),
+	};
+	//-------------------------------------------------------------------------
+	// Сазерленд-Ходжман по одной плоскости
+	size_t clipPolygon(const glm::vec4& plane, const glm::vec4* in, size_t count, glm::vec4* out)
+	{
+		size_t outCount = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			const glm::vec4& a = in[i];
+			const glm::vec4& b = in[(i + 1) % count];
+			const float da = glm::dot(plane, a);
+			const float db = glm::dot(plane, b);
+			if (da >= 0.0f)
+				out[outCount++] = a;
+			if ((da >= 0.0f) != (db >= 0.0f))
+				out[outCount++] = glm::mix(a, b, da / (da - db));
+		}
+		return outCount;
+	}
+	//-------------------------------------------------------------------------
+	// бит y * TileWidth + x - центр пикселя внутри всех трех ребер
+	uint32_t computeCoverage(const glm::vec3* edge, float x0, float y0)
+	{
+		uint32_t coverage = 0;
+#if NANO_OCCLUSION_SSE2
+		const __m128 columns = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+		__m128 stepLo[3], stepHi[3];
+		for (int e = 0; e < 3; e++)
+		{
+			const __m128 a = _mm_set1_ps(edge[e].x);
+			stepLo[e] = _mm_mul_ps(a, columns);
+			stepHi[e] = _mm_add_ps(stepLo[e], _mm_mul_ps(a, _mm_set1_ps(4.0f)));
+		}
+		for (uint32_t row = 0; row < OcclusionBuffer::TileHeight; row++)
+		{
+			const float y = y0 + static_cast<float>(row) + 0.5f;
+			__m128 minLo = _mm_set1_ps(std::numeric_limits<float>::max());
+			__m128 minHi = minLo;
+			for (int e = 0; e < 3; e++)
+			{
+				const __m128 base = _mm_set1_ps(edge[e].x * x0 + edge[e].y * y + edge[e].z);
+				minLo = _mm_min_ps(minLo, _mm_add_ps(base, stepLo[e]));
+				minHi = _mm_min_ps(minHi, _mm_add_ps(base, stepHi[e]));
+			}
+			const __m128 zero = _mm_setzero_ps();
+			const uint32_t bits = static_cast<uint32_t>(_mm_movemask_ps(_mm_cmpge_ps(minLo, zero)) | (_mm_movemask_ps(_mm_cmpge_ps(minHi, zero)) << 4));
+			coverage |= bits << (row * OcclusionBuffer::TileWidth);
+		}
+#else
+		for (uint32_t row = 0; row < OcclusionBuffer::TileHeight; row++)
+		{
+			const float y = y0 + static_cast<float>(row) + 0.5f;
+			for (uint32_t column = 0; column < OcclusionBuffer::TileWidth; column++)
+			{
+				const float x = x0 + static_cast<float>(column) + 0.5f;
+				bool inside = true;
+				for (int e = 0; e < 3; e++)
+					inside = inside && edge[e].x * x + edge[e].y * y + edge[e].z >= 0.0f;
+				if (inside)
+					coverage |= 1u << (row * OcclusionBuffer::TileWidth + column);
+			}
+		}
+#endif
+		return coverage;
+	}
+} // namespace
+//=============================================================================
+void OcclusionBuffer::Resize(uint32_t width, uint32_t height)
+{
+	m_tilesX = std::max(1u, (width + TileWidth - 1) / TileWidth);
+	m_tilesY = std::max(1u, (height + TileHeight - 1) / TileHeight);
+	m_width = m_tilesX * TileWidth;
+	m_height = m_tilesY * TileHeight;
+
+	const size_t numTiles = static_cast<size_t>(m_tilesX) * m_tilesY;
+	m_depth0.assign(numTiles, 1.0f);
+	m_depth1.assign(numTiles, 0.0f);
+	m_coverage.assign(numTiles, 0u);
+}
+//=============================================================================
+void OcclusionBuffer::Begin(const glm::mat4& viewProj)
+{
+	if (m_width == 0) Resize(DefaultWidth, DefaultHeight);
+
+	m_viewProj = viewProj;
+	std::fill(m_depth0.begin(), m_depth0.end(), 1.0f);
+	std::fill(m_depth1.begin(), m_depth1.end(), 0.0f);
+	std::fill(m_coverage.begin(), m_coverage.end(), 0u);
+	m_occluders.clear();
+	m_numTriangles = 0;
+	m_hasOccluders = false;
+}
+//=============================================================================
+bool OcclusionBuffer::AddOccluder(const MeshPositions& geometry, const glm::mat4& transform, const AABB& worldBox)
+{
+	if (geometry.indices.size() < 3) return false;
+
+	// мелкий на экране окклюдер почти ничего не закрывает, а стоит столько же треугольников
+	glm::vec2 screenMin(std::numeric_limits<float>::max());
+	glm::vec2 screenMax(-std::numeric_limits<float>::max());
+	float distance = std::numeric_limits<float>::max();
+	for (uint32_t i = 0; i < 8; i++)
+	{
+		const glm::vec3 corner{ i & 1 ? worldBox.max.x : worldBox.min.x, i & 2 ? worldBox.max.y : worldBox.min.y, i & 4 ? worldBox.max.z : worldBox.min.z };
+		const glm::vec4 clip = m_viewProj * glm::vec4(corner, 1.0f);
+		if (clip.z < -clip.w)
+		{
+			// пересекает ближнюю плоскость - закрывает большую часть экрана
+			screenMin = glm::vec2(-1.0f);
+			screenMax = glm::vec2(1.0f);
+			distance = 0.0f;
+			break;
+		}
+		distance = std::min(distance, clip.w);
+		const glm::vec2 ndc = glm::vec2(clip) / clip.w;
+		screenMin = glm::min(screenMin, ndc);
+		screenMax = glm::max(screenMax, ndc);
+	}
+	screenMin = glm::clamp(screenMin, glm::vec2(-1.0f), glm::vec2(1.0f));
+	screenMax = glm::clamp(screenMax, glm::vec2(-1.0f), glm::vec2(1.0f));
+	const glm::vec2 screenSize = (screenMax - screenMin) * 0.5f;
+	if (screenSize.x * screenSize.y < MinOccluderArea)
+		return false;
+
+	m_occluders.push_back({ &geometry, m_viewProj * transform, distance });
+	return true;
+}
+//=============================================================================
+bool OcclusionBuffer::AddOccluder(const Mesh& mesh, const glm::mat4& transform)
+{
+	if (!mesh.IsOpaque()) return false;
+	return AddOccluder(mesh.GetPositions(), transform, mesh.GetAABB().GetTransformed(transform));
+}
+//=============================================================================
+void OcclusionBuffer::End()
+{
+	const auto startTime = std::chrono::steady_clock::now();
+
+	// ближние треугольники первыми - дальние чаще отбрасываются целиком по опорному слою
+	std::sort(m_occluders.begin(), m_occluders.end(), [](const Occluder& a, const Occluder& b) { return a.distance < b.distance; });
+
+	struct Task final
+	{
+		size_t occluder;
+		size_t firstIndex;
+		size_t lastIndex;
+	};
+	std::vector<Task> tasks;
+	for (size_t i = 0; i < m_occluders.size(); i++)
+	{
+		const size_t numIndices = m_occluders[i].geometry->indices.size() / 3 * 3;
+		for (size_t first = 0; first < numIndices; first += TrianglesPerTask * 3)
+			tasks.push_back({ i, first, std::min(numIndices, first + TrianglesPerTask * 3) });
+	}
+
+	m_triangles.resize(tasks.size());
+	ParallelFor(tasks.size(), [&](size_t t)
+		{
+			m_triangles[t].clear();
+			setupTriangles(m_occluders[tasks[t].occluder], tasks[t].firstIndex, tasks[t].lastIndex, m_triangles[t]);
+		});
+
+	m_numTriangles = 0;
+	for (size_t t = 0; t < tasks.size(); t++)
+		m_numTriangles += m_triangles[t].size();
+	m_hasOccluders = m_numTriangles > 0;
+
+	// полосы строк тайлов не пересекаются - потоки пишут без синхронизации. Порядок треугольников в полосе как при одном потоке
+	if (m_hasOccluders)
+	{
+		const size_t numBands = m_numTriangles < TrianglesPerTask ? 1 : std::min<size_t>(m_tilesY, std::max(1u, std::thread::hardware_concurrency()));
+		ParallelFor(numBands, [&](size_t band)
+			{
+				const uint32_t tileMinY = static_cast<uint32_t>(band * m_tilesY / numBands);
+				const uint32_t tileMaxY = static_cast<uint32_t>((band + 1) * m_tilesY / numBands) - 1;
+				for (size_t t = 0; t < tasks.size(); t++)
+				{
+					for (const Triangle& triangle : m_triangles[t])
+						rasterize(triangle, tileMinY, tileMaxY);
+				}
+			});
+	}
+
+	m_rasterTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+}
+//=============================================================================
+bool OcclusionBuffer::IsVisible(const AABB& worldBox) const
+{
+	if (!m_hasOccluders) return true;
+
+	glm::vec2 screenMin(std::numeric_limits<float>::max());
+	glm::vec2 screenMax(-std::numeric_limits<float>::max());
+	float minDepth = 1.0f;
+	for (uint32_t i = 0; i < 8; i++)
+	{
+		const glm::vec3 corner{ i & 1 ? worldBox.max.x : worldBox.min.x, i & 2 ? worldBox.max.y : worldBox.min.y, i & 4 ? worldBox.max.z : worldBox.min.z };
+		const glm::vec4 clip = m_viewProj * glm::vec4(corner, 1.0f);
+		if (clip.z < -clip.w || clip.w <= 0.0f)
+			return true;
+		const float invW = 1.0f / clip.w;
+		screenMin = glm::min(screenMin, glm::vec2(clip) * invW);
+		screenMax = glm::max(screenMax, glm::vec2(clip) * invW);
+		minDepth = std::min(minDepth, clip.z * invW * 0.5f + 0.5f);
+	}
+
+	const glm::vec2 size(static_cast<float>(m_width), static_cast<float>(m_height));
+	screenMin = (screenMin * 0.5f + 0.5f) * size;
+	screenMax = (screenMax * 0.5f + 0.5f) * size;
+	if (screenMax.x < 0.0f || screenMax.y < 0.0f || screenMin.x >= size.x || screenMin.y >= size.y)
+		return true; // вне экрана - решает отсечение пирамидой
+
+	const uint32_t tileMinX = static_cast<uint32_t>(std::max(screenMin.x, 0.0f)) / TileWidth;
+	const uint32_t tileMinY = static_cast<uint32_t>(std::max(screenMin.y, 0.0f)) / TileHeight;
+	const uint32_t tileMaxX = std::min(static_cast<uint32_t>(screenMax.x) / TileWidth, m_tilesX - 1);
+	const uint32_t tileMaxY = std::min(static_cast<uint32_t>(screenMax.y) / TileHeight, m_tilesY - 1);
+
+	// видим, если хоть в одном тайле ближайшая точка бокса не дальше опорного слоя
+	for (uint32_t ty = tileMinY; ty <= tileMaxY; ty++)
+	{
+		const float* depth = m_depth0.data() + static_cast<size_t>(ty) * m_tilesX;
+		uint32_t tx = tileMinX;
+#if NANO_OCCLUSION_SSE2
+		const __m128 boxDepth = _mm_set1_ps(minDepth);
+		for (; tx + 4 <= tileMaxX + 1; tx += 4)
+		{
+			if (_mm_movemask_ps(_mm_cmple_ps(boxDepth, _mm_loadu_ps(depth + tx))))
+				return true;
+		}
+#endif
+		for (; tx <= tileMaxX; tx++)
+		{
+			if (minDepth <= depth[tx])
+				return true;
+		}
+	}
+	return false;
+}
+//=============================================================================
+void OcclusionBuffer::GetDebugImage(std::vector<uint8_t>& pixels) const
+{
+	pixels.assign(static_cast<size_t>(m_width) * m_height * 4, 0);
+
+	// глубина OpenGL почти вся у 1 - растягивается на диапазон кадра
+	float nearest = 1.0f;
+	for (size_t i = 0; i < m_depth0.size(); i++)
+	{
+		nearest = std::min(nearest, m_depth0[i]);
+		if (m_coverage[i]) nearest = std::min(nearest, m_depth1[i]);
+	}
+	const float scale = nearest < 1.0f ? 1.0f / (1.0f - nearest) : 0.0f;
+	auto brightness = [&](float depth)
+		{
+			return static_cast<uint8_t>(40.0f + 215.0f * std::clamp((1.0f - depth) * scale, 0.0f, 1.0f));
+		};
+
+	for (uint32_t y = 0; y < m_height; y++)
+	{
+		for (uint32_t x = 0; x < m_width; x++)
+		{
+			const size_t tile = static_cast<size_t>(y / TileHeight) * m_tilesX + x / TileWidth;
+			const uint32_t bit = 1u << ((y % TileHeight) * TileWidth + x % TileWidth);
+			uint8_t* pixel = &pixels[(static_cast<size_t>(y) * m_width + x) * 4];
+			if ((m_coverage[tile] & bit) && m_depth1[tile] < m_depth0[tile])
+			{
+				pixel[2] = brightness(m_depth1[tile]);
+			}
+			else if (m_depth0[tile] < 1.0f)
+			{
+				pixel[0] = pixel[1] = pixel[2] = brightness(m_depth0[tile]);
+			}
+			pixel[3] = 255;
+		}
+	}
+}
+//=============================================================================
+void OcclusionBuffer::setupTriangles(const Occluder& occluder, size_t firstIndex, size_t lastIndex, std::vector<Triangle>& triangles) const
+{
+	const std::vector<glm::vec3>& positions = occluder.geometry->positions;
+	const std::vector<uint32_t>& indices = occluder.geometry->indices;
+
+	std::array<glm::vec4, MaxClipVertices> polygon, clipped;
+	for (size_t i = firstIndex; i + 2 < lastIndex; i += 3)
+	{
+		if (indices[i] >= positions.size() || indices[i + 1] >= positions.size() || indices[i + 2] >= positions.size())
+			continue;
+
+		polygon[0] = occluder.transform * glm::vec4(positions[indices[i]], 1.0f);
+		polygon[1] = occluder.transform * glm::vec4(positions[indices[i + 1]], 1.0f);
+		polygon[2] = occluder.transform * glm::vec4(positions[indices[i + 2]], 1.0f);
+
+		// целиком за одной из границ экрана или за дальней плоскостью
+		auto allOutside = [&](glm::length_t axis, float sign)
+			{
+				return sign * polygon[0][axis] > polygon[0].w && sign * polygon[1][axis] > polygon[1].w && sign * polygon[2][axis] > polygon[2].w;
+			};
+		if (allOutside(0, 1.0f) || allOutside(0, -1.0f) || allOutside(1, 1.0f) || allOutside(1, -1.0f) || allOutside(2, 1.0f))
+			continue;
+
+		size_t count = 3;
+		for (const glm::vec4& plane : ClipPlanes)
+		{
+			if (std::all_of(polygon.begin(), polygon.begin() + count, [&](const glm::vec4& v) { return glm::dot(plane, v) >= 0.0f; }))
+				continue;
+			count = clipPolygon(plane, polygon.data(), count, clipped.data());
+			std::copy_n(clipped.begin(), count, polygon.begin());
+			if (count < 3) break;
+		}
+
+		for (size_t v = 2; v < count; v++)
+			addTriangle(polygon[0], polygon[v - 1], polygon[v], triangles);
+	}
+}
+//=============================================================================
+void OcclusionBuffer::addTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2, std::vector<Triangle>& triangles) const
+{
+	const glm::vec2 size(static_cast<float>(m_width), static_cast<float>(m_height));
+	auto project = [&](const glm::vec4& v)
+		{
+			const float invW = 1.0f / v.w;
+			return glm::vec3((glm::vec2(v) * invW * 0.5f + 0.5f) * size, v.z * invW * 0.5f + 0.5f);
+		};
+	const glm::vec3 p0 = project(v0);
+	const glm::vec3 p1 = project(v1);
+	const glm::vec3 p2 = project(v2);
+
+	// задние грани (обход против часовой - передняя, как GL_CCW) и вырожденные
+	const float area = (p1.x - p0.x) * (p2.y - p0.y) - (p2.x - p0.x) * (p1.y - p0.y);
+	if (!(area > 0.0f)) return;
+
+	const float minX = std::min({ p0.x, p1.x, p2.x });
+	const float maxX = std::max({ p0.x, p1.x, p2.x });
+	const float minY = std::min({ p0.y, p1.y, p2.y });
+	const float maxY = std::max({ p0.y, p1.y, p2.y });
+	if (maxX < 0.0f || maxY < 0.0f || minX >= size.x || minY >= size.y)
+		return;
+
+	Triangle triangle;
+	triangle.minDepth = std::max(std::min({ p0.z, p1.z, p2.z }), 0.0f);
+	triangle.maxDepth = std::min(std::max({ p0.z, p1.z, p2.z }), 1.0f);
+	if (triangle.minDepth >= 1.0f) return;
+
+	const glm::vec3* p[3] = { &p0, &p1, &p2 };
+	for (int e = 0; e < 3; e++)
+	{
+		const glm::vec3& a = *p[e];
+		const glm::vec3& b = *p[(e + 1) % 3];
+		triangle.edge[e] = glm::vec3(a.y - b.y, b.x - a.x, a.x * b.y - a.y * b.x);
+	}
+
+	const float invArea = 1.0f / area;
+	const float depthX = ((p1.z - p0.z) * (p2.y - p0.y) - (p2.z - p0.z) * (p1.y - p0.y)) * invArea;
+	const float depthY = ((p1.x - p0.x) * (p2.z - p0.z) - (p2.x - p0.x) * (p1.z - p0.z)) * invArea;
+	triangle.depth = glm::vec3(depthX, depthY, p0.z - depthX * p0.x - depthY * p0.y);
+
+	triangle.tileMinX = static_cast<uint16_t>(static_cast<uint32_t>(std::max(minX, 0.0f)) / TileWidth);
+	triangle.tileMinY = static_cast<uint16_t>(static_cast<uint32_t>(std::max(minY, 0.0f)) / TileHeight);
+	triangle.tileMaxX = static_cast<uint16_t>(std::min(static_cast<uint32_t>(maxX) / TileWidth, m_tilesX - 1));
+	triangle.tileMaxY = static_cast<uint16_t>(std::min(static_cast<uint32_t>(maxY) / TileHeight, m_tilesY - 1));
+	triangles.push_back(triangle);
+}
+//=============================================================================
+void OcclusionBuffer::rasterize(const Triangle& triangle, uint32_t tileMinY, uint32_t tileMaxY)
+{
+	tileMinY = std::max<uint32_t>(tileMinY, triangle.tileMinY);
+	tileMaxY = std::min<uint32_t>(tileMaxY, triangle.tileMaxY);
+
+	for (uint32_t ty = tileMinY; ty <= tileMaxY; ty++)
+	{
+		const float y0 = static_cast<float>(ty * TileHeight);
+		// самая дальняя точка плоскости треугольника в тайле - угол по знакам градиента
+		const float farY = triangle.depth.y > 0.0f ? y0 + TileHeight - 0.5f : y0 + 0.5f;
+		for (uint32_t tx = triangle.tileMinX; tx <= triangle.tileMaxX; tx++)
+		{
+			const size_t tile = static_cast<size_t>(ty) * m_tilesX + tx;
+			if (triangle.minDepth >= m_depth0[tile])
+				continue; // целиком за опорным слоем
+
+			// по углам тайла: ребро снаружи всего тайла - пропуск, все ребра внутри - тайл покрыт целиком
+			const float x0 = static_cast<float>(tx * TileWidth);
+			const float left = x0 + 0.5f, right = x0 + TileWidth - 0.5f;
+			const float bottom = y0 + 0.5f, top = y0 + TileHeight - 0.5f;
+			bool outside = false, inside = true;
+			for (const glm::vec3& edge : triangle.edge)
+			{
+				const float maxValue = edge.x * (edge.x > 0.0f ? right : left) + edge.y * (edge.y > 0.0f ? top : bottom) + edge.z;
+				const float minValue = edge.x * (edge.x > 0.0f ? left : right) + edge.y * (edge.y > 0.0f ? bottom : top) + edge.z;
+				outside = outside || maxValue < 0.0f;
+				inside = inside && minValue >= 0.0f;
+			}
+			if (outside) continue;
+
+			const uint32_t coverage = inside ? FullCoverage : computeCoverage(triangle.edge, x0, y0);
+			if (!coverage) continue;
+
+			const float farX = triangle.depth.x > 0.0f ? x0 + TileWidth - 0.5f : x0 + 0.5f;
+			const float depth = std::min(triangle.depth.x * farX + triangle.depth.y * farY + triangle.depth.z, triangle.maxDepth);
+			updateTile(tile, coverage, depth);
+		}
+	}
+}
+//=============================================================================
+void OcclusionBuffer::updateTile(size_t tile, uint32_t coverage, float depth)
+{
+	float& depth0 = m_depth0[tile];
+	float& depth1 = m_depth1[tile];
+	uint32_t& mask = m_coverage[tile];
+
+	// рабочий слой ближе к опорному, чем к треугольнику - сбрасывается, иначе слияние завысило бы глубину
+	if (depth1 - depth > depth0 - depth1)
+	{
+		depth1 = 0.0f;
+		mask = 0;
+	}
+	depth1 = std::max(depth1, depth);
+	mask |= coverage;
+
+	// рабочий слой закрыл тайл целиком - становится опорным
+	if (mask == FullCoverage)
+	{
+		depth0 = std::min(depth0, depth1);
+		depth1 = 0.0f;
+		mask = 0;
+	}
+}
+//=============================================================================
+void OcclusionDebugView::Close()
+{
+	Destroy(m_texture);
+	m_width = m_height = 0;
+}
+//=============================================================================
+void OcclusionDebugView::Draw(const OcclusionBuffer& buffer)
+{
+	if (buffer.GetWidth() == 0) return;
+
+	buffer.GetDebugImage(m_pixels);
+	if (!IsValid(m_texture) || m_width != buffer.GetWidth() || m_height != buffer.GetHeight())
+	{
+		Destroy(m_texture);
+		m_width = buffer.GetWidth();
+		m_height = buffer.GetHeight();
+		m_texture = CreateTexture2D(m_width, m_height, InternalFormat::RGBA8, PixelFormat::Rgba, PixelType::UnsignedByte, m_pixels.data());
+	}
+	else
+		SetTextureData(m_texture, InternalFormat::RGBA8, m_width, m_height, PixelFormat::Rgba, PixelType::UnsignedByte, m_pixels.data());
+
+	if (const ImGuiViewport* v = ImGui::GetMainViewport())
+	{
+		ImGui::SetNextWindowPos({ v->WorkPos.x + 15.0f, v->WorkPos.y + v->WorkSize.y - 15.0f }, ImGuiCond_Always, { 0.0f, 1.0f });
+	}
+	ImGui::SetNextWindowBgAlpha(0.30f);
+	if (ImGui::Begin("##Occlusion", nullptr,
+		ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings |
+		ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav | ImGuiWindowFlags_NoMove))
+	{
+		ImGui::Text("Occluders: %zu, tris: %zu, %.2f ms", buffer.GetNumOccluders(), buffer.GetNumTriangles(), buffer.GetRasterTime());
+		// строка 0 текстуры - низ экрана
+		ImGui::Image(ImTextureRef(static_cast<ImTextureID>(m_texture.handle)), ImVec2(static_cast<float>(m_width * 2), static_cast<float>(m_height * 2)), ImVec2(0.0f, 1.0f), ImVec2(1.0f, 0.0f));
+	}
+	ImGui::End();
+}
+//=============================================================================
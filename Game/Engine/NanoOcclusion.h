@@ -0,0 +1,109 @@
+﻿#pragma once
+
+#include "NanoRenderMesh.h"
+#include "NanoCulling.h"
+#include "NanoOpenGL3.h"
+
+// Программный буфер глубины для отсечения перекрытых объектов (masked software occlusion culling, Andersson 2015).
+// Тайл 8x4 пикселя хранит маску покрытия рабочего слоя и две глубины: опорную (тайл закрыт целиком не дальше нее)
+// и рабочую (максимум по пикселям маски). Глубина как в OpenGL, [0, 1], 1 - дальняя плоскость.
+// Окклюдеры - крупные меши, растеризуются без текстур и альфа-теста; проверяются экранные прямоугольники AABB
+class OcclusionBuffer final
+{
+public:
+	static constexpr uint32_t TileWidth = 8;
+	static constexpr uint32_t TileHeight = 4;
+	static constexpr uint32_t DefaultWidth = 320;
+	static constexpr uint32_t DefaultHeight = 184;
+	// окклюдер меньше этой доли экрана (по экранному прямоугольнику AABB) не растеризуется
+	static constexpr float    MinOccluderArea = 0.01f;
+
+	// размеры округляются вверх до кратных тайлу
+	void Resize(uint32_t width, uint32_t height);
+
+	// очищает буфер. viewProj - та же матрица, что у камеры прохода
+	void Begin(const glm::mat4& viewProj);
+	// геометрия должна жить до End. worldBox - мировой AABB меша для отбора мелких окклюдеров. false - окклюдер отброшен
+	bool AddOccluder(const MeshPositions& geometry, const glm::mat4& transform, const AABB& worldBox);
+	// меши с прозрачностью или альфа-тестом (Mesh::IsOpaque) отбрасываются
+	bool AddOccluder(const Mesh& mesh, const glm::mat4& transform);
+	// подготовка треугольников и растеризация на всех ядрах
+	void End();
+
+	// false - бокс целиком за окклюдерами. Бокс, пересекающий ближнюю плоскость, всегда видим
+	bool IsVisible(const AABB& worldBox) const;
+	// оставляет в visible только id, бокс которых видим. getBox(id) - мировой AABB
+	template<typename F>
+	void Cull(std::vector<uint32_t>& visible, F&& getBox) const
+	{
+		const size_t numTested = visible.size();
+		if (m_hasOccluders)
+			std::erase_if(visible, [&](uint32_t id) { return !IsVisible(getBox(id)); });
+		culling::AddStats(CullingView::Occlusion, numTested, visible.size());
+	}
+
+	uint32_t GetWidth() const { return m_width; }
+	uint32_t GetHeight() const { return m_height; }
+	size_t GetNumOccluders() const { return m_occluders.size(); }
+	size_t GetNumTriangles() const { return m_numTriangles; }
+	// время End в мс
+	double GetRasterTime() const { return m_rasterTimeMs; }
+
+	// RGBA8, строка 0 - низ экрана: опорный слой серым (ближе - светлее), пиксели рабочего слоя синим, пусто - черный
+	void GetDebugImage(std::vector<uint8_t>& pixels) const;
+
+private:
+	struct Occluder final
+	{
+		const MeshPositions* geometry;
+		glm::mat4            transform; // viewProj * модель
+		float                distance;  // ближайшая w углов AABB - окклюдеры рисуются от ближних к дальним
+	};
+
+	// треугольник после отсечения ближней плоскостью, в пикселях
+	struct Triangle final
+	{
+		glm::vec3 edge[3];  // a, b, c: a*x + b*y + c >= 0 внутри
+		glm::vec3 depth;    // z = a*x + b*y + c
+		float     minDepth;
+		float     maxDepth;
+		uint16_t  tileMinX, tileMaxX;
+		uint16_t  tileMinY, tileMaxY;
+	};
+
+	void setupTriangles(const Occluder& occluder, size_t firstIndex, size_t lastIndex, std::vector<Triangle>& triangles) const;
+	void addTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2, std::vector<Triangle>& triangles) const;
+	void rasterize(const Triangle& triangle, uint32_t tileMinY, uint32_t tileMaxY);
+	void updateTile(size_t tile, uint32_t coverage, float depth);
+
+	uint32_t  m_width{ 0 };
+	uint32_t  m_height{ 0 };
+	uint32_t  m_tilesX{ 0 };
+	uint32_t  m_tilesY{ 0 };
+	glm::mat4 m_viewProj{ 1.0f };
+
+	// по тайлам, SoA - проверка идет по 4 тайла
+	std::vector<float>    m_depth0;   // опорный слой
+	std::vector<float>    m_depth1;   // рабочий слой
+	std::vector<uint32_t> m_coverage; // бит y * TileWidth + x - пиксель закрыт рабочим слоем
+
+	std::vector<Occluder>              m_occluders;
+	std::vector<std::vector<Triangle>> m_triangles; // по задачам подготовки
+	size_t                             m_numTriangles{ 0 };
+	bool                               m_hasOccluders{ false };
+	double                             m_rasterTimeMs{ 0.0 };
+};
+
+// Отладочный вид буфера окклюзии - окно ImGui с картинкой. Требует контекст OpenGL
+class OcclusionDebugView final
+{
+public:
+	void Close();
+	void Draw(const OcclusionBuffer& buffer);
+
+private:
+	Texture2DHandle      m_texture{ 0 };
+	uint32_t             m_width{ 0 };
+	uint32_t             m_height{ 0 };
+	std::vector<uint8_t> m_pixels;
+};
@@ -260,6 +260,12 @@ void BindTexture2D(GLenum id, Texture2DHandle texture)
 	glBindTexture(GL_TEXTURE_2D, texture.handle);
 }
 //=============================================================================
+void BindTexture2DArray(GLenum id, Texture2DArrayHandle texture)
+{
+	glActiveTexture(GL_TEXTURE0 + id);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture.handle);
+}
+//=============================================================================
 bool IsValid(Texture1DHandle id)
 {
 	return id.handle > 0;
@@ -364,6 +370,11 @@ void SetTextureParameters(Texture3DHandle texture, const TextureConfig& config)
 	setTextureParameters(GL_TEXTURE_3D, texture.handle, config);
 }
 //=============================================================================
+void SetTextureParameters(Texture2DArrayHandle texture, const TextureConfig& config)
+{
+	setTextureParameters(GL_TEXTURE_2D_ARRAY, texture.handle, config);
+}
+//=============================================================================
 void SetTextureParameters(TextureCubeHandle texture, const TextureConfig& config)
 {
 	setTextureParameters(GL_TEXTURE_CUBE_MAP, texture.handle, config);
@@ -681,6 +692,23 @@ GLuint GetCurrentTexture(GLenum target)
 	return currentState;
 }
 //=============================================================================
+bool IsExtensionSupported(std::string_view name)
+{
+	static const std::set<std::string, std::less<>> extensions = []()
+		{
+			std::set<std::string, std::less<>> result;
+			GLint numExtensions = 0;
+			glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+			for (GLint i = 0; i < numExtensions; i++)
+			{
+				if (const GLubyte* extension = glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)); extension)
+					result.emplace(reinterpret_cast<const char*>(extension));
+			}
+			return result;
+		}();
+	return extensions.contains(name);
+}
+//=============================================================================
 void EnableSRGB(bool enable)
 {
 #if ENABLE_SRGB
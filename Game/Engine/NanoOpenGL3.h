@@ -82,6 +82,7 @@ void SetTextureData(Texture2DArrayHandle texture, InternalFormat internalformat,
 void SetTextureData(TextureCubeHandle texture, InternalFormat internalformat, unsigned width, unsigned height, PixelFormat format, PixelType type, const void* posX, const void* negX, const void* posY, const void* negY, const void* posZ, const void* negZ);
 
 void BindTexture2D(GLenum id, Texture2DHandle texture);
+void BindTexture2DArray(GLenum id, Texture2DArrayHandle texture);
 
 bool IsValid(Texture1DHandle id);
 bool IsValid(Texture2DHandle id);
@@ -109,6 +110,7 @@ struct TextureConfig final
 void SetTextureParameters(Texture1DHandle texture, const TextureConfig& config);
 void SetTextureParameters(Texture2DHandle texture, const TextureConfig& config);
 void SetTextureParameters(Texture3DHandle texture, const TextureConfig& config);
+void SetTextureParameters(Texture2DArrayHandle texture, const TextureConfig& config);
 void SetTextureParameters(TextureCubeHandle texture, const TextureConfig& config);
 
 //=============================================================================
@@ -225,6 +227,9 @@ void BindState(const GLState& state);
 
 GLuint GetCurrentTexture(GLenum target);
 
+// список расширений читается один раз, при первом вызове
+bool IsExtensionSupported(std::string_view name);
+
 void EnableSRGB(bool enable);
 
 //=============================================================================
@@ -2,6 +2,17 @@
 
 #include "NanoOpenGL3Advance.h"
 #include "NanoMath.h"
+#include "NanoCulling.h"
+#include "NanoAABBTree.h"
+#include "NanoOcclusion.h"
+#include "NanoGPUCulling.h"
+#include "NanoShadowScheduler.h"
+#include "NanoShadowAtlas.h"
+#include "NanoClusteredLighting.h"
+#include "NanoGPUTimer.h"
+#include "NanoDepthPrePass.h"
+#include "NanoFullscreenQuad.h"
+#include "NanoRenderGraph.h"
 #include "NanoRenderTextures.h"
 #include "NanoRenderMaterial.h"
 #include "NanoRenderMesh.h"
@@ -0,0 +1,244 @@
+﻿#include "stdafx.h"
+#include "NanoRenderGraph.h"
+#include "NanoLog.h"
+//=============================================================================
+void TransientTexturePool::Close()
+{
+	for (auto& entry : m_entries)
+		entry->fbo.Destroy();
+	m_entries.clear();
+	m_frame = 0;
+}
+//=============================================================================
+Framebuffer* TransientTexturePool::Acquire(const RGTextureDesc& desc)
+{
+	for (auto& entry : m_entries)
+	{
+		if (!entry->used && entry->desc == desc)
+		{
+			entry->used = true;
+			entry->lastUsedFrame = m_frame;
+			return &entry->fbo;
+		}
+	}
+
+	FramebufferInfo fboInfo;
+	fboInfo.colorAttachments.resize(1);
+	fboInfo.colorAttachments[0].type = AttachmentType::Texture;
+	fboInfo.colorAttachments[0].format = desc.format;
+	fboInfo.colorAttachments[0].dataType = desc.dataType;
+	fboInfo.colorAttachments[0].precision = desc.precision;
+	fboInfo.width = desc.width;
+	fboInfo.height = desc.height;
+
+	auto entry = std::make_unique<Entry>();
+	if (!entry->fbo.Create(fboInfo))
+	{
+		return nullptr;
+	}
+	entry->desc = desc;
+	entry->lastUsedFrame = m_frame;
+	entry->used = true;
+	m_entries.push_back(std::move(entry));
+	return &m_entries.back()->fbo;
+}
+//=============================================================================
+void TransientTexturePool::Release(const Framebuffer* fbo)
+{
+	for (auto& entry : m_entries)
+	{
+		if (&entry->fbo == fbo)
+		{
+			entry->used = false;
+			return;
+		}
+	}
+}
+//=============================================================================
+void TransientTexturePool::EndFrame()
+{
+	std::erase_if(m_entries, [&](const std::unique_ptr<Entry>& entry)
+		{
+			if (entry->used || m_frame - entry->lastUsedFrame < MaxUnusedFrames)
+				return false;
+			entry->fbo.Destroy();
+			return true;
+		});
+	m_frame++;
+}
+//=============================================================================
+RGResource RGPassBuilder::Create(std::string_view name, const RGTextureDesc& desc)
+{
+	m_graph.m_resources.push_back({ .name = std::string(name), .desc = desc, .transient = true });
+	const RGResource resource = m_graph.addVersion(static_cast<uint32_t>(m_graph.m_resources.size() - 1), m_pass);
+	m_graph.m_passes[m_pass].writes.push_back(resource.id);
+	return resource;
+}
+//=============================================================================
+RGResource RGPassBuilder::Write(RGResource resource)
+{
+	assert(resource.IsValid() && resource.id < m_graph.m_versions.size());
+	// содержимое прошлой версии сохраняется - это тоже чтение
+	Read(resource);
+	const RGResource written = m_graph.addVersion(m_graph.m_versions[resource.id].resource, m_pass);
+	m_graph.m_passes[m_pass].writes.push_back(written.id);
+	return written;
+}
+//=============================================================================
+void RGPassBuilder::Read(RGResource resource)
+{
+	assert(resource.IsValid() && resource.id < m_graph.m_versions.size());
+	m_graph.m_passes[m_pass].reads.push_back(resource.id);
+}
+//=============================================================================
+void RGPassBuilder::SideEffect()
+{
+	m_graph.m_passes[m_pass].sideEffect = true;
+}
+//=============================================================================
+void RenderGraph::Close()
+{
+	clear();
+	m_executed.clear();
+	m_pool.Close();
+}
+//=============================================================================
+RGResource RenderGraph::Import(std::string_view name)
+{
+	m_resources.push_back({ .name = std::string(name), .desc = {} });
+	return addVersion(static_cast<uint32_t>(m_resources.size() - 1), RGResource::Invalid);
+}
+//=============================================================================
+uint32_t RenderGraph::AddPass(std::string_view name, const SetupFunc& setup)
+{
+	const uint32_t pass = static_cast<uint32_t>(m_passes.size());
+	m_passes.push_back({ .name = std::string(name), .execute = {}, .reads = {}, .writes = {} });
+	RGPassBuilder builder(*this, pass);
+	ExecuteFunc execute = setup(builder);
+	m_passes[pass].execute = std::move(execute);
+	return pass;
+}
+//=============================================================================
+void RenderGraph::Execute()
+{
+	m_executed = cull();
+
+	// время жизни временных текстур - от первого до последнего выполняемого прохода, который к ним обращается
+	constexpr uint32_t Unused = RGResource::Invalid;
+	for (auto& resource : m_resources)
+	{
+		resource.firstPass = Unused;
+		resource.lastPass = 0;
+	}
+	for (uint32_t pass = 0; pass < m_passes.size(); pass++)
+	{
+		if (!m_executed[pass]) continue;
+		for (const auto* versions : { &m_passes[pass].reads, &m_passes[pass].writes })
+		{
+			for (const uint32_t version : *versions)
+			{
+				Resource& resource = m_resources[m_versions[version].resource];
+				resource.firstPass = std::min(resource.firstPass, pass);
+				resource.lastPass = std::max(resource.lastPass, pass);
+			}
+		}
+	}
+
+	for (uint32_t pass = 0; pass < m_passes.size(); pass++)
+	{
+		if (!m_executed[pass]) continue;
+
+		// писатели идут раньше читателей, и все они живые - невыполненный писатель значит пропущенный проход.
+		// Его результат не определен, поэтому пропускаются и все, кто его читает, вплоть до вывода на экран
+		bool allocated = true;
+		for (const uint32_t version : m_passes[pass].reads)
+		{
+			const uint32_t writer = m_versions[version].writer;
+			if (writer != RGResource::Invalid && !m_executed[writer])
+			{
+				Error("Render graph: pass " + m_passes[writer].name + " was skipped, pass " + m_passes[pass].name + " skipped");
+				allocated = false;
+				break;
+			}
+		}
+		for (auto& resource : m_resources)
+		{
+			if (allocated && resource.transient && resource.firstPass == pass)
+			{
+				resource.fbo = m_pool.Acquire(resource.desc);
+				if (!resource.fbo)
+				{
+					Error("Render graph: no texture for " + resource.name + ", pass " + m_passes[pass].name + " skipped");
+					allocated = false;
+				}
+			}
+		}
+
+		if (allocated)
+			m_passes[pass].execute(*this);
+		else
+			m_executed[pass] = false;
+
+		// освобожденная текстура достается следующим проходам - в этом и состоит алиасинг
+		for (auto& resource : m_resources)
+		{
+			if (resource.transient && resource.lastPass == pass && resource.fbo)
+				m_pool.Release(resource.fbo);
+		}
+	}
+
+	m_pool.EndFrame();
+	clear();
+}
+//=============================================================================
+Framebuffer& RenderGraph::GetFramebuffer(RGResource resource) const
+{
+	assert(resource.IsValid() && resource.id < m_versions.size());
+	const Resource& res = m_resources[m_versions[resource.id].resource];
+	assert(res.transient && res.fbo);
+	return *res.fbo;
+}
+//=============================================================================
+RGResource RenderGraph::addVersion(uint32_t resource, uint32_t writer)
+{
+	m_versions.push_back({ .resource = resource, .writer = writer });
+	return { static_cast<uint32_t>(m_versions.size() - 1) };
+}
+//=============================================================================
+std::vector<bool> RenderGraph::cull() const
+{
+	// нужны проходы с внешним результатом и, рекурсивно, писатели всего, что они читают
+	std::vector<bool> live(m_passes.size(), false);
+	std::vector<uint32_t> stack;
+	for (uint32_t pass = 0; pass < m_passes.size(); pass++)
+	{
+		if (m_passes[pass].sideEffect)
+		{
+			live[pass] = true;
+			stack.push_back(pass);
+		}
+	}
+	while (!stack.empty())
+	{
+		const uint32_t pass = stack.back();
+		stack.pop_back();
+		for (const uint32_t version : m_passes[pass].reads)
+		{
+			const uint32_t writer = m_versions[version].writer;
+			if (writer != RGResource::Invalid && !live[writer])
+			{
+				live[writer] = true;
+				stack.push_back(writer);
+			}
+		}
+	}
+	return live;
+}
+//=============================================================================
+void RenderGraph::clear()
+{
+	m_resources.clear();
+	m_versions.clear();
+	m_passes.clear();
+}
+//=============================================================================
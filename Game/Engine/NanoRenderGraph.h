@@ -0,0 +1,138 @@
+﻿#pragma once
+
+#include "Framebuffer.h"
+
+// временная текстура графа - framebuffer с одним цветовым вложением
+struct RGTextureDesc final
+{
+	uint16_t       width{ 1 };
+	uint16_t       height{ 1 };
+	ColorFormat    format{ ColorFormat::RGBA };
+	DataType       dataType{ DataType::UnsignedByte };
+	ColorPrecision precision{ ColorPrecision::Default };
+
+	bool operator==(const RGTextureDesc&) const = default;
+};
+
+// Пул временных текстур графа. В OpenGL 3.3 нельзя разместить две текстуры в одной памяти, поэтому алиасинг - это
+// повторное использование одного framebuffer'а ресурсами с одинаковым описанием и непересекающимся временем жизни.
+// Содержимое выданной текстуры не определено. Не нужные MaxUnusedFrames кадров удаляются (например, после смены размера окна)
+class TransientTexturePool final
+{
+public:
+	static constexpr uint32_t MaxUnusedFrames = 30;
+
+	void Close();
+
+	// nullptr - не удалось создать framebuffer
+	Framebuffer* Acquire(const RGTextureDesc& desc);
+	void Release(const Framebuffer* fbo);
+	void EndFrame();
+
+	size_t GetNumTextures() const { return m_entries.size(); }
+
+private:
+	struct Entry final
+	{
+		RGTextureDesc desc;
+		Framebuffer   fbo;
+		uint32_t      lastUsedFrame{ 0 };
+		bool          used{ false };
+	};
+	std::vector<std::unique_ptr<Entry>> m_entries;
+	uint32_t                            m_frame{ 0 };
+};
+
+// версия ресурса графа: каждая запись дает новую версию, чтение связывает проход с ее писателем
+struct RGResource final
+{
+	static constexpr uint32_t Invalid = ~0u;
+
+	bool IsValid() const { return id != Invalid; }
+
+	uint32_t id{ Invalid };
+};
+
+class RenderGraph;
+
+class RGPassBuilder final
+{
+public:
+	// временная текстура, которую заполняет этот проход
+	RGResource Create(std::string_view name, const RGTextureDesc& desc);
+	// запись поверх прошлой версии - проход выполняется после ее писателя
+	RGResource Write(RGResource resource);
+	void Read(RGResource resource);
+	// результат уходит за пределы графа (экран) - проход не отсекается
+	void SideEffect();
+
+private:
+	friend class RenderGraph;
+	RGPassBuilder(RenderGraph& graph, uint32_t pass) : m_graph(graph), m_pass(pass) {}
+
+	RenderGraph& m_graph;
+	uint32_t     m_pass;
+};
+
+// Граф проходов кадра. Проходы объявляют чтения и записи ресурсов, граф отсекает проходы, результат которых никто не
+// читает, и выдает временные текстуры из пула на время от первой записи до последнего чтения.
+// Ресурс можно получить только из уже добавленного прохода, поэтому порядок добавления - всегда порядок зависимостей.
+// Собирается заново каждый кадр: Import/AddPass, затем Execute
+class RenderGraph final
+{
+public:
+	using ExecuteFunc = std::function<void(const RenderGraph&)>;
+	// объявляет ресурсы прохода и возвращает его отрисовку - она захватывает полученные ресурсы по значению
+	using SetupFunc = std::function<ExecuteFunc(RGPassBuilder&)>;
+
+	void Close();
+
+	// ресурс, который живет вне графа (G-буфер, кадр сцены, атлас теней) - граф только упорядочивает доступ к нему
+	RGResource Import(std::string_view name);
+	uint32_t AddPass(std::string_view name, const SetupFunc& setup);
+
+	void Execute();
+
+	// временная текстура - только внутри ExecuteFunc прохода, который ее объявил
+	Framebuffer& GetFramebuffer(RGResource resource) const;
+	// выполнялся ли проход в последнем Execute
+	bool WasExecuted(uint32_t pass) const { return pass < m_executed.size() && m_executed[pass]; }
+	size_t GetNumPooledTextures() const { return m_pool.GetNumTextures(); }
+
+private:
+	friend class RGPassBuilder;
+
+	struct Resource final
+	{
+		std::string   name;
+		RGTextureDesc desc;
+		bool          transient{ false };
+		Framebuffer*  fbo{ nullptr };
+		uint32_t      firstPass{ 0 }; // время жизни в номерах выполняемых проходов
+		uint32_t      lastPass{ 0 };
+	};
+	struct Version final
+	{
+		uint32_t resource{ 0 };
+		uint32_t writer{ RGResource::Invalid };
+	};
+	struct Pass final
+	{
+		std::string           name;
+		ExecuteFunc           execute;
+		std::vector<uint32_t> reads;  // версии
+		std::vector<uint32_t> writes;
+		bool                  sideEffect{ false };
+	};
+
+	RGResource addVersion(uint32_t resource, uint32_t writer);
+	std::vector<bool> cull() const;
+	void clear();
+
+	std::vector<Resource> m_resources;
+	std::vector<Version>  m_versions;
+	std::vector<Pass>     m_passes;
+	std::vector<bool>     m_executed;
+	TransientTexturePool  m_pool;
+};
+
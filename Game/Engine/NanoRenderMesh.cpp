@@ -1,35 +1,72 @@
 ﻿#include "stdafx.h"
 #include "NanoRenderMesh.h"
+#include "NanoLog.h"
+#include "OGLContext.h"
 //=============================================================================
-Mesh::Mesh(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices, std::optional<Material> material, std::optional<PBRMaterial> pbrMaterial)
+Mesh::Mesh(std::span<const MeshVertex> vertices, std::span<const uint32_t> indices, std::optional<Material> material, std::optional<PBRMaterial> pbrMaterial)
 {
 	assert(!vertices.empty());
 
 	m_vertexCount = static_cast<uint32_t>(vertices.size());
 	m_indicesCount = static_cast<uint32_t>(indices.size());
 
-	m_material = material;
-	m_pbrMaterial = pbrMaterial;
-
-	GLuint currentVBO = GetCurrentBuffer(BufferTarget::Array);
-	GLuint currentEBO = GetCurrentBuffer(BufferTarget::ElementArray);
+	m_material = std::move(material);
+	m_pbrMaterial = std::move(pbrMaterial);
 
 	// Buffers
-	m_vbo = CreateBuffer(BufferTarget::Array, BufferUsage::StaticDraw, vertices.size() * sizeof(MeshVertex), vertices.data());
+	m_vbo = CreateBuffer(BufferTarget::Array, BufferUsage::StaticDraw, vertices.size_bytes(), vertices.data());
 	if (!indices.empty())
-		m_ebo = CreateBuffer(BufferTarget::ElementArray, BufferUsage::StaticDraw, indices.size() * sizeof(uint32_t), indices.data());
+		m_ebo = CreateBuffer(BufferTarget::ElementArray, BufferUsage::StaticDraw, indices.size_bytes(), indices.data());
 
-	// VAO
-	glGenVertexArrays(1, &m_vao);
-	glBindVertexArray(m_vao);
-	glBindBuffer(GL_ARRAY_BUFFER, m_vbo.handle);
-	if (m_ebo.handle > 0) glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo.handle);
-	MeshVertex::SetVertexAttributes();
-	glBindVertexArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, currentVBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, currentEBO);
+	initVAO();
+	initAABB(vertices);
+}
+//=============================================================================
+Mesh::Mesh(uint32_t vertexCount, uint32_t indexCount, const MeshWriteFunc& writeFunc, std::optional<Material> material, std::optional<PBRMaterial> pbrMaterial)
+{
+	assert(vertexCount > 0 && writeFunc);
+
+	m_vertexCount = vertexCount;
+	m_indicesCount = indexCount;
+
+	m_material = std::move(material);
+	m_pbrMaterial = std::move(pbrMaterial);
+
+	const GLsizeiptr vertexSize = static_cast<GLsizeiptr>(vertexCount * sizeof(MeshVertex));
+	const GLsizeiptr indexSize = static_cast<GLsizeiptr>(indexCount * sizeof(uint32_t));
+
+	// Buffers - память выделяется без данных, данные пишутся сразу в отображенный буфер
+	m_vbo = CreateBuffer(BufferTarget::Array, BufferUsage::StaticDraw, static_cast<size_t>(vertexSize), nullptr);
+	if (indexCount > 0)
+		m_ebo = CreateBuffer(BufferTarget::ElementArray, BufferUsage::StaticDraw, static_cast<size_t>(indexSize), nullptr);
+
+	constexpr GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT;
+	auto* vertices = static_cast<MeshVertex*>(MapBuffer(m_vbo, BufferTarget::Array, 0, vertexSize, access));
+	uint32_t* indices = nullptr;
+	if (indexCount > 0)
+		indices = static_cast<uint32_t*>(MapBuffer(m_ebo, BufferTarget::ElementArray, 0, indexSize, access));
+
+	bool mapped = vertices && (indices || indexCount == 0);
+	if (mapped)
+		writeFunc({ vertices, vertexCount }, { indices, indexCount }, m_aabb);
+
+	if (vertices) mapped = UnmapBuffer(m_vbo, BufferTarget::Array) && mapped;
+	if (indices)  mapped = UnmapBuffer(m_ebo, BufferTarget::ElementArray) && mapped;
 
-	initAABB(vertices, indices);
+	if (!mapped)
+	{
+		// драйвер не смог отобразить буфер или данные были потеряны - заливаем через временную память
+		Warning("Mesh buffer mapping failed, fallback to glBufferSubData");
+		std::vector<MeshVertex> tempVertices(vertexCount);
+		std::vector<uint32_t> tempIndices(indexCount);
+		m_aabb = AABB();
+		writeFunc(tempVertices, tempIndices, m_aabb);
+		BufferSubData(m_vbo, BufferTarget::Array, 0, vertexSize, tempVertices.data());
+		if (indexCount > 0)
+			BufferSubData(m_ebo, BufferTarget::ElementArray, 0, indexSize, tempIndices.data());
+	}
+
+	initVAO();
 }
 //=============================================================================
 Mesh::Mesh(Mesh&& old) noexcept
@@ -41,6 +78,7 @@ Mesh::Mesh(Mesh&& old) noexcept
 	, m_material(std::exchange(old.m_material, std::nullopt))
 	, m_pbrMaterial(std::exchange(old.m_pbrMaterial, std::nullopt))
 	, m_aabb(old.m_aabb)
+	, m_positions(std::move(old.m_positions))
 {
 }
 //=============================================================================
@@ -64,6 +102,7 @@ Mesh& Mesh::operator=(Mesh&& old) noexcept
 		m_material = std::exchange(old.m_material, std::nullopt);
 		m_pbrMaterial = std::exchange(old.m_pbrMaterial, std::nullopt);
 		m_aabb = old.m_aabb;
+		m_positions = std::move(old.m_positions);
 	}
 	return *this;
 }
@@ -71,6 +110,8 @@ Mesh& Mesh::operator=(Mesh&& old) noexcept
 void Mesh::Draw(GLenum mode, unsigned instanceCount) const
 {
 	assert(m_vao);
+	if (instanceCount == 0) return; // все экземпляры отсечены
+
 	glBindVertexArray(m_vao);
 
 	if (m_ebo.handle > 0)
@@ -83,14 +124,70 @@ void Mesh::Draw(GLenum mode, unsigned instanceCount) const
 	else
 	{
 		if (instanceCount > 1)
-			; // TODO:???
+			glDrawArraysInstanced(mode, 0, static_cast<GLsizei>(m_vertexCount), static_cast<GLsizei>(instanceCount));
 		else
 			glDrawArrays(mode, 0, static_cast<GLsizei>(m_vertexCount));
 	}
 	glBindVertexArray(0);
 }
 //=============================================================================
-void Mesh::tDraw(GLenum mode, ProgramHandle program, bool bindMaterial, bool instancing, int amount)
+void Mesh::DrawIndirect(GLenum mode, size_t commandOffset) const
+{
+	assert(m_vao);
+	glBindVertexArray(m_vao);
+	if (m_ebo.handle > 0)
+		OGLContext::DrawElementsIndirect(mode, commandOffset);
+	else
+		OGLContext::DrawArraysIndirect(mode, commandOffset);
+	glBindVertexArray(0);
+}
+//=============================================================================
+const MeshPositions& Mesh::GetPositions() const
+{
+	if (m_positions) return *m_positions;
+
+	m_positions = std::make_unique<MeshPositions>();
+	m_positions->positions.resize(m_vertexCount);
+
+	const GLsizeiptr vertexSize = static_cast<GLsizeiptr>(m_vertexCount * sizeof(MeshVertex));
+	if (const auto* vertices = static_cast<const MeshVertex*>(MapBuffer(m_vbo, BufferTarget::Array, 0, vertexSize, GL_MAP_READ_BIT)))
+	{
+		for (uint32_t i = 0; i < m_vertexCount; i++)
+			m_positions->positions[i] = vertices[i].position;
+		UnmapBuffer(m_vbo, BufferTarget::Array);
+	}
+	else
+	{
+		Warning("Mesh buffer read failed");
+		m_positions->positions.clear();
+		return *m_positions;
+	}
+
+	if (m_ebo.handle > 0)
+	{
+		m_positions->indices.resize(m_indicesCount);
+		const GLsizeiptr indexSize = static_cast<GLsizeiptr>(m_indicesCount * sizeof(uint32_t));
+		if (const void* indices = MapBuffer(m_ebo, BufferTarget::ElementArray, 0, indexSize, GL_MAP_READ_BIT))
+		{
+			std::memcpy(m_positions->indices.data(), indices, static_cast<size_t>(indexSize));
+			UnmapBuffer(m_ebo, BufferTarget::ElementArray);
+		}
+		else
+		{
+			Warning("Mesh buffer read failed");
+			m_positions->positions.clear();
+			m_positions->indices.clear();
+		}
+	}
+	else
+	{
+		m_positions->indices.resize(m_vertexCount);
+		std::iota(m_positions->indices.begin(), m_positions->indices.end(), 0u);
+	}
+	return *m_positions;
+}
+//=============================================================================
+void Mesh::tDraw(GLenum mode, ProgramHandle program, bool bindMaterial, bool instancing, int amount) const
 {
 	assert(m_vao);
 
@@ -157,21 +254,38 @@ void Mesh::tDraw(GLenum mode, ProgramHandle program, bool bindMaterial, bool ins
 	glBindVertexArray(0);
 }
 //=============================================================================
-void Mesh::initAABB(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indexData)
+bool Mesh::IsOpaque() const noexcept
 {
-	if (indexData.size() > 0)
-	{
-		for (size_t index_id = 0; index_id < indexData.size(); index_id++)
-		{
-			m_aabb.CombinePoint(vertices[indexData[index_id]].position);
-		}
-	}
-	else
+	auto hasAlpha = [](const Texture2D& texture) { return IsValid(texture) && (texture.pixelFormat == PixelFormat::Rgba || texture.pixelFormat == PixelFormat::Bgra); };
+
+	if (m_material)
 	{
-		for (size_t vertex_id = 0; vertex_id < vertices.size(); vertex_id++)
-		{
-			m_aabb.CombinePoint(vertices[vertex_id].position);
-		}
+		if (m_material->opacity < 1.0f || !m_material->opacityTextures.empty())
+			return false;
+		if (std::any_of(m_material->diffuseTextures.begin(), m_material->diffuseTextures.end(), hasAlpha))
+			return false;
 	}
+	return !m_pbrMaterial || !hasAlpha(m_pbrMaterial->albedoTexture);
+}
+//=============================================================================
+void Mesh::initVAO()
+{
+	GLuint currentVBO = GetCurrentBuffer(BufferTarget::Array);
+	GLuint currentEBO = GetCurrentBuffer(BufferTarget::ElementArray);
+
+	glGenVertexArrays(1, &m_vao);
+	glBindVertexArray(m_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo.handle);
+	if (m_ebo.handle > 0) glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo.handle);
+	MeshVertex::SetVertexAttributes();
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, currentVBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, currentEBO);
+}
+//=============================================================================
+void Mesh::initAABB(std::span<const MeshVertex> vertices)
+{
+	// по всем вершинам буфера, а не по индексам - общие вершины не читаются повторно. Вершины без индексов бокс только расширяют
+	m_aabb = ComputeAABB(vertices.empty() ? nullptr : &vertices[0].position, vertices.size(), sizeof(MeshVertex));
 }
 //=============================================================================
\ No newline at end of file
@@ -14,10 +14,21 @@ struct MeshInfo final
 	std::optional<PBRMaterial> pbrMaterial{};
 };
 
+// Позиции и индексы меша в памяти CPU - для программного растеризатора окклюдеров
+struct MeshPositions final
+{
+	std::vector<glm::vec3> positions;
+	std::vector<uint32_t>  indices;
+};
+
+// Заполняет вершины и индексы прямо в отображенную память GPU буфера. Память только для записи - читать из нее нельзя
+using MeshWriteFunc = std::function<void(std::span<MeshVertex> vertices, std::span<uint32_t> indices, AABB& aabb)>;
+
 class Mesh final
 {
 public:
-	Mesh(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices, std::optional<Material> material, std::optional<PBRMaterial> pbrMaterial);
+	Mesh(std::span<const MeshVertex> vertices, std::span<const uint32_t> indices, std::optional<Material> material, std::optional<PBRMaterial> pbrMaterial);
+	Mesh(uint32_t vertexCount, uint32_t indexCount, const MeshWriteFunc& writeFunc, std::optional<Material> material, std::optional<PBRMaterial> pbrMaterial);
 	Mesh(const Mesh&) = delete;
 	Mesh(Mesh&& other) noexcept;
 	~Mesh();
@@ -25,18 +36,28 @@ public:
 	Mesh& operator=(const Mesh&) = delete;
 	Mesh& operator=(Mesh&& other) noexcept;
 
+	// instanceCount 0 - ничего не рисуется (например, все экземпляры отсечены)
 	void Draw(GLenum mode = GL_TRIANGLES, unsigned instanceCount = 1) const;
+	// команда (DrawElementsIndirectCommand для индексированного меша, иначе DrawArraysIndirectCommand) из буфера GL_DRAW_INDIRECT_BUFFER.
+	// Требует OGLContext::IsDrawIndirectSupported()
+	void DrawIndirect(GLenum mode, size_t commandOffset) const;
 
-	void tDraw(GLenum mode = GL_TRIANGLES, ProgramHandle program = {}, bool bindMaterial = true, bool instancing = false, int amount = 1);
+	void tDraw(GLenum mode = GL_TRIANGLES, ProgramHandle program = {}, bool bindMaterial = true, bool instancing = false, int amount = 1) const;
 
 	auto GetVertexCount() const noexcept { return m_vertexCount; }
 	auto GetIndexCount() const noexcept { return m_indicesCount; }
-	auto GetMaterial() const noexcept { return m_material; }
-	auto GetPbrMaterial() const noexcept { return m_pbrMaterial; }
+	const std::optional<Material>& GetMaterial() const noexcept { return m_material; }
+	const std::optional<PBRMaterial>& GetPbrMaterial() const noexcept { return m_pbrMaterial; }
 	const AABB& GetAABB() const noexcept { return m_aabb; }
+	// материал без прозрачности: нет карты прозрачности (map_d), opacity 1 и у диффузной/albedo текстуры нет альфа-канала.
+	// Только такие меши годятся в окклюдеры - сквозь отсеченные альфой части видно
+	bool IsOpaque() const noexcept;
+	// читаются из буферов GPU при первом вызове и хранятся до удаления меша. Требует контекст OpenGL
+	const MeshPositions& GetPositions() const;
 
 private:
-	void initAABB(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices);
+	void initVAO();
+	void initAABB(std::span<const MeshVertex> vertices);
 
 	uint32_t                   m_vertexCount{ 0 };
 	uint32_t                   m_indicesCount{ 0 };
@@ -46,4 +67,5 @@ private:
 	std::optional<Material>    m_material{};
 	std::optional<PBRMaterial> m_pbrMaterial{};
 	AABB                       m_aabb{};
+	mutable std::unique_ptr<MeshPositions> m_positions;
 };
\ No newline at end of file
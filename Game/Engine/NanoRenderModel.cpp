@@ -1,8 +1,80 @@
 ﻿#include "stdafx.h"
 #include "NanoRenderModel.h"
+#include "NanoRenderGeometryGen.h"
+#include "NanoObjLoader.h"
+#include "NanoCookedAssets.h"
+#include "NanoCore.h"
 #include "NanoLog.h"
 #include "NanoIO.h"
 //=============================================================================
+// у каждого источника свое пространство имен
+enum class ModelSource : uint8_t
+{
+	File,
+	Named,    // models::Create
+	Generator // models::CreateBox и т.п.
+};
+
+struct ModelCache final
+{
+	bool operator==(const ModelCache&) const noexcept = default;
+
+	std::string       name;
+	ModelMaterialType materialType;
+	ModelSource       source;
+};
+//=============================================================================
+namespace std
+{
+	template<>
+	struct hash<ModelCache>
+	{
+		std::size_t operator()(const ModelCache& mc) const noexcept
+		{
+			std::size_t h1 = std::hash<std::string>{}(mc.name);
+			std::size_t h2 = std::hash<uint8_t>{}(static_cast<uint8_t>(mc.materialType));
+			std::size_t h3 = std::hash<uint8_t>{}(static_cast<uint8_t>(mc.source));
+			std::size_t seed = 0;
+			HashCombine(seed, h1, h2, h3);
+			return seed;
+		}
+	};
+}
+//=============================================================================
+namespace
+{
+	// кеш держит одну ссылку, поэтому use_count() == 1 означает что модель никому не нужна
+	std::unordered_map<ModelCache, std::shared_ptr<Model>> modelsMap;
+
+	// create вызывается только при промахе кеша
+	template<typename CreateFunc>
+	ModelRef getOrCreate(const ModelCache& keyMap, CreateFunc&& create)
+	{
+		auto it = modelsMap.find(keyMap);
+		if (it != modelsMap.end())
+			return it->second;
+
+		auto model = std::make_shared<Model>();
+		model->Create(create());
+		modelsMap[keyMap] = model;
+		return model;
+	}
+
+	// тип и все параметры в кратчайшей точной записи: одинаковые параметры дают одну модель, разные не совпадут
+	ModelCache makeGeneratorKey(std::string_view type, std::initializer_list<float> params)
+	{
+		std::string name(type);
+		for (float param : params)
+		{
+			char buffer[32];
+			auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), param);
+			name += ' ';
+			name.append(buffer, end);
+		}
+		return { .name = std::move(name), .materialType = ModelMaterialType::None, .source = ModelSource::Generator };
+	}
+}
+//=============================================================================
 bool Model::Load(const std::string& fileName, ModelMaterialType materialType)
 {
 #define ASSIMP_LOAD_FLAGS (aiProcess_JoinIdenticalVertices |    \
@@ -23,6 +95,43 @@ bool Model::Load(const std::string& fileName, ModelMaterialType materialType)
 	Free();
 
 	m_materialType = materialType;
+	m_name = fileName;
+
+	// запеченная AssetCooker'ом модель - без импорта и постобработки
+	const std::string cookedFileName = cooked::GetCookedPath(fileName, cooked::ModelExtension);
+	if (cooked::IsUpToDate(fileName, cookedFileName))
+	{
+		if (loadCooked(fileName, cookedFileName))
+		{
+			computeAABB();
+			return true;
+		}
+		Free();
+	}
+
+	// glTF грузится своим загрузчиком без промежуточных копий, остальные форматы - через Assimp
+	std::string extension = io::GetFileExtension(fileName);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	if (extension == ".gltf" || extension == ".glb")
+	{
+		if (loadGLTF(fileName))
+		{
+			computeAABB();
+			return true;
+		}
+		Warning("Native glTF loader failed, fallback to Assimp: " + fileName);
+		Free();
+	}
+	else if (extension == ".obj")
+	{
+		if (loadOBJ(fileName))
+		{
+			computeAABB();
+			return true;
+		}
+		Warning("Native OBJ loader failed, fallback to Assimp: " + fileName);
+		Free();
+	}
 
 	Assimp::Importer importer;
 	const aiScene* scene = importer.ReadFile(fileName.c_str(), ASSIMP_LOAD_FLAGS);
@@ -32,8 +141,6 @@ bool Model::Load(const std::string& fileName, ModelMaterialType materialType)
 		return false;
 	}
 
-	m_name = fileName;
-
 	std::string directory = io::GetFileDirectory(fileName);
 	processNode(scene, scene->mRootNode, directory);
 
@@ -68,6 +175,30 @@ void Model::Create(const std::vector<MeshInfo>& meshes)
 	// TODO: центрировать модель, так как бывают не от центра
 }
 //=============================================================================
+void Model::Create(MeshInfo&& ci)
+{
+	Free();
+	m_meshes.emplace_back(ci.vertices, ci.indices, std::move(ci.material), std::move(ci.pbrMaterial));
+	computeAABB();
+
+	// TODO: центрировать модель, так как бывают не от центра
+}
+//=============================================================================
+void Model::Create(std::vector<MeshInfo>&& meshes)
+{
+	Free();
+	m_meshes.reserve(meshes.size());
+	for (size_t i = 0; i < meshes.size(); i++)
+	{
+		if (meshes[i].vertices.empty()) continue;
+
+		m_meshes.emplace_back(meshes[i].vertices, meshes[i].indices, std::move(meshes[i].material), std::move(meshes[i].pbrMaterial));
+	}
+	computeAABB();
+
+	// TODO: центрировать модель, так как бывают не от центра
+}
+//=============================================================================
 void Model::Free()
 {
 	m_meshes.clear();
@@ -79,7 +210,7 @@ void Model::DrawSubMesh(size_t id, GLenum mode)
 		m_meshes[id].tDraw(mode);
 }
 //=============================================================================
-void Model::tDraw(GLenum mode)
+void Model::tDraw(GLenum mode) const
 {
 	for (size_t i = 0; i < m_meshes.size(); i++)
 	{
@@ -87,7 +218,7 @@ void Model::tDraw(GLenum mode)
 	}
 }
 //=============================================================================
-void Model::tDraw(const ModelDrawInfo& drawInfo)
+void Model::tDraw(const ModelDrawInfo& drawInfo) const
 {
 	for (size_t i = 0; i < m_meshes.size(); i++)
 	{
@@ -95,77 +226,176 @@ void Model::tDraw(const ModelDrawInfo& drawInfo)
 	}
 }
 //=============================================================================
-void Model::processNode(const aiScene* scene, aiNode* node, std::string_view directory)
+bool Model::loadOBJ(const std::string& fileName)
 {
-	for (unsigned i = 0; i < node->mNumMeshes; i++)
+	// те же соглашения что и у Assimp с ASSIMP_LOAD_FLAGS
+	ObjLoadInfo loadInfo{
+		.flipTexCoordV = true,
+		.generateNormals = true,
+		.generateTangents = true,
+		.loadMaterials = m_materialType != ModelMaterialType::None
+	};
+	ObjData data;
+	if (!obj::Load(fileName, data, loadInfo) || data.groups.empty())
+		return false;
+
+	auto loadTextures = [](const std::string& texPath, ColorSpace colorSpace) -> std::vector<Texture2D>
+		{
+			if (texPath.empty()) return {};
+			return { textures::LoadTexture2D(texPath, colorSpace) };
+		};
+	auto loadTexture = [](const std::string& texPath, ColorSpace colorSpace) -> Texture2D
+		{
+			if (texPath.empty()) return {};
+			return textures::LoadTexture2D(texPath, colorSpace);
+		};
+
+	// текстуры грузятся один раз на материал, а не на каждую группу
+	std::vector<std::optional<Material>> materials(data.materials.size());
+	std::vector<std::optional<PBRMaterial>> pbrMaterials(data.materials.size());
+	for (size_t i = 0; i < data.materials.size(); i++)
 	{
-		aiMesh* aimesh = scene->mMeshes[node->mMeshes[i]];
-		m_meshes.emplace_back(processMesh(scene, aimesh, directory));
+		const ObjMaterial& objMaterial = data.materials[i];
+		if (m_materialType == ModelMaterialType::BlinnPhong)
+		{
+			Material& material = materials[i].emplace();
+			material.diffuseColor = objMaterial.diffuseColor;
+			material.specularColor = objMaterial.specularColor;
+			material.ambientColor = objMaterial.ambientColor;
+			material.opacity = objMaterial.opacity;
+			material.diffuseTextures = loadTextures(objMaterial.diffuseMap, ColorSpace::sRGB);
+			material.specularTextures = loadTextures(objMaterial.specularMap, ColorSpace::Linear);
+			material.normalTextures = loadTextures(objMaterial.normalMap, ColorSpace::Linear);
+			material.shininessTextures = loadTextures(objMaterial.shininessMap, ColorSpace::Linear);
+			material.emissionTextures = loadTextures(objMaterial.emissionMap, ColorSpace::Linear);
+			material.opacityTextures = loadTextures(objMaterial.opacityMap, ColorSpace::Linear);
+		}
+		else if (m_materialType == ModelMaterialType::PBR)
+		{
+			PBRMaterial& material = pbrMaterials[i].emplace();
+			material.albedoTexture = loadTexture(objMaterial.diffuseMap, ColorSpace::sRGB);
+			material.normalTexture = loadTexture(objMaterial.normalMap, ColorSpace::Linear);
+			material.emissiveTexture = loadTexture(objMaterial.emissionMap, ColorSpace::sRGB);
+		}
 	}
 
-	for (unsigned i = 0; i < node->mNumChildren; i++)
+	m_meshes.reserve(data.groups.size());
+	for (auto& group : data.groups)
 	{
-		processNode(scene, node->mChildren[i], directory);
+		std::optional<Material> material{};
+		std::optional<PBRMaterial> pbrMaterial{};
+		if (group.materialId >= 0)
+		{
+			material = materials[static_cast<size_t>(group.materialId)];
+			pbrMaterial = pbrMaterials[static_cast<size_t>(group.materialId)];
+		}
+		else if (m_materialType == ModelMaterialType::BlinnPhong)
+			material = Material();
+		else if (m_materialType == ModelMaterialType::PBR)
+			pbrMaterial = PBRMaterial();
+
+		m_meshes.emplace_back(group.mesh.vertices, group.mesh.indices, std::move(material), std::move(pbrMaterial));
 	}
+
+	return true;
 }
 //=============================================================================
-Mesh Model::processMesh(const aiScene* scene, struct aiMesh* mesh, std::string_view directory)
+bool Model::loadCooked(const std::string& fileName, const std::string& cookedFileName)
 {
-	// Process vertices
-	std::vector<MeshVertex> vertices(mesh->mNumVertices);
-	for (unsigned i = 0; i < mesh->mNumVertices; i++)
-	{
-		MeshVertex& v = vertices[i];
-
-		v.position.x = mesh->mVertices[i].x;
-		v.position.y = mesh->mVertices[i].y;
-		v.position.z = mesh->mVertices[i].z;
+	CookedModel model;
+	if (!cooked::LoadModel(cookedFileName, model) || model.meshes.empty())
+		return false;
 
-		if (mesh->HasVertexColors(0))
+	const std::string directory = io::GetFileDirectory(fileName);
+	auto loadTexture = [&](const CookedMaterial& cookedMaterial, CookedTextureSlot slot, ColorSpace colorSpace) -> Texture2D
 		{
-			v.color.x = mesh->mColors[0][i].r;
-			v.color.y = mesh->mColors[0][i].g;
-			v.color.z = mesh->mColors[0][i].b;
-		}
-
-		if (mesh->HasNormals())
+			const std::string& texName = cookedMaterial.textures[static_cast<size_t>(slot)];
+			if (texName.empty()) return {};
+			if (texName[0] == '*')
+			{
+				const size_t embedded = std::strtoul(texName.c_str() + 1, nullptr, 10);
+				if (embedded >= model.embeddedTextures.size()) return {};
+				return textures::LoadTexture2DFromMemory(m_name + " --- " + texName, model.embeddedTextures[embedded], colorSpace);
+			}
+			return textures::LoadTexture2D(directory + texName, colorSpace);
+		};
+	auto loadTextures = [&](const CookedMaterial& cookedMaterial, CookedTextureSlot slot, ColorSpace colorSpace) -> std::vector<Texture2D>
+		{
+			Texture2D texture = loadTexture(cookedMaterial, slot, colorSpace);
+			if (!IsValid(texture)) return {};
+			return { texture };
+		};
+
+	std::vector<std::optional<Material>> materials(model.materials.size());
+	std::vector<std::optional<PBRMaterial>> pbrMaterials(model.materials.size());
+	for (size_t i = 0; i < model.materials.size(); i++)
+	{
+		const CookedMaterial& cookedMaterial = model.materials[i];
+		if (m_materialType == ModelMaterialType::BlinnPhong)
 		{
-			v.normal.x = mesh->mNormals[i].x;
-			v.normal.y = mesh->mNormals[i].y;
-			v.normal.z = mesh->mNormals[i].z;
+			Material& material = materials[i].emplace();
+			material.diffuseColor = cookedMaterial.diffuseColor;
+			material.specularColor = cookedMaterial.specularColor;
+			material.ambientColor = cookedMaterial.ambientColor;
+			material.opacity = cookedMaterial.opacity;
+			material.diffuseTextures = loadTextures(cookedMaterial, CookedTextureSlot::Diffuse, ColorSpace::sRGB);
+			material.specularTextures = loadTextures(cookedMaterial, CookedTextureSlot::Specular, ColorSpace::Linear);
+			material.normalTextures = loadTextures(cookedMaterial, CookedTextureSlot::Normal, ColorSpace::Linear);
+			material.shininessTextures = loadTextures(cookedMaterial, CookedTextureSlot::Shininess, ColorSpace::Linear);
+			material.emissionTextures = loadTextures(cookedMaterial, CookedTextureSlot::Emission, ColorSpace::Linear);
+			material.opacityTextures = loadTextures(cookedMaterial, CookedTextureSlot::Opacity, ColorSpace::Linear);
 		}
-
-		if (mesh->HasTextureCoords(0))
+		else if (m_materialType == ModelMaterialType::PBR)
 		{
-			v.texCoord.x = mesh->mTextureCoords[0][i].x;
-			v.texCoord.y = mesh->mTextureCoords[0][i].y;
+			PBRMaterial& material = pbrMaterials[i].emplace();
+			material.albedoTexture = loadTexture(cookedMaterial, CookedTextureSlot::Diffuse, ColorSpace::sRGB);
+			material.normalTexture = loadTexture(cookedMaterial, CookedTextureSlot::Normal, ColorSpace::Linear);
+			material.metallicRoughnessTexture = loadTexture(cookedMaterial, CookedTextureSlot::MetallicRoughness, ColorSpace::Linear);
+			material.AOTexture = loadTexture(cookedMaterial, CookedTextureSlot::AO, ColorSpace::Linear);
+			material.emissiveTexture = loadTexture(cookedMaterial, CookedTextureSlot::Emission, ColorSpace::sRGB);
 		}
+	}
 
-		if (mesh->HasTangentsAndBitangents())
+	m_meshes.reserve(model.meshes.size());
+	for (const auto& mesh : model.meshes)
+	{
+		std::optional<Material> material{};
+		std::optional<PBRMaterial> pbrMaterial{};
+		if (mesh.materialId >= 0)
 		{
-			v.tangent.x = mesh->mTangents[i].x;
-			v.tangent.y = mesh->mTangents[i].y;
-			v.tangent.z = mesh->mTangents[i].z;
-
-			v.bitangent.x = mesh->mBitangents[i].x;
-			v.bitangent.y = mesh->mBitangents[i].y;
-			v.bitangent.z = mesh->mBitangents[i].z;
+			material = materials[static_cast<size_t>(mesh.materialId)];
+			pbrMaterial = pbrMaterials[static_cast<size_t>(mesh.materialId)];
 		}
+		else if (m_materialType == ModelMaterialType::BlinnPhong)
+			material = Material();
+		else if (m_materialType == ModelMaterialType::PBR)
+			pbrMaterial = PBRMaterial();
+
+		m_meshes.emplace_back(mesh.vertices, mesh.indices, std::move(material), std::move(pbrMaterial));
 	}
 
-	// Process indices
-	std::vector<uint32_t> indices;
-	indices.reserve(mesh->mNumFaces * 3);
-	for (size_t i = 0; i < mesh->mNumFaces; i++)
-	{
-		const aiFace& face = mesh->mFaces[i];
+	return true;
+}
+//=============================================================================
+void Model::processNode(const aiScene* scene, aiNode* node, std::string_view directory)
+{
+	if (node == scene->mRootNode)
+		m_meshes.reserve(scene->mNumMeshes);
 
-		// Assume the model has only triangles.
-		indices.emplace_back(face.mIndices[0]);
-		indices.emplace_back(face.mIndices[1]);
-		indices.emplace_back(face.mIndices[2]);
+	for (unsigned i = 0; i < node->mNumMeshes; i++)
+	{
+		aiMesh* aimesh = scene->mMeshes[node->mMeshes[i]];
+		m_meshes.emplace_back(processMesh(scene, aimesh, directory));
 	}
 
+	for (unsigned i = 0; i < node->mNumChildren; i++)
+	{
+		processNode(scene, node->mChildren[i], directory);
+	}
+}
+//=============================================================================
+Mesh Model::processMesh(const aiScene* scene, struct aiMesh* mesh, std::string_view directory)
+{
 	// Process material
 	std::optional<Material> material{};
 	std::optional<PBRMaterial> pbrMaterial{};
@@ -271,7 +501,72 @@ Mesh Model::processMesh(const aiScene* scene, struct aiMesh* mesh, std::string_v
 		if (!emissiveMap.empty())          pbrMaterial->emissiveTexture = emissiveMap[0];
 	}
 
-	return Mesh(vertices, indices, material, pbrMaterial);
+	// Вершины пишутся сразу в память VBO/EBO, размер буферов известен по aiMesh
+	const bool hasColors = mesh->HasVertexColors(0);
+	const bool hasNormals = mesh->HasNormals();
+	const bool hasTexCoords = mesh->HasTextureCoords(0);
+	const bool hasTangents = mesh->HasTangentsAndBitangents();
+
+	auto writeFunc = [&](std::span<MeshVertex> vertices, std::span<uint32_t> indices, AABB& aabb)
+		{
+			// Process vertices
+			for (unsigned i = 0; i < mesh->mNumVertices; i++)
+			{
+				// вершина собирается целиком и пишется одной записью - отображенная память может быть write-combined
+				MeshVertex v;
+
+				v.position.x = mesh->mVertices[i].x;
+				v.position.y = mesh->mVertices[i].y;
+				v.position.z = mesh->mVertices[i].z;
+
+				if (hasColors)
+				{
+					v.color.x = mesh->mColors[0][i].r;
+					v.color.y = mesh->mColors[0][i].g;
+					v.color.z = mesh->mColors[0][i].b;
+				}
+
+				if (hasNormals)
+				{
+					v.normal.x = mesh->mNormals[i].x;
+					v.normal.y = mesh->mNormals[i].y;
+					v.normal.z = mesh->mNormals[i].z;
+				}
+
+				if (hasTexCoords)
+				{
+					v.texCoord.x = mesh->mTextureCoords[0][i].x;
+					v.texCoord.y = mesh->mTextureCoords[0][i].y;
+				}
+
+				if (hasTangents)
+				{
+					v.tangent.x = mesh->mTangents[i].x;
+					v.tangent.y = mesh->mTangents[i].y;
+					v.tangent.z = mesh->mTangents[i].z;
+
+					v.bitangent.x = mesh->mBitangents[i].x;
+					v.bitangent.y = mesh->mBitangents[i].y;
+					v.bitangent.z = mesh->mBitangents[i].z;
+				}
+
+				aabb.CombinePoint(v.position);
+				vertices[i] = v;
+			}
+
+			// Process indices
+			for (size_t i = 0; i < mesh->mNumFaces; i++)
+			{
+				const aiFace& face = mesh->mFaces[i];
+
+				// Assume the model has only triangles.
+				indices[i * 3 + 0] = face.mIndices[0];
+				indices[i * 3 + 1] = face.mIndices[1];
+				indices[i * 3 + 2] = face.mIndices[2];
+			}
+		};
+
+	return Mesh(mesh->mNumVertices, mesh->mNumFaces * 3, writeFunc, std::move(material), std::move(pbrMaterial));
 }
 //=============================================================================
 std::vector<Texture2D> Model::loadMaterialTextures(std::string_view directory, const aiScene* scene, aiMaterial* mat, aiTextureType type, ColorSpace colorSpace)
@@ -323,4 +618,71 @@ void Model::computeAABB()
 		m_aabb.CombineAABB(m_meshes[i].GetAABB());
 	}
 }
+//=============================================================================
+void models::Close()
+{
+	for (auto& it : modelsMap)
+	{
+		if (it.second.use_count() > 1)
+			Warning("Model still in use on close: " + it.first.name);
+		it.second->Free();
+	}
+	modelsMap.clear();
+}
+//=============================================================================
+ModelRef models::Load(const std::string& fileName, ModelMaterialType materialType)
+{
+	ModelCache keyMap = { .name = fileName, .materialType = materialType, .source = ModelSource::File };
+	auto it = modelsMap.find(keyMap);
+	if (it != modelsMap.end())
+		return it->second;
+
+	auto model = std::make_shared<Model>();
+	if (!model->Load(fileName, materialType))
+		return nullptr;
+
+	Debug("Load Model: " + fileName);
+	modelsMap[keyMap] = model;
+	return model;
+}
+//=============================================================================
+ModelRef models::CreatePlane(float width, float height, float wSegment, float hSegment)
+{
+	return getOrCreate(makeGeneratorKey("plane", { width, height, wSegment, hSegment }),
+		[&]() { return GeometryGenerator::CreatePlane(width, height, wSegment, hSegment); });
+}
+//=============================================================================
+ModelRef models::CreateBox(float width, float height, float depth, float widthSegments, float heightSegments, float depthSegments)
+{
+	return getOrCreate(makeGeneratorKey("box", { width, height, depth, widthSegments, heightSegments, depthSegments }),
+		[&]() { return GeometryGenerator::CreateBox(width, height, depth, widthSegments, heightSegments, depthSegments); });
+}
+//=============================================================================
+ModelRef models::CreateSphere(float radius, float widthSegments, float heightSegments, float phiStart, float phiLength, float thetaStart, float thetaLength)
+{
+	return getOrCreate(makeGeneratorKey("sphere", { radius, widthSegments, heightSegments, phiStart, phiLength, thetaStart, thetaLength }),
+		[&]() { return GeometryGenerator::CreateSphere(radius, widthSegments, heightSegments, phiStart, phiLength, thetaStart, thetaLength); });
+}
+//=============================================================================
+ModelRef models::Create(const std::string& name, MeshInfo&& meshInfo)
+{
+	const ModelCache keyMap = { .name = name, .materialType = ModelMaterialType::None, .source = ModelSource::Named };
+	return getOrCreate(keyMap, [&]() { return std::move(meshInfo); });
+}
+//=============================================================================
+ModelRef models::Create(const std::string& name, std::vector<MeshInfo>&& meshes)
+{
+	const ModelCache keyMap = { .name = name, .materialType = ModelMaterialType::None, .source = ModelSource::Named };
+	return getOrCreate(keyMap, [&]() { return std::move(meshes); });
+}
+//=============================================================================
+void models::ReleaseUnused()
+{
+	std::erase_if(modelsMap, [](const auto& it) { return it.second.use_count() == 1; });
+}
+//=============================================================================
+size_t models::GetCount()
+{
+	return modelsMap.size();
+}
 //=============================================================================
\ No newline at end of file
@@ -22,12 +22,15 @@ public:
 	bool Load(const std::string& fileName, ModelMaterialType materialType);
 	void Create(const MeshInfo& meshCreateInfo);
 	void Create(const std::vector<MeshInfo>& meshes);
+	// материалы перемещаются в меши без копирования
+	void Create(MeshInfo&& meshCreateInfo);
+	void Create(std::vector<MeshInfo>&& meshes);
 
 	void Free();
 
 	void DrawSubMesh(size_t id, GLenum mode = GL_TRIANGLES);
-	void tDraw(GLenum mode = GL_TRIANGLES);
-	void tDraw(const ModelDrawInfo& drawInfo);
+	void tDraw(GLenum mode = GL_TRIANGLES) const;
+	void tDraw(const ModelDrawInfo& drawInfo) const;
 
 	size_t GetNumMeshes() const noexcept { return m_meshes.size(); }
 	const std::vector<Mesh>& GetMeshes() const noexcept { return m_meshes; }
@@ -37,6 +40,9 @@ public:
 	bool Valid() const noexcept { return !m_meshes.empty(); }
 
 private:
+	bool loadGLTF(const std::string& fileName); // NanoRenderModelGLTF.cpp
+	bool loadOBJ(const std::string& fileName);
+	bool loadCooked(const std::string& fileName, const std::string& cookedFileName);
 	void processNode(const aiScene* scene, aiNode* node, std::string_view directory);
 	Mesh processMesh(const aiScene* scene, struct aiMesh* mesh, std::string_view directory);
 	std::vector<Texture2D> loadMaterialTextures(std::string_view directory, const aiScene* scene, aiMaterial* mat, aiTextureType type, ColorSpace colorSpace);
@@ -46,4 +52,27 @@ private:
 	ModelMaterialType m_materialType;
 	AABB              m_aabb;
 	std::string       m_name;
-};
\ No newline at end of file
+};
+
+// Модель в кеше неизменяемая и разделяется между всеми объектами. Трансформ, цвет и прочее хранятся в самом объекте
+using ModelRef = std::shared_ptr<const Model>;
+
+namespace models
+{
+	void Close();
+
+	// повторный запрос того же файла с теми же опциями импорта вернет уже загруженную модель
+	ModelRef Load(const std::string& fileName, ModelMaterialType materialType);
+	// модели GeometryGenerator: ключ кеша строится из типа и всех параметров создания, геометрия строится только при промахе
+	ModelRef CreatePlane(float width = 1.0f, float height = 1.0f, float wSegment = 1.0f, float hSegment = 1.0f);
+	ModelRef CreateBox(float width = 1.0f, float height = 1.0f, float depth = 1.0, float widthSegments = 1.0f, float heightSegments = 1.0f, float depthSegments = 1.0f);
+	ModelRef CreateSphere(float radius = 1.0f, float widthSegments = 8.0f, float heightSegments = 6.0f, float phiStart = 0.0f, float phiLength = M_PI * 2.0f, float thetaStart = 0.0f, float thetaLength = M_PI);
+	// своя процедурная геометрия, кешируется по имени - разная геометрия должна иметь разные имена. С моделями
+	// GeometryGenerator и файлами имена не пересекаются
+	ModelRef Create(const std::string& name, MeshInfo&& meshInfo);
+	ModelRef Create(const std::string& name, std::vector<MeshInfo>&& meshes);
+
+	// удаляет модели, на которые больше никто не ссылается
+	void ReleaseUnused();
+	size_t GetCount();
+} // namespace models
\ No newline at end of file
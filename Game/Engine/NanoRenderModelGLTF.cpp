@@ -0,0 +1,805 @@
+﻿#include "stdafx.h"
+#include "NanoRenderModel.h"
+#include "NanoLog.h"
+#include "NanoIO.h"
+//=============================================================================
+// Нативный загрузчик glTF 2.0 (.gltf/.glb). Файл отображается в память, вершины пишутся из него сразу в GPU буферы.
+// Не поддерживается: sparse accessors, анимации, скины, morph targets, расширения (KHR_*). Для них используется Assimp
+//=============================================================================
+namespace
+{
+	struct JsonValue final
+	{
+		enum class Type : uint8_t
+		{
+			Null,
+			Bool,
+			Number,
+			String,
+			Array,
+			Object
+		};
+
+		const JsonValue& operator[](std::string_view key) const
+		{
+			for (const auto& it : object)
+			{
+				if (it.first == key) return it.second;
+			}
+			return Empty();
+		}
+		const JsonValue& operator[](size_t id) const
+		{
+			return id < array.size() ? array[id] : Empty();
+		}
+
+		bool   IsNull() const noexcept { return type == Type::Null; }
+		size_t Size() const noexcept { return type == Type::Array ? array.size() : object.size(); }
+		double GetNumber(double defaultValue) const noexcept { return type == Type::Number ? number : defaultValue; }
+		int    GetInt(int defaultValue) const noexcept { return type == Type::Number ? static_cast<int>(number) : defaultValue; }
+		bool   GetBool(bool defaultValue) const noexcept { return type == Type::Bool ? boolean : defaultValue; }
+
+		static const JsonValue& Empty()
+		{
+			static const JsonValue empty;
+			return empty;
+		}
+
+		Type                                         type{ Type::Null };
+		bool                                         boolean{ false };
+		double                                       number{ 0.0 };
+		std::string                                  string;
+		std::vector<JsonValue>                       array;
+		std::vector<std::pair<std::string, JsonValue>> object;
+	};
+	//-------------------------------------------------------------------------
+	class JsonParser final
+	{
+	public:
+		JsonParser(std::string_view text) : m_text(text) {}
+
+		bool Parse(JsonValue& value)
+		{
+			if (!parseValue(value)) return false;
+			skipSpaces();
+			return m_pos == m_text.size();
+		}
+
+	private:
+		void skipSpaces()
+		{
+			while (m_pos < m_text.size() && (m_text[m_pos] == ' ' || m_text[m_pos] == '\t' || m_text[m_pos] == '\n' || m_text[m_pos] == '\r'))
+				m_pos++;
+		}
+
+		bool match(std::string_view str)
+		{
+			if (m_text.substr(m_pos, str.size()) != str) return false;
+			m_pos += str.size();
+			return true;
+		}
+
+		bool parseValue(JsonValue& value)
+		{
+			skipSpaces();
+			if (m_pos >= m_text.size()) return false;
+
+			const char c = m_text[m_pos];
+			if (c == '{') return parseObject(value);
+			if (c == '[') return parseArray(value);
+			if (c == '"')
+			{
+				value.type = JsonValue::Type::String;
+				return parseString(value.string);
+			}
+			if (match("true"))  { value.type = JsonValue::Type::Bool; value.boolean = true; return true; }
+			if (match("false")) { value.type = JsonValue::Type::Bool; value.boolean = false; return true; }
+			if (match("null"))  { value.type = JsonValue::Type::Null; return true; }
+			return parseNumber(value);
+		}
+
+		bool parseNumber(JsonValue& value)
+		{
+			const char* first = m_text.data() + m_pos;
+			const char* last = m_text.data() + m_text.size();
+			auto [ptr, ec] = std::from_chars(first, last, value.number);
+			if (ec != std::errc()) return false;
+			value.type = JsonValue::Type::Number;
+			m_pos += static_cast<size_t>(ptr - first);
+			return true;
+		}
+
+		bool parseString(std::string& str)
+		{
+			m_pos++; // "
+			while (m_pos < m_text.size())
+			{
+				const char c = m_text[m_pos++];
+				if (c == '"') return true;
+				if (c != '\\')
+				{
+					str.push_back(c);
+					continue;
+				}
+				if (m_pos >= m_text.size()) return false;
+				const char e = m_text[m_pos++];
+				switch (e)
+				{
+				case '"':  str.push_back('"'); break;
+				case '\\': str.push_back('\\'); break;
+				case '/':  str.push_back('/'); break;
+				case 'b':  str.push_back('\b'); break;
+				case 'f':  str.push_back('\f'); break;
+				case 'n':  str.push_back('\n'); break;
+				case 'r':  str.push_back('\r'); break;
+				case 't':  str.push_back('\t'); break;
+				case 'u':
+				{
+					if (m_pos + 4 > m_text.size()) return false;
+					unsigned code = 0;
+					auto [ptr, ec] = std::from_chars(m_text.data() + m_pos, m_text.data() + m_pos + 4, code, 16);
+					if (ec != std::errc()) return false;
+					m_pos += 4;
+					// UTF-8 (суррогатные пары не склеиваются - в glTF строки это имена и пути)
+					if (code < 0x80) str.push_back(static_cast<char>(code));
+					else if (code < 0x800)
+					{
+						str.push_back(static_cast<char>(0xC0 | (code >> 6)));
+						str.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+					}
+					else
+					{
+						str.push_back(static_cast<char>(0xE0 | (code >> 12)));
+						str.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+						str.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+					}
+					break;
+				}
+				default: return false;
+				}
+			}
+			return false;
+		}
+
+		bool parseArray(JsonValue& value)
+		{
+			if (++m_depth > MaxDepth) return false;
+			value.type = JsonValue::Type::Array;
+			m_pos++; // [
+			skipSpaces();
+			if (match("]")) { m_depth--; return true; }
+			while (true)
+			{
+				JsonValue& element = value.array.emplace_back();
+				if (!parseValue(element)) return false;
+				skipSpaces();
+				if (match(",")) continue;
+				m_depth--;
+				return match("]");
+			}
+		}
+
+		bool parseObject(JsonValue& value)
+		{
+			if (++m_depth > MaxDepth) return false;
+			value.type = JsonValue::Type::Object;
+			m_pos++; // {
+			skipSpaces();
+			if (match("}")) { m_depth--; return true; }
+			while (true)
+			{
+				skipSpaces();
+				if (m_pos >= m_text.size() || m_text[m_pos] != '"') return false;
+				auto& member = value.object.emplace_back();
+				if (!parseString(member.first)) return false;
+				skipSpaces();
+				if (!match(":")) return false;
+				if (!parseValue(member.second)) return false;
+				skipSpaces();
+				if (match(",")) continue;
+				m_depth--;
+				return match("}");
+			}
+		}
+
+		// вложенность glTF - единицы уровней, глубже - битый или враждебный файл, а не переполнение стека
+		static constexpr size_t MaxDepth = 64;
+
+		std::string_view m_text;
+		size_t           m_pos{ 0 };
+		size_t           m_depth{ 0 };
+	};
+	//-------------------------------------------------------------------------
+	std::vector<uint8_t> decodeBase64(std::string_view str)
+	{
+		auto decodeChar = [](char c) -> int
+			{
+				if (c >= 'A' && c <= 'Z') return c - 'A';
+				if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+				if (c >= '0' && c <= '9') return c - '0' + 52;
+				if (c == '+' || c == '-') return 62;
+				if (c == '/' || c == '_') return 63;
+				return -1;
+			};
+
+		std::vector<uint8_t> result;
+		result.reserve(str.size() * 3 / 4);
+		uint32_t bits = 0;
+		int numBits = 0;
+		for (char c : str)
+		{
+			const int v = decodeChar(c);
+			if (v < 0) continue; // '=' и переводы строк
+			bits = (bits << 6) | static_cast<uint32_t>(v);
+			numBits += 6;
+			if (numBits >= 8)
+			{
+				numBits -= 8;
+				result.push_back(static_cast<uint8_t>((bits >> numBits) & 0xFF));
+			}
+		}
+		return result;
+	}
+	//-------------------------------------------------------------------------
+	std::string decodeUri(std::string_view uri)
+	{
+		std::string result;
+		result.reserve(uri.size());
+		for (size_t i = 0; i < uri.size(); i++)
+		{
+			unsigned code = 0;
+			if (uri[i] == '%' && i + 2 < uri.size() && std::from_chars(uri.data() + i + 1, uri.data() + i + 3, code, 16).ec == std::errc())
+			{
+				result.push_back(static_cast<char>(code));
+				i += 2;
+			}
+			else
+				result.push_back(uri[i]);
+		}
+		return result;
+	}
+	//-------------------------------------------------------------------------
+	constexpr uint32_t GLBMagic = 0x46546C67; // glTF
+	constexpr uint32_t GLBChunkJSON = 0x4E4F534A;
+	constexpr uint32_t GLBChunkBIN = 0x004E4942;
+
+	constexpr int ComponentByte = 5120;
+	constexpr int ComponentUnsignedByte = 5121;
+	constexpr int ComponentShort = 5122;
+	constexpr int ComponentUnsignedShort = 5123;
+	constexpr int ComponentUnsignedInt = 5125;
+	constexpr int ComponentFloat = 5126;
+
+	constexpr int ModeTriangles = 4;
+
+	struct GLTFAccessor final
+	{
+		const uint8_t* data{ nullptr };
+		size_t         count{ 0 };
+		size_t         stride{ 0 };
+		int            componentType{ 0 };
+		int            numComponents{ 0 };
+		bool           normalized{ false };
+	};
+
+	struct GLTFContext final
+	{
+		const JsonValue&                          root;
+		std::vector<std::span<const uint8_t>>     buffers;
+		std::vector<std::unique_ptr<io::MappedFile>> externalFiles;
+		std::vector<std::vector<uint8_t>>         decodedBuffers;
+		std::string                               fileName;
+		std::string                               directory;
+	};
+	//-------------------------------------------------------------------------
+	size_t componentSize(int componentType)
+	{
+		switch (componentType)
+		{
+		case ComponentByte:
+		case ComponentUnsignedByte:  return 1;
+		case ComponentShort:
+		case ComponentUnsignedShort: return 2;
+		case ComponentUnsignedInt:
+		case ComponentFloat:         return 4;
+		default:                     return 0;
+		}
+	}
+	//-------------------------------------------------------------------------
+	int numComponentsFromType(std::string_view type)
+	{
+		if (type == "SCALAR") return 1;
+		if (type == "VEC2")   return 2;
+		if (type == "VEC3")   return 3;
+		if (type == "VEC4")   return 4;
+		if (type == "MAT4")   return 16;
+		return 0;
+	}
+	//-------------------------------------------------------------------------
+	std::span<const uint8_t> getBufferView(const GLTFContext& ctx, int id, size_t* byteStride = nullptr)
+	{
+		const JsonValue& view = ctx.root["bufferViews"][static_cast<size_t>(id)];
+		const int bufferId = view["buffer"].GetInt(-1);
+		if (bufferId < 0 || static_cast<size_t>(bufferId) >= ctx.buffers.size())
+			return {};
+
+		const auto& buffer = ctx.buffers[static_cast<size_t>(bufferId)];
+		const size_t offset = static_cast<size_t>(view["byteOffset"].GetNumber(0.0));
+		const size_t length = static_cast<size_t>(view["byteLength"].GetNumber(0.0));
+		if (offset + length > buffer.size())
+			return {};
+
+		if (byteStride) *byteStride = static_cast<size_t>(view["byteStride"].GetNumber(0.0));
+		return buffer.subspan(offset, length);
+	}
+	//-------------------------------------------------------------------------
+	bool getAccessor(const GLTFContext& ctx, int id, GLTFAccessor& accessor)
+	{
+		if (id < 0) return false;
+		const JsonValue& acc = ctx.root["accessors"][static_cast<size_t>(id)];
+		if (acc.IsNull()) return false;
+		if (!acc["sparse"].IsNull())
+		{
+			Warning("glTF sparse accessors are not supported: " + ctx.fileName);
+			return false;
+		}
+
+		accessor.count = static_cast<size_t>(acc["count"].GetNumber(0.0));
+		accessor.componentType = acc["componentType"].GetInt(0);
+		accessor.numComponents = numComponentsFromType(acc["type"].string);
+		accessor.normalized = acc["normalized"].GetBool(false);
+
+		const size_t elementSize = componentSize(accessor.componentType) * static_cast<size_t>(accessor.numComponents);
+		if (elementSize == 0 || accessor.count == 0) return false;
+
+		size_t byteStride = 0;
+		auto view = getBufferView(ctx, acc["bufferView"].GetInt(-1), &byteStride);
+		accessor.stride = byteStride ? byteStride : elementSize;
+
+		const size_t offset = static_cast<size_t>(acc["byteOffset"].GetNumber(0.0));
+		if (view.empty() || offset + accessor.stride * (accessor.count - 1) + elementSize > view.size())
+			return false;
+
+		accessor.data = view.data() + offset;
+		return true;
+	}
+	//-------------------------------------------------------------------------
+	float readComponent(const uint8_t* ptr, int componentType, bool normalized)
+	{
+		switch (componentType)
+		{
+		case ComponentFloat:         { float v;    std::memcpy(&v, ptr, 4); return v; }
+		case ComponentUnsignedByte:  { uint8_t v = *ptr;                     return normalized ? v / 255.0f : v; }
+		case ComponentByte:          { int8_t v;   std::memcpy(&v, ptr, 1); return normalized ? std::max(v / 127.0f, -1.0f) : v; }
+		case ComponentUnsignedShort: { uint16_t v; std::memcpy(&v, ptr, 2); return normalized ? v / 65535.0f : v; }
+		case ComponentShort:         { int16_t v;  std::memcpy(&v, ptr, 2); return normalized ? std::max(v / 32767.0f, -1.0f) : v; }
+		case ComponentUnsignedInt:   { uint32_t v; std::memcpy(&v, ptr, 4); return static_cast<float>(v); }
+		default: std::unreachable();
+		}
+	}
+	//-------------------------------------------------------------------------
+	glm::vec4 readVec(const GLTFAccessor& accessor, size_t id, glm::vec4 result = glm::vec4(0.0f))
+	{
+		const uint8_t* ptr = accessor.data + accessor.stride * id;
+		if (accessor.componentType == ComponentFloat)
+		{
+			std::memcpy(&result, ptr, sizeof(float) * static_cast<size_t>(std::min(accessor.numComponents, 4)));
+			return result;
+		}
+		const size_t size = componentSize(accessor.componentType);
+		for (int i = 0; i < std::min(accessor.numComponents, 4); i++)
+			result[i] = readComponent(ptr + size * static_cast<size_t>(i), accessor.componentType, accessor.normalized);
+		return result;
+	}
+	//-------------------------------------------------------------------------
+	uint32_t readIndex(const GLTFAccessor& accessor, size_t id)
+	{
+		const uint8_t* ptr = accessor.data + accessor.stride * id;
+		switch (accessor.componentType)
+		{
+		case ComponentUnsignedByte:  return *ptr;
+		case ComponentUnsignedShort: { uint16_t v; std::memcpy(&v, ptr, 2); return v; }
+		case ComponentUnsignedInt:   { uint32_t v; std::memcpy(&v, ptr, 4); return v; }
+		default:                     return 0;
+		}
+	}
+	//-------------------------------------------------------------------------
+	bool loadBuffers(GLTFContext& ctx, std::span<const uint8_t> glbBin)
+	{
+		const JsonValue& buffers = ctx.root["buffers"];
+		for (size_t i = 0; i < buffers.Size(); i++)
+		{
+			const JsonValue& buffer = buffers[i];
+			const size_t byteLength = static_cast<size_t>(buffer["byteLength"].GetNumber(0.0));
+			const std::string& uri = buffer["uri"].string;
+
+			std::span<const uint8_t> data;
+			if (uri.empty())
+			{
+				// GLB-stored buffer
+				data = glbBin;
+			}
+			else if (uri.starts_with("data:"))
+			{
+				const size_t comma = uri.find(',');
+				if (comma == std::string::npos || uri.find(";base64") == std::string::npos)
+				{
+					Error("glTF unsupported data uri in " + ctx.fileName);
+					return false;
+				}
+				auto& decoded = ctx.decodedBuffers.emplace_back(decodeBase64(std::string_view(uri).substr(comma + 1)));
+				data = decoded;
+			}
+			else
+			{
+				auto file = std::make_unique<io::MappedFile>();
+				if (!file->Open(ctx.directory + decodeUri(uri)))
+					return false;
+				data = file->GetData();
+				ctx.externalFiles.emplace_back(std::move(file));
+			}
+
+			if (data.size() < byteLength)
+			{
+				Error("glTF buffer " + std::to_string(i) + " is smaller than byteLength in " + ctx.fileName);
+				return false;
+			}
+			ctx.buffers.push_back(data.first(byteLength));
+		}
+		return true;
+	}
+	//-------------------------------------------------------------------------
+	Texture2D loadTexture(const GLTFContext& ctx, const JsonValue& textureInfo, ColorSpace colorSpace)
+	{
+		const int textureId = textureInfo["index"].GetInt(-1);
+		if (textureId < 0) return {};
+
+		const int imageId = ctx.root["textures"][static_cast<size_t>(textureId)]["source"].GetInt(-1);
+		if (imageId < 0) return {};
+		const JsonValue& image = ctx.root["images"][static_cast<size_t>(imageId)];
+
+		const std::string& uri = image["uri"].string;
+		if (!uri.empty() && !uri.starts_with("data:"))
+			return textures::LoadTexture2D(ctx.directory + decodeUri(uri), colorSpace);
+
+		const std::string name = ctx.fileName + " --- image " + std::to_string(imageId);
+		if (!uri.empty())
+		{
+			const size_t comma = uri.find(',');
+			if (comma == std::string::npos) return {};
+			std::vector<uint8_t> data = decodeBase64(std::string_view(uri).substr(comma + 1));
+			return textures::LoadTexture2DFromMemory(name, data, colorSpace);
+		}
+
+		// изображение внутри буфера (GLB) - декодируется прямо из отображенного файла
+		auto view = getBufferView(ctx, image["bufferView"].GetInt(-1));
+		if (view.empty()) return {};
+		return textures::LoadTexture2DFromMemory(name, view, colorSpace);
+	}
+	//-------------------------------------------------------------------------
+	glm::vec4 readFactor(const JsonValue& value, glm::vec4 defaultValue)
+	{
+		for (size_t i = 0; i < std::min<size_t>(value.Size(), 4); i++)
+			defaultValue[static_cast<int>(i)] = static_cast<float>(value[i].GetNumber(defaultValue[static_cast<int>(i)]));
+		return defaultValue;
+	}
+	//-------------------------------------------------------------------------
+	glm::mat4 getNodeTransform(const JsonValue& node)
+	{
+		const JsonValue& matrix = node["matrix"];
+		if (matrix.Size() == 16)
+		{
+			glm::mat4 m;
+			for (int i = 0; i < 16; i++)
+				m[i / 4][i % 4] = static_cast<float>(matrix[static_cast<size_t>(i)].GetNumber(0.0));
+			return m;
+		}
+
+		const glm::vec4 t = readFactor(node["translation"], glm::vec4(0.0f));
+		const glm::vec4 r = readFactor(node["rotation"], glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+		const glm::vec4 s = readFactor(node["scale"], glm::vec4(1.0f));
+		return glm::translate(glm::mat4(1.0f), glm::vec3(t)) * glm::mat4_cast(glm::quat(r.w, r.x, r.y, r.z)) * glm::scale(glm::mat4(1.0f), glm::vec3(s));
+	}
+} // namespace
+//=============================================================================
+bool Model::loadGLTF(const std::string& fileName)
+{
+	io::MappedFile file;
+	if (!file.Open(fileName))
+		return false;
+
+	std::span<const uint8_t> fileData = file.GetData();
+	std::string_view jsonText;
+	std::span<const uint8_t> glbBin;
+
+	uint32_t magic = 0;
+	if (fileData.size() >= 12) std::memcpy(&magic, fileData.data(), 4);
+	if (magic == GLBMagic)
+	{
+		// header (magic, version, length) + chunks (length, type, data)
+		size_t offset = 12;
+		while (offset + 8 <= fileData.size())
+		{
+			uint32_t chunkLength = 0, chunkType = 0;
+			std::memcpy(&chunkLength, fileData.data() + offset, 4);
+			std::memcpy(&chunkType, fileData.data() + offset + 4, 4);
+			offset += 8;
+			if (offset + chunkLength > fileData.size())
+				break;
+
+			if (chunkType == GLBChunkJSON)
+				jsonText = std::string_view(reinterpret_cast<const char*>(fileData.data() + offset), chunkLength);
+			else if (chunkType == GLBChunkBIN && glbBin.empty())
+				glbBin = fileData.subspan(offset, chunkLength);
+			offset += (chunkLength + 3u) & ~3u;
+		}
+	}
+	else
+	{
+		jsonText = std::string_view(reinterpret_cast<const char*>(fileData.data()), fileData.size());
+	}
+
+	JsonValue root;
+	if (jsonText.empty() || !JsonParser(jsonText).Parse(root) || root.type != JsonValue::Type::Object)
+	{
+		Error("glTF parse failed: " + fileName);
+		return false;
+	}
+
+	if (!root["extensionsRequired"].IsNull())
+	{
+		Warning("glTF required extensions are not supported: " + fileName);
+		return false;
+	}
+
+	GLTFContext ctx{ .root = root, .buffers = {}, .externalFiles = {}, .decodedBuffers = {}, .fileName = fileName, .directory = io::GetFileDirectory(fileName) };
+	if (!loadBuffers(ctx, glbBin))
+		return false;
+
+	// Materials
+	const JsonValue& gltfMaterials = root["materials"];
+	std::vector<std::optional<Material>> materials(gltfMaterials.Size());
+	std::vector<std::optional<PBRMaterial>> pbrMaterials(gltfMaterials.Size());
+	for (size_t i = 0; i < gltfMaterials.Size(); i++)
+	{
+		const JsonValue& mat = gltfMaterials[i];
+		const JsonValue& pbr = mat["pbrMetallicRoughness"];
+
+		if (m_materialType == ModelMaterialType::BlinnPhong)
+		{
+			Material& material = materials[i].emplace();
+			const glm::vec4 baseColor = readFactor(pbr["baseColorFactor"], glm::vec4(1.0f));
+			material.diffuseColor = glm::vec3(baseColor);
+			material.opacity = baseColor.w;
+			material.roughness = static_cast<float>(pbr["roughnessFactor"].GetNumber(1.0));
+			material.metallic = static_cast<float>(pbr["metallicFactor"].GetNumber(1.0));
+
+			if (Texture2D tex = loadTexture(ctx, pbr["baseColorTexture"], ColorSpace::sRGB); IsValid(tex))
+				material.diffuseTextures.push_back(tex);
+			if (Texture2D tex = loadTexture(ctx, mat["normalTexture"], ColorSpace::Linear); IsValid(tex))
+				material.normalTextures.push_back(tex);
+			if (Texture2D tex = loadTexture(ctx, mat["emissiveTexture"], ColorSpace::sRGB); IsValid(tex))
+				material.emissionTextures.push_back(tex);
+		}
+		else if (m_materialType == ModelMaterialType::PBR)
+		{
+			PBRMaterial& material = pbrMaterials[i].emplace();
+			material.albedoTexture = loadTexture(ctx, pbr["baseColorTexture"], ColorSpace::sRGB);
+			material.normalTexture = loadTexture(ctx, mat["normalTexture"], ColorSpace::Linear);
+			material.metallicRoughnessTexture = loadTexture(ctx, pbr["metallicRoughnessTexture"], ColorSpace::Linear);
+			material.AOTexture = loadTexture(ctx, mat["occlusionTexture"], ColorSpace::Linear);
+			material.emissiveTexture = loadTexture(ctx, mat["emissiveTexture"], ColorSpace::sRGB);
+		}
+	}
+
+	// Nodes
+	const JsonValue& scenes = root["scenes"];
+	const JsonValue& nodes = root["nodes"];
+	const JsonValue& meshes = root["meshes"];
+
+	std::vector<std::pair<int, glm::mat4>> stack;
+	const JsonValue& scene = scenes[static_cast<size_t>(root["scene"].GetInt(0))];
+	for (size_t i = 0; i < scene["nodes"].Size(); i++)
+		stack.emplace_back(scene["nodes"][i].GetInt(-1), glm::mat4(1.0f));
+	if (scenes.Size() == 0)
+	{
+		// без сцен корни - узлы, которые не входят в children других узлов, иначе дети попадут дважды
+		std::vector<bool> isChild(nodes.Size(), false);
+		for (size_t i = 0; i < nodes.Size(); i++)
+		{
+			const JsonValue& children = nodes[i]["children"];
+			for (size_t j = 0; j < children.Size(); j++)
+			{
+				const int child = children[j].GetInt(-1);
+				if (child >= 0 && static_cast<size_t>(child) < nodes.Size())
+					isChild[static_cast<size_t>(child)] = true;
+			}
+		}
+		for (size_t i = 0; i < nodes.Size(); i++)
+		{
+			if (!isChild[i])
+				stack.emplace_back(static_cast<int>(i), glm::mat4(1.0f));
+		}
+	}
+
+	// у узла glTF не больше одного родителя - повторный заход означает цикл или общий узел в битом файле
+	std::vector<bool> visited(nodes.Size(), false);
+	while (!stack.empty())
+	{
+		auto [nodeId, parentTransform] = stack.back();
+		stack.pop_back();
+		if (nodeId < 0 || static_cast<size_t>(nodeId) >= nodes.Size())
+			continue;
+		if (visited[static_cast<size_t>(nodeId)])
+		{
+			Warning("glTF node " + std::to_string(nodeId) + " is reached twice (cycle in children), skip: " + fileName);
+			continue;
+		}
+		visited[static_cast<size_t>(nodeId)] = true;
+
+		const JsonValue& node = nodes[static_cast<size_t>(nodeId)];
+		const glm::mat4 transform = parentTransform * getNodeTransform(node);
+		const glm::mat3 normalTransform = glm::transpose(glm::inverse(glm::mat3(transform)));
+		// зеркальный трансформ выворачивает треугольники - порядок вершин меняется, иначе отсечение задних граней уберет лицевые
+		const bool flipWinding = glm::determinant(glm::mat3(transform)) < 0.0f;
+		const float mirror = flipWinding ? -1.0f : 1.0f;
+
+		const JsonValue& children = node["children"];
+		for (size_t i = 0; i < children.Size(); i++)
+			stack.emplace_back(children[i].GetInt(-1), transform);
+
+		const int meshId = node["mesh"].GetInt(-1);
+		if (meshId < 0) continue;
+
+		const JsonValue& primitives = meshes[static_cast<size_t>(meshId)]["primitives"];
+		for (size_t p = 0; p < primitives.Size(); p++)
+		{
+			const JsonValue& primitive = primitives[p];
+			if (primitive["mode"].GetInt(ModeTriangles) != ModeTriangles)
+			{
+				Warning("glTF primitive mode is not triangles, skip: " + fileName);
+				continue;
+			}
+
+			const JsonValue& attributes = primitive["attributes"];
+			GLTFAccessor positions, normals, texCoords, tangents, colors, indices;
+			if (!getAccessor(ctx, attributes["POSITION"].GetInt(-1), positions))
+			{
+				Warning("glTF primitive without POSITION, skip: " + fileName);
+				continue;
+			}
+			const bool hasNormals = getAccessor(ctx, attributes["NORMAL"].GetInt(-1), normals) && normals.count == positions.count;
+			const bool hasTexCoords = getAccessor(ctx, attributes["TEXCOORD_0"].GetInt(-1), texCoords) && texCoords.count == positions.count;
+			const bool hasTangents = getAccessor(ctx, attributes["TANGENT"].GetInt(-1), tangents) && tangents.count == positions.count;
+			const bool hasColors = getAccessor(ctx, attributes["COLOR_0"].GetInt(-1), colors) && colors.count == positions.count;
+			const bool hasIndices = !primitive["indices"].IsNull();
+			if (hasIndices && (!getAccessor(ctx, primitive["indices"].GetInt(-1), indices) || indices.numComponents != 1
+				|| (indices.componentType != ComponentUnsignedByte && indices.componentType != ComponentUnsignedShort && indices.componentType != ComponentUnsignedInt)))
+			{
+				Error("glTF primitive has invalid indices accessor, skip: " + fileName);
+				continue;
+			}
+
+			const uint32_t vertexCount = static_cast<uint32_t>(positions.count);
+			const uint32_t indexCount = hasIndices ? static_cast<uint32_t>(indices.count) : 0u;
+
+			// индексы идут в EBO как есть - выход за вершины дал бы чтение вне буфера на GPU
+			bool indicesValid = true;
+			for (uint32_t i = 0; indicesValid && i < indexCount; i++)
+				indicesValid = readIndex(indices, i) < vertexCount;
+			if (!indicesValid)
+			{
+				Error("glTF primitive index is out of vertex range, skip: " + fileName);
+				continue;
+			}
+			// порядок вершин в треугольнике с учетом flipWinding: меняются местами вторая и третья
+			auto windingOrder = [&](uint32_t i) -> uint32_t
+				{
+					if (!flipWinding || i / 3 >= (hasIndices ? indexCount : vertexCount) / 3) return i;
+					return (i % 3 == 1) ? i + 1 : (i % 3 == 2) ? i - 1 : i;
+				};
+
+			// Касательных нет в файле - считаются по треугольникам как aiProcess_CalcTangentSpace
+			std::vector<glm::vec3> genTangents, genBitangents;
+			if (!hasTangents && hasNormals && hasTexCoords)
+			{
+				genTangents.resize(vertexCount, glm::vec3(0.0f));
+				genBitangents.resize(vertexCount, glm::vec3(0.0f));
+				const uint32_t numTriangles = (hasIndices ? indexCount : vertexCount) / 3;
+				for (uint32_t t = 0; t < numTriangles; t++)
+				{
+					uint32_t id[3];
+					for (uint32_t k = 0; k < 3; k++)
+						id[k] = hasIndices ? readIndex(indices, t * 3 + k) : t * 3 + k;
+					if (id[0] >= vertexCount || id[1] >= vertexCount || id[2] >= vertexCount)
+						continue;
+
+					const glm::vec3 p0 = readVec(positions, id[0]), p1 = readVec(positions, id[1]), p2 = readVec(positions, id[2]);
+					const glm::vec2 uv0 = readVec(texCoords, id[0]), uv1 = readVec(texCoords, id[1]), uv2 = readVec(texCoords, id[2]);
+					const glm::vec3 e1 = p1 - p0, e2 = p2 - p0;
+					const glm::vec2 d1 = uv1 - uv0, d2 = uv2 - uv0;
+					const float det = d1.x * d2.y - d2.x * d1.y;
+					if (std::abs(det) < 1e-12f) continue;
+					const float r = 1.0f / det;
+					const glm::vec3 tangent = (e1 * d2.y - e2 * d1.y) * r;
+					const glm::vec3 bitangent = (e2 * d1.x - e1 * d2.x) * r;
+					for (uint32_t k = 0; k < 3; k++)
+					{
+						genTangents[id[k]] += tangent;
+						genBitangents[id[k]] += bitangent;
+					}
+				}
+			}
+
+			auto writeFunc = [&](std::span<MeshVertex> outVertices, std::span<uint32_t> outIndices, AABB& aabb)
+				{
+					for (uint32_t o = 0; o < vertexCount; o++)
+					{
+						// без индексов порядок в треугольнике меняется перестановкой самих вершин
+						const uint32_t i = hasIndices ? o : windingOrder(o);
+						MeshVertex v;
+						v.position = glm::vec3(transform * glm::vec4(glm::vec3(readVec(positions, i)), 1.0f));
+						if (hasColors)    v.color = glm::vec3(readVec(colors, i, glm::vec4(1.0f)));
+						if (hasNormals)   v.normal = glm::normalize(normalTransform * glm::vec3(readVec(normals, i)));
+						if (hasTexCoords) v.texCoord = glm::vec2(readVec(texCoords, i));
+						if (hasTangents)
+						{
+							const glm::vec4 tangent = readVec(tangents, i);
+							v.tangent = glm::normalize(glm::mat3(transform) * glm::vec3(tangent));
+							v.bitangent = glm::cross(v.normal, v.tangent) * (tangent.w < 0.0f ? -mirror : mirror);
+						}
+						else if (!genTangents.empty())
+						{
+							const glm::vec3 n = glm::vec3(readVec(normals, i));
+							glm::vec3 tangent = genTangents[i] - n * glm::dot(n, genTangents[i]);
+							if (glm::dot(tangent, tangent) > 1e-12f)
+							{
+								tangent = glm::normalize(tangent);
+								const float handedness = glm::dot(glm::cross(n, tangent), genBitangents[i]) < 0.0f ? -1.0f : 1.0f;
+								v.tangent = glm::normalize(glm::mat3(transform) * tangent);
+								v.bitangent = glm::cross(v.normal, v.tangent) * handedness * mirror;
+							}
+						}
+						aabb.CombinePoint(v.position);
+						outVertices[o] = v;
+					}
+
+					if (!hasIndices) return;
+					if (!flipWinding && indices.componentType == ComponentUnsignedInt && indices.stride == sizeof(uint32_t))
+					{
+						// формат индексов совпадает - копия прямо из файла в буфер
+						std::memcpy(outIndices.data(), indices.data, outIndices.size_bytes());
+					}
+					else
+					{
+						for (uint32_t i = 0; i < indexCount; i++)
+							outIndices[i] = readIndex(indices, windingOrder(i));
+					}
+				};
+
+			const int materialId = primitive["material"].GetInt(-1);
+			std::optional<Material> material{};
+			std::optional<PBRMaterial> pbrMaterial{};
+			if (materialId >= 0 && static_cast<size_t>(materialId) < materials.size())
+			{
+				material = materials[static_cast<size_t>(materialId)];
+				pbrMaterial = pbrMaterials[static_cast<size_t>(materialId)];
+			}
+			else if (m_materialType == ModelMaterialType::BlinnPhong)
+				material = Material();
+			else if (m_materialType == ModelMaterialType::PBR)
+				pbrMaterial = PBRMaterial();
+
+			m_meshes.emplace_back(vertexCount, indexCount, writeFunc, std::move(material), std::move(pbrMaterial));
+		}
+	}
+
+	if (m_meshes.empty())
+	{
+		Error("glTF has no meshes: " + fileName);
+		return false;
+	}
+
+	return true;
+}
+//=============================================================================
\ No newline at end of file
@@ -1,14 +1,38 @@
 ﻿#include "stdafx.h"
 #include "NanoRenderTextures.h"
+#include "NanoCookedAssets.h"
+#include "NanoMipmap.h"
+#include "NanoMath.h"
 #include "NanoCore.h"
 #include "NanoLog.h"
 #include "NanoIO.h"
 //=============================================================================
+struct TextureResource final
+{
+	Texture2DHandle id{ 0 };
+	PixelFormat     pixelFormat{ PixelFormat::None };
+	uint32_t        width{ 0 };
+	uint32_t        height{ 0 };
+	size_t          bytes{ 0 };   // вместе с мипами
+	uint64_t        lastUse{ 0 }; // номер последнего запроса - для LRU
+
+	// потоковая подгрузка: загружены мипы [residentLevel, numLevels), более подробные читаются из cookedFileName по запросу
+	std::string     cookedFileName; // пусто - подгружать нечего
+	BlockFormat     format{ BlockFormat::None };
+	uint32_t        components{ 0 };
+	ColorSpace      colorSpace{ ColorSpace::Linear };
+	uint32_t        numLevels{ 1 };
+	uint32_t        residentLevel{ 0 };
+	uint32_t        requestedLevel{ NoStreamingRequest }; // самый подробный мип, запрошенный за кадр
+
+	static constexpr uint32_t NoStreamingRequest = std::numeric_limits<uint32_t>::max();
+};
+//=============================================================================
 struct TextureCache final
 {
 	bool operator==(const TextureCache&) const noexcept = default;
 
-	std::string name;
+	TexturePathId path;
 	bool sRGB;
 	bool flipVertical;
 };
@@ -20,11 +44,8 @@ namespace std
 	{
 		std::size_t operator()(const TextureCache& tc) const noexcept
 		{
-			std::size_t h1 = std::hash<std::string>{}(tc.name);
-			std::size_t h2 = std::hash<bool>{}(tc.sRGB);
-			std::size_t h3 = std::hash<bool>{}(tc.flipVertical);
 			std::size_t seed = 0;
-			HashCombine(seed, h1, h2, h3);
+			HashCombine(seed, tc.path.index, tc.sRGB, tc.flipVertical);
 			return seed;
 		}
 	};
@@ -32,12 +53,282 @@ namespace std
 //=============================================================================
 namespace
 {
-	std::unordered_map<TextureCache, Texture2D> texturesMap;
+	constexpr size_t DefaultMemoryBudget = 512ull * 1024 * 1024;
+	constexpr size_t DefaultStreamingUploadBudget = 8ull * 1024 * 1024;
+	// при потоковой загрузке сразу грузятся мипы не больше этого размера
+	constexpr uint32_t StreamingInitialSize = 64;
+	// тексели на пиксель экрана: текстура обычно тайлится по мешу, поэтому мип берется на уровень подробнее оценки
+	constexpr float StreamingMipBias = 1.0f;
+
+	struct PathHash final
+	{
+		using is_transparent = void;
+		std::size_t operator()(std::string_view path) const noexcept { return std::hash<std::string_view>{}(path); }
+	};
+
+	// deque - ссылки из GetPath не инвалидируются при добавлении
+	std::deque<std::string> paths;
+	std::unordered_map<std::string, TexturePathId, PathHash, std::equal_to<>> pathIds;
+
+	std::unordered_map<TextureCache, std::shared_ptr<TextureResource>> texturesMap;
+	size_t   residentBytes = 0;
+	size_t   memoryBudget = DefaultMemoryBudget;
+	size_t   numEvicted = 0;
+	uint64_t useCounter = 0;
+	bool     overBudgetReported = false;
+
+	bool     streamingEnabled = false;
+	size_t   streamingUploadBudget = DefaultStreamingUploadBudget;
+	// текстуры, у которых за кадр запросили еще не загруженные мипы
+	std::vector<std::shared_ptr<TextureResource>> streamingRequests;
+
 	Texture2D defaultWhite2D;
 	Texture2D defaultDiffuse2D;
 	Texture2D defaultNormal2D;
 	Texture2D defaultSpecular2D;
-}
+	//-------------------------------------------------------------------------
+	size_t getTextureBytes(uint32_t width, uint32_t height, uint32_t numLevels, BlockFormat format, uint32_t components)
+	{
+		// RGB8 драйверы хранят как RGBA8
+		const size_t bytesPerPixel = (components == 3) ? 4 : components;
+		size_t bytes = 0;
+		for (uint32_t level = 0; level < numLevels; level++)
+		{
+			bytes += (format == BlockFormat::None) ? size_t(width) * height * bytesPerPixel : bcn::GetCompressedSize(format, width, height);
+			width = std::max(1u, width / 2);
+			height = std::max(1u, height / 2);
+		}
+		return bytes;
+	}
+	//-------------------------------------------------------------------------
+	std::string bytesToMegabytes(size_t bytes)
+	{
+		return std::to_string((bytes + 512 * 1024) / (1024 * 1024)) + " MB";
+	}
+	//-------------------------------------------------------------------------
+	Texture2D useTexture(const std::shared_ptr<TextureResource>& resource)
+	{
+		resource->lastUse = ++useCounter;
+		return Texture2D{
+			.id = resource->id,
+			.pixelFormat = resource->pixelFormat,
+			.width = resource->width,
+			.height = resource->height,
+			.resource = resource
+		};
+	}
+	//-------------------------------------------------------------------------
+	// выгружает неиспользуемые текстуры, начиная с давно запрошенных, пока занятая память больше budget
+	void trimToBudget(size_t budget)
+	{
+		if (residentBytes <= budget)
+			return;
+
+		std::vector<decltype(texturesMap)::iterator> unused;
+		for (auto it = texturesMap.begin(); it != texturesMap.end(); ++it)
+		{
+			if (it->second.use_count() == 1)
+				unused.push_back(it);
+		}
+		std::sort(unused.begin(), unused.end(), [](const auto& a, const auto& b) { return a->second->lastUse < b->second->lastUse; });
+
+		for (const auto& it : unused)
+		{
+			if (residentBytes <= budget) break;
+
+			Debug("Evict Texture: " + paths[it->first.path.index]);
+			Destroy(it->second->id);
+			residentBytes -= it->second->bytes;
+			numEvicted++;
+			texturesMap.erase(it);
+		}
+	}
+	//-------------------------------------------------------------------------
+	Texture2D addTexture(const TextureCache& key, TextureResource&& resource)
+	{
+		auto entry = std::make_shared<TextureResource>(std::move(resource));
+		texturesMap[key] = entry;
+		residentBytes += entry->bytes;
+		Texture2D texture = useTexture(entry);
+
+		trimToBudget(memoryBudget);
+		if (residentBytes <= memoryBudget)
+			overBudgetReported = false;
+		else if (!overBudgetReported)
+		{
+			Warning("Textures in use exceed memory budget: " + bytesToMegabytes(residentBytes) + " of " + bytesToMegabytes(memoryBudget));
+			overBudgetReported = true;
+		}
+		return texture;
+	}
+	//-------------------------------------------------------------------------
+	// грузит мипы [firstLevel, lastLevel] и открывает выборку с firstLevel. Более подробные мипы дозагружаются позже
+	void uploadMips(TextureResource& texture, const CookedTexture& cookedTexture, uint32_t firstLevel, uint32_t lastLevel)
+	{
+		const bool compressed = texture.format != BlockFormat::None;
+		InternalFormat internalFormat{};
+		switch (texture.components)
+		{
+		case 1: internalFormat = InternalFormat::R8; break;
+		case 2: internalFormat = InternalFormat::RG8; break;
+		case 3: internalFormat = (texture.colorSpace == ColorSpace::sRGB) ? InternalFormat::SRGB8 : InternalFormat::RGB8; break;
+		case 4: internalFormat = (texture.colorSpace == ColorSpace::sRGB) ? InternalFormat::SRGB8_ALPHA8 : InternalFormat::RGBA8; break;
+		default: std::unreachable();
+		}
+
+		// строки мипов плотно упакованы - у RGB и нечетной ширины нет выравнивания на 4
+		GLint unpackAlignment = 4;
+		glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		const GLuint currentTexture = GetCurrentTexture(GL_TEXTURE_2D);
+		glBindTexture(GL_TEXTURE_2D, texture.id.handle);
+		for (uint32_t level = firstLevel; level <= lastLevel; level++)
+		{
+			const auto& mip = cookedTexture.mips[level];
+			const uint32_t width = std::max(1u, texture.width >> level);
+			const uint32_t height = std::max(1u, texture.height >> level);
+			if (compressed)
+				glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), bcn::GetInternalFormatGL(texture.format, texture.colorSpace), static_cast<GLsizei>(width), static_cast<GLsizei>(height), 0, static_cast<GLsizei>(mip.size()), mip.data());
+			else
+				glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), EnumToValue(internalFormat), static_cast<GLsizei>(width), static_cast<GLsizei>(height), 0, EnumToValue(texture.pixelFormat), GL_UNSIGNED_BYTE, mip.data());
+			texture.bytes += getTextureBytes(width, height, 1, texture.format, texture.components);
+		}
+		// уровень детализации считается от базового мипа, так что отдельно ограничивать GL_TEXTURE_MIN_LOD не нужно
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(firstLevel));
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(texture.numLevels - 1));
+		glBindTexture(GL_TEXTURE_2D, currentTexture);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+
+		texture.residentLevel = firstLevel;
+	}
+	//-------------------------------------------------------------------------
+	// текстура из готовой цепочки мипов, в видеопамять грузятся мипы с firstLevel. streamFileName - откуда дозагружать остальные
+	TextureResource createTexture(const CookedTexture& cookedTexture, ColorSpace colorSpace, uint32_t firstLevel, const std::string& streamFileName)
+	{
+		const bool compressed = cookedTexture.format != BlockFormat::None;
+		const uint32_t numLevels = static_cast<uint32_t>(cookedTexture.mips.size());
+		TextureResource texture{
+			.pixelFormat = PixelFormat::None,
+			.width = cookedTexture.width,
+			.height = cookedTexture.height,
+			.cookedFileName = streamFileName,
+			.format = cookedTexture.format,
+			.components = compressed ? bcn::GetComponents(cookedTexture.format) : cookedTexture.components,
+			.colorSpace = colorSpace,
+			.numLevels = numLevels
+		};
+		switch (texture.components)
+		{
+		case 1: texture.pixelFormat = PixelFormat::Red; break;
+		case 2: texture.pixelFormat = PixelFormat::Rg; break;
+		case 3: texture.pixelFormat = PixelFormat::Rgb; break;
+		case 4: texture.pixelFormat = PixelFormat::Rgba; break;
+		default: std::unreachable();
+		}
+
+		glGenTextures(1, &texture.id.handle);
+		uploadMips(texture, cookedTexture, firstLevel, numLevels - 1);
+		if (!IsValid(texture.id))
+			return {};
+
+		TextureConfig texConfig{
+			.minFilter = (numLevels > 1) ? TextureFilter::LinearMipmapLinear : TextureFilter::Linear,
+			.magFilter = TextureFilter::Linear,
+			.wrapS = TextureWrap::Repeat,
+			.wrapT = TextureWrap::Repeat,
+			.generateMipmaps = false
+		};
+		SetTextureParameters(texture.id, texConfig);
+
+		return texture;
+	}
+	//-------------------------------------------------------------------------
+	// пиксели как у stbi_load. Мипы строятся на CPU и грузятся всей цепочкой: glGenerateMipmap на части драйверов
+	// останавливает конвейер, а на части фильтрует sRGB без перевода в линейное пространство
+	TextureResource uploadPixels(const stbi_uc* pixels, int width, int height, int nrComponents, ColorSpace colorSpace)
+	{
+		CookedTexture texture{
+			.width = static_cast<uint32_t>(width),
+			.height = static_cast<uint32_t>(height),
+			.components = static_cast<uint32_t>(nrComponents),
+			.colorSpace = colorSpace,
+			.format = BlockFormat::None,
+			.mips = {}
+		};
+		const MipSettings mipSettings{
+			.filter = MipFilter::Box,
+			.colorSpace = colorSpace,
+			.alphaCutoff = mipmap::IsCutout(pixels, texture.width, texture.height, texture.components) ? mipmap::DefaultAlphaCutoff : 0.0f
+		};
+		texture.mips = mipmap::Generate(pixels, texture.width, texture.height, texture.components, mipSettings);
+		return createTexture(texture, colorSpace, 0, std::string());
+	}
+	//-------------------------------------------------------------------------
+	// мипы от AssetCooker'а грузятся как есть. При streaming сначала только мелкие мипы
+	TextureResource loadCookedTexture(const std::string& fileName, ColorSpace colorSpace, bool streaming)
+	{
+		// сначала только заголовок - от размеров зависит, с какого мипа начинать
+		CookedTexture cookedTexture;
+		if (!cooked::LoadTexture(fileName, cookedTexture, std::numeric_limits<uint32_t>::max()) || cookedTexture.mips.empty())
+			return {};
+
+		const bool compressed = cookedTexture.format != BlockFormat::None;
+		// без поддержки формата вызывающий код загрузит исходник
+		if (compressed && !bcn::IsSupported(cookedTexture.format))
+		{
+			Warning("Texture format " + std::string(bcn::GetFormatName(cookedTexture.format)) + " is not supported: " + fileName);
+			return {};
+		}
+
+		const uint32_t numLevels = static_cast<uint32_t>(cookedTexture.mips.size());
+		uint32_t firstLevel = 0;
+		if (streaming)
+		{
+			while (firstLevel + 1 < numLevels && std::max(cookedTexture.width >> firstLevel, cookedTexture.height >> firstLevel) > StreamingInitialSize)
+				firstLevel++;
+		}
+		if (!cooked::LoadTexture(fileName, cookedTexture, firstLevel))
+			return {};
+
+		return createTexture(cookedTexture, colorSpace, firstLevel, (firstLevel > 0) ? fileName : std::string());
+	}
+	//-------------------------------------------------------------------------
+	// дозагружает мипы до requestedLevel, но не больше, чем осталось в бюджете кадра (хотя бы один мип, если бюджет еще не тронут)
+	size_t streamTexture(TextureResource& texture, size_t budgetLeft, bool firstUpload)
+	{
+		uint32_t level = texture.residentLevel;
+		size_t bytes = 0;
+		while (level > texture.requestedLevel)
+		{
+			const size_t levelBytes = getTextureBytes(std::max(1u, texture.width >> (level - 1)), std::max(1u, texture.height >> (level - 1)), 1, texture.format, texture.components);
+			if (bytes + levelBytes > budgetLeft && !(firstUpload && bytes == 0))
+				break;
+			bytes += levelBytes;
+			level--;
+		}
+		if (level == texture.residentLevel)
+			return 0;
+
+		CookedTexture cookedTexture;
+		if (!cooked::LoadTexture(texture.cookedFileName, cookedTexture, level, texture.residentLevel - 1)
+			|| cookedTexture.width != texture.width || cookedTexture.height != texture.height
+			|| cookedTexture.mips.size() != texture.numLevels || cookedTexture.format != texture.format)
+		{
+			// файл перезапечен или удален - остаемся на загруженных мипах
+			Warning("Failed to stream texture mips: " + texture.cookedFileName);
+			texture.cookedFileName.clear();
+			return 0;
+		}
+
+		const size_t oldBytes = texture.bytes;
+		uploadMips(texture, cookedTexture, level, texture.residentLevel - 1);
+		residentBytes += texture.bytes - oldBytes;
+		if (texture.residentLevel == 0)
+			texture.cookedFileName.clear();
+		return bytes;
+	}
+} // namespace
 //=============================================================================
 bool IsValid(Texture2D tex)
 {
@@ -185,9 +476,11 @@ void textures::Close()
 
 	for (auto& it : texturesMap)
 	{
-		Destroy(it.second.id);
+		Destroy(it.second->id);
 	}
 	texturesMap.clear();
+	streamingRequests.clear();
+	residentBytes = 0;
 }
 //=============================================================================
 Texture2D textures::GetWhiteTexture2D()
@@ -210,152 +503,190 @@ Texture2D textures::GetDefaultSpecular2D()
 	return defaultSpecular2D;
 }
 //=============================================================================
-Texture2D textures::LoadTexture2D(const std::string& fileName, ColorSpace colorSpace, bool flipVertical)
+TexturePathId textures::InternPath(std::string_view path)
 {
-	TextureCache keyMap = { .name = fileName, .sRGB = colorSpace == ColorSpace::sRGB, .flipVertical = flipVertical};
-	auto it = texturesMap.find(keyMap);
-	if (it != texturesMap.end() && IsValid(it->second))
-	{
+	if (auto it = pathIds.find(path); it != pathIds.end())
 		return it->second;
-	}
-	else
-	{
-		bool hasTex = io::Exists(fileName);
-		if (hasTex == false)
-		{
-			Error("Failed to load texture " + fileName);
-			return GetDefaultDiffuse2D();
-		}
 
-		stbi_set_flip_vertically_on_load(flipVertical);
+	const TexturePathId id{ .index = static_cast<uint32_t>(paths.size()) };
+	paths.emplace_back(path);
+	pathIds.emplace(paths.back(), id);
+	return id;
+}
+//=============================================================================
+const std::string& textures::GetPath(TexturePathId path)
+{
+	assert(path.index < paths.size());
+	return paths[path.index];
+}
+//=============================================================================
+Texture2D textures::LoadTexture2D(TexturePathId path, ColorSpace colorSpace, bool flipVertical)
+{
+	const TextureCache keyMap = { .path = path, .sRGB = colorSpace == ColorSpace::sRGB, .flipVertical = flipVertical };
+	if (auto it = texturesMap.find(keyMap); it != texturesMap.end())
+		return useTexture(it->second);
 
-		int width, height, nrComponents;
-		stbi_uc* pixels = stbi_load(fileName.c_str(), &width, &height, &nrComponents, 0);
-		if (!pixels || nrComponents < 1 || nrComponents > 4 || width <= 0 || height <= 0)
-		{
-			stbi_image_free(pixels);
-			Error("Failed to load texture " + fileName);
-			return GetDefaultDiffuse2D();
-		}
+	const std::string& fileName = GetPath(path);
+	if (!io::Exists(fileName))
+	{
+		Error("Failed to load texture " + fileName);
+		return GetDefaultDiffuse2D();
+	}
 
-		InternalFormat internalFormat{};
-		PixelFormat pixelFormat{ PixelFormat::None };
-		if (nrComponents == 1)
-		{
-			internalFormat = InternalFormat::R8;
-			pixelFormat = PixelFormat::Red;
-		}
-		else if (nrComponents == 2)
-		{
-			internalFormat = InternalFormat::RG8;
-			pixelFormat = PixelFormat::Rg;
-		}
-		else if (nrComponents == 3)
-		{
-			internalFormat = (colorSpace == ColorSpace::sRGB) ? InternalFormat::SRGB8 : InternalFormat::RGB8;
-			pixelFormat = PixelFormat::Rgb;
-		}
-		else if (nrComponents == 4)
-		{
-			internalFormat = (colorSpace == ColorSpace::sRGB) ? InternalFormat::SRGB8_ALPHA8 : InternalFormat::RGBA8;
-			pixelFormat = PixelFormat::Rgba;
-		}
-		else
+	// запеченные мипы хранятся без переворота
+	const std::string cookedFileName = cooked::GetCookedPath(fileName, cooked::TextureExtension);
+	if (!flipVertical && cooked::IsUpToDate(fileName, cookedFileName))
+	{
+		if (TextureResource texture = loadCookedTexture(cookedFileName, colorSpace, streamingEnabled); IsValid(texture.id))
 		{
-			std::unreachable();
+			Debug("Load Cooked Texture: " + fileName);
+			return addTexture(keyMap, std::move(texture));
 		}
+	}
 
-		Texture2DHandle textureID = CreateTexture2D(static_cast<uint32_t>(width), static_cast<uint32_t>(height), internalFormat, pixelFormat, PixelType::UnsignedByte, pixels);
-		TextureConfig texConfig{
-			.minFilter = TextureFilter::LinearMipmapLinear,
-			.magFilter = TextureFilter::Linear,
-			.wrapS = TextureWrap::Repeat,
-			.wrapT = TextureWrap::Repeat,
-			.generateMipmaps = true
-		};
-		SetTextureParameters(textureID, texConfig);
+	stbi_set_flip_vertically_on_load(flipVertical);
 
+	int width, height, nrComponents;
+	stbi_uc* pixels = stbi_load(fileName.c_str(), &width, &height, &nrComponents, 0);
+	if (!pixels || nrComponents < 1 || nrComponents > 4 || width <= 0 || height <= 0)
+	{
 		stbi_image_free(pixels);
-
-		Debug("Load Texture: " + fileName);
-
-		texturesMap[keyMap] = Texture2D{ 
-			.id = textureID, 
-			.pixelFormat = pixelFormat,
-			.width = static_cast<uint32_t>(width), 
-			.height = static_cast<uint32_t>(height)
-		};
-		return texturesMap[keyMap];
+		Error("Failed to load texture " + fileName);
+		return GetDefaultDiffuse2D();
 	}
+	TextureResource texture = uploadPixels(pixels, width, height, nrComponents, colorSpace);
+	stbi_image_free(pixels);
+
+	Debug("Load Texture: " + fileName);
+	return addTexture(keyMap, std::move(texture));
+}
+//=============================================================================
+Texture2D textures::LoadTexture2D(const std::string& fileName, ColorSpace colorSpace, bool flipVertical)
+{
+	return LoadTexture2D(InternPath(fileName), colorSpace, flipVertical);
 }
 //=============================================================================
 Texture2D textures::CreateTextureFromData(std::string_view name, aiTexture* embTex, ColorSpace colorSpace, bool flipVertical)
 {
-	TextureCache keyMap = { .name = name.data(), .sRGB = colorSpace == ColorSpace::sRGB, .flipVertical = flipVertical };
-	auto it = texturesMap.find(keyMap);
-	if (it != texturesMap.end())
+	size_t size = (embTex->mHeight == 0) ? embTex->mWidth : embTex->mWidth * embTex->mHeight;
+	return LoadTexture2DFromMemory(name, { reinterpret_cast<const uint8_t*>(embTex->pcData), size }, colorSpace, flipVertical);
+}
+//=============================================================================
+Texture2D textures::LoadTexture2DFromMemory(std::string_view name, std::span<const uint8_t> fileData, ColorSpace colorSpace, bool flipVertical)
+{
+	const TextureCache keyMap = { .path = InternPath(name), .sRGB = colorSpace == ColorSpace::sRGB, .flipVertical = flipVertical };
+	if (auto it = texturesMap.find(keyMap); it != texturesMap.end())
+		return useTexture(it->second);
+
+	stbi_set_flip_vertically_on_load(flipVertical);
+
+	int width, height, nrComponents;
+	stbi_uc* data = stbi_load_from_memory(fileData.data(), static_cast<int>(fileData.size()), &width, &height, &nrComponents, 0);
+	if (!data || nrComponents < 1 || nrComponents > 4 || width <= 0 || height <= 0)
 	{
-		return it->second;
+		stbi_image_free(data);
+		Error("Error while trying to load texture from memory: " + std::string(name));
+		return GetDefaultDiffuse2D();
 	}
-	else
+	TextureResource texture = uploadPixels(data, width, height, nrComponents, colorSpace);
+	stbi_image_free(data);
+
+	Debug("Load Texture: " + std::string(name));
+	return addTexture(keyMap, std::move(texture));
+}
+//=============================================================================
+void textures::SetMemoryBudget(size_t bytes)
+{
+	memoryBudget = bytes;
+	trimToBudget(memoryBudget);
+}
+//=============================================================================
+void textures::ReleaseUnused()
+{
+	trimToBudget(0);
+}
+//=============================================================================
+TextureMemoryStats textures::GetMemoryStats()
+{
+	TextureMemoryStats stats{
+		.numTextures = texturesMap.size(),
+		.residentBytes = residentBytes,
+		.budgetBytes = memoryBudget,
+		.numEvicted = numEvicted
+	};
+	for (const auto& it : texturesMap)
 	{
-		stbi_set_flip_vertically_on_load(flipVertical);
-
-		int width, height, nrComponents;
-		stbi_uc* data{ nullptr };
-		if (embTex->mHeight == 0)
-			data = stbi_load_from_memory(reinterpret_cast<unsigned char*>(embTex->pcData), static_cast<int>(embTex->mWidth), &width, &height, &nrComponents, 0);
-		else
-			data = stbi_load_from_memory(reinterpret_cast<unsigned char*>(embTex->pcData), static_cast<int>(embTex->mWidth * embTex->mHeight), &width, &height, &nrComponents, 0);
-		if (!data || nrComponents < 1 || nrComponents > 4 || width <= 0 || height <= 0)
+		if (it.second.use_count() == 1)
 		{
-			stbi_image_free(data);
-			Error("Error while trying to load embedded texture!");
-			return GetDefaultDiffuse2D();
+			stats.numUnused++;
+			stats.unusedBytes += it.second->bytes;
 		}
+		if (!it.second->cookedFileName.empty())
+			stats.numStreaming++;
+	}
+	return stats;
+}
+//=============================================================================
+void textures::EnableStreaming(bool enable)
+{
+	streamingEnabled = enable;
+}
+//=============================================================================
+void textures::SetStreamingUploadBudget(size_t bytesPerFrame)
+{
+	streamingUploadBudget = bytesPerFrame;
+}
+//=============================================================================
+float textures::EstimateScreenSize(const AABB& localBounds, const glm::mat4& world, const glm::vec3& cameraPosition, float projectionScale)
+{
+	// описанная сфера AABB: радиус растягивается наибольшим масштабом модели
+	const float scale = std::max({ glm::length(glm::vec3(world[0])), glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2])) });
+	const glm::vec3 center = glm::vec3(world * glm::vec4(localBounds.GetCenter(), 1.0f));
+	const float radius = 0.5f * glm::length(localBounds.GetSize()) * scale;
 
-		InternalFormat internalFormat{};
-		PixelFormat pixelFormat{ PixelFormat::None };
-		if (nrComponents == 1)
-		{
-			internalFormat = InternalFormat::R8;
-			pixelFormat = PixelFormat::Red;
-		}
-		else if (nrComponents == 2)
-		{
-			internalFormat = InternalFormat::RG8;
-			pixelFormat = PixelFormat::Rg;
-		}
-		else if (nrComponents == 3)
-		{
-			internalFormat = (colorSpace == ColorSpace::sRGB) ? InternalFormat::SRGB8 : InternalFormat::RGB8;
-			pixelFormat = PixelFormat::Rgb;
-		}
-		else if (nrComponents == 4)
-		{
-			internalFormat = (colorSpace == ColorSpace::sRGB) ? InternalFormat::SRGB8_ALPHA8 : InternalFormat::RGBA8;
-			pixelFormat = PixelFormat::Rgba;
-		}
-		else
-		{
-			std::unreachable();
-		}
+	const float distance = glm::distance(center, cameraPosition) - radius;
+	if (distance <= 0.0f)
+		return std::numeric_limits<float>::max(); // камера внутри - нужна полная детализация
+	return 2.0f * radius * projectionScale / distance;
+}
+//=============================================================================
+void textures::RequestScreenSize(const Texture2D& texture, float screenSize)
+{
+	TextureResource* resource = texture.resource.get();
+	if (!resource || resource->cookedFileName.empty() || screenSize <= 0.0f)
+		return;
 
-		Texture2DHandle textureID = CreateTexture2D(static_cast<uint32_t>(width), static_cast<uint32_t>(height), internalFormat, pixelFormat, PixelType::UnsignedByte, data);
-		TextureConfig texConfig{
-			.minFilter = TextureFilter::LinearMipmapLinear,
-			.magFilter = TextureFilter::Linear,
-			.wrapS = TextureWrap::Repeat,
-			.wrapT = TextureWrap::Repeat,
-			.generateMipmaps = true
-		};
-		SetTextureParameters(textureID, texConfig);
-		
-		stbi_image_free(data);
+	const float texels = static_cast<float>(std::max(resource->width, resource->height));
+	const float desiredLevel = std::log2(texels / screenSize) - StreamingMipBias;
+	const uint32_t level = (desiredLevel <= 0.0f) ? 0u : std::min(static_cast<uint32_t>(desiredLevel), resource->numLevels - 1);
+	if (level >= resource->residentLevel || level >= resource->requestedLevel)
+		return;
+
+	if (resource->requestedLevel == TextureResource::NoStreamingRequest)
+		streamingRequests.push_back(texture.resource);
+	resource->requestedLevel = level;
+}
+//=============================================================================
+void textures::UpdateStreaming()
+{
+	if (streamingRequests.empty())
+		return;
 
-		Debug("Load Texture: " + std::string(name));
-		texturesMap[keyMap] = Texture2D{ .id = textureID, .width = (uint32_t)width, .height = (uint32_t)height };
-		return texturesMap[keyMap];
+	// сначала текстуры, которым больше всего не хватает детализации
+	std::sort(streamingRequests.begin(), streamingRequests.end(), [](const auto& a, const auto& b)
+		{
+			return a->residentLevel - a->requestedLevel > b->residentLevel - b->requestedLevel;
+		});
+
+	size_t uploadedBytes = 0;
+	for (const auto& resource : streamingRequests)
+	{
+		if (uploadedBytes < streamingUploadBudget && !resource->cookedFileName.empty())
+			uploadedBytes += streamTexture(*resource, streamingUploadBudget - uploadedBytes, uploadedBytes == 0);
+		resource->requestedLevel = TextureResource::NoStreamingRequest;
 	}
+	streamingRequests.clear();
+
+	trimToBudget(memoryBudget);
 }
-//=============================================================================
\ No newline at end of file
+//=============================================================================
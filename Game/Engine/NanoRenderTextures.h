@@ -2,6 +2,9 @@
 
 #include "NanoOpenGL3Advance.h"
 
+class AABB;
+struct TextureResource; // запись кеша textures::
+
 struct Texture2D final
 {
 	bool operator==(const Texture2D& rhs) const
@@ -17,6 +20,27 @@ struct Texture2D final
 	PixelFormat   pixelFormat{ PixelFormat::None };
 	uint32_t      width{ 0 };
 	uint32_t      height{ 0 };
+	// пока жива хоть одна копия, textures:: не выгрузит текстуру. У текстур не из кеша пустой
+	std::shared_ptr<TextureResource> resource;
+};
+
+// путь, сохраненный в textures:: один раз. Поиск в кеше по нему не хеширует строку
+struct TexturePathId final
+{
+	bool operator==(const TexturePathId&) const noexcept = default;
+
+	uint32_t index{ 0 };
+};
+
+struct TextureMemoryStats final
+{
+	size_t numTextures{ 0 };
+	size_t numUnused{ 0 };     // никем не используются - выгружаются первыми
+	size_t residentBytes{ 0 }; // вместе с мипами
+	size_t unusedBytes{ 0 };
+	size_t budgetBytes{ 0 };
+	size_t numEvicted{ 0 };    // за все время
+	size_t numStreaming{ 0 };  // подробные мипы еще не загружены
 };
 
 bool IsValid(Texture2D tex);
@@ -31,6 +55,30 @@ namespace textures
 	Texture2D GetDefaultDiffuse2D();
 	Texture2D GetDefaultNormal2D();
 	Texture2D GetDefaultSpecular2D();
+	TexturePathId InternPath(std::string_view path);
+	const std::string& GetPath(TexturePathId path);
+
+	// выгруженная по бюджету текстура загружается заново при следующем запросе
+	Texture2D LoadTexture2D(TexturePathId path, ColorSpace colorSpace = ColorSpace::Linear, bool flipVertical = false);
 	Texture2D LoadTexture2D(const std::string& fileName, ColorSpace colorSpace = ColorSpace::Linear, bool flipVertical = false);
 	Texture2D CreateTextureFromData(std::string_view name, aiTexture* embTex, ColorSpace colorSpace = ColorSpace::Linear, bool flipVertical = false);
+	// сжатое изображение (png, jpg...) в памяти. name - ключ кеша
+	Texture2D LoadTexture2DFromMemory(std::string_view name, std::span<const uint8_t> fileData, ColorSpace colorSpace = ColorSpace::Linear, bool flipVertical = false);
+
+	// При превышении бюджета выгружаются неиспользуемые текстуры, начиная с давно запрошенных
+	void SetMemoryBudget(size_t bytes);
+	// выгрузить все неиспользуемые, не дожидаясь бюджета
+	void ReleaseUnused();
+	TextureMemoryStats GetMemoryStats();
+
+	// Потоковая загрузка запеченных текстур: сначала мелкие мипы, подробные - по запросу рендера.
+	// Действует на текстуры, загруженные после включения. Без запросов текстура так и останется размытой
+	void EnableStreaming(bool enable);
+	void SetStreamingUploadBudget(size_t bytesPerFrame);
+	// примерный размер объекта на экране в пикселях. projectionScale = 0.5 * высота вьюпорта * proj[1][1]
+	float EstimateScreenSize(const AABB& localBounds, const glm::mat4& world, const glm::vec3& cameraPosition, float projectionScale);
+	// запрос мипа под экранный размер. Запросы копятся за кадр и обрабатываются в UpdateStreaming
+	void RequestScreenSize(const Texture2D& texture, float screenSize);
+	// вызывается раз в кадр: дозагружает запрошенные мипы в пределах бюджета
+	void UpdateStreaming();
 } // namespace textures
\ No newline at end of file
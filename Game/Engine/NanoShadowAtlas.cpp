@@ -0,0 +1,109 @@
+﻿#include "stdafx.h"
+#include "NanoShadowAtlas.h"
+//=============================================================================
+void ShadowAtlasAllocator::Init(uint32_t atlasSize, uint32_t minTileSize)
+{
+	assert(std::has_single_bit(atlasSize) && std::has_single_bit(minTileSize) && minTileSize <= atlasSize);
+
+	m_atlasSize = atlasSize;
+	m_minTileSize = minTileSize;
+
+	size_t numNodes = 0;
+	for (uint32_t size = atlasSize; size >= minTileSize; size /= 2)
+		numNodes = numNodes * 4 + 1;
+	m_nodes.assign(numNodes, NodeState::Free);
+}
+//=============================================================================
+void ShadowAtlasAllocator::Clear()
+{
+	std::fill(m_nodes.begin(), m_nodes.end(), NodeState::Free);
+}
+//=============================================================================
+bool ShadowAtlasAllocator::Allocate(uint32_t size, ShadowAtlasRect& rect)
+{
+	size = std::max(std::bit_ceil(size), m_minTileSize);
+	if (m_nodes.empty() || size > m_atlasSize) return false;
+
+	return allocate(0, m_atlasSize, size, 0, 0, rect);
+}
+//=============================================================================
+void ShadowAtlasAllocator::Free(const ShadowAtlasRect& rect)
+{
+	if (rect.size == 0) return;
+
+	// путь от корня до узла тайла
+	std::array<uint32_t, 16> path;
+	size_t depth = 0;
+	uint32_t node = 0;
+	uint16_t x = 0, y = 0;
+	for (uint32_t nodeSize = m_atlasSize; nodeSize > rect.size; nodeSize /= 2)
+	{
+		path[depth++] = node;
+		const uint32_t half = nodeSize / 2;
+		const uint32_t cx = rect.x >= x + half ? 1 : 0;
+		const uint32_t cy = rect.y >= y + half ? 1 : 0;
+		x = static_cast<uint16_t>(x + cx * half);
+		y = static_cast<uint16_t>(y + cy * half);
+		node = 4 * node + 1 + cy * 2 + cx;
+	}
+	assert(x == rect.x && y == rect.y && m_nodes[node] == NodeState::Used);
+	m_nodes[node] = NodeState::Free;
+
+	// родитель со всеми свободными детьми снова целый
+	while (depth > 0)
+	{
+		const uint32_t parent = path[--depth];
+		const uint32_t first = 4 * parent + 1;
+		if (m_nodes[first] != NodeState::Free || m_nodes[first + 1] != NodeState::Free || m_nodes[first + 2] != NodeState::Free || m_nodes[first + 3] != NodeState::Free)
+			break;
+		m_nodes[parent] = NodeState::Free;
+	}
+}
+//=============================================================================
+glm::vec4 ShadowAtlasAllocator::GetScaleBiasUV(const ShadowAtlasRect& rect) const
+{
+	const float invSize = 1.0f / static_cast<float>(m_atlasSize);
+	return glm::vec4(rect.x * invSize, rect.y * invSize, rect.size * invSize, rect.size * invSize);
+}
+//=============================================================================
+glm::vec4 ShadowAtlasAllocator::GetScaleBiasNDC(const ShadowAtlasRect& rect) const
+{
+	const float invSize = 1.0f / static_cast<float>(m_atlasSize);
+	const float scale = rect.size * invSize;
+	return glm::vec4(scale, scale, (2.0f * rect.x + rect.size) * invSize - 1.0f, (2.0f * rect.y + rect.size) * invSize - 1.0f);
+}
+//=============================================================================
+bool ShadowAtlasAllocator::allocate(uint32_t node, uint32_t nodeSize, uint32_t size, uint16_t x, uint16_t y, ShadowAtlasRect& rect)
+{
+	if (m_nodes[node] == NodeState::Used) return false;
+	if (nodeSize == size)
+	{
+		if (m_nodes[node] != NodeState::Free) return false;
+		m_nodes[node] = NodeState::Used;
+		rect = { .x = x, .y = y, .size = static_cast<uint16_t>(size) };
+		return true;
+	}
+
+	const bool wasFree = m_nodes[node] == NodeState::Free;
+	m_nodes[node] = NodeState::Split;
+
+	// сначала в уже разделенных детях, целые свободные - в последнюю очередь
+	const uint32_t half = nodeSize / 2;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			const uint32_t child = 4 * node + 1 + c;
+			const bool childFree = m_nodes[child] == NodeState::Free;
+			if (half > size && childFree != (pass == 1)) continue;
+			if (half == size && pass == 1) continue;
+
+			if (allocate(child, half, size, static_cast<uint16_t>(x + (c & 1) * half), static_cast<uint16_t>(y + (c >> 1) * half), rect))
+				return true;
+		}
+	}
+
+	if (wasFree) m_nodes[node] = NodeState::Free;
+	return false;
+}
+//=============================================================================
@@ -0,0 +1,43 @@
+﻿#pragma once
+
+// Тайл атласа теней в текселях
+struct ShadowAtlasRect final
+{
+	uint16_t x{ 0 };
+	uint16_t y{ 0 };
+	uint16_t size{ 0 }; // 0 - тайла нет
+};
+
+// Распределение атласа теней квадродеревом: квадрат делится на четыре, тайлы - степени двойки от minTileSize до размера атласа.
+// Освобожденные соседи сливаются обратно в родителя. Новый тайл сначала ищется в уже разделенных узлах, чтобы не дробить свободные
+class ShadowAtlasAllocator final
+{
+public:
+	void Init(uint32_t atlasSize, uint32_t minTileSize);
+	void Clear();
+
+	// size округляется вверх до степени двойки. false - свободного квадрата такого размера нет
+	bool Allocate(uint32_t size, ShadowAtlasRect& rect);
+	void Free(const ShadowAtlasRect& rect);
+
+	uint32_t GetAtlasSize() const { return m_atlasSize; }
+	uint32_t GetMinTileSize() const { return m_minTileSize; }
+	// UV тайла в атласе: xy - смещение, zw - масштаб
+	glm::vec4 GetScaleBiasUV(const ShadowAtlasRect& rect) const;
+	// тайл в NDC атласа: xy - масштаб, zw - смещение. Переводит NDC проекции источника в его тайл
+	glm::vec4 GetScaleBiasNDC(const ShadowAtlasRect& rect) const;
+
+private:
+	enum class NodeState : uint8_t
+	{
+		Free,
+		Split,
+		Used
+	};
+
+	bool allocate(uint32_t node, uint32_t nodeSize, uint32_t size, uint16_t x, uint16_t y, ShadowAtlasRect& rect);
+
+	std::vector<NodeState> m_nodes; // полное дерево, дети узла n - 4n+1..4n+4
+	uint32_t               m_atlasSize{ 0 };
+	uint32_t               m_minTileSize{ 0 };
+};
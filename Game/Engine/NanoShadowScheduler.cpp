@@ -0,0 +1,55 @@
+﻿#include "stdafx.h"
+#include "NanoShadowScheduler.h"
+//=============================================================================
+namespace
+{
+	// источник с нулевой важностью тоже дождется своей очереди
+	constexpr float MinImportance = 0.01f;
+} // namespace
+//=============================================================================
+void ShadowUpdateScheduler::Begin(size_t budget)
+{
+	m_budget = budget;
+	m_requests.clear();
+	m_scheduled.clear();
+}
+//=============================================================================
+void ShadowUpdateScheduler::Add(uint32_t id, float importance, bool force)
+{
+	if (id >= m_framesSinceUpdate.size())
+		m_framesSinceUpdate.resize(id + 1, 0);
+
+	if (force || importance >= 1.0f)
+		m_scheduled.push_back(id);
+	else
+		m_requests.push_back({ .id = id, .priority = std::max(importance, MinImportance) * static_cast<float>(m_framesSinceUpdate[id] + 1) });
+}
+//=============================================================================
+const std::vector<uint32_t>& ShadowUpdateScheduler::Schedule()
+{
+	const size_t count = std::min(m_budget, m_requests.size());
+	std::partial_sort(m_requests.begin(), m_requests.begin() + count, m_requests.end(), [](const Request& a, const Request& b) { return a.priority > b.priority; });
+
+	for (const Request& request : m_requests)
+		m_framesSinceUpdate[request.id]++;
+	for (size_t i = 0; i < count; i++)
+		m_scheduled.push_back(m_requests[i].id);
+	for (const uint32_t id : m_scheduled)
+		m_framesSinceUpdate[id] = 0;
+
+	std::sort(m_scheduled.begin(), m_scheduled.end());
+	return m_scheduled;
+}
+//=============================================================================
+bool ShadowUpdateScheduler::IsScheduled(uint32_t id) const
+{
+	return std::binary_search(m_scheduled.begin(), m_scheduled.end(), id);
+}
+//=============================================================================
+void ShadowUpdateScheduler::Reset()
+{
+	m_framesSinceUpdate.clear();
+	m_requests.clear();
+	m_scheduled.clear();
+}
+//=============================================================================
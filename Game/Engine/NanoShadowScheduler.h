@@ -0,0 +1,29 @@
+﻿#pragma once
+
+// Планировщик обновления теневых карт с бюджетом на кадр. Обязательные (свет сдвинулся, карты еще нет) и важные
+// (importance >= 1) обновляются каждый кадр вне бюджета. Остальные - не больше budget за кадр по убыванию
+// importance * число кадров без обновления: далекие и неважные источники обновляются по очереди, важные - чаще
+class ShadowUpdateScheduler final
+{
+public:
+	void Begin(size_t budget);
+	// id - постоянный номер карты (индекс источника, каскада)
+	void Add(uint32_t id, float importance, bool force = false);
+	// id карт, которые обновить в этом кадре, по возрастанию
+	const std::vector<uint32_t>& Schedule();
+	bool IsScheduled(uint32_t id) const;
+
+	void Reset();
+
+private:
+	struct Request final
+	{
+		uint32_t id;
+		float    priority;
+	};
+
+	std::vector<uint32_t> m_framesSinceUpdate; // по id
+	std::vector<Request>  m_requests;
+	std::vector<uint32_t> m_scheduled;
+	size_t                m_budget{ 0 };
+};
@@ -0,0 +1,585 @@
+﻿#include "stdafx.h"
+#include "NanoTextureCompression.h"
+#include "NanoCore.h"
+#include "NanoLog.h"
+//=============================================================================
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#	include <emmintrin.h>
+#	define NANO_BCN_SSE2 1
+#endif
+//=============================================================================
+// в glad собран только core 3.3 - форматы из расширений
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#	define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#	define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#	define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#	define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#	define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+#	define GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM 0x8E8D
+#endif
+//=============================================================================
+namespace
+{
+	constexpr size_t MinBlocksPerTask = 1024; // меньше нет смысла отдавать потоку
+
+	// веса интерполяции 4-битных индексов BC7, из 64
+	constexpr uint32_t BC7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	// пиксели блока по каналам: channels[c][y * 4 + x]
+	struct Block final
+	{
+		alignas(16) float channels[4][16];
+	};
+
+	struct BitWriter final
+	{
+		void Put(uint32_t value, uint32_t numBits)
+		{
+			for (uint32_t b = 0; b < numBits; b++, pos++)
+			{
+				if ((value >> b) & 1u)
+					data[pos >> 3] |= static_cast<uint8_t>(1u << (pos & 7u));
+			}
+		}
+
+		uint8_t  data[16]{};
+		uint32_t pos{ 0 };
+	};
+	//-------------------------------------------------------------------------
+	void loadBlock(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t components, uint32_t blockX, uint32_t blockY, Block& block)
+	{
+		for (uint32_t y = 0; y < 4; y++)
+		{
+			// за краем текстуры повторяется последний пиксель - он не выводится, но и не тянет палитру в сторону
+			const uint32_t py = std::min(blockY * 4 + y, height - 1);
+			for (uint32_t x = 0; x < 4; x++)
+			{
+				const uint32_t px = std::min(blockX * 4 + x, width - 1);
+				const uint8_t* p = pixels + (size_t(py) * width + px) * components;
+				for (uint32_t c = 0; c < 4; c++)
+					block.channels[c][y * 4 + x] = (c < components) ? p[c] : (c == 3 ? 255.0f : 0.0f);
+			}
+		}
+	}
+	//-------------------------------------------------------------------------
+	// Положение пикселей на отрезке e0-e1, округленное до шага 0..numSteps. Учитываются каналы [firstChannel, firstChannel + numChannels)
+	void projectSteps(const Block& block, uint32_t firstChannel, uint32_t numChannels, const float e0[4], const float e1[4], uint32_t numSteps, uint8_t steps[16])
+	{
+		float dir[4]{};
+		float length2 = 0.0f;
+		for (uint32_t c = firstChannel; c < firstChannel + numChannels; c++)
+		{
+			dir[c] = e1[c] - e0[c];
+			length2 += dir[c] * dir[c];
+		}
+		if (length2 < 1e-6f)
+		{
+			std::fill_n(steps, 16, uint8_t(0));
+			return;
+		}
+		const float scale = static_cast<float>(numSteps) / length2;
+
+#if NANO_BCN_SSE2
+		const __m128 maxStep = _mm_set1_ps(static_cast<float>(numSteps));
+		for (uint32_t i = 0; i < 16; i += 4)
+		{
+			__m128 dot = _mm_setzero_ps();
+			for (uint32_t c = firstChannel; c < firstChannel + numChannels; c++)
+			{
+				const __m128 d = _mm_sub_ps(_mm_load_ps(&block.channels[c][i]), _mm_set1_ps(e0[c]));
+				dot = _mm_add_ps(dot, _mm_mul_ps(d, _mm_set1_ps(dir[c])));
+			}
+			__m128 t = _mm_mul_ps(dot, _mm_set1_ps(scale));
+			t = _mm_min_ps(_mm_max_ps(t, _mm_setzero_ps()), maxStep);
+			alignas(16) int32_t result[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(result), _mm_cvttps_epi32(_mm_add_ps(t, _mm_set1_ps(0.5f))));
+			for (uint32_t k = 0; k < 4; k++)
+				steps[i + k] = static_cast<uint8_t>(result[k]);
+		}
+#else
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			float dot = 0.0f;
+			for (uint32_t c = firstChannel; c < firstChannel + numChannels; c++)
+				dot += (block.channels[c][i] - e0[c]) * dir[c];
+			const float t = std::clamp(dot * scale, 0.0f, static_cast<float>(numSteps));
+			steps[i] = static_cast<uint8_t>(t + 0.5f);
+		}
+#endif
+	}
+	//-------------------------------------------------------------------------
+	// Концы отрезка вдоль главной оси разброса пикселей (степенной метод по матрице ковариации)
+	void fitEndpoints(const Block& block, uint32_t firstChannel, uint32_t numChannels, float e0[4], float e1[4])
+	{
+		const uint32_t lastChannel = firstChannel + numChannels;
+		float mean[4]{}, minValue[4]{}, maxValue[4]{};
+		for (uint32_t c = firstChannel; c < lastChannel; c++)
+		{
+			minValue[c] = 255.0f;
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				mean[c] += block.channels[c][i];
+				minValue[c] = std::min(minValue[c], block.channels[c][i]);
+				maxValue[c] = std::max(maxValue[c], block.channels[c][i]);
+			}
+			mean[c] /= 16.0f;
+		}
+
+		float covariance[4][4]{};
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			for (uint32_t a = firstChannel; a < lastChannel; a++)
+			{
+				const float da = block.channels[a][i] - mean[a];
+				for (uint32_t b = a; b < lastChannel; b++)
+					covariance[a][b] += da * (block.channels[b][i] - mean[b]);
+			}
+		}
+		for (uint32_t a = firstChannel; a < lastChannel; a++)
+		{
+			for (uint32_t b = firstChannel; b < a; b++)
+				covariance[a][b] = covariance[b][a];
+		}
+
+		// начальное приближение - диагональ ограничивающего бокса
+		float axis[4]{};
+		for (uint32_t c = firstChannel; c < lastChannel; c++)
+			axis[c] = maxValue[c] - minValue[c];
+		for (int iteration = 0; iteration < 8; iteration++)
+		{
+			float next[4]{};
+			float maxComponent = 0.0f;
+			for (uint32_t a = firstChannel; a < lastChannel; a++)
+			{
+				for (uint32_t b = firstChannel; b < lastChannel; b++)
+					next[a] += covariance[a][b] * axis[b];
+				maxComponent = std::max(maxComponent, std::abs(next[a]));
+			}
+			if (maxComponent < 1e-6f) break;
+			for (uint32_t c = firstChannel; c < lastChannel; c++)
+				axis[c] = next[c] / maxComponent;
+		}
+
+		float length2 = 0.0f;
+		for (uint32_t c = firstChannel; c < lastChannel; c++)
+			length2 += axis[c] * axis[c];
+		if (length2 < 1e-6f)
+		{
+			for (uint32_t c = firstChannel; c < lastChannel; c++)
+				e0[c] = e1[c] = mean[c];
+			return;
+		}
+
+		float minT = std::numeric_limits<float>::max(), maxT = std::numeric_limits<float>::lowest();
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			float t = 0.0f;
+			for (uint32_t c = firstChannel; c < lastChannel; c++)
+				t += (block.channels[c][i] - mean[c]) * axis[c];
+			minT = std::min(minT, t);
+			maxT = std::max(maxT, t);
+		}
+		for (uint32_t c = firstChannel; c < lastChannel; c++)
+		{
+			e0[c] = std::clamp(mean[c] + axis[c] * minT / length2, 0.0f, 255.0f);
+			e1[c] = std::clamp(mean[c] + axis[c] * maxT / length2, 0.0f, 255.0f);
+		}
+	}
+	//-------------------------------------------------------------------------
+	// Концы, лучше всего (МНК) приближающие пиксели при заданных весах интерполяции 0..1
+	bool refineEndpoints(const Block& block, uint32_t firstChannel, uint32_t numChannels, const float weights[16], float e0[4], float e1[4])
+	{
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		float ax[4]{}, bx[4]{};
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			const float b = weights[i];
+			const float a = 1.0f - b;
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+			for (uint32_t c = firstChannel; c < firstChannel + numChannels; c++)
+			{
+				ax[c] += a * block.channels[c][i];
+				bx[c] += b * block.channels[c][i];
+			}
+		}
+		const float det = aa * bb - ab * ab;
+		if (std::abs(det) < 1e-6f)
+			return false;
+
+		const float invDet = 1.0f / det;
+		for (uint32_t c = firstChannel; c < firstChannel + numChannels; c++)
+		{
+			e0[c] = std::clamp((bb * ax[c] - ab * bx[c]) * invDet, 0.0f, 255.0f);
+			e1[c] = std::clamp((aa * bx[c] - ab * ax[c]) * invDet, 0.0f, 255.0f);
+		}
+		return true;
+	}
+	//-------------------------------------------------------------------------
+	uint16_t packRGB565(const float color[4])
+	{
+		const uint32_t r = static_cast<uint32_t>(color[0] * 31.0f / 255.0f + 0.5f);
+		const uint32_t g = static_cast<uint32_t>(color[1] * 63.0f / 255.0f + 0.5f);
+		const uint32_t b = static_cast<uint32_t>(color[2] * 31.0f / 255.0f + 0.5f);
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+	//-------------------------------------------------------------------------
+	void unpackRGB565(uint16_t value, float color[4])
+	{
+		const uint32_t r = (value >> 11) & 31u;
+		const uint32_t g = (value >> 5) & 63u;
+		const uint32_t b = value & 31u;
+		color[0] = static_cast<float>((r << 3) | (r >> 2));
+		color[1] = static_cast<float>((g << 2) | (g >> 4));
+		color[2] = static_cast<float>((b << 3) | (b >> 2));
+		color[3] = 255.0f;
+	}
+	//-------------------------------------------------------------------------
+	void encodeBC1(const Block& block, uint8_t* out)
+	{
+		struct Candidate final
+		{
+			uint16_t color0, color1;
+			uint8_t  indices[16];
+			float    error;
+		};
+
+		// порядок в палитре 4-цветного режима: c0, c1, (2c0+c1)/3, (c0+2c1)/3
+		constexpr uint8_t StepToIndex[4] = { 0, 2, 3, 1 };
+		constexpr float IndexToWeight[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+		const auto evaluate = [&](const float e0[4], const float e1[4], Candidate& candidate)
+			{
+				candidate.color0 = packRGB565(e0);
+				candidate.color1 = packRGB565(e1);
+				float palette[4][4];
+				unpackRGB565(candidate.color0, palette[0]);
+				unpackRGB565(candidate.color1, palette[1]);
+				for (uint32_t c = 0; c < 3; c++)
+				{
+					palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+					palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+				}
+
+				uint8_t steps[16];
+				projectSteps(block, 0, 3, palette[0], palette[1], 3, steps);
+				candidate.error = 0.0f;
+				for (uint32_t i = 0; i < 16; i++)
+				{
+					candidate.indices[i] = StepToIndex[steps[i]];
+					for (uint32_t c = 0; c < 3; c++)
+					{
+						const float d = block.channels[c][i] - palette[candidate.indices[i]][c];
+						candidate.error += d * d;
+					}
+				}
+			};
+
+		float e0[4], e1[4];
+		fitEndpoints(block, 0, 3, e0, e1);
+		Candidate best;
+		evaluate(e0, e1, best);
+
+		float weights[16];
+		for (uint32_t i = 0; i < 16; i++)
+			weights[i] = IndexToWeight[best.indices[i]];
+		if (refineEndpoints(block, 0, 3, weights, e0, e1))
+		{
+			Candidate refined;
+			evaluate(e0, e1, refined);
+			if (refined.error < best.error)
+				best = refined;
+		}
+
+		// 4-цветный режим только при color0 > color1
+		if (best.color0 < best.color1)
+		{
+			std::swap(best.color0, best.color1);
+			for (uint8_t& index : best.indices)
+				index ^= 1u; // 0<->1, 2<->3
+		}
+		else if (best.color0 == best.color1)
+			std::fill_n(best.indices, 16, uint8_t(0));
+
+		uint32_t indexBits = 0;
+		for (uint32_t i = 0; i < 16; i++)
+			indexBits |= uint32_t(best.indices[i]) << (i * 2);
+
+		out[0] = static_cast<uint8_t>(best.color0 & 0xFF);
+		out[1] = static_cast<uint8_t>(best.color0 >> 8);
+		out[2] = static_cast<uint8_t>(best.color1 & 0xFF);
+		out[3] = static_cast<uint8_t>(best.color1 >> 8);
+		for (uint32_t b = 0; b < 4; b++)
+			out[4 + b] = static_cast<uint8_t>(indexBits >> (b * 8));
+	}
+	//-------------------------------------------------------------------------
+	void encodeBC4(const Block& block, uint32_t channel, uint8_t* out)
+	{
+		float minValue = 255.0f, maxValue = 0.0f;
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			minValue = std::min(minValue, block.channels[channel][i]);
+			maxValue = std::max(maxValue, block.channels[channel][i]);
+		}
+		const uint8_t value0 = static_cast<uint8_t>(maxValue + 0.5f);
+		const uint8_t value1 = static_cast<uint8_t>(minValue + 0.5f);
+		out[0] = value0;
+		out[1] = value1;
+
+		uint64_t indexBits = 0;
+		// при value0 == value1 все индексы 0
+		if (value0 > value1)
+		{
+			// 8-значный режим: 0 - value0, 1 - value1, k = 2..7 - ((8 - k) * value0 + (k - 1) * value1) / 7
+			constexpr uint8_t StepToIndex[8] = { 1, 7, 6, 5, 4, 3, 2, 0 };
+			float e0[4]{}, e1[4]{};
+			e0[channel] = value1;
+			e1[channel] = value0;
+			uint8_t steps[16];
+			projectSteps(block, channel, 1, e0, e1, 7, steps);
+			for (uint32_t i = 0; i < 16; i++)
+				indexBits |= uint64_t(StepToIndex[steps[i]]) << (i * 3);
+		}
+		for (uint32_t b = 0; b < 6; b++)
+			out[2 + b] = static_cast<uint8_t>(indexBits >> (b * 8));
+	}
+	//-------------------------------------------------------------------------
+	// 7 бит на канал + общий для конца младший бит (p-bit)
+	void quantizeBC7Endpoint(const float endpoint[4], uint8_t quantized[4], uint8_t& pbit, float decoded[4])
+	{
+		float bestError = std::numeric_limits<float>::max();
+		for (uint8_t p = 0; p < 2; p++)
+		{
+			uint8_t q[4];
+			float d[4];
+			float error = 0.0f;
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				q[c] = static_cast<uint8_t>(std::clamp((endpoint[c] - p) * 0.5f + 0.5f, 0.0f, 127.0f));
+				d[c] = static_cast<float>((q[c] << 1) | p);
+				error += (d[c] - endpoint[c]) * (d[c] - endpoint[c]);
+			}
+			if (error < bestError)
+			{
+				bestError = error;
+				pbit = p;
+				std::copy_n(q, 4, quantized);
+				std::copy_n(d, 4, decoded);
+			}
+		}
+	}
+	//-------------------------------------------------------------------------
+	// BC7 режим 6: одна пара концов RGBA для всего блока, 16 уровней интерполяции
+	void encodeBC7(const Block& block, uint8_t* out)
+	{
+		struct Candidate final
+		{
+			uint8_t endpoints[2][4];
+			uint8_t pbits[2];
+			uint8_t indices[16];
+			float   error;
+		};
+
+		const auto evaluate = [&](const float e0[4], const float e1[4], Candidate& candidate)
+			{
+				float decoded[2][4];
+				quantizeBC7Endpoint(e0, candidate.endpoints[0], candidate.pbits[0], decoded[0]);
+				quantizeBC7Endpoint(e1, candidate.endpoints[1], candidate.pbits[1], decoded[1]);
+				projectSteps(block, 0, 4, decoded[0], decoded[1], 15, candidate.indices);
+
+				candidate.error = 0.0f;
+				for (uint32_t i = 0; i < 16; i++)
+				{
+					const uint32_t w = BC7Weights4[candidate.indices[i]];
+					for (uint32_t c = 0; c < 4; c++)
+					{
+						const uint32_t value = ((64 - w) * uint32_t(decoded[0][c]) + w * uint32_t(decoded[1][c]) + 32) >> 6;
+						const float d = block.channels[c][i] - static_cast<float>(value);
+						candidate.error += d * d;
+					}
+				}
+			};
+
+		float e0[4], e1[4];
+		fitEndpoints(block, 0, 4, e0, e1);
+		Candidate best;
+		evaluate(e0, e1, best);
+
+		float weights[16];
+		for (uint32_t i = 0; i < 16; i++)
+			weights[i] = static_cast<float>(BC7Weights4[best.indices[i]]) / 64.0f;
+		if (refineEndpoints(block, 0, 4, weights, e0, e1))
+		{
+			Candidate refined;
+			evaluate(e0, e1, refined);
+			if (refined.error < best.error)
+				best = refined;
+		}
+
+		// у первого пикселя (anchor) старший бит индекса не хранится и должен быть 0
+		if (best.indices[0] & 8u)
+		{
+			std::swap(best.endpoints[0], best.endpoints[1]);
+			std::swap(best.pbits[0], best.pbits[1]);
+			for (uint8_t& index : best.indices)
+				index = static_cast<uint8_t>(15 - index);
+		}
+
+		BitWriter writer;
+		writer.Put(1u << 6, 7); // режим 6
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			writer.Put(best.endpoints[0][c], 7);
+			writer.Put(best.endpoints[1][c], 7);
+		}
+		writer.Put(best.pbits[0], 1);
+		writer.Put(best.pbits[1], 1);
+		writer.Put(best.indices[0], 3);
+		for (uint32_t i = 1; i < 16; i++)
+			writer.Put(best.indices[i], 4);
+		assert(writer.pos == 128);
+		std::copy_n(writer.data, 16, out);
+	}
+	//-------------------------------------------------------------------------
+	void encodeBlock(BlockFormat format, const Block& block, uint8_t* out)
+	{
+		switch (format)
+		{
+		case BlockFormat::BC1: encodeBC1(block, out); break;
+		case BlockFormat::BC3: encodeBC4(block, 3, out); encodeBC1(block, out + 8); break;
+		case BlockFormat::BC4: encodeBC4(block, 0, out); break;
+		case BlockFormat::BC5: encodeBC4(block, 0, out); encodeBC4(block, 1, out + 8); break;
+		case BlockFormat::BC7: encodeBC7(block, out); break;
+		default: std::unreachable();
+		}
+	}
+} // namespace
+//=============================================================================
+uint32_t bcn::GetBlockBytes(BlockFormat format) noexcept
+{
+	switch (format)
+	{
+	case BlockFormat::BC1:
+	case BlockFormat::BC4: return 8;
+	case BlockFormat::BC3:
+	case BlockFormat::BC5:
+	case BlockFormat::BC7: return 16;
+	default: std::unreachable();
+	}
+}
+//=============================================================================
+size_t bcn::GetCompressedSize(BlockFormat format, uint32_t width, uint32_t height) noexcept
+{
+	const size_t blocksX = (width + BlockDimension - 1) / BlockDimension;
+	const size_t blocksY = (height + BlockDimension - 1) / BlockDimension;
+	return blocksX * blocksY * GetBlockBytes(format);
+}
+//=============================================================================
+uint32_t bcn::GetComponents(BlockFormat format) noexcept
+{
+	switch (format)
+	{
+	case BlockFormat::BC4: return 1;
+	case BlockFormat::BC5: return 2;
+	case BlockFormat::BC1: return 3;
+	case BlockFormat::BC3:
+	case BlockFormat::BC7: return 4;
+	default: std::unreachable();
+	}
+}
+//=============================================================================
+std::string_view bcn::GetFormatName(BlockFormat format) noexcept
+{
+	switch (format)
+	{
+	case BlockFormat::None: return "none";
+	case BlockFormat::BC1:  return "BC1";
+	case BlockFormat::BC3:  return "BC3";
+	case BlockFormat::BC4:  return "BC4";
+	case BlockFormat::BC5:  return "BC5";
+	case BlockFormat::BC7:  return "BC7";
+	default: std::unreachable();
+	}
+}
+//=============================================================================
+BlockFormat bcn::ChooseFormat(uint32_t components, ColorSpace colorSpace, bool normalMap, bool hasAlpha) noexcept
+{
+	if (components == 1)
+		return BlockFormat::BC4;
+	if (components == 2 || normalMap)
+		return BlockFormat::BC5;
+	// на цвете артефакты BC1 заметны, а маски и прочие линейные данные их прощают
+	if (colorSpace == ColorSpace::sRGB)
+		return BlockFormat::BC7;
+	return hasAlpha ? BlockFormat::BC3 : BlockFormat::BC1;
+}
+//=============================================================================
+std::vector<uint8_t> bcn::Compress(BlockFormat format, const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t components)
+{
+	assert(format != BlockFormat::None);
+	assert(pixels && width > 0 && height > 0);
+	assert(components >= 1 && components <= 4);
+
+	const uint32_t blocksX = (width + BlockDimension - 1) / BlockDimension;
+	const uint32_t blocksY = (height + BlockDimension - 1) / BlockDimension;
+	const uint32_t blockBytes = GetBlockBytes(format);
+	std::vector<uint8_t> result(size_t(blocksX) * blocksY * blockBytes);
+
+	const uint32_t rowsPerTask = std::max(1u, static_cast<uint32_t>(MinBlocksPerTask / blocksX));
+	const size_t numTasks = (blocksY + rowsPerTask - 1) / rowsPerTask;
+	ParallelFor(numTasks, [&](size_t task)
+		{
+			const uint32_t firstRow = static_cast<uint32_t>(task) * rowsPerTask;
+			const uint32_t lastRow = std::min(firstRow + rowsPerTask, blocksY);
+			Block block;
+			for (uint32_t by = firstRow; by < lastRow; by++)
+			{
+				for (uint32_t bx = 0; bx < blocksX; bx++)
+				{
+					loadBlock(pixels, width, height, components, bx, by, block);
+					encodeBlock(format, block, &result[(size_t(by) * blocksX + bx) * blockBytes]);
+				}
+			}
+		});
+	return result;
+}
+//=============================================================================
+GLenum bcn::GetInternalFormatGL(BlockFormat format, ColorSpace colorSpace) noexcept
+{
+	const bool sRGB = colorSpace == ColorSpace::sRGB;
+	switch (format)
+	{
+	case BlockFormat::BC1: return sRGB ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	case BlockFormat::BC3: return sRGB ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case BlockFormat::BC4: return GL_COMPRESSED_RED_RGTC1;
+	case BlockFormat::BC5: return GL_COMPRESSED_RG_RGTC2;
+	case BlockFormat::BC7: return sRGB ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+	default: std::unreachable();
+	}
+}
+//=============================================================================
+bool bcn::IsSupported(BlockFormat format)
+{
+	switch (format)
+	{
+	case BlockFormat::None:
+	case BlockFormat::BC4:
+	case BlockFormat::BC5: return true; // RGTC в ядре OpenGL 3.0
+	case BlockFormat::BC1:
+	case BlockFormat::BC3: return IsExtensionSupported("GL_EXT_texture_compression_s3tc");
+	case BlockFormat::BC7: return IsExtensionSupported("GL_ARB_texture_compression_bptc");
+	default: std::unreachable();
+	}
+}
+//=============================================================================
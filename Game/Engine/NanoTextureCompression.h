@@ -0,0 +1,35 @@
+﻿#pragma once
+
+#include "NanoOpenGL3.h"
+
+// Блочное сжатие текстур (S3TC/RGTC/BPTC). Блок 4x4 пикселя, размеры текстуры не обязаны быть кратны 4
+enum class BlockFormat : uint8_t
+{
+	None, // без сжатия
+	BC1,  // RGB, 8 байт на блок
+	BC3,  // RGBA: альфа как BC4 + цвет как BC1, 16 байт
+	BC4,  // R, 8 байт
+	BC5,  // RG - две BC4, 16 байт. Карты нормалей: z восстанавливается в шейдере
+	BC7   // RGBA, 16 байт. Кодируется только режимом 6 (одна пара концов, 4-битные индексы)
+};
+
+namespace bcn
+{
+	constexpr uint32_t BlockDimension = 4;
+
+	uint32_t GetBlockBytes(BlockFormat format) noexcept;
+	size_t GetCompressedSize(BlockFormat format, uint32_t width, uint32_t height) noexcept;
+	// сколько каналов отдает выборка из текстуры: BC4 - 1, BC5 - 2, BC1 - 3, BC3/BC7 - 4
+	uint32_t GetComponents(BlockFormat format) noexcept;
+	std::string_view GetFormatName(BlockFormat format) noexcept;
+
+	// нормали - BC5, цвет (sRGB) - BC7, линейные данные (маски, roughness...) - BC1 или BC3 при наличии альфы
+	BlockFormat ChooseFormat(uint32_t components, ColorSpace colorSpace, bool normalMap, bool hasAlpha) noexcept;
+
+	// pixels - components каналов (1-4) на пиксель, плотно упакованы. Строки блоков кодируются на всех ядрах
+	std::vector<uint8_t> Compress(BlockFormat format, const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t components);
+
+	// требуют контекст OpenGL
+	GLenum GetInternalFormatGL(BlockFormat format, ColorSpace colorSpace) noexcept;
+	bool IsSupported(BlockFormat format);
+} // namespace bcn
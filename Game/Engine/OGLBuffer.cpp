@@ -67,4 +67,28 @@ void BufferSubData(BufferHandle bufferId, BufferTarget target, GLintptr offset,
 	glBufferSubData(glTarget, offset, size, data);
 	glBindBuffer(glTarget, currentBuffer);
 }
+//=============================================================================
+void* MapBuffer(BufferHandle bufferId, BufferTarget target, GLintptr offset, GLsizeiptr size, GLbitfield access)
+{
+	GLuint currentBuffer = GetCurrentBuffer(target);
+	GLenum glTarget = EnumToValue(target);
+
+	glBindBuffer(glTarget, bufferId.handle);
+	void* data = glMapBufferRange(glTarget, offset, size, access);
+	glBindBuffer(glTarget, currentBuffer);
+
+	return data;
+}
+//=============================================================================
+bool UnmapBuffer(BufferHandle bufferId, BufferTarget target)
+{
+	GLuint currentBuffer = GetCurrentBuffer(target);
+	GLenum glTarget = EnumToValue(target);
+
+	glBindBuffer(glTarget, bufferId.handle);
+	GLboolean result = glUnmapBuffer(glTarget);
+	glBindBuffer(glTarget, currentBuffer);
+
+	return result == GL_TRUE;
+}
 //=============================================================================
\ No newline at end of file
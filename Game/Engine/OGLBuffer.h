@@ -33,4 +33,9 @@ struct BufferHandle final { GLuint handle{ 0u }; };
 
 BufferHandle CreateBuffer(BufferTarget target, BufferUsage usage, size_t size, const void* data);
 
-void BufferSubData(BufferHandle bufferId, BufferTarget target, GLintptr offset, GLsizeiptr size, const void* data);
\ No newline at end of file
+void BufferSubData(BufferHandle bufferId, BufferTarget target, GLintptr offset, GLsizeiptr size, const void* data);
+
+// access - флаги glMapBufferRange (GL_MAP_WRITE_BIT и т.д.). Буфер остается отображенным после восстановления привязки
+void* MapBuffer(BufferHandle bufferId, BufferTarget target, GLintptr offset, GLsizeiptr size, GLbitfield access);
+// false - содержимое буфера было повреждено пока он был отображен и его нужно залить заново
+bool UnmapBuffer(BufferHandle bufferId, BufferTarget target);
\ No newline at end of file
@@ -12,6 +12,17 @@ extern "C"
 #endif
 //=============================================================================
 extern std::unordered_map<SamplerStateInfo, SamplerHandle> SamplerCache;
+//=============================================================================
+namespace
+{
+	// точки входа GL 4.0+, которых нет в glad
+	using DrawElementsIndirectFunc = void(GLAD_API_PTR*)(GLenum mode, GLenum type, const void* indirect);
+	using DrawArraysIndirectFunc = void(GLAD_API_PTR*)(GLenum mode, const void* indirect);
+
+	DrawElementsIndirectFunc drawElementsIndirect = nullptr;
+	DrawArraysIndirectFunc   drawArraysIndirect = nullptr;
+	bool                     queryBufferSupported = false;
+}
 //#if defined(_DEBUG)
 namespace
 {
@@ -92,6 +103,13 @@ bool OGLContextInit()
 	Print("Renderer: " + std::string(renderer));
 	Print("OpenGL version supported " + std::string(version));
 
+	if (openGLVersion >= GLAD_MAKE_VERSION(4, 0) || IsExtensionSupported("GL_ARB_draw_indirect"))
+	{
+		drawElementsIndirect = reinterpret_cast<DrawElementsIndirectFunc>(RGFW_getProcAddress_OpenGL("glDrawElementsIndirect"));
+		drawArraysIndirect = reinterpret_cast<DrawArraysIndirectFunc>(RGFW_getProcAddress_OpenGL("glDrawArraysIndirect"));
+	}
+	queryBufferSupported = openGLVersion >= GLAD_MAKE_VERSION(4, 4) || IsExtensionSupported("GL_ARB_query_buffer_object");
+
 	// enable debug context
 	int flags;
 	glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
@@ -220,6 +238,28 @@ void OGLContext::DrawArraysInstanced(PrimitiveMode primitiveMode, uint32_t verte
 	glDrawArraysInstanced(EnumToValue(primitiveMode), 0, vertexCount, instances);
 }
 //=============================================================================
+bool OGLContext::IsDrawIndirectSupported()
+{
+	return drawElementsIndirect && drawArraysIndirect;
+}
+//=============================================================================
+bool OGLContext::IsQueryBufferSupported()
+{
+	return queryBufferSupported;
+}
+//=============================================================================
+void OGLContext::DrawElementsIndirect(GLenum mode, size_t commandOffset)
+{
+	assert(drawElementsIndirect);
+	drawElementsIndirect(mode, GL_UNSIGNED_INT, reinterpret_cast<const void*>(commandOffset));
+}
+//=============================================================================
+void OGLContext::DrawArraysIndirect(GLenum mode, size_t commandOffset)
+{
+	assert(drawArraysIndirect);
+	drawArraysIndirect(mode, reinterpret_cast<const void*>(commandOffset));
+}
+//=============================================================================
 //void OGLContext::DispatchCompute(uint32_t x, uint32_t y, uint32_t z)
 //{
 //	glDispatchCompute(x, y, z);
@@ -30,6 +30,14 @@ namespace OGLContext
 	void DrawArrays(PrimitiveMode primitiveMode, uint32_t vertexCount);
 	void DrawArraysInstanced(PrimitiveMode primitiveMode, uint32_t vertexCount, uint32_t instances);
 
+	// GL 4.0 (ARB_draw_indirect). glad собран под 3.3, точки входа грузятся при создании контекста, если их дает драйвер
+	bool IsDrawIndirectSupported();
+	// GL 4.4 (ARB_query_buffer_object): результат запроса пишется в буфер на GPU, CPU его не ждет
+	bool IsQueryBufferSupported();
+	// команда читается из буфера, привязанного к GL_DRAW_INDIRECT_BUFFER, по смещению commandOffset. Индексы uint32
+	void DrawElementsIndirect(GLenum mode, size_t commandOffset);
+	void DrawArraysIndirect(GLenum mode, size_t commandOffset);
+
 	//void DispatchCompute(uint32_t x, uint32_t y, uint32_t z);
 	//void MemoryBarrier(MemoryBarrierFlags barriers);
 
@@ -174,7 +174,7 @@ ProgramHandle CreateShaderProgram(std::string_view vertexShader, std::string_vie
 	return CreateShaderProgram(vertexShader, "", fragmentShader);
 }
 //=============================================================================
-ProgramHandle CreateShaderProgram(std::string_view vertexShader, std::string_view geometryShader, std::string_view fragmentShader)
+[[nodiscard]] inline ProgramHandle createProgram(std::string_view vertexShader, std::string_view geometryShader, std::string_view fragmentShader, std::span<const char* const> feedbackVaryings)
 {
 	struct LocalShader final
 	{
@@ -212,6 +212,9 @@ ProgramHandle CreateShaderProgram(std::string_view vertexShader, std::string_vie
 	if (vs.id) glAttachShader(program.handle, vs.id);
 	if (gs.id) glAttachShader(program.handle, gs.id);
 	if (fs.id) glAttachShader(program.handle, fs.id);
+	// выходы transform feedback задаются до линковки
+	if (!feedbackVaryings.empty())
+		glTransformFeedbackVaryings(program.handle, static_cast<GLsizei>(feedbackVaryings.size()), feedbackVaryings.data(), GL_INTERLEAVED_ATTRIBS);
 	glLinkProgram(program.handle);
 
 	GLint success{ 0 };
@@ -235,6 +238,17 @@ ProgramHandle CreateShaderProgram(std::string_view vertexShader, std::string_vie
 	return program;
 }
 //=============================================================================
+ProgramHandle CreateShaderProgram(std::string_view vertexShader, std::string_view geometryShader, std::string_view fragmentShader)
+{
+	return createProgram(vertexShader, geometryShader, fragmentShader, {});
+}
+//=============================================================================
+ProgramHandle CreateTransformFeedbackProgram(std::string_view vertexShader, std::string_view geometryShader, std::span<const char* const> varyings)
+{
+	assert(!varyings.empty());
+	return createProgram(vertexShader, geometryShader, "", varyings);
+}
+//=============================================================================
 ProgramHandle LoadShaderProgram(const std::string& vsFile, const std::vector<std::string>& defines)
 {
 	return CreateShaderProgram(LoadShaderCode(vsFile, defines));
@@ -250,6 +264,11 @@ ProgramHandle LoadShaderProgram(const std::string& vsFile, const std::string& gs
 	return CreateShaderProgram(LoadShaderCode(vsFile, defines), LoadShaderCode(gsFile, defines), LoadShaderCode(fsFile, defines));
 }
 //=============================================================================
+ProgramHandle LoadTransformFeedbackProgram(const std::string& vsFile, const std::string& gsFile, std::span<const char* const> varyings, const std::vector<std::string>& defines)
+{
+	return CreateTransformFeedbackProgram(LoadShaderCode(vsFile, defines), gsFile.empty() ? std::string() : LoadShaderCode(gsFile, defines), varyings);
+}
+//=============================================================================
 int GetUniformLocation(ProgramHandle program, std::string_view name)
 {
 	return glGetUniformLocation(program.handle, name.data());
@@ -295,6 +314,16 @@ void SetUniform(int id, unsigned s)
 	glUniform1ui(id, s);
 }
 //=============================================================================
+void SetUniform(int id, const glm::ivec3& v)
+{
+	if (id < 0)
+	{
+		Error("Uniform error");
+		return;
+	}
+	glUniform3iv(id, 1, glm::value_ptr(v));
+}
+//=============================================================================
 void SetUniform(int id, const glm::vec2& v)
 {
 	if (id < 0)
@@ -18,6 +18,10 @@ ProgramHandle LoadShaderProgram(const std::string& vsFile, const std::vector<std
 ProgramHandle LoadShaderProgram(const std::string& vsFile, const std::string& fsFile, const std::vector<std::string>& defines = {});
 ProgramHandle LoadShaderProgram(const std::string& vsFile, const std::string& gsFile, const std::string& fsFile, const std::vector<std::string>& defines = {});
 
+// без фрагментного шейдера: выходы varyings последней стадии (vs или gs, если он задан) пишутся подряд в один буфер transform feedback
+ProgramHandle CreateTransformFeedbackProgram(std::string_view vertexShader, std::string_view geometryShader, std::span<const char* const> varyings);
+ProgramHandle LoadTransformFeedbackProgram(const std::string& vsFile, const std::string& gsFile, std::span<const char* const> varyings, const std::vector<std::string>& defines = {});
+
 //=============================================================================
 // Shader Uniforms
 //=============================================================================
@@ -31,6 +35,7 @@ void SetUniform(int id, const glm::vec2& v);
 void SetUniform(int id, std::span<const glm::vec2> v);
 void SetUniform(int id, const glm::vec3& v);
 void SetUniform(int id, std::span<const glm::vec3> v);
+void SetUniform(int id, const glm::ivec3& v);
 void SetUniform(int id, const glm::vec4& v);
 void SetUniform(int id, std::span<const glm::vec4> v);
 void SetUniform(int id, const glm::quat& v);
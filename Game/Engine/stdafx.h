@@ -32,13 +32,24 @@
 #include <chrono>
 #include <random>
 #include <optional>
+#include <memory>
+#include <functional>
+#include <charconv>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 #include <regex>
 #include <string>
 #include <string_view>
 #include <span>
+#include <bit>
+#include <numbers>
+#include <numeric>
 #include <set>
 #include <array>
 #include <stack>
+#include <deque>
 #include <vector>
 #include <map>
 #include <unordered_map>
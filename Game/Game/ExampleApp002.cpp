@@ -34,15 +34,15 @@ void ExampleApp002()
 		camera.SetPosition(glm::vec3(0.0f, 0.5f, 4.5f));
 		//scene.SetGridAxis(22);
 
-		modelPlane.model.Create(GeometryGenerator::CreatePlane(100, 100, 100, 100));
-		modelBox.model.Create(GeometryGenerator::CreateBox());
-		modelSphere.model.Create(GeometryGenerator::CreateSphere());
-		modelTest.model.Load("data/models/tree.glb", ModelMaterialType::BlinnPhong);
+		modelPlane.model = models::CreatePlane(100, 100, 100, 100);
+		modelBox.model = models::CreateBox();
+		modelSphere.model = models::CreateSphere();
+		modelTest.model = models::Load("data/models/tree.glb", ModelMaterialType::BlinnPhong);
 		//modelTest.model.Load("data/models/ForgottenPlains/Forgotten_Plains_Demo.obj");
 
 		gRegion.Init();
 		
-		modelTest2.model.Load("data/models/cottage/cottage_obj.obj", ModelMaterialType::BlinnPhong);
+		modelTest2.model = models::Load("data/models/cottage/cottage_obj.obj", ModelMaterialType::BlinnPhong);
 		// TRS matrix
 		modelTest2.modelMat = glm::translate(glm::mat4(1.0f), glm::vec3(-5.0f, 0.0f, -3.0f));
 		// rotate mat
@@ -53,24 +53,27 @@ void GameApp()
 	{
 		if (!engine::Init(1600, 900, "Game"))
 			return;
+		// подробные мипы грузит RenderPass2 по экранному размеру мешей
+		textures::EnableStreaming(true);
 
 		scene.Init();
 
 		camera.SetPosition(glm::vec3(0.0f, 0.5f, 4.5f));
 
-		modelTest.model.Load("data/models/ForgottenPlains/Forgotten_Plains_Demo.obj", ModelMaterialType::BlinnPhong);
+		modelTest.model = models::Load("data/models/ForgottenPlains/Forgotten_Plains_Demo.obj", ModelMaterialType::BlinnPhong);
 		modelTest.modelMat = glm::translate(glm::mat4(1.0f), glm::vec3(-30.0f, 0.0f, 15.0f));
+		modelTest.isStatic = true;
 
-		sphereEntity.model.Create(GeometryGenerator::CreateSphere(0.5f, 16, 16));
+		sphereEntity.model = models::CreateSphere(0.5f, 16, 16);
 		sphereEntity.modelMat = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 2.0f, 0.0f));
 
-		box1Entity.model.Create(GeometryGenerator::CreateBox());
+		box1Entity.model = models::CreateBox();
 		box1Entity.modelMat = glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 0.0f));
-		box2Entity.model.Create(GeometryGenerator::CreateBox());
+		box2Entity.model = models::CreateBox();
 		box2Entity.modelMat = glm::translate(glm::mat4(1.0f), glm::vec3(-1.0f, 2.0f, 0.0f));
-		box3Entity.model.Create(GeometryGenerator::CreateBox());
+		box3Entity.model = models::CreateBox();
 		box3Entity.modelMat = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 2.0f, -1.0f));
-		box4Entity.model.Create(GeometryGenerator::CreateBox());
+		box4Entity.model = models::CreateBox();
 		box4Entity.modelMat = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
 
 		dirLight.direction = glm::vec3(-0.2f, -0.6f, -0.2f);
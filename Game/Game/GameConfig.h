@@ -2,13 +2,30 @@
 
 inline float ScaleScreen = 1.0f;
 
-inline bool EnableSSAO = false;
+inline bool EnableSSAO = false; // F4, качество - F5 (GameSceneO::SetSSAOQuality)
+
+// программный буфер глубины из крупных мешей (isOccluder) отсекает перекрытые объекты основного прохода
+inline bool EnableOcclusionCulling = true;
+inline bool ShowOcclusionBuffer = false; // F2
+
+// каскадные тени направленного света: пирамида камеры до ShadowDistance делится на каскады (2-4).
+// Границы - смесь логарифмического и равномерного деления (lambda 1 - чисто логарифмическое)
+inline size_t NumShadowCascades = 4;
+inline float ShadowDistance = 100.0f;
+inline float ShadowCascadeSplitLambda = 0.75f;
+inline float ShadowCascadeFade = 0.1f; // доля каскада у его дальней границы, где он смешивается со следующим
+// статика в тенях кэшируется и перерисовывается только при сдвиге каскада или изменении статических объектов
+inline bool EnableShadowCache = true;
+inline size_t ShadowCascadeUpdateBudget = 2; // дальних каскадов с перерисовкой статики за кадр, ближний - каждый кадр. Вышедшие за запас - вне бюджета
 
 constexpr size_t MaxLights = 16u;
 
 constexpr size_t MaxDirectionalLight = 4u;
 constexpr size_t MaxSpotLight = 4u;
 constexpr size_t MaxPointLight = 16u;
+// GameSceneO: точечные и прожекторы распределяются по кластерам (LightClusters), в шейдер идут буфером текстур
+constexpr size_t MaxClusteredSpotLight = 1024u;
+constexpr size_t MaxClusteredPointLight = 4096u;
 constexpr size_t MaxAmbientBoxLight = 4u;
 constexpr size_t MaxAmbientSphereLight = 4u;
 
@@ -124,6 +124,14 @@ void GameScene::beginDraw()
 
 	m_oldrpMainScene.Resize(wndWidth, wndHeight);
 	m_rpComposite.Resize(wndWidth * ScaleScreen, wndHeight * ScaleScreen);
+
+	for (size_t i = 0; i < m_data.numOldGameObject; i++)
+	{
+		const OldGameObject* go = m_data.oldGameObjects[i];
+		if (go && go->visible && go->model)
+			m_data.objectTree.Update(go, static_cast<uint32_t>(i), go->GetAABB().GetTransformed(go->modelMat), go->isStatic);
+	}
+	m_data.objectTree.EndUpdate();
 }
 //=============================================================================
 void GameScene::draw()
@@ -9,11 +9,12 @@
 
 struct OldGameObject final
 {
-	const AABB& GetAABB() const noexcept { return model.GetAABB(); }
+	const AABB& GetAABB() const noexcept { return model->GetAABB(); }
 
-	Model     model;
+	ModelRef  model;
 	glm::mat4 modelMat{ glm::mat4(1.0f) };
 	bool      visible{ true };
+	bool      isStatic{ false }; // не двигается - попадает в статическое дерево культинга
 };
 
 class GameScene final
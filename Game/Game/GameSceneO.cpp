@@ -19,10 +19,14 @@ bool GameSceneO::Init()
 		return false;
 	if (!m_rpSSAOBlur.Init(wndWidth, wndHeight))
 		return false;
+	if (!m_ssaoTimer.Init(GetSSAOPreset(m_rpSSAO.GetQuality()).name))
+		return false;
 	if (!m_rpBlinnPhong.Init(wndWidth, wndHeight))
 		return false;
 	if (!m_rpMainScene.Init(wndWidth, wndHeight))
 		return false;
+	if (!m_rpDeferredLighting.Init())
+		return false;
 	if (!m_rpComposite.Init(wndWidth, wndHeight))
 		return false;
 		
@@ -31,15 +35,26 @@ bool GameSceneO::Init()
 //=============================================================================
 void GameSceneO::Close()
 {
+	m_renderGraph.Close();
+	m_rpDeferredLighting.Close();
 	m_rpMainScene.Close();
 	m_rpBlinnPhong.Close();
 	m_rpComposite.Close();
+	m_ssaoTimer.Close();
 	m_rpSSAOBlur.Close();
 	m_rpSSAO.Close();
 	m_rpGeometry.Close();
 	m_rpDirShadowMap.Close();
 }
 //=============================================================================
+void GameSceneO::SetSSAOQuality(SSAOQuality quality)
+{
+	m_rpSSAO.SetQuality(quality);
+	// прошлые замеры относятся к другому качеству
+	m_ssaoTimer.SetName(GetSSAOPreset(quality).name);
+	m_ssaoTimer.Reset();
+}
+//=============================================================================
 void GameSceneO::BindCamera(Camera* camera)
 {
 	m_data.camera = camera;
@@ -68,7 +83,7 @@ void GameSceneO::BindLight(DirectionalLight* ent)
 //=============================================================================
 void GameSceneO::BindLight(SpotLight* ent)
 {
-	if (m_data.numSpotLights >= MaxSpotLight)
+	if (m_data.numSpotLights >= MaxClusteredSpotLight)
 	{
 		Error("Max Spot light");
 		return;
@@ -79,7 +94,7 @@ void GameSceneO::BindLight(SpotLight* ent)
 //=============================================================================
 void GameSceneO::BindLight(PointLight* ent)
 {
-	if (m_data.numPointLights >= MaxPointLight)
+	if (m_data.numPointLights >= MaxClusteredPointLight)
 	{
 		Error("Max point light");
 		return;
@@ -117,48 +132,207 @@ void GameSceneO::beginDraw()
 	m_rpBlinnPhong.Resize(wndWidth, wndHeight);
 	m_rpMainScene.Resize(wndWidth, wndHeight);
 	m_rpComposite.Resize(wndWidth, wndHeight);
+
+	for (size_t i = 0; i < m_data.numGameObject; i++)
+	{
+		const GameObjectO* go = m_data.gameObjects[i];
+		if (go && go->visible && go->model)
+			m_data.objectTree.Update(go, static_cast<uint32_t>(i), go->GetAABB().GetTransformed(go->modelMat), go->isStatic);
+	}
+	m_data.objectTree.EndUpdate();
 }
 //=============================================================================
 void GameSceneO::draw()
 {
+	// порядок задается объявлениями проходов, ненужные отсекает граф: например, SSAO и G-буфер прямого пути,
+	// когда затенение никто не читает
 	//================================================================================
 	// 1.) Render Pass: render depth of scene to texture (from light's perspective)
-	m_rpDirShadowMap.Draw(m_data);
+	RGResource shadowAtlas;
+	m_renderGraph.AddPass("DirShadowMap", [&](RGPassBuilder& builder) -> RenderGraph::ExecuteFunc
+		{
+			shadowAtlas = builder.Write(m_renderGraph.Import("DirShadowAtlas"));
+			return [this](const RenderGraph&) { m_rpDirShadowMap.Draw(m_data, m_rpMainScene.GetProjection()); };
+		});
 	//m_rpSpotShadowMap.Draw(m_data);
 	//m_rpPointShadowMap.Draw(m_data);
 	//m_rpAreaShadowMap.Draw(m_data);
 
 	//================================================================================
-	// 2.) Render Pass: render Scene as normal using the generated depth / shadow map
-	m_rpMainScene.Draw(m_rpDirShadowMap, m_data);
+	// 2.) - 4.) Render Pass: scene, SSAO, post frame
+	const RGResource frame = m_renderPath == RenderPath::Deferred ? addDeferredPasses(shadowAtlas) : addForwardPasses(shadowAtlas);
 
 	//================================================================================
-	// 3.) Render Pass: SSAO
-	if (EnableSSAO)
+	// 5 Render Pass: blitting main fbo
+	m_renderGraph.AddPass("Blit", [&](RGPassBuilder& builder) -> RenderGraph::ExecuteFunc
+		{
+			builder.Read(frame);
+			builder.SideEffect();
+			return [this](const RenderGraph&) { blittingToScreen(m_rpComposite.GetFBOId(), m_rpComposite.GetWidth(), m_rpComposite.GetHeight()); };
+		});
+
+	m_rpMainScene.UpdateLights(m_data);
+	m_renderGraph.Execute();
+	// SSAO начался, но последний его проход пропущен графом - запрос закрывается, неполный замер не показывается
+	if (m_ssaoTimer.IsRunning())
 	{
-		//================================================================================
-		// 3.1 Render Pass: geometry
-		m_rpGeometry.Draw(m_data.gameObjects, m_data.numGameObject, m_data.camera);
-
-		//================================================================================
-		// 3.2 Render Pass: SSAO
-		//		Set state: glDisable(GL_DEPTH_TEST);
-		m_rpSSAO.Draw(&m_rpGeometry.GetFBO());
-
-		//================================================================================
-		// 3.3 Render Pass: SSAO Blur
-		m_rpSSAOBlur.Draw(&m_rpSSAO.GetFBO());
+		m_ssaoTimer.End();
+		m_ssaoTimer.Reset();
 	}
+	if (!m_renderGraph.WasExecuted(m_ssaoPass))
+		m_ssaoTimer.Reset();
+}
+//=============================================================================
+RGResource GameSceneO::addForwardPasses(RGResource shadowAtlas)
+{
+	//================================================================================
+	// 2.) Render Pass: render Scene as normal using the generated depth / shadow map
+	RGResource scene;
+	m_renderGraph.AddPass("MainScene", [&](RGPassBuilder& builder) -> RenderGraph::ExecuteFunc
+		{
+			builder.Read(shadowAtlas);
+			scene = builder.Write(m_renderGraph.Import("SceneColor"));
+			return [this](const RenderGraph&) { m_rpMainScene.Draw(m_rpDirShadowMap, m_data); };
+		});
+
+	//================================================================================
+	// 3.) Render Pass: SSAO - its own geometry pass, the G-buffer is not needed otherwise
+	const RGResource ao = addSSAOPasses(addGeometryPass());
 
 	//================================================================================
 	// 4 Render Pass: post frame
-	//		Set state: glDisable(GL_DEPTH_TEST);
-	//m_rpComposite.Draw(&m_rpBlinnPhong.GetFBO(), EnableSSAO ? &m_rpSSAOBlur.GetFBO() : nullptr);
-	m_rpComposite.Draw(&m_rpMainScene.GetFBO(), EnableSSAO ? &m_rpSSAOBlur.GetFBO() : nullptr);
+	const bool useSSAO = EnableSSAO;
+	RGResource frame;
+	m_renderGraph.AddPass("Composite", [&](RGPassBuilder& builder) -> RenderGraph::ExecuteFunc
+		{
+			builder.Read(scene);
+			if (useSSAO)
+				builder.Read(ao);
+			frame = builder.Write(m_renderGraph.Import("Composite"));
+			return [this, ao, useSSAO](const RenderGraph& graph)
+				{
+					//m_rpComposite.Draw(&m_rpBlinnPhong.GetFBO(), useSSAO ? &graph.GetFramebuffer(ao) : nullptr);
+					m_rpComposite.Draw(&m_rpMainScene.GetFBO(), useSSAO ? &graph.GetFramebuffer(ao) : nullptr);
+				};
+		});
+	return frame;
+}
+//=============================================================================
+RGResource GameSceneO::addDeferredPasses(RGResource shadowAtlas)
+{
+	//================================================================================
+	// 2.) Render Pass: G-buffer
+	const RGResource gbuffer = addGeometryPass();
 
 	//================================================================================
-	// 5 Render Pass: blitting main fbo
-	blittingToScreen(m_rpComposite.GetFBOId(), m_rpComposite.GetWidth(), m_rpComposite.GetHeight());
+	// 3.) Render Pass: SSAO - before lighting, it is applied to the ambient term only
+	const RGResource ao = addSSAOPasses(gbuffer);
+
+	//================================================================================
+	// 4.1 Render Pass: lighting from the G-buffer into the main scene fbo, then transparent objects forward
+	const bool useSSAO = EnableSSAO;
+	RGResource scene;
+	m_renderGraph.AddPass("DeferredLighting", [&](RGPassBuilder& builder) -> RenderGraph::ExecuteFunc
+		{
+			builder.Read(gbuffer);
+			builder.Read(shadowAtlas);
+			if (useSSAO)
+				builder.Read(ao);
+			scene = builder.Write(m_renderGraph.Import("SceneColor"));
+			return [this, ao, useSSAO](const RenderGraph& graph)
+				{
+					m_rpDeferredLighting.Draw(m_rpDirShadowMap, m_rpGeometry, useSSAO ? &graph.GetFramebuffer(ao) : nullptr, m_data, m_rpMainScene.GetProjection(), m_rpMainScene.GetFBO());
+				};
+		});
+	m_renderGraph.AddPass("Transparent", [&](RGPassBuilder& builder) -> RenderGraph::ExecuteFunc
+		{
+			builder.Read(shadowAtlas);
+			scene = builder.Write(scene);
+			return [this](const RenderGraph&) { m_rpMainScene.DrawTransparent(m_rpDirShadowMap, m_data); };
+		});
+
+	//================================================================================
+	// 4.2 Render Pass: post frame
+	RGResource frame;
+	m_renderGraph.AddPass("Composite", [&](RGPassBuilder& builder) -> RenderGraph::ExecuteFunc
+		{
+			builder.Read(scene);
+			frame = builder.Write(m_renderGraph.Import("Composite"));
+			return [this](const RenderGraph&) { m_rpComposite.Draw(&m_rpMainScene.GetFBO(), nullptr); };
+		});
+	return frame;
+}
+//=============================================================================
+RGResource GameSceneO::addGeometryPass()
+{
+	RGResource gbuffer;
+	m_renderGraph.AddPass("GBuffer", [&](RGPassBuilder& builder) -> RenderGraph::ExecuteFunc
+		{
+			gbuffer = builder.Write(m_renderGraph.Import("GBuffer"));
+			return [this](const RenderGraph&) { m_rpGeometry.Draw(m_data); };
+		});
+	return gbuffer;
+}
+//=============================================================================
+RGResource GameSceneO::addSSAOPasses(RGResource gbuffer)
+{
+	const RGTextureDesc aoDesc{ .width = m_rpSSAO.GetWidth(), .height = m_rpSSAO.GetHeight(), .format = ColorFormat::Red };
+	const RGTextureDesc fullDesc{ .width = m_rpSSAOBlur.GetWidth(), .height = m_rpSSAOBlur.GetHeight(), .format = ColorFormat::Red };
+	const bool fullResolution = aoDesc == fullDesc;
+
+	//================================================================================
+	// 3.1 Render Pass: SSAO
+	RGResource ssao;
+	m_ssaoPass = m_renderGraph.AddPass("SSAO", [&](RGPassBuilder& builder) -> RenderGraph::ExecuteFunc
+		{
+			builder.Read(gbuffer);
+			ssao = builder.Create("SSAO", aoDesc);
+			return [this, ssao](const RenderGraph& graph)
+				{
+					m_ssaoTimer.Begin();
+					m_rpSSAO.Draw(m_rpGeometry.GetFBO(), graph.GetFramebuffer(ssao));
+				};
+		});
+
+	//================================================================================
+	// 3.2 Render Pass: SSAO Blur. Исходное затенение и размытое по y не живут одновременно - пул отдает им одну текстуру
+	RGResource blurX;
+	m_renderGraph.AddPass("SSAO Blur X", [&](RGPassBuilder& builder) -> RenderGraph::ExecuteFunc
+		{
+			builder.Read(ssao);
+			blurX = builder.Create("SSAO Blur X", aoDesc);
+			return [this, ssao, blurX](const RenderGraph& graph) { m_rpSSAOBlur.DrawBlur(m_rpSSAO, graph.GetFramebuffer(ssao), graph.GetFramebuffer(blurX), false); };
+		});
+	RGResource blurY;
+	m_renderGraph.AddPass("SSAO Blur Y", [&](RGPassBuilder& builder) -> RenderGraph::ExecuteFunc
+		{
+			builder.Read(blurX);
+			blurY = builder.Create("SSAO Blur Y", aoDesc);
+			return [this, blurX, blurY, fullResolution](const RenderGraph& graph)
+				{
+					m_rpSSAOBlur.DrawBlur(m_rpSSAO, graph.GetFramebuffer(blurX), graph.GetFramebuffer(blurY), true);
+					if (fullResolution)
+						m_ssaoTimer.End();
+				};
+		});
+	if (fullResolution)
+		return blurY;
+
+	//================================================================================
+	// 3.3 Render Pass: SSAO upsample
+	RGResource ao;
+	m_renderGraph.AddPass("SSAO Upsample", [&](RGPassBuilder& builder) -> RenderGraph::ExecuteFunc
+		{
+			builder.Read(blurY);
+			builder.Read(gbuffer);
+			ao = builder.Create("SSAO Full", fullDesc);
+			return [this, blurY, ao](const RenderGraph& graph)
+				{
+					m_rpSSAOBlur.DrawUpsample(m_rpSSAO, graph.GetFramebuffer(blurY), m_rpGeometry.GetFBO(), graph.GetFramebuffer(ao));
+					m_ssaoTimer.End();
+				};
+		});
+	return ao;
 }
 //=============================================================================
 void GameSceneO::endDraw()
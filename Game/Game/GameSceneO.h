@@ -5,6 +5,7 @@
 #include "RP_1_DirectionalLightsShadowMap.h"
 #include "RP_2_MainScene.h"
 #include "RPGeometry.h"
+#include "RPDeferredLighting.h"
 #include "RPSSAO.h"
 #include "RPSSAOBlur.h"
 #include "RPBlinnPhong.h"
@@ -13,11 +14,23 @@
 
 struct GameObjectO final
 {
-	const AABB& GetAABB() const noexcept { return model.GetAABB(); }
+	const AABB& GetAABB() const noexcept { return model->GetAABB(); }
+	bool IsTransparent() const noexcept { return opacity < 1.0f; }
 
-	Model     model;
+	ModelRef  model;
 	glm::mat4 modelMat{ glm::mat4(1.0f) };
 	bool      visible{ true };
+	bool      isStatic{ false }; // не двигается - попадает в статическое дерево культинга
+	bool      isOccluder{ false }; // крупная непрозрачная геометрия - рисуется в буфер окклюзии
+	float     opacity{ 1.0f }; // меньше 1 - полупрозрачный: не попадает в G-буфер, рисуется прямым проходом после непрозрачных
+};
+
+// Forward - освещение при отрисовке объектов (кластеры источников), Deferred - G-буфер и освещение по нему объемами источников.
+// В обоих путях полупрозрачные объекты рисуются прямым проходом поверх непрозрачных
+enum class RenderPath : uint8_t
+{
+	Forward,
+	Deferred
 };
 
 class GameSceneO final
@@ -27,6 +40,14 @@ public:
 	void Close();
 	void Draw();
 
+	void SetRenderPath(RenderPath path) { m_renderPath = path; }
+	RenderPath GetRenderPath() const { return m_renderPath; }
+	void SetSSAOQuality(SSAOQuality quality);
+	SSAOQuality GetSSAOQuality() const { return m_rpSSAO.GetQuality(); }
+	// только прямой путь - в отложенном глубину и так пишет G-буфер
+	void SetDepthPrePass(DepthPrePassMode mode) { m_rpMainScene.SetDepthPrePass(mode); }
+	DepthPrePassMode GetDepthPrePass() const { return m_rpMainScene.GetDepthPrePass(); }
+
 	void BindCamera(Camera* camera);
 	void BindGameObject(GameObjectO* go);
 	void BindLight(DirectionalLight* ent);
@@ -37,10 +58,16 @@ private:
 	void beginDraw();
 	void draw();
 	void endDraw();
+	// проходы кадра в графе, результат - кадр после постобработки
+	RGResource addForwardPasses(RGResource shadowAtlas);
+	RGResource addDeferredPasses(RGResource shadowAtlas);
+	RGResource addGeometryPass();
+	RGResource addSSAOPasses(RGResource gbuffer);
 
 	void blittingToScreen(GLuint fbo, uint16_t srcWidth, uint16_t srcHeight);
 
 	GameWorldDataO                m_data;
+	RenderPath                    m_renderPath{ RenderPath::Forward };
 
 	RPDirectionalLightsShadowMap m_rpDirShadowMap;
 	RPMainScene                  m_rpMainScene;
@@ -48,7 +75,12 @@ private:
 	RPGeometry                   m_rpGeometry;
 	RPSSAO                       m_rpSSAO;
 	RPSSAOBlur                   m_rpSSAOBlur;
+	GPUTimer                     m_ssaoTimer;
 	RPBlinnPhong                 m_rpBlinnPhong;
+	RPDeferredLighting           m_rpDeferredLighting;
 
 	RPComposite                  m_rpComposite;
+
+	RenderGraph                  m_renderGraph;
+	uint32_t                     m_ssaoPass{ 0 };
 };
\ No newline at end of file
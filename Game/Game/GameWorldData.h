@@ -45,5 +45,8 @@ struct GameWorldData final // TODO;
 	std::vector<AmbientSphereLight*> sphereLights;
 	size_t                           numSphereLights{ 0 };
 
+	// видимые объекты кадра в деревьях AABB (id - индекс в oldGameObjects). Обновляются в начале кадра, общие для всех видов
+	SceneTree                        objectTree;
+
 
 };
\ No newline at end of file
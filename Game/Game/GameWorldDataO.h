@@ -12,8 +12,8 @@ struct GameWorldDataO final // TODO;
 	{
 		gameObjects.reserve(10000);
 		dirLights.resize(MaxDirectionalLight);
-		spotLights.resize(MaxSpotLight);
-		pointLights.resize(MaxPointLight);
+		spotLights.resize(MaxClusteredSpotLight);
+		pointLights.resize(MaxClusteredPointLight);
 	}
 
 	void ResetFrame()
@@ -34,4 +34,7 @@ struct GameWorldDataO final // TODO;
 	size_t                         numSpotLights{ 0 };
 	std::vector<PointLight*>       pointLights;
 	size_t                         numPointLights{ 0 };
+
+	// видимые объекты кадра в деревьях AABB (id - индекс в gameObjects). Обновляются в начале кадра, общие для всех видов
+	SceneTree                      objectTree;
 };
\ No newline at end of file
@@ -17,7 +17,9 @@ namespace
 	GameObjectO modelTest;
 	DirectionalLight dirLight;
 
-	PointLight pointLights[10];
+	// проверка кластерного освещения под нагрузкой
+	constexpr size_t NumPointLights = 1024;
+	PointLight pointLights[NumPointLights];
 
 
 	GameObjectO sphereEntity;
@@ -38,31 +40,33 @@ void OldGameApp()
 
 		camera.SetPosition(glm::vec3(0.0f, 0.5f, 4.5f));
 
-		modelTest.model.Load("data/models/ForgottenPlains/Forgotten_Plains_Demo.obj", ModelMaterialType::PBR);
+		modelTest.model = models::Load("data/models/ForgottenPlains/Forgotten_Plains_Demo.obj", ModelMaterialType::PBR);
 		modelTest.modelMat = glm::translate(glm::mat4(1.0f), glm::vec3(-30.0f, 0.0f, 15.0f));
+		modelTest.isStatic = true;
+		modelTest.isOccluder = true;
 
-		sphereEntity.model.Create(GeometryGenerator::CreateSphere(0.5f, 16, 16));
+		sphereEntity.model = models::CreateSphere(0.5f, 16, 16);
 		sphereEntity.modelMat = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 2.0f, 0.0f));
 
-		box1Entity.model.Create(GeometryGenerator::CreateBox());
+		box1Entity.model = models::CreateBox();
 		box1Entity.modelMat = glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 0.0f));
-		box2Entity.model.Create(GeometryGenerator::CreateBox());
+		box2Entity.model = models::CreateBox();
 		box2Entity.modelMat = glm::translate(glm::mat4(1.0f), glm::vec3(-1.0f, 2.0f, 0.0f));
-		box3Entity.model.Create(GeometryGenerator::CreateBox());
+		box3Entity.model = models::CreateBox();
 		box3Entity.modelMat = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 2.0f, -1.0f));
-		box4Entity.model.Create(GeometryGenerator::CreateBox());
+		box4Entity.model = models::CreateBox();
 		box4Entity.modelMat = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
 
 		dirLight.direction = glm::vec3(0.3f, -0.7f, -0.4f);
 		dirLight.color = glm::vec3(5.0f, 4.5f, 4.0f);
 
-		for (int i = 0; i < 10; ++i)
+		for (size_t i = 0; i < NumPointLights; ++i)
 		{
-			float x = rand() % 20 - 10;
-			float y = rand() % 20 - 10;
+			float x = (rand() % 2000 - 1000) * 0.05f;
+			float y = (rand() % 2000 - 1000) * 0.05f;
 
 			pointLights[i].position = glm::vec3(x, 1.0f, y);
-			pointLights[i].color = glm::vec3(5.0f, 0.8f, 4.5f);
+			pointLights[i].color = glm::vec3(rand() % 100, rand() % 100, rand() % 100) * 0.01f;
 		}
 
 		while (!engine::ShouldClose())
@@ -75,6 +79,11 @@ void OldGameApp()
 				if (input::IsKeyDown(RGFW_s)) camera.ProcessKeyboard(CameraBackward, engine::GetDeltaTime());
 				if (input::IsKeyDown(RGFW_a)) camera.ProcessKeyboard(CameraLeft, engine::GetDeltaTime());
 				if (input::IsKeyDown(RGFW_d)) camera.ProcessKeyboard(CameraRight, engine::GetDeltaTime());
+				if (input::IsKeyPressed(RGFW_F2)) ShowOcclusionBuffer = !ShowOcclusionBuffer;
+				if (input::IsKeyPressed(RGFW_F3)) scene.SetRenderPath(scene.GetRenderPath() == RenderPath::Forward ? RenderPath::Deferred : RenderPath::Forward);
+				if (input::IsKeyPressed(RGFW_F4)) EnableSSAO = !EnableSSAO;
+				if (input::IsKeyPressed(RGFW_F5)) scene.SetSSAOQuality(static_cast<SSAOQuality>((static_cast<int>(scene.GetSSAOQuality()) + 1) % (static_cast<int>(SSAOQuality::Full) + 1)));
+				if (input::IsKeyPressed(RGFW_F6)) scene.SetDepthPrePass(static_cast<DepthPrePassMode>((static_cast<int>(scene.GetDepthPrePass()) + 1) % (static_cast<int>(DepthPrePassMode::Auto) + 1)));
 
 				if (input::IsMouseDown(RGFW_mouseRight))
 				{
@@ -96,7 +105,7 @@ void OldGameApp()
 			scene.BindGameObject(&box4Entity);
 
 			scene.BindLight(&dirLight);
-			for (size_t i = 0; i < 10; i++)
+			for (size_t i = 0; i < NumPointLights; i++)
 			{
 				scene.BindLight(&pointLights[i]);
 			}
@@ -125,8 +125,9 @@ void RPBlinnPhong::drawScene(const std::vector<GameObjectO*>& gameObject, size_t
 	drawInfo.shaderProgram = m_program;
 	for (size_t i = 0; i < numGameObject; i++)
 	{
+		if (!gameObject[i]->model) continue;
 		SetUniform(m_modelMatrixId, gameObject[i]->modelMat);
-		gameObject[i]->model.tDraw(drawInfo);
+		gameObject[i]->model->tDraw(drawInfo);
 	}
 }
 //=============================================================================
\ No newline at end of file
@@ -3,7 +3,7 @@
 #include "NanoIO.h"
 #include "NanoOpenGL3Advance.h"
 #include "NanoLog.h"
-#include "NanoRenderMesh.h"
+#include "NanoFullscreenQuad.h"
 //=============================================================================
 bool RPComposite::Init(uint16_t framebufferWidth, uint16_t framebufferHeight)
 {
@@ -22,7 +22,6 @@ bool RPComposite::Init(uint16_t framebufferWidth, uint16_t framebufferHeight)
 	SetUniform(GetUniformLocation(m_program, "brightInput"), 1);
 	SetUniform(GetUniformLocation(m_program, "ssaoSampler"), 2);
 	SetUniform(GetUniformLocation(m_program, "bloom"), false);
-	SetUniform(GetUniformLocation(m_program, "useSSAO"), EnableSSAO);
 
 	FramebufferInfo fboInfo;
 
@@ -37,24 +36,6 @@ bool RPComposite::Init(uint16_t framebufferWidth, uint16_t framebufferHeight)
 	if (!m_fbo.Create(fboInfo))
 		return false;
 
-	std::vector<QuadVertex> vertices = {
-		{glm::vec2(-1.0f,  1.0f), glm::vec2(0.0f, 1.0f)},
-		{glm::vec2(-1.0f, -1.0f), glm::vec2(0.0f, 0.0f)},
-		{glm::vec2( 1.0f, -1.0f), glm::vec2(1.0f, 0.0f)},
-		{glm::vec2( 1.0f, -1.0f), glm::vec2(1.0f, 0.0f)},
-		{glm::vec2( 1.0f,  1.0f), glm::vec2(1.0f, 1.0f)},
-		{glm::vec2(-1.0f,  1.0f), glm::vec2(0.0f, 1.0f)},
-	};
-
-	GLuint currentVBO = GetCurrentBuffer(BufferTarget::Array);
-	m_vbo = CreateBuffer(BufferTarget::Array, BufferUsage::StaticDraw, vertices.size() * sizeof(QuadVertex), vertices.data());
-	glGenVertexArrays(1, &m_vao);
-	glBindVertexArray(m_vao);
-	glBindBuffer(GL_ARRAY_BUFFER, m_vbo.handle);
-	QuadVertex::SetVertexAttributes();
-	glBindVertexArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, currentVBO);
-
 	glUseProgram(0);
 
 	return true;
@@ -88,12 +69,13 @@ void RPComposite::Draw(const Framebuffer* colorFBO, const Framebuffer* SSAOFBO)
 	colorFBO->BindColorTexture(0, 0);
 	//blurFBO->BindColorTexture(0, 1);
 
-	if (EnableSSAO)
+	// nullptr - SSAO выключен или уже учтен в освещении (отложенный путь)
+	SetUniform(GetUniformLocation(m_program, "useSSAO"), SSAOFBO != nullptr);
+	if (SSAOFBO)
 	{
 		SSAOFBO->BindColorTexture(0, 2);
 	}
 
-	glBindVertexArray(m_vao);
-	glDrawArrays(GL_TRIANGLES, 0, 6);
+	fullscreenQuad::Draw();
 }
 //=============================================================================
\ No newline at end of file
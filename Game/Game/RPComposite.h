@@ -19,8 +19,6 @@ public:
 private:
 	Framebuffer m_fbo;
 	ProgramHandle                       m_program{ 0 };
-	GLuint                       m_vao{ 0 };
-	BufferHandle                 m_vbo{ 0 };
 	uint16_t                     m_framebufferWidth{ 0 }; // TODO: можно удалить - есть в m_fbo
 	uint16_t                     m_framebufferHeight{ 0 }; // TODO: можно удалить - есть в m_fbo
 };
\ No newline at end of file
@@ -0,0 +1,284 @@
+﻿#include "stdafx.h"
+#include "RPDeferredLighting.h"
+#include "GameSceneO.h"
+#include "NanoLog.h"
+//=============================================================================
+namespace
+{
+	// 0-3 - G-буфер (RPGeometry::*Attachment), затем его глубина, SSAO и каскады теней направленных источников
+	constexpr unsigned DepthTextureUnit = RPGeometry::NumAttachments;
+	constexpr unsigned SSAOTextureUnit = DepthTextureUnit + 1;
+	constexpr unsigned DirLightTextureUnit = SSAOTextureUnit + 1;
+
+	constexpr int VolumeSegments = 16;
+	constexpr int SphereRings = 8;
+	// шире - конус слишком плоский, объемом служит сфера
+	constexpr float MinConeOuterCos = 0.2f;
+} // namespace
+//=============================================================================
+bool RPDeferredLighting::Init()
+{
+	if (!initPrograms())
+		return false;
+
+	const float pi = glm::pi<float>();
+
+	// грани многогранника лежат внутри сферы через его вершины - вершины отодвинуты на косинус полудиагонали грани
+	std::vector<glm::vec3> sphereVertices;
+	std::vector<uint16_t> sphereIndices;
+	const float sphereScale = 1.0f / std::cos(glm::length(glm::vec2(pi / VolumeSegments, pi / (2 * SphereRings))));
+	for (int r = 0; r <= SphereRings; r++)
+	{
+		const float theta = pi * r / SphereRings;
+		for (int s = 0; s < VolumeSegments; s++)
+		{
+			const float phi = 2.0f * pi * s / VolumeSegments;
+			sphereVertices.push_back(glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)) * sphereScale);
+		}
+	}
+	for (int r = 0; r < SphereRings; r++)
+	{
+		for (int s = 0; s < VolumeSegments; s++)
+		{
+			const uint16_t a = static_cast<uint16_t>(r * VolumeSegments + s);
+			const uint16_t b = static_cast<uint16_t>(r * VolumeSegments + (s + 1) % VolumeSegments);
+			const uint16_t c = static_cast<uint16_t>(a + VolumeSegments);
+			const uint16_t d = static_cast<uint16_t>(b + VolumeSegments);
+			sphereIndices.insert(sphereIndices.end(), { a, b, c, b, d, c });
+		}
+	}
+
+	std::vector<glm::vec3> coneVertices = { glm::vec3(0.0f) };
+	std::vector<uint16_t> coneIndices;
+	const float coneScale = 1.0f / std::cos(pi / VolumeSegments);
+	for (int s = 0; s < VolumeSegments; s++)
+	{
+		const float phi = 2.0f * pi * s / VolumeSegments;
+		coneVertices.push_back(glm::vec3(std::cos(phi) * coneScale, std::sin(phi) * coneScale, -1.0f));
+	}
+	coneVertices.push_back(glm::vec3(0.0f, 0.0f, -1.0f));
+	const uint16_t baseCenter = static_cast<uint16_t>(VolumeSegments + 1);
+	for (int s = 0; s < VolumeSegments; s++)
+	{
+		const uint16_t a = static_cast<uint16_t>(1 + s);
+		const uint16_t b = static_cast<uint16_t>(1 + (s + 1) % VolumeSegments);
+		coneIndices.insert(coneIndices.end(), { 0, a, b, baseCenter, b, a });
+	}
+
+	if (!createVolume(m_sphere, sphereVertices, sphereIndices) || !createVolume(m_cone, coneVertices, coneIndices))
+		return false;
+
+	return true;
+}
+//=============================================================================
+void RPDeferredLighting::Close()
+{
+	destroyVolume(m_cone);
+	destroyVolume(m_sphere);
+	glDeleteProgram(m_stencilProgram.handle);
+	glDeleteProgram(m_lightProgram.handle);
+	glDeleteProgram(m_directionalProgram.handle);
+	*this = {};
+}
+//=============================================================================
+void RPDeferredLighting::Draw(const RPDirectionalLightsShadowMap& rpShadowMap, const RPGeometry& rpGeometry, const Framebuffer* ssaoFBO,
+	const GameWorldDataO& gameData, const glm::mat4& projection, Framebuffer& target)
+{
+	// глубина G-буфера нужна объемам источников и прозрачным объектам после освещения
+	target.CopyDepth(rpGeometry.GetFBO());
+	glViewport(0, 0, static_cast<int>(rpGeometry.GetWidth()), static_cast<int>(rpGeometry.GetHeight()));
+	glClearColor(0.3f, 0.4f, 0.9f, 1.0f);
+	glClearStencil(0);
+	glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+	glEnable(GL_DEPTH_TEST);
+	glDepthMask(GL_FALSE);
+
+	for (size_t i = 0; i < RPGeometry::NumAttachments; i++)
+		rpGeometry.GetFBO().BindColorTexture(i, i);
+	rpGeometry.GetFBO().BindDepthTexture(DepthTextureUnit);
+
+	const glm::mat4 view = gameData.camera->GetViewMatrix();
+	const glm::mat4 invView = glm::inverse(view);
+	const glm::mat4 invProjection = glm::inverse(projection);
+	for (const ProgramHandle program : { m_directionalProgram, m_lightProgram })
+	{
+		glUseProgram(program.handle);
+		SetUniform(GetUniformLocation(program, "invViewMatrix"), invView);
+		SetUniform(GetUniformLocation(program, "invProjectionMatrix"), invProjection);
+		SetUniform(GetUniformLocation(program, "camPos"), gameData.camera->Position);
+	}
+
+	drawDirectional(rpShadowMap, ssaoFBO, gameData);
+	drawVolumes(gameData, projection * view);
+
+	glDepthMask(GL_TRUE);
+	glBindVertexArray(0);
+}
+//=============================================================================
+bool RPDeferredLighting::initPrograms()
+{
+	const std::vector<std::string> defines = {
+		std::string("MAX_DIR_LIGHTS ") + std::to_string(MaxDirectionalLight),
+		std::string("MAX_CASCADES ") + std::to_string(RPDirectionalLightsShadowMap::MaxCascades),
+	};
+
+	m_directionalProgram = LoadShaderProgram("data/shaders/deferredDirectional/vertex.glsl", "data/shaders/deferredDirectional/fragment.glsl", defines);
+	m_lightProgram = LoadShaderProgram("data/shaders/deferredLight/vertex.glsl", "data/shaders/deferredLight/fragment.glsl", defines);
+	m_stencilProgram = LoadShaderProgram("data/shaders/deferredLight/vertex.glsl", "data/shaders/deferredStencil/fragment.glsl");
+	if (!m_directionalProgram.handle || !m_lightProgram.handle || !m_stencilProgram.handle)
+	{
+		Fatal("Scene Deferred Lighting RenderPass Shader failed!");
+		return false;
+	}
+
+	for (const ProgramHandle program : { m_directionalProgram, m_lightProgram })
+	{
+		glUseProgram(program.handle);
+		SetUniform(GetUniformLocation(program, "gDepth"), static_cast<int>(DepthTextureUnit));
+		SetUniform(GetUniformLocation(program, "gNormal"), static_cast<int>(RPGeometry::NormalAttachment));
+		SetUniform(GetUniformLocation(program, "gAlbedo"), static_cast<int>(RPGeometry::AlbedoAttachment));
+		SetUniform(GetUniformLocation(program, "gMaterial"), static_cast<int>(RPGeometry::MaterialAttachment));
+		SetUniform(GetUniformLocation(program, "gEmissive"), static_cast<int>(RPGeometry::EmissiveAttachment));
+	}
+
+	glUseProgram(m_directionalProgram.handle);
+	SetUniform(GetUniformLocation(m_directionalProgram, "ssaoSampler"), static_cast<int>(SSAOTextureUnit));
+	m_useSSAOId = GetUniformLocation(m_directionalProgram, "useSSAO");
+	assert(m_useSSAOId > -1);
+
+	m_lightViewProjMatrixId = GetUniformLocation(m_lightProgram, "viewProjMatrix");
+	assert(m_lightViewProjMatrixId > -1);
+	m_lightModelMatrixId = GetUniformLocation(m_lightProgram, "modelMatrix");
+	assert(m_lightModelMatrixId > -1);
+	m_lightDataId = GetUniformLocation(m_lightProgram, "lightData");
+	assert(m_lightDataId > -1);
+
+	m_stencilViewProjMatrixId = GetUniformLocation(m_stencilProgram, "viewProjMatrix");
+	assert(m_stencilViewProjMatrixId > -1);
+	m_stencilModelMatrixId = GetUniformLocation(m_stencilProgram, "modelMatrix");
+	assert(m_stencilModelMatrixId > -1);
+
+	glUseProgram(0);
+
+	return true;
+}
+//=============================================================================
+bool RPDeferredLighting::createVolume(VolumeMesh& mesh, const std::vector<glm::vec3>& vertices, const std::vector<uint16_t>& indices)
+{
+	GLuint currentVBO = GetCurrentBuffer(BufferTarget::Array);
+	mesh.vbo = CreateBuffer(BufferTarget::Array, BufferUsage::StaticDraw, vertices.size() * sizeof(glm::vec3), vertices.data());
+
+	GLuint currentIBO = GetCurrentBuffer(BufferTarget::ElementArray);
+	mesh.ibo = CreateBuffer(BufferTarget::ElementArray, BufferUsage::StaticDraw, indices.size() * sizeof(uint16_t), indices.data());
+	mesh.numIndices = static_cast<GLsizei>(indices.size());
+	if (!mesh.vbo.handle || !mesh.ibo.handle)
+	{
+		Error("Failed to create light volume buffers");
+		return false;
+	}
+
+	glGenVertexArrays(1, &mesh.vao);
+	glBindVertexArray(mesh.vao);
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo.handle);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ibo.handle);
+	VertexP3::SetVertexAttributes();
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, currentVBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, currentIBO);
+
+	return true;
+}
+//=============================================================================
+void RPDeferredLighting::destroyVolume(VolumeMesh& mesh)
+{
+	glDeleteVertexArrays(1, &mesh.vao);
+	glDeleteBuffers(1, &mesh.vbo.handle);
+	glDeleteBuffers(1, &mesh.ibo.handle);
+	mesh = {};
+}
+//=============================================================================
+void RPDeferredLighting::drawDirectional(const RPDirectionalLightsShadowMap& rpShadowMap, const Framebuffer* ssaoFBO, const GameWorldDataO& gameData)
+{
+	glUseProgram(m_directionalProgram.handle);
+	rpShadowMap.SetLightUniforms(m_directionalProgram, gameData, DirLightTextureUnit);
+	SetUniform(m_useSSAOId, ssaoFBO != nullptr);
+	if (ssaoFBO)
+		ssaoFBO->BindColorTexture(0, SSAOTextureUnit);
+
+	// квад на дальней плоскости: GL_GREATER пропускает только пиксели с геометрией G-буфера, фон не трогается
+	glDepthFunc(GL_GREATER);
+	fullscreenQuad::Draw();
+	glDepthFunc(GL_LESS);
+}
+//=============================================================================
+void RPDeferredLighting::drawVolumes(const GameWorldDataO& gameData, const glm::mat4& viewProj)
+{
+	RPMainScene::CollectLights(gameData, m_lights);
+	if (m_lights.empty())
+		return;
+
+	glUseProgram(m_lightProgram.handle);
+	SetUniform(m_lightViewProjMatrixId, viewProj);
+	glUseProgram(m_stencilProgram.handle);
+	SetUniform(m_stencilViewProjMatrixId, viewProj);
+
+	glEnable(GL_STENCIL_TEST);
+	glBlendFunc(GL_ONE, GL_ONE);
+
+	const Frustum frustum(viewProj);
+	for (const ClusteredLight& light : m_lights)
+	{
+		if (!frustum.IsVisible(light.position, light.range))
+			continue;
+
+		// конус: ось -Z поворачивается в направление прожектора, основание - на дальности источника
+		const float outerCos = light.spotScale > 0.0f ? -light.spotOffset / light.spotScale : 0.0f;
+		const bool isCone = outerCos > MinConeOuterCos;
+		const VolumeMesh& mesh = isCone ? m_cone : m_sphere;
+		glm::mat4 model = glm::translate(glm::mat4(1.0f), light.position);
+		if (isCone)
+		{
+			const glm::vec3 up = std::abs(light.direction.y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+			const float baseRadius = light.range * std::sqrt(1.0f - outerCos * outerCos) / outerCos;
+			model = model * glm::inverse(glm::lookAt(glm::vec3(0.0f), light.direction, up)) * glm::scale(glm::mat4(1.0f), glm::vec3(baseRadius, baseRadius, light.range));
+		}
+		else
+		{
+			model = glm::scale(model, glm::vec3(light.range));
+		}
+		glBindVertexArray(mesh.vao);
+
+		// 1) трафарет: только глубина, задние грани за геометрией +1, передние -1
+		glUseProgram(m_stencilProgram.handle);
+		SetUniform(m_stencilModelMatrixId, model);
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		glEnable(GL_DEPTH_TEST);
+		glDisable(GL_CULL_FACE);
+		glDisable(GL_BLEND);
+		glStencilFunc(GL_ALWAYS, 0, 0);
+		glStencilOpSeparate(GL_BACK, GL_KEEP, GL_INCR_WRAP, GL_KEEP);
+		glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_DECR_WRAP, GL_KEEP);
+		glDrawElements(GL_TRIANGLES, mesh.numIndices, GL_UNSIGNED_SHORT, nullptr);
+
+		// 2) свет: задние грани без теста глубины - камера может быть внутри объема. Трафарет сразу обнуляется для следующего источника
+		glUseProgram(m_lightProgram.handle);
+		SetUniform(m_lightModelMatrixId, model);
+		SetUniform(m_lightDataId, std::span<const glm::vec4>(reinterpret_cast<const glm::vec4*>(&light), 3));
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		glDisable(GL_DEPTH_TEST);
+		glEnable(GL_CULL_FACE);
+		glCullFace(GL_FRONT);
+		glEnable(GL_BLEND);
+		glStencilFunc(GL_NOTEQUAL, 0, 0xFF);
+		glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
+		glDrawElements(GL_TRIANGLES, mesh.numIndices, GL_UNSIGNED_SHORT, nullptr);
+	}
+
+	glDisable(GL_STENCIL_TEST);
+	glDisable(GL_CULL_FACE);
+	glCullFace(GL_BACK);
+	glDisable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glEnable(GL_DEPTH_TEST);
+}
+//=============================================================================
\ No newline at end of file
@@ -0,0 +1,56 @@
+﻿#pragma once
+
+#include "Framebuffer.h"
+#include "NanoClusteredLighting.h"
+
+class RPDirectionalLightsShadowMap;
+class RPGeometry;
+struct GameWorldDataO;
+
+// Отложенное освещение по G-буферу RPGeometry. Полноэкранный проход - фоновый свет, излучение и направленные источники с тенями,
+// точечные и прожекторы - объемами (сфера, конус). Пиксели внутри объема отбираются трафаретом: задние грани за геометрией
+// увеличивают значение, передние уменьшают, свет рисуется задними гранями без теста глубины там, где трафарет не 0, и сразу
+// его обнуляет - работает и с камерой внутри объема. Стоимость источника - пиксели его объема, а не весь экран
+class RPDeferredLighting final
+{
+public:
+	bool Init();
+	void Close();
+
+	// target - буфер размера G-буфера с глубиной и трафаретом того же формата, в него копируется глубина G-буфера.
+	// ssaoFBO - затенение фонового света, nullptr - без SSAO
+	void Draw(const RPDirectionalLightsShadowMap& rpShadowMap, const RPGeometry& rpGeometry, const Framebuffer* ssaoFBO,
+		const GameWorldDataO& gameData, const glm::mat4& projection, Framebuffer& target);
+
+private:
+	struct VolumeMesh final
+	{
+		BufferHandle vbo{ 0 };
+		BufferHandle ibo{ 0 };
+		GLuint       vao{ 0 };
+		GLsizei      numIndices{ 0 };
+	};
+
+	bool initPrograms();
+	bool createVolume(VolumeMesh& mesh, const std::vector<glm::vec3>& vertices, const std::vector<uint16_t>& indices);
+	void destroyVolume(VolumeMesh& mesh);
+	void drawDirectional(const RPDirectionalLightsShadowMap& rpShadowMap, const Framebuffer* ssaoFBO, const GameWorldDataO& gameData);
+	void drawVolumes(const GameWorldDataO& gameData, const glm::mat4& viewProj);
+
+	ProgramHandle               m_directionalProgram{ 0 };
+	int                         m_useSSAOId{ -1 };
+
+	ProgramHandle               m_lightProgram{ 0 };
+	int                         m_lightViewProjMatrixId{ -1 };
+	int                         m_lightModelMatrixId{ -1 };
+	int                         m_lightDataId{ -1 };
+
+	ProgramHandle               m_stencilProgram{ 0 };
+	int                         m_stencilViewProjMatrixId{ -1 };
+	int                         m_stencilModelMatrixId{ -1 };
+
+	VolumeMesh                  m_sphere; // описан вокруг единичной сферы
+	VolumeMesh                  m_cone;   // вершина в начале координат, ось -Z, основание радиуса 1 на z = -1
+
+	std::vector<ClusteredLight> m_lights;
+};
\ No newline at end of file
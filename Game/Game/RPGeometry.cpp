@@ -22,22 +22,38 @@ bool RPGeometry::Init(uint16_t framebufferWidth, uint16_t framebufferHeight)
 	m_projectionMatrixId = GetUniformLocation(m_program, "projectionMatrix");
 	m_viewMatrixId = GetUniformLocation(m_program, "viewMatrix");
 	m_modelMatrixId = GetUniformLocation(m_program, "modelMatrix");
+	m_hasAlbedoMapId = GetUniformLocation(m_program, "hasAlbedoMap");
+	m_hasNormalMapId = GetUniformLocation(m_program, "hasNormalMap");
+	m_hasMetallicRoughnessMapId = GetUniformLocation(m_program, "hasMetallicRoughnessMap");
+	m_hasAOMapId = GetUniformLocation(m_program, "hasAOMap");
+	m_hasEmissiveMapId = GetUniformLocation(m_program, "hasEmissiveMap");
+
+	SetUniform(GetUniformLocation(m_program, "material.albedoMap"), 0);
+	SetUniform(GetUniformLocation(m_program, "material.normalMap"), 1);
+	SetUniform(GetUniformLocation(m_program, "material.metallicRoughnessMap"), 2);
+	SetUniform(GetUniformLocation(m_program, "material.aoMap"), 3);
+	SetUniform(GetUniformLocation(m_program, "material.emissiveMap"), 4);
 
 	glUseProgram(0); // TODO: возможно вернуть прошлую версию шейдера
 
 
 	FramebufferInfo fboInfo;
 
-	fboInfo.colorAttachments.resize(2);
-	fboInfo.colorAttachments[0].type = AttachmentType::Texture;
-	fboInfo.colorAttachments[0].format = ColorFormat::RGB;
-	fboInfo.colorAttachments[0].dataType = DataType::Float;
-	fboInfo.colorAttachments[1].type = AttachmentType::Texture;
-	fboInfo.colorAttachments[1].format = ColorFormat::RGB;
-	fboInfo.colorAttachments[1].dataType = DataType::Float;
+	fboInfo.colorAttachments.resize(NumAttachments);
+	fboInfo.colorAttachments[NormalAttachment].format = ColorFormat::RG;
+	fboInfo.colorAttachments[NormalAttachment].precision = ColorPrecision::Norm16;
+	fboInfo.colorAttachments[AlbedoAttachment].format = ColorFormat::RGBA;
+	fboInfo.colorAttachments[AlbedoAttachment].dataType = DataType::UnsignedByte;
+	fboInfo.colorAttachments[MaterialAttachment].format = ColorFormat::RG;
+	fboInfo.colorAttachments[MaterialAttachment].dataType = DataType::UnsignedByte;
+	fboInfo.colorAttachments[EmissiveAttachment].format = ColorFormat::RGB;
+	fboInfo.colorAttachments[EmissiveAttachment].dataType = DataType::Float;
+	fboInfo.colorAttachments[EmissiveAttachment].precision = ColorPrecision::Half;
 
+	// текстура - из нее читается позиция. Трафарет - отложенное освещение копирует глубину в буфер с трафаретом
 	fboInfo.depthAttachment = DepthAttachment();
-	fboInfo.depthAttachment->type = AttachmentType::RenderBuffer;
+	fboInfo.depthAttachment->type = AttachmentType::Texture;
+	fboInfo.depthAttachment->stencil = true;
 
 	fboInfo.width = m_framebufferWidth;
 	fboInfo.height = m_framebufferHeight;
@@ -66,30 +82,66 @@ void RPGeometry::Resize(uint16_t framebufferWidth, uint16_t framebufferHeight)
 	m_fbo.Resize(m_framebufferWidth, m_framebufferHeight);
 }
 //=============================================================================
-void RPGeometry::Draw(const std::vector<GameObjectO*>& gameObject, size_t numGameObject, Camera* camera)
+void RPGeometry::Draw(const GameWorldDataO& gameData)
 {
 	m_fbo.Bind();
+	glEnable(GL_DEPTH_TEST);
 	glViewport(0, 0, static_cast<int>(m_framebufferWidth), static_cast<int>(m_framebufferHeight));
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT/* | GL_STENCIL_BUFFER_BIT*/);
 
 	glUseProgram(m_program.handle);
 	SetUniform(m_projectionMatrixId, m_perspective);
-	SetUniform(m_viewMatrixId, camera->GetViewMatrix());
+	SetUniform(m_viewMatrixId, gameData.camera->GetViewMatrix());
 
-	drawScene(gameObject, numGameObject);
+	drawScene(gameData);
 }
 //=============================================================================
-void RPGeometry::drawScene(const std::vector<GameObjectO*>& gameObject, size_t numGameObject)
+void RPGeometry::drawScene(const GameWorldDataO& gameData)
 {
-	ModelDrawInfo drawInfo;
-	drawInfo.bindMaterials = true;
-	drawInfo.mode = GL_TRIANGLES;
-	drawInfo.shaderProgram = m_program;
-	for (size_t i = 0; i < numGameObject; i++)
+	Texture2DHandle albedoTex{ 0 };
+	Texture2DHandle normalTex{ 0 };
+	Texture2DHandle metallicRoughnessTex{ 0 };
+	Texture2DHandle aoTex{ 0 };
+	Texture2DHandle emissiveTex{ 0 };
+
+	gameData.objectTree.Cull(Frustum(m_perspective * gameData.camera->GetViewMatrix()), m_visible, CullingView::Camera);
+
+	for (const uint32_t i : m_visible)
 	{
-		SetUniform(m_modelMatrixId, gameObject[i]->modelMat);
-		gameObject[i]->model.tDraw(drawInfo);
+		const GameObjectO* go = gameData.gameObjects[i];
+		if (go->IsTransparent()) continue;
+
+		SetUniform(m_modelMatrixId, go->modelMat);
+		for (const auto& mesh : go->model->GetMeshes())
+		{
+			const auto& material = mesh.GetPbrMaterial();
+			albedoTex.handle = 0;
+			normalTex.handle = 0;
+			metallicRoughnessTex.handle = 0;
+			aoTex.handle = 0;
+			emissiveTex.handle = 0;
+			if (material)
+			{
+				albedoTex = material->albedoTexture.id;
+				normalTex = material->normalTexture.id;
+				metallicRoughnessTex = material->metallicRoughnessTexture.id;
+			}
+
+			SetUniform(m_hasAlbedoMapId, IsValid(albedoTex));
+			SetUniform(m_hasNormalMapId, IsValid(normalTex));
+			SetUniform(m_hasMetallicRoughnessMapId, IsValid(metallicRoughnessTex));
+			SetUniform(m_hasAOMapId, IsValid(aoTex));
+			SetUniform(m_hasEmissiveMapId, IsValid(emissiveTex));
+
+			BindTexture2D(0, albedoTex);
+			BindTexture2D(1, normalTex);
+			BindTexture2D(2, metallicRoughnessTex);
+			BindTexture2D(3, aoTex);
+			BindTexture2D(4, emissiveTex);
+
+			mesh.Draw(GL_TRIANGLES);
+		}
 	}
 }
 //=============================================================================
\ No newline at end of file
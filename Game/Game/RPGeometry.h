@@ -2,18 +2,26 @@
 
 #include "Framebuffer.h"
 
-class Camera;
-struct GameObjectO;
+struct GameWorldDataO;
 
+// G-буфер видимых непрозрачных объектов. Глубина и нормаль - для SSAO, остальное - для отложенного освещения.
+// Позиция не хранится - восстанавливается из глубины и обратной проекции (geometry/packing.glsl). 20 байт на пиксель вместе с глубиной.
+// Полупрозрачные объекты сюда не попадают, они рисуются прямым проходом после освещения
 class RPGeometry final
 {
 public:
+	static constexpr size_t NormalAttachment = 0;   // RG16, нормаль в пространстве вида, октаэдрическая упаковка
+	static constexpr size_t AlbedoAttachment = 1;   // RGBA8, rgb - альбедо, a - AO материала
+	static constexpr size_t MaterialAttachment = 2; // RG8, металличность и шероховатость
+	static constexpr size_t EmissiveAttachment = 3; // RGB16F
+	static constexpr size_t NumAttachments = 4;
+
 	bool Init(uint16_t framebufferWidth, uint16_t framebufferHeight);
 	void Close();
 
 	void Resize(uint16_t framebufferWidth, uint16_t framebufferHeight);
 
-	void Draw(const std::vector<GameObjectO*>& gameObject, size_t numGameObject, Camera* camera);
+	void Draw(const GameWorldDataO& gameData);
 
 	const Framebuffer& GetFBO() const { return m_fbo; }
 	GLuint GetFBOId() const { return m_fbo.GetId(); }
@@ -21,15 +29,22 @@ public:
 	uint16_t GetHeight() const { return m_framebufferHeight; }
 
 private:
-	void drawScene(const std::vector<GameObjectO*>& gameObject, size_t numGameObject);
+	void drawScene(const GameWorldDataO& gameData);
 
 	ProgramHandle m_program{ 0 };
 	int           m_projectionMatrixId{ -1 };
 	int           m_viewMatrixId{ -1 };
 	int           m_modelMatrixId{ -1 };
+	int           m_hasAlbedoMapId{ -1 };
+	int           m_hasNormalMapId{ -1 };
+	int           m_hasMetallicRoughnessMapId{ -1 };
+	int           m_hasAOMapId{ -1 };
+	int           m_hasEmissiveMapId{ -1 };
 	uint16_t      m_framebufferWidth{ 0 }; // TODO: можно удалить - есть в m_fbo
 	uint16_t      m_framebufferHeight{ 0 }; // TODO: можно удалить - есть в m_fbo
 	glm::mat4     m_perspective{ 1.0f };
 
 	Framebuffer   m_fbo;
+
+	std::vector<uint32_t> m_visible;
 };
\ No newline at end of file
@@ -3,64 +3,152 @@
 #include "NanoWindow.h"
 #include "NanoLog.h"
 #include "GameSceneO.h"
-// TODO: в каждом renderpass создается свой квад, а нужно сделать общий
 //=============================================================================
-bool RPSSAO::Init(uint16_t framebufferWidth, uint16_t framebufferHeight)
+namespace
+{
+	constexpr SSAOPreset Presets[] = {
+		{ .depthLevel = 2, .kernelSize = 8,  .name = "SSAO Low"  },
+		{ .depthLevel = 1, .kernelSize = 16, .name = "SSAO Med"  },
+		{ .depthLevel = 1, .kernelSize = 32, .name = "SSAO High" },
+		{ .depthLevel = 0, .kernelSize = 64, .name = "SSAO Full" },
+	};
+
+	constexpr int NoiseSize = 4;
+
+	// 0 - глубина, 1 - нормаль G-буфера или предыдущего уровня цепочки, 2 - шум
+	constexpr int DepthTextureUnit = 0;
+	constexpr int NormalTextureUnit = 1;
+	constexpr int NoiseTextureUnit = 2;
+
+	uint16_t getLevelSize(uint16_t size, size_t level)
+	{
+		return static_cast<uint16_t>(std::max(size >> level, 1));
+	}
+} // namespace
+//=============================================================================
+const SSAOPreset& GetSSAOPreset(SSAOQuality quality)
+{
+	return Presets[static_cast<size_t>(quality)];
+}
+//=============================================================================
+bool RPSSAO::Init(uint16_t framebufferWidth, uint16_t framebufferHeight, SSAOQuality quality)
 {
 	m_framebufferWidth = framebufferWidth;
 	m_framebufferHeight = framebufferHeight;
+	m_quality = quality;
 	m_perspective = glm::perspective(glm::radians(60.0f), window::GetAspect(), 0.01f, 1000.0f);
-	glm::vec2 size((float)m_framebufferWidth, (float)m_framebufferHeight);
-	m_noiseScale = size / 4.0f;
 
 	m_program = LoadShaderProgram("data/shaders/ssao/vertex.glsl", "data/shaders/ssao/fragment.glsl");
-	if (!m_program.handle)
+	m_depthProgram = LoadShaderProgram("data/shaders/ssaoDepth/vertex.glsl", "data/shaders/ssaoDepth/fragment.glsl");
+	if (!m_program.handle || !m_depthProgram.handle)
 	{
 		Fatal("Scene SSAO RenderPass Shader failed!");
 		return false;
 	}
 
 	glUseProgram(m_program.handle);
-	SetUniform(GetUniformLocation(m_program, "gPosition"), 0);
-	SetUniform(GetUniformLocation(m_program, "gNormal"), 1);
-	SetUniform(GetUniformLocation(m_program, "texNoise"), 2);
-
-	std::vector<QuadVertex> vertices = {
-		{glm::vec2(-1.0f,  1.0f), glm::vec2(0.0f, 1.0f)},
-		{glm::vec2(-1.0f, -1.0f), glm::vec2(0.0f, 0.0f)},
-		{glm::vec2(1.0f, -1.0f), glm::vec2(1.0f, 0.0f)},
-		{glm::vec2(1.0f, -1.0f), glm::vec2(1.0f, 0.0f)},
-		{glm::vec2(1.0f,  1.0f), glm::vec2(1.0f, 1.0f)},
-		{glm::vec2(-1.0f,  1.0f), glm::vec2(0.0f, 1.0f)},
-	};
-
-	GLuint currentVBO = GetCurrentBuffer(BufferTarget::Array);
-	m_vbo = CreateBuffer(BufferTarget::Array, BufferUsage::StaticDraw, vertices.size() * sizeof(QuadVertex), vertices.data());
-	glGenVertexArrays(1, &m_vao);
-	glBindVertexArray(m_vao);
-	glBindBuffer(GL_ARRAY_BUFFER, m_vbo.handle);
-	QuadVertex::SetVertexAttributes();
-	glBindVertexArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, currentVBO);
+	SetUniform(GetUniformLocation(m_program, "viewDepth"), DepthTextureUnit);
+	SetUniform(GetUniformLocation(m_program, "viewNormal"), NormalTextureUnit);
+	SetUniform(GetUniformLocation(m_program, "texNoise"), NoiseTextureUnit);
+	m_kernelSizeId = GetUniformLocation(m_program, "kernelSize");
+	m_noiseScaleId = GetUniformLocation(m_program, "noiseScale");
+	m_projectionId = GetUniformLocation(m_program, "projection");
+	glUniformBlockBinding(m_program.handle, glGetUniformBlockIndex(m_program.handle, "SSAOKernel"), KernelBinding);
+
+	glUseProgram(m_depthProgram.handle);
+	SetUniform(GetUniformLocation(m_depthProgram, "sourceDepth"), DepthTextureUnit);
+	SetUniform(GetUniformLocation(m_depthProgram, "sourceNormal"), NormalTextureUnit);
+	m_depthLinearizeId = GetUniformLocation(m_depthProgram, "linearize");
+	m_depthRatioId = GetUniformLocation(m_depthProgram, "ratio");
+	m_depthProjectionId = GetUniformLocation(m_depthProgram, "projection");
 
 	glUseProgram(0); // TODO: возможно вернуть прошлую версию шейдера
 
-	FramebufferInfo fboInfo;
+	// все уровни цепочки создаются сразу - смена качества только выбирает уровень
+	for (size_t level = 0; level < NumDepthLevels; level++)
+	{
+		FramebufferInfo chainInfo;
+		chainInfo.colorAttachments.resize(2);
+		chainInfo.colorAttachments[0].format = ColorFormat::Red;
+		chainInfo.colorAttachments[0].dataType = DataType::Float;
+		chainInfo.colorAttachments[1].format = ColorFormat::RG;
+		chainInfo.colorAttachments[1].precision = ColorPrecision::Norm16;
+		chainInfo.width = getLevelSize(m_framebufferWidth, level);
+		chainInfo.height = getLevelSize(m_framebufferHeight, level);
+		if (!m_depthChain[level].Create(chainInfo))
+			return false;
+	}
 
-	fboInfo.colorAttachments.resize(1);
-	fboInfo.colorAttachments[0].type = AttachmentType::Texture;
-	fboInfo.colorAttachments[0].format = ColorFormat::Red;
-	fboInfo.colorAttachments[0].dataType = DataType::Float;
+	updateSize();
 
-	fboInfo.width = m_framebufferWidth;
-	fboInfo.height = m_framebufferHeight;
+	return initKernel();
+}
+//=============================================================================
+void RPSSAO::Close()
+{
+	for (auto& fbo : m_depthChain)
+		fbo.Destroy();
+	glDeleteTextures(1, &m_noiseTexture);
+	glDeleteBuffers(1, &m_kernelUBO.handle);
+	glDeleteProgram(m_depthProgram.handle);
+	glDeleteProgram(m_program.handle);
+}
+//=============================================================================
+void RPSSAO::Resize(uint16_t framebufferWidth, uint16_t framebufferHeight)
+{
+	if (m_framebufferWidth == framebufferWidth && m_framebufferHeight == framebufferHeight)
+		return;
 
-	if (!m_fbo.Create(fboInfo))
-		return false;
+	m_framebufferWidth = framebufferWidth;
+	m_framebufferHeight = framebufferHeight;
+	m_perspective = glm::perspective(glm::radians(60.0f), window::GetAspect(), 0.01f, 1000.0f);
 
+	for (size_t level = 0; level < NumDepthLevels; level++)
+		m_depthChain[level].Resize(getLevelSize(m_framebufferWidth, level), getLevelSize(m_framebufferHeight, level));
+	updateSize();
+}
+//=============================================================================
+void RPSSAO::SetQuality(SSAOQuality quality)
+{
+	if (m_quality == quality)
+		return;
+
+	m_quality = quality;
+	updateSize();
+}
+//=============================================================================
+void RPSSAO::Draw(const Framebuffer& gbuffer, Framebuffer& target)
+{
+	glDisable(GL_DEPTH_TEST);
+
+	drawDepthChain(gbuffer);
+
+	target.Bind();
+	glViewport(0, 0, static_cast<int>(m_width), static_cast<int>(m_height));
+
+	glUseProgram(m_program.handle);
+	SetUniform(m_kernelSizeId, GetSSAOPreset(m_quality).kernelSize);
+	SetUniform(m_noiseScaleId, glm::vec2(m_width, m_height) / static_cast<float>(NoiseSize));
+	SetUniform(m_projectionId, m_perspective);
+	glBindBufferBase(GL_UNIFORM_BUFFER, KernelBinding, m_kernelUBO.handle);
+
+	const Framebuffer& depthFBO = GetDepthFBO();
+	depthFBO.BindColorTexture(0, DepthTextureUnit);
+	depthFBO.BindColorTexture(1, NormalTextureUnit);
+	glActiveTexture(GL_TEXTURE0 + NoiseTextureUnit);
+	glBindTexture(GL_TEXTURE_2D, m_noiseTexture);
+
+	fullscreenQuad::Draw();
+}
+//=============================================================================
+bool RPSSAO::initKernel()
+{
 	std::uniform_real_distribution<GLfloat> randomFloats(0.0, 1.0); // random floats between 0.0 - 1.0
 	std::default_random_engine generator;
-	for (GLuint i = 0; i < 64; ++i)
+
+	// std140: vec3 в массиве занимает vec4
+	std::vector<glm::vec4> ssaoKernel;
+	for (GLuint i = 0; i < MaxKernelSize; ++i)
 	{
 		glm::vec3 sample(
 			randomFloats(generator) * 2.0 - 1.0,
@@ -69,15 +157,25 @@ bool RPSSAO::Init(uint16_t framebufferWidth, uint16_t framebufferHeight)
 		);
 		sample = glm::normalize(sample);
 		sample *= randomFloats(generator);
-		float scale = float(i) / 64.0;
+		// радиус по обращенному порядку бит номера - первые 8, 16, 32 выборки покрывают все радиусы, а не только ближние
+		float scale = float(glm::bitfieldReverse(i) >> 26) / float(MaxKernelSize);
 
 		scale = glm::lerp(0.1f, 1.0f, scale * scale);
 		sample *= scale;
-		m_ssaoKernel.push_back(sample);
+		ssaoKernel.push_back(glm::vec4(sample, 0.0f));
+	}
+
+	GLuint currentUBO = GetCurrentBuffer(BufferTarget::Uniform);
+	m_kernelUBO = CreateBuffer(BufferTarget::Uniform, BufferUsage::StaticDraw, ssaoKernel.size() * sizeof(glm::vec4), ssaoKernel.data());
+	glBindBuffer(GL_UNIFORM_BUFFER, currentUBO);
+	if (!m_kernelUBO.handle)
+	{
+		Error("Failed to create SSAO kernel buffer");
+		return false;
 	}
 
 	std::vector<glm::vec3> ssaoNoise;
-	for (GLuint i = 0; i < 16; i++)
+	for (GLuint i = 0; i < NoiseSize * NoiseSize; i++)
 	{
 		glm::vec3 noise(
 			randomFloats(generator) * 2.0 - 1.0,
@@ -89,7 +187,7 @@ bool RPSSAO::Init(uint16_t framebufferWidth, uint16_t framebufferHeight)
 	GLint currentTexture = GetCurrentTexture(GL_TEXTURE_2D);
 	glGenTextures(1, &m_noiseTexture);
 	glBindTexture(GL_TEXTURE_2D, m_noiseTexture);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, 4, 4, 0, GL_RGB, GL_FLOAT, &ssaoNoise[0]);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, NoiseSize, NoiseSize, 0, GL_RGB, GL_FLOAT, &ssaoNoise[0]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -99,45 +197,40 @@ bool RPSSAO::Init(uint16_t framebufferWidth, uint16_t framebufferHeight)
 	return true;
 }
 //=============================================================================
-void RPSSAO::Close()
-{
-	m_fbo.Destroy();
-	glDeleteProgram(m_program.handle);
-}
-//=============================================================================
-void RPSSAO::Resize(uint16_t framebufferWidth, uint16_t framebufferHeight)
+void RPSSAO::drawDepthChain(const Framebuffer& gbuffer)
 {
-	if (m_framebufferWidth == framebufferWidth && m_framebufferHeight == framebufferHeight)
-		return;
+	const size_t lastLevel = GetSSAOPreset(m_quality).depthLevel;
 
-	m_framebufferWidth = framebufferWidth;
-	m_framebufferHeight = framebufferHeight;
-	m_perspective = glm::perspective(glm::radians(60.0f), window::GetAspect(), 0.01f, 1000.0f);
-	glm::vec2 size((float)m_framebufferWidth, (float)m_framebufferHeight);
-	m_noiseScale = size / 4.0f;
+	glUseProgram(m_depthProgram.handle);
+	SetUniform(m_depthProjectionId, m_perspective);
 
-	m_fbo.Resize(m_framebufferWidth, m_framebufferHeight);
+	// уровень 0 нужен только полному разрешению, 1 строится прямо из G-буфера
+	for (size_t level = (lastLevel == 0 ? 0 : 1); level <= lastLevel; level++)
+	{
+		const bool fromGBuffer = level <= 1;
+		if (fromGBuffer)
+		{
+			gbuffer.BindDepthTexture(DepthTextureUnit);
+			gbuffer.BindColorTexture(RPGeometry::NormalAttachment, NormalTextureUnit);
+		}
+		else
+		{
+			m_depthChain[level - 1].BindColorTexture(0, DepthTextureUnit);
+			m_depthChain[level - 1].BindColorTexture(1, NormalTextureUnit);
+		}
+		SetUniform(m_depthLinearizeId, fromGBuffer);
+		SetUniform(m_depthRatioId, level == 0 ? 1 : 2);
+
+		m_depthChain[level].Bind();
+		glViewport(0, 0, static_cast<int>(getLevelSize(m_framebufferWidth, level)), static_cast<int>(getLevelSize(m_framebufferHeight, level)));
+		fullscreenQuad::Draw();
+	}
 }
 //=============================================================================
-void RPSSAO::Draw(const Framebuffer* preFBO)
+void RPSSAO::updateSize()
 {
-	m_fbo.Bind();
-	glDisable(GL_DEPTH_TEST);
-	glViewport(0, 0, static_cast<int>(m_framebufferWidth), static_cast<int>(m_framebufferHeight));
-	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-	glClear(GL_COLOR_BUFFER_BIT);
-
-	glUseProgram(m_program.handle);
-	SetUniform(GetUniformLocation(m_program, "samples"), m_ssaoKernel);
-	SetUniform(GetUniformLocation(m_program, "noiseScale"), m_noiseScale);
-	SetUniform(GetUniformLocation(m_program, "projection"), m_perspective);
-
-	preFBO->BindColorTexture(0, 0);
-	preFBO->BindColorTexture(1, 1);
-	glActiveTexture(GL_TEXTURE2);
-	glBindTexture(GL_TEXTURE_2D, m_noiseTexture);
-
-	glBindVertexArray(m_vao);
-	glDrawArrays(GL_TRIANGLES, 0, 6);
+	const SSAOPreset& preset = GetSSAOPreset(m_quality);
+	m_width = getLevelSize(m_framebufferWidth, preset.depthLevel);
+	m_height = getLevelSize(m_framebufferHeight, preset.depthLevel);
 }
-//=============================================================================
\ No newline at end of file
+//=============================================================================
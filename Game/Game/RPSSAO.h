@@ -2,32 +2,69 @@
 
 #include "Framebuffer.h"
 
+enum class SSAOQuality : uint8_t
+{
+	Low,    // 1/4 разрешения, 8 выборок
+	Medium, // 1/2 разрешения, 16 выборок
+	High,   // 1/2 разрешения, 32 выборки
+	Full    // полное разрешение, 64 выборки
+};
+
+struct SSAOPreset final
+{
+	size_t      depthLevel; // уровень цепочки глубины: 0 - полное разрешение, 1 - 1/2, 2 - 1/4
+	int         kernelSize;
+	const char* name;
+};
+const SSAOPreset& GetSSAOPreset(SSAOQuality quality);
+
+// Затенение фонового света по G-буферу RPGeometry. Глубина (линейная) и нормали сначала уменьшаются до разрешения SSAO
+// цепочкой уровней - из каждых 2x2 пикселей остается ближайший, затенение считается в этом разрешении.
+// Ядро выборок - в статическом UBO, качество меняет только число используемых выборок
 class RPSSAO final
 {
 public:
-	bool Init(uint16_t framebufferWidth, uint16_t framebufferHeight);
+	static constexpr size_t NumDepthLevels = 3;
+	static constexpr size_t MaxKernelSize = 64;
+	static constexpr GLuint KernelBinding = 0;
+
+	bool Init(uint16_t framebufferWidth, uint16_t framebufferHeight, SSAOQuality quality = SSAOQuality::Medium);
 	void Close();
 
 	void Resize(uint16_t framebufferWidth, uint16_t framebufferHeight);
+	void SetQuality(SSAOQuality quality);
+	SSAOQuality GetQuality() const { return m_quality; }
 
-	void Draw(const Framebuffer* preFBO);
+	// target - R8 в разрешении текущего уровня цепочки (GetWidth x GetHeight), временная текстура графа кадра
+	void Draw(const Framebuffer& gbuffer, Framebuffer& target);
 
-	const Framebuffer& GetFBO() const { return m_fbo; }
-	GLuint GetFBOId() const { return m_fbo.GetId(); }
-	uint16_t GetWidth() const { return m_framebufferWidth; }
-	uint16_t GetHeight() const { return m_framebufferHeight; }
+	// уровень цепочки, в котором считалось затенение: 0 - R32F линейная глубина, 1 - RG16 нормаль
+	const Framebuffer& GetDepthFBO() const { return m_depthChain[GetSSAOPreset(m_quality).depthLevel]; }
+	const glm::mat4& GetProjection() const { return m_perspective; }
+	uint16_t GetWidth() const { return m_width; }
+	uint16_t GetHeight() const { return m_height; }
 
 private:
+	bool initKernel();
+	void drawDepthChain(const Framebuffer& gbuffer);
+	void updateSize();
+
 	ProgramHandle m_program{ 0 };
-	uint16_t      m_framebufferWidth{ 0 }; // TODO: можно удалить - есть в m_fbo
-	uint16_t      m_framebufferHeight{ 0 }; // TODO: можно удалить - есть в m_fbo
+	int           m_kernelSizeId{ -1 };
+	int           m_noiseScaleId{ -1 };
+	int           m_projectionId{ -1 };
+	ProgramHandle m_depthProgram{ 0 };
+	int           m_depthLinearizeId{ -1 };
+	int           m_depthRatioId{ -1 };
+	int           m_depthProjectionId{ -1 };
+	uint16_t      m_framebufferWidth{ 0 };
+	uint16_t      m_framebufferHeight{ 0 };
+	uint16_t      m_width{ 0 };  // разрешение затенения
+	uint16_t      m_height{ 0 };
+	SSAOQuality   m_quality{ SSAOQuality::Medium };
 	glm::mat4     m_perspective{ 1.0f };
-	GLuint        m_vao{ 0 };
-	BufferHandle  m_vbo{ 0 };
-
-	Framebuffer   m_fbo;
+	BufferHandle  m_kernelUBO{ 0 };
+	GLuint        m_noiseTexture{ 0 };
 
-	std::vector<glm::vec3> m_ssaoKernel;
-	glm::vec2 m_noiseScale;
-	GLuint m_noiseTexture;
-};
\ No newline at end of file
+	Framebuffer   m_depthChain[NumDepthLevels];
+};
@@ -3,7 +3,13 @@
 #include "NanoWindow.h"
 #include "NanoLog.h"
 #include "GameSceneO.h"
-// TODO: в каждом renderpass создается свой квад, а нужно сделать общий
+//=============================================================================
+namespace
+{
+	constexpr int SSAOTextureUnit = 0;
+	constexpr int LowDepthTextureUnit = 1;
+	constexpr int DepthTextureUnit = 2;
+} // namespace
 //=============================================================================
 bool RPSSAOBlur::Init(uint16_t framebufferWidth, uint16_t framebufferHeight)
 {
@@ -11,80 +17,70 @@ bool RPSSAOBlur::Init(uint16_t framebufferWidth, uint16_t framebufferHeight)
 	m_framebufferHeight = framebufferHeight;
 
 	m_program = LoadShaderProgram("data/shaders/ssaoBlur/vertex.glsl", "data/shaders/ssaoBlur/fragment.glsl");
-	if (!m_program.handle)
+	m_upsampleProgram = LoadShaderProgram("data/shaders/ssaoUpsample/vertex.glsl", "data/shaders/ssaoUpsample/fragment.glsl");
+	if (!m_program.handle || !m_upsampleProgram.handle)
 	{
 		Fatal("Scene SSAO Blur RenderPass Shader failed!");
 		return false;
 	}
 
 	glUseProgram(m_program.handle);
-	SetUniform(GetUniformLocation(m_program, "ssaoInput"), 0);
-
-	std::vector<QuadVertex> vertices = {
-		{glm::vec2(-1.0f,  1.0f), glm::vec2(0.0f, 1.0f)},
-		{glm::vec2(-1.0f, -1.0f), glm::vec2(0.0f, 0.0f)},
-		{glm::vec2(1.0f, -1.0f), glm::vec2(1.0f, 0.0f)},
-		{glm::vec2(1.0f, -1.0f), glm::vec2(1.0f, 0.0f)},
-		{glm::vec2(1.0f,  1.0f), glm::vec2(1.0f, 1.0f)},
-		{glm::vec2(-1.0f,  1.0f), glm::vec2(0.0f, 1.0f)},
-	};
+	SetUniform(GetUniformLocation(m_program, "ssaoInput"), SSAOTextureUnit);
+	SetUniform(GetUniformLocation(m_program, "viewDepth"), LowDepthTextureUnit);
+	m_directionId = GetUniformLocation(m_program, "direction");
 
-	GLuint currentVBO = GetCurrentBuffer(BufferTarget::Array);
-	m_vbo = CreateBuffer(BufferTarget::Array, BufferUsage::StaticDraw, vertices.size() * sizeof(QuadVertex), vertices.data());
-	glGenVertexArrays(1, &m_vao);
-	glBindVertexArray(m_vao);
-	glBindBuffer(GL_ARRAY_BUFFER, m_vbo.handle);
-	QuadVertex::SetVertexAttributes();
-	glBindVertexArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, currentVBO);
+	glUseProgram(m_upsampleProgram.handle);
+	SetUniform(GetUniformLocation(m_upsampleProgram, "ssaoInput"), SSAOTextureUnit);
+	SetUniform(GetUniformLocation(m_upsampleProgram, "lowDepth"), LowDepthTextureUnit);
+	SetUniform(GetUniformLocation(m_upsampleProgram, "gDepth"), DepthTextureUnit);
+	m_upsampleProjectionId = GetUniformLocation(m_upsampleProgram, "projection");
 
 	glUseProgram(0); // TODO: возможно вернуть прошлую версию шейдера
 
-	FramebufferInfo fboInfo;
-
-	fboInfo.colorAttachments.resize(1);
-	fboInfo.colorAttachments[0].type = AttachmentType::Texture;
-	fboInfo.colorAttachments[0].format = ColorFormat::Red;
-	fboInfo.colorAttachments[0].dataType = DataType::Float;
-
-	fboInfo.width = m_framebufferWidth;
-	fboInfo.height = m_framebufferHeight;
-
-	if (!m_fbo.Create(fboInfo))
-		return false;
-
 	return true;
 }
 //=============================================================================
 void RPSSAOBlur::Close()
 {
-	m_fbo.Destroy();
+	glDeleteProgram(m_upsampleProgram.handle);
 	glDeleteProgram(m_program.handle);
 }
 //=============================================================================
 void RPSSAOBlur::Resize(uint16_t framebufferWidth, uint16_t framebufferHeight)
 {
-	if (m_framebufferWidth == framebufferWidth && m_framebufferHeight == framebufferHeight)
-		return;
-
 	m_framebufferWidth = framebufferWidth;
 	m_framebufferHeight = framebufferHeight;
-
-	m_fbo.Resize(m_framebufferWidth, m_framebufferHeight);
 }
 //=============================================================================
-void RPSSAOBlur::Draw(const Framebuffer* preFBO)
+void RPSSAOBlur::DrawBlur(const RPSSAO& ssao, const Framebuffer& source, Framebuffer& target, bool vertical)
 {
-	m_fbo.Bind();
-	glViewport(0, 0, static_cast<int>(m_framebufferWidth), static_cast<int>(m_framebufferHeight));
-	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-	glClear(GL_COLOR_BUFFER_BIT);
+	glDisable(GL_DEPTH_TEST);
+	target.Bind();
+	glViewport(0, 0, static_cast<int>(ssao.GetWidth()), static_cast<int>(ssao.GetHeight()));
 
 	glUseProgram(m_program.handle);
+	if (vertical)
+		glUniform2i(m_directionId, 0, 1);
+	else
+		glUniform2i(m_directionId, 1, 0);
+	source.BindColorTexture(0, SSAOTextureUnit);
+	ssao.GetDepthFBO().BindColorTexture(0, LowDepthTextureUnit);
+
+	fullscreenQuad::Draw();
+}
+//=============================================================================
+void RPSSAOBlur::DrawUpsample(const RPSSAO& ssao, const Framebuffer& source, const Framebuffer& gbuffer, Framebuffer& target)
+{
+	glDisable(GL_DEPTH_TEST);
+	target.Bind();
+	glViewport(0, 0, static_cast<int>(m_framebufferWidth), static_cast<int>(m_framebufferHeight));
 
-	preFBO->BindColorTexture(0, 0);
+	glUseProgram(m_upsampleProgram.handle);
+	SetUniform(m_upsampleProjectionId, ssao.GetProjection());
+	source.BindColorTexture(0, SSAOTextureUnit);
+	ssao.GetDepthFBO().BindColorTexture(0, LowDepthTextureUnit);
+	gbuffer.BindDepthTexture(DepthTextureUnit);
 
-	glBindVertexArray(m_vao);
-	glDrawArrays(GL_TRIANGLES, 0, 6);
+	fullscreenQuad::Draw();
 }
-//=============================================================================
\ No newline at end of file
+//=============================================================================
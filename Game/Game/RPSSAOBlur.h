@@ -2,6 +2,11 @@
 
 #include "Framebuffer.h"
 
+class RPSSAO;
+
+// Размытие SSAO в его разрешении двумя проходами (по x, затем по y) с учетом глубины, затем билатеральное повышение
+// разрешения до полного. На полном разрешении SSAO повышение не нужно - результат дает второй проход размытия.
+// Своих буферов нет: источники и цели - временные R8 текстуры графа кадра
 class RPSSAOBlur final
 {
 public:
@@ -10,19 +15,19 @@ public:
 
 	void Resize(uint16_t framebufferWidth, uint16_t framebufferHeight);
 
-	void Draw(const Framebuffer* preFBO);
+	// source и target в разрешении SSAO
+	void DrawBlur(const RPSSAO& ssao, const Framebuffer& source, Framebuffer& target, bool vertical);
+	// gbuffer - глубина полного разрешения, target - полное разрешение
+	void DrawUpsample(const RPSSAO& ssao, const Framebuffer& source, const Framebuffer& gbuffer, Framebuffer& target);
 
-	const Framebuffer& GetFBO() const { return m_fbo; }
-	GLuint GetFBOId() const { return m_fbo.GetId(); }
 	uint16_t GetWidth() const { return m_framebufferWidth; }
 	uint16_t GetHeight() const { return m_framebufferHeight; }
 
 private:
-	ProgramHandle                       m_program{ 0 };
-	uint16_t                     m_framebufferWidth{ 0 }; // TODO: можно удалить - есть в m_fbo
-	uint16_t                     m_framebufferHeight{ 0 }; // TODO: можно удалить - есть в m_fbo
-	GLuint                       m_vao{ 0 };
-	BufferHandle                 m_vbo{ 0 };
-
-	Framebuffer m_fbo;
-};
\ No newline at end of file
+	ProgramHandle                m_program{ 0 };
+	int                          m_directionId{ -1 };
+	ProgramHandle                m_upsampleProgram{ 0 };
+	int                          m_upsampleProjectionId{ -1 };
+	uint16_t                     m_framebufferWidth{ 0 };
+	uint16_t                     m_framebufferHeight{ 0 };
+};
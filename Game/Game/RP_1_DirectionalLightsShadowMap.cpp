@@ -4,18 +4,29 @@
 #include "NanoIO.h"
 #include "NanoLog.h"
 //=============================================================================
+namespace
+{
+	// на сколько ближняя плоскость отсечения каскада отодвинута к свету: объекты вне каскада, но между ним и светом, отбрасывают в него тень
+	constexpr float ShadowCasterDistance = 100.0f;
+	// запас проекции каскада от радиуса его сферы: пока центр сферы сдвинулся меньше запаса, проекция и кэш статики не меняются
+	constexpr float CascadeMarginFraction = 0.15f;
+	//-------------------------------------------------------------------------
+	glm::mat4 getLightRotation(const glm::vec3& lightDirection)
+	{
+		const glm::vec3 direction = glm::normalize(lightDirection);
+		const glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+		return glm::lookAt(glm::vec3(0.0f), direction, up);
+	}
+} // namespace
+//=============================================================================
 bool RPDirectionalLightsShadowMap::Init(ShadowQuality shadowQuality)
 {
 	m_shadowQuality = shadowQuality;
-	m_orthoDimension = 10.0f;
-	m_orthoProjection = glm::ortho(-m_orthoDimension, m_orthoDimension, -m_orthoDimension, m_orthoDimension, 1.0f, 50.0f);
+	m_numCascades = std::clamp<size_t>(NumShadowCascades, 2, MaxCascades);
 
 	if (!initProgram())
 		return false;
 
-	if (!initFBO())
-		return false;
-
 	return true;
 }
 //=============================================================================
@@ -27,45 +38,126 @@ void RPDirectionalLightsShadowMap::Close()
 	for (size_t i = 0; i < m_depthFBO.size(); i++)
 	{
 		m_depthFBO[i].Destroy();
+		m_staticFBO[i].Destroy();
 	}
+	resetCache();
 }
 //=============================================================================
-void RPDirectionalLightsShadowMap::Draw(const GameWorldDataO& worldData)
+void RPDirectionalLightsShadowMap::Draw(const GameWorldDataO& worldData, const glm::mat4& cameraProjection)
 {
 	if (m_shadowQuality == ShadowQuality::Off) return;
-	if (worldData.numDirLights == 0) return;
+	if (worldData.numDirLights == 0 || !worldData.camera) return;
 
 	size_t numDirLights = worldData.numDirLights;
-	if (numDirLights >= m_depthFBO.size())
+	if (numDirLights > m_depthFBO.size())
 	{
 		Warning("Num Dir Light bigger num");
-		numDirLights = m_depthFBO.size() - 1;
+		numDirLights = m_depthFBO.size();
+	}
+
+	if (NumShadowCascades != m_numCascades)
+		SetNumCascades(NumShadowCascades);
+	computeCascades(worldData.camera->GetViewMatrix(), cameraProjection);
+
+	// покрытие проверяется у всех каскадов каждый кадр: каскад, часть пирамиды которого вышла за запас, перепроецируется вне бюджета.
+	// По бюджету - только перерисовка статики верных каскадов: ближний каждый кадр, дальние по очереди, тексели у них крупнее
+	m_scheduler.Begin(ShadowCascadeUpdateBudget);
+	for (size_t i = 0; i < numDirLights; i++)
+	{
+		const auto* light = worldData.dirLights[i];
+		if (!light) continue;
+		if (!m_depthFBO[i].GetId())
+		{
+			if (!initFBO(m_depthFBO[i])) continue;
+			m_lightCache[i] = {};
+		}
+
+		LightCache& cache = m_lightCache[i];
+		if (cache.direction != light->direction)
+		{
+			cache.direction = light->direction;
+			cache.computedMask = 0;
+		}
+		if (cache.staticVersion != worldData.objectTree.GetStaticVersion())
+		{
+			cache.staticVersion = worldData.objectTree.GetStaticVersion();
+			cache.staticMask = 0;
+		}
+
+		cache.reprojectMask = 0;
+		for (size_t c = 0; c < m_numCascades; c++)
+		{
+			const uint8_t bit = static_cast<uint8_t>(1u << c);
+			if (!isCascadeValid(i, c)) cache.reprojectMask |= bit;
+			if ((cache.reprojectMask & bit) || !(cache.staticMask & bit))
+				m_scheduler.Add(static_cast<uint32_t>(i * MaxCascades + c), 1.0f / static_cast<float>(c + 1), (cache.reprojectMask & bit) != 0);
+		}
 	}
+	m_scheduler.Schedule();
 
 	glEnable(GL_DEPTH_TEST);
+	// ближняя плоскость каскада режет сцену - объекты перед ней прижимаются к глубине 0, а не обрезаются
+	glEnable(GL_DEPTH_CLAMP);
 	glUseProgram(m_program.handle);
 	glViewport(0, 0, static_cast<int>(m_shadowQuality), static_cast<int>(m_shadowQuality));
 
-	glm::mat4 lightView;
+	const uint8_t cascadesMask = static_cast<uint8_t>((1u << m_numCascades) - 1);
 	for (size_t i = 0; i < numDirLights; i++)
 	{
 		const auto* light = worldData.dirLights[i];
-		if (!light) continue;
+		if (!light || !m_depthFBO[i].GetId()) continue;
 
-		m_depthFBO[i].Bind();
-		glClear(GL_DEPTH_BUFFER_BIT);
+		LightCache& cache = m_lightCache[i];
+		uint8_t scheduledMask = 0;
+		for (size_t c = 0; c < m_numCascades; c++)
+		{
+			if (!m_scheduler.IsScheduled(static_cast<uint32_t>(i * MaxCascades + c))) continue;
 
-		glm::vec3 lightPos = -light->direction * 10.0f;
+			const uint8_t bit = static_cast<uint8_t>(1u << c);
+			scheduledMask |= bit;
+			if ((cache.reprojectMask & bit) && reprojectCascade(i, c, light->direction))
+				cache.staticMask &= ~bit;
+			cache.computedMask |= bit;
+		}
 
-		//constexpr const glm::vec3 worldUp(0.0f, 1.0f, 0.0f);
-		//glm::vec3 right = glm::normalize(glm::cross(light->direction, worldUp));
-		//glm::vec3 up = glm::normalize(glm::cross(right, light->direction));
+		if (!EnableShadowCache)
+		{
+			m_depthFBO[i].Bind();
+			glClear(GL_DEPTH_BUFFER_BIT);
+			collectCasters(cache.cullMatrices, cascadesMask, SceneObjects::All, worldData);
+			drawCasters(m_cascadeMatrices[i], worldData);
+			cache.staticMask = 0;
+			continue;
+		}
 
-		lightView = glm::lookAt(lightPos, glm::vec3(0.0f), glm::vec3(0.0, 1.0, 0.0));
+		// статика каскадов вне бюджета остается прежней до их очереди
+		const uint8_t rebuildMask = cascadesMask & ~cache.staticMask & scheduledMask;
+		if (rebuildMask)
+		{
+			if (!m_staticFBO[i].GetId() && !initFBO(m_staticFBO[i])) continue;
 
-		m_lightSpaceMatrix[i] = m_orthoProjection * lightView;
-		drawScene(m_lightSpaceMatrix[i], worldData);
+			m_staticFBO[i].Bind();
+			for (size_t c = 0; c < m_numCascades; c++)
+			{
+				if (rebuildMask & (1u << c))
+					m_staticFBO[i].ClearDepth(static_cast<int>(c));
+			}
+			collectCasters(cache.cullMatrices, rebuildMask, SceneObjects::Static, worldData);
+			drawCasters(m_cascadeMatrices[i], worldData);
+			cache.staticMask |= rebuildMask;
+		}
+
+		// динамические объекты - поверх копии статики. Если их нет ни сейчас, ни в прошлом кадре, а статика не менялась, карта уже верна
+		const bool hasDynamicCasters = collectCasters(cache.cullMatrices, cascadesMask, SceneObjects::Dynamic, worldData);
+		if (rebuildMask || hasDynamicCasters || cache.hasDynamicCasters)
+		{
+			m_depthFBO[i].CopyDepth(m_staticFBO[i]);
+			drawCasters(m_cascadeMatrices[i], worldData);
+		}
+		cache.hasDynamicCasters = hasDynamicCasters;
 	}
+
+	glDisable(GL_DEPTH_CLAMP);
 }
 //=============================================================================
 void RPDirectionalLightsShadowMap::SetShadowQuality(ShadowQuality quality)
@@ -76,20 +168,157 @@ void RPDirectionalLightsShadowMap::SetShadowQuality(ShadowQuality quality)
 	if (m_shadowQuality != ShadowQuality::Off)
 	{
 		for (size_t i = 0; i < m_depthFBO.size(); i++)
-			m_depthFBO[i].Resize(static_cast<uint16_t>(m_shadowQuality), static_cast<uint16_t>(m_shadowQuality));
+		{
+			if (m_depthFBO[i].GetId())
+				m_depthFBO[i].Resize(static_cast<uint16_t>(m_shadowQuality), static_cast<uint16_t>(m_shadowQuality));
+			if (m_staticFBO[i].GetId())
+				m_staticFBO[i].Resize(static_cast<uint16_t>(m_shadowQuality), static_cast<uint16_t>(m_shadowQuality));
+		}
 	}
+	// сдвиг на тексель зависит от размера карты
+	resetCache();
 }
 //=============================================================================
-void RPDirectionalLightsShadowMap::drawScene(const glm::mat4& lightSpaceMatrix, const GameWorldDataO& worldData)
+void RPDirectionalLightsShadowMap::SetNumCascades(size_t numCascades)
 {
-	for (size_t i = 0; i < worldData.numGameObject; i++)
+	numCascades = std::clamp<size_t>(numCascades, 2, MaxCascades);
+	if (m_numCascades == numCascades) return;
+
+	m_numCascades = numCascades;
+	NumShadowCascades = numCascades;
+	// число слоев меняется - массивы пересоздаются при следующей отрисовке
+	for (size_t i = 0; i < m_depthFBO.size(); i++)
 	{
-		if (!worldData.gameObjects[i] || !worldData.gameObjects[i]->visible)
-			continue;
+		m_depthFBO[i].Destroy();
+		m_staticFBO[i].Destroy();
+	}
+	resetCache();
+}
+//=============================================================================
+void RPDirectionalLightsShadowMap::resetCache()
+{
+	m_lightCache.fill({});
+	m_scheduler.Reset();
+}
+//=============================================================================
+void RPDirectionalLightsShadowMap::computeCascades(const glm::mat4& cameraView, const glm::mat4& cameraProjection)
+{
+	// симметричная перспектива OpenGL
+	const float nearPlane = cameraProjection[3][2] / (cameraProjection[2][2] - 1.0f);
+	const float farPlane = cameraProjection[3][2] / (cameraProjection[2][2] + 1.0f);
+	const float shadowFar = std::min(farPlane, ShadowDistance);
+	const float tanHalfX = 1.0f / cameraProjection[0][0];
+	const float tanHalfY = 1.0f / cameraProjection[1][1];
+	const glm::mat4 invView = glm::inverse(cameraView);
+
+	float splitNear = nearPlane;
+	for (size_t c = 0; c < m_numCascades; c++)
+	{
+		const float p = static_cast<float>(c + 1) / static_cast<float>(m_numCascades);
+		const float logSplit = nearPlane * std::pow(shadowFar / nearPlane, p);
+		const float uniformSplit = nearPlane + (shadowFar - nearPlane) * p;
+		const float splitFar = glm::mix(uniformSplit, logSplit, ShadowCascadeSplitLambda);
+
+		std::array<glm::vec3, 8> corners;
+		glm::vec3 center(0.0f);
+		for (size_t i = 0; i < corners.size(); i++)
+		{
+			const float depth = (i & 4) ? splitFar : splitNear;
+			const glm::vec4 corner((i & 1) ? depth * tanHalfX : -depth * tanHalfX, (i & 2) ? depth * tanHalfY : -depth * tanHalfY, -depth, 1.0f);
+			corners[i] = glm::vec3(invView * corner);
+			center += corners[i];
+		}
+		center /= static_cast<float>(corners.size());
+
+		// сфера вокруг части пирамиды не зависит от поворота камеры - размер проекции каскада постоянный
+		float radius = 0.0f;
+		for (const auto& corner : corners)
+			radius = std::max(radius, glm::length(corner - center));
+		radius = std::ceil(radius * 16.0f) / 16.0f;
+
+		m_cascadeCenters[c] = center;
+		const float extent = std::ceil(radius * (1.0f + CascadeMarginFraction) * 16.0f) / 16.0f;
+
+		m_cascadeRadii[c] = radius;
+		m_cascadeExtents[c] = extent;
+		m_cascadeSplits[c] = splitFar;
+		m_cascadeTexelSizes[c] = 2.0f * extent / static_cast<float>(m_shadowQuality);
+		splitNear = splitFar;
+	}
+}
+//=============================================================================
+bool RPDirectionalLightsShadowMap::isCascadeValid(size_t light, size_t cascade) const
+{
+	const LightCache& cache = m_lightCache[light];
+	if (!(cache.computedMask & (1u << cascade)) || cache.extents[cascade] != m_cascadeExtents[cascade])
+		return false;
+
+	// сфера каскада еще внутри проекции
+	const glm::vec3 center = glm::vec3(getLightRotation(cache.direction) * glm::vec4(m_cascadeCenters[cascade], 1.0f));
+	const glm::vec3 delta = center - glm::vec3(cache.origins[cascade]) * m_cascadeTexelSizes[cascade];
+	const float margin = m_cascadeExtents[cascade] - m_cascadeRadii[cascade];
+	return glm::all(glm::lessThanEqual(glm::abs(delta), glm::vec3(margin)));
+}
+//=============================================================================
+bool RPDirectionalLightsShadowMap::reprojectCascade(size_t light, size_t cascade, const glm::vec3& lightDirection)
+{
+	LightCache& cache = m_lightCache[light];
+	// только поворот: сдвиг проекции задается ниже целыми текселями
+	const glm::mat4 lightView = getLightRotation(lightDirection);
+
+	const float extent = m_cascadeExtents[cascade];
+	const float texelSize = m_cascadeTexelSizes[cascade];
+	const glm::vec3 center = glm::vec3(lightView * glm::vec4(m_cascadeCenters[cascade], 1.0f));
 
-		SetUniform((GLuint)m_mvpMatrixId, lightSpaceMatrix * worldData.gameObjects[i]->modelMat);
+	const glm::ivec3 origin = glm::ivec3(glm::round(center / texelSize));
+	const bool moved = !(cache.computedMask & (1u << cascade)) || cache.extents[cascade] != extent || origin != cache.origins[cascade];
+	cache.origins[cascade] = origin;
+	cache.extents[cascade] = extent;
 
-		const auto& meshes = worldData.gameObjects[i]->model.GetMeshes();
+	// стороны проекции на границах текселей: центр в целых текселях, сторона - ровно размер карты в текселях
+	const glm::vec3 offset = glm::vec3(origin) * texelSize;
+	const float left = offset.x - extent, right = offset.x + extent;
+	const float bottom = offset.y - extent, top = offset.y + extent;
+	// вид света смотрит вдоль -z
+	const float nearPlane = -offset.z - extent, farPlane = -offset.z + extent;
+	const glm::mat4 lightProjection = glm::ortho(left, right, bottom, top, nearPlane, farPlane);
+	const glm::mat4 cullProjection = glm::ortho(left, right, bottom, top, nearPlane - ShadowCasterDistance, farPlane);
+
+	m_cascadeMatrices[light][cascade] = lightProjection * lightView;
+	cache.cullMatrices[cascade] = cullProjection * lightView;
+	return moved;
+}
+//=============================================================================
+bool RPDirectionalLightsShadowMap::collectCasters(const CascadeMatrices& cullMatrices, uint8_t mask, SceneObjects objects, const GameWorldDataO& worldData)
+{
+	// обход дерева на каждый каскад, но объект рисуется один раз - с маской каскадов, в которые он попал
+	m_cascadeMask.assign(worldData.numGameObject, 0);
+	m_casters.clear();
+	for (size_t c = 0; c < m_numCascades; c++)
+	{
+		if (!(mask & (1u << c))) continue;
+
+		worldData.objectTree.Cull(Frustum(cullMatrices[c]), m_visible, CullingView::Shadow, objects);
+		for (const uint32_t i : m_visible)
+		{
+			if (m_cascadeMask[i] == 0) m_casters.push_back(i);
+			m_cascadeMask[i] |= static_cast<uint8_t>(1u << c);
+		}
+	}
+	return !m_casters.empty();
+}
+//=============================================================================
+void RPDirectionalLightsShadowMap::drawCasters(const CascadeMatrices& matrices, const GameWorldDataO& worldData)
+{
+	for (size_t c = 0; c < m_numCascades; c++)
+		SetUniform(m_cascadeMatrixId[c], matrices[c]);
+
+	for (const uint32_t i : m_casters)
+	{
+		SetUniform(m_modelMatrixId, worldData.gameObjects[i]->modelMat);
+		SetUniform(m_cascadeMaskId, static_cast<int>(m_cascadeMask[i]));
+
+		const auto& meshes = worldData.gameObjects[i]->model->GetMeshes();
 		for (const auto& mesh : meshes)
 		{
 			const auto& material = mesh.GetPbrMaterial();
@@ -101,7 +330,7 @@ void RPDirectionalLightsShadowMap::drawScene(const glm::mat4& lightSpaceMatrix,
 				albedoTex = material->albedoTexture.id;
 			}
 
-			SetUniform((GLuint)m_hasAlbedoMapId, hasAlbedoMap);
+			SetUniform(m_hasAlbedoMapId, hasAlbedoMap);
 			BindTexture2D(0, albedoTex);
 
 			mesh.Draw(GL_TRIANGLES);
@@ -114,9 +343,41 @@ void RPDirectionalLightsShadowMap::BindDepthTexture(size_t id, unsigned slot) co
 	m_depthFBO[id].BindDepthTexture(slot);
 }
 //=============================================================================
+void RPDirectionalLightsShadowMap::SetLightUniforms(ProgramHandle program, const GameWorldDataO& worldData, unsigned firstTextureUnit) const
+{
+	for (size_t i = 0; i < worldData.numDirLights; ++i)
+	{
+		const auto* light = worldData.dirLights[i];
+		const unsigned textureUnit = firstTextureUnit + static_cast<unsigned>(i);
+
+		const std::string prefix = "dirLight[" + std::to_string(i) + "].";
+		SetUniform(GetUniformLocation(program, prefix + "direction"), light->direction);
+		SetUniform(GetUniformLocation(program, prefix + "color"), light->color);
+		SetUniform(GetUniformLocation(program, prefix + "shadowMap"), static_cast<int>(textureUnit));
+		for (size_t c = 0; c < m_numCascades; c++)
+			SetUniform(GetUniformLocation(program, prefix + "cascadeMatrix[" + std::to_string(c) + "]"), m_cascadeMatrices[i][c]);
+
+		BindDepthTexture(i, textureUnit);
+	}
+	SetUniform(GetUniformLocation(program, "dirLightCount"), static_cast<int>(worldData.numDirLights));
+
+	SetUniform(GetUniformLocation(program, "cascadeCount"), static_cast<int>(m_numCascades));
+	SetUniform(GetUniformLocation(program, "cascadeFade"), ShadowCascadeFade);
+	for (size_t c = 0; c < m_numCascades; c++)
+	{
+		const std::string index = "[" + std::to_string(c) + "]";
+		SetUniform(GetUniformLocation(program, "cascadeSplits" + index), m_cascadeSplits[c]);
+		SetUniform(GetUniformLocation(program, "cascadeTexelSize" + index), m_cascadeTexelSizes[c]);
+	}
+}
+//=============================================================================
 bool RPDirectionalLightsShadowMap::initProgram()
 {
-	m_program = LoadShaderProgram("data/shaders/shadowMapping/vertex.glsl", "data/shaders/shadowMapping/fragment.glsl");
+	const std::vector<std::string> defines = {
+		std::string("MAX_CASCADES ") + std::to_string(MaxCascades),
+	};
+
+	m_program = LoadShaderProgram("data/shaders/shadowCascades/vertex.glsl", "data/shaders/shadowCascades/geometry.glsl", "data/shaders/shadowCascades/fragment.glsl", defines);
 	if (!m_program.handle)
 	{
 		Fatal("Scene Shadow Mapping Shader failed!");
@@ -128,28 +389,31 @@ bool RPDirectionalLightsShadowMap::initProgram()
 	assert(albedoTextureId > -1);
 	m_hasAlbedoMapId = GetUniformLocation(m_program, "hasAlbedoMap");
 	assert(m_hasAlbedoMapId > -1);
-	m_mvpMatrixId = GetUniformLocation(m_program, "mvpMatrix");
-	assert(m_mvpMatrixId > -1);
+	m_modelMatrixId = GetUniformLocation(m_program, "modelMatrix");
+	assert(m_modelMatrixId > -1);
+	m_cascadeMaskId = GetUniformLocation(m_program, "cascadeMask");
+	assert(m_cascadeMaskId > -1);
+	for (size_t c = 0; c < MaxCascades; c++)
+	{
+		m_cascadeMatrixId[c] = GetUniformLocation(m_program, "cascadeMatrix[" + std::to_string(c) + "]");
+		assert(m_cascadeMatrixId[c] > -1);
+	}
 
-	SetUniform((GLuint)albedoTextureId, 0);
+	SetUniform(albedoTextureId, 0);
 
 	glUseProgram(0); // TODO: возможно вернуть прошлую
 
 	return true;
 }
 //=============================================================================
-bool RPDirectionalLightsShadowMap::initFBO()
+bool RPDirectionalLightsShadowMap::initFBO(Framebuffer& fbo)
 {
 	FramebufferInfo depthFboInfo;
-	depthFboInfo.depthAttachment = DepthAttachment{ .type = AttachmentType::Texture };
+	depthFboInfo.depthAttachment = DepthAttachment{ .type = AttachmentType::TextureArray, .shadowCompare = true };
 	depthFboInfo.width = static_cast<uint16_t>(m_shadowQuality);
 	depthFboInfo.height = static_cast<uint16_t>(m_shadowQuality);
-	for (size_t i = 0; i < m_depthFBO.size(); i++)
-	{
-		if (!m_depthFBO[i].Create(depthFboInfo))
-			return false;
-	}
+	depthFboInfo.layers = static_cast<uint16_t>(m_numCascades);
 
-	return true;
+	return fbo.Create(depthFboInfo);
 }
-//=============================================================================
\ No newline at end of file
+//=============================================================================
@@ -1,6 +1,8 @@
 ﻿#pragma once
 
 #include "Framebuffer.h"
+#include "NanoAABBTree.h"
+#include "NanoShadowScheduler.h"
 
 enum class ShadowQuality 
 {
@@ -15,35 +17,92 @@ enum class ShadowQuality
 
 struct GameWorldDataO;
 
+// Каскадные тени направленного света (PSSM). Пирамида камеры до ShadowDistance делится на каскады, у каждого своя
+// ортографическая проекция по описанной сфере части пирамиды с запасом. Центр проекции в пространстве света стоит в целых текселях
+// по всем трем осям и не двигается, пока сфера не выйдет за запас - тени не дрожат при движении камеры.
+// Все каскады света рисуются за один проход в слои массива глубины: объект рисуется один раз, геометрический шейдер
+// размножает треугольники в слои каскадов, в пирамиды которых объект попал.
+// Статические объекты рисуются в отдельный кэш каскада только при сдвиге его проекции или изменении статики, каждый кадр кэш
+// копируется в карту и поверх рисуются динамические. Каскад, вышедший за запас, перепроецируется сразу,
+// а перерисовка статики верных каскадов идет в бюджете: ближний каждый кадр, дальние по очереди
 class RPDirectionalLightsShadowMap final
 {
 public:
+	static constexpr size_t MaxCascades = 4;
+
 	bool Init(ShadowQuality shadowQuality);
 	void Close();
 
-	void Draw(const GameWorldDataO& worldData);
+	// cameraProjection - перспективная проекция основного прохода, по ней строятся каскады
+	void Draw(const GameWorldDataO& worldData, const glm::mat4& cameraProjection);
 
 	void SetShadowQuality(ShadowQuality quality);
+	void SetNumCascades(size_t numCascades);
 
-	const auto& GetDepthFBO() const { return m_depthFBO; }
-	const auto& GetProjection() const { return m_orthoProjection; }
+	size_t GetNumCascades() const { return m_numCascades; }
+	// дальние границы каскадов по глубине вида камеры
+	const std::array<float, MaxCascades>& GetCascadeSplits() const { return m_cascadeSplits; }
+	// размер текселя каскада в мировых единицах - для смещения по нормали
+	const std::array<float, MaxCascades>& GetCascadeTexelSizes() const { return m_cascadeTexelSizes; }
 
+	// массив глубины со сравнением (sampler2DArrayShadow), слой - каскад
 	void BindDepthTexture(size_t id, unsigned slot) const;
-	const glm::mat4& GetLightSpaceMatrix(size_t id) const { return m_lightSpaceMatrix[id]; }
+	const glm::mat4& GetCascadeMatrix(size_t id, size_t cascade) const { return m_cascadeMatrices[id][cascade]; }
+	// источники и каскады для blinnPhong/lighting.glsl, карта источника i - в текстурный блок firstTextureUnit + i. Программа должна быть активна
+	void SetLightUniforms(ProgramHandle program, const GameWorldDataO& worldData, unsigned firstTextureUnit) const;
 
 private:
+	using CascadeMatrices = std::array<glm::mat4, MaxCascades>;
+
+	// состояние карты источника между кадрами
+	struct LightCache final
+	{
+		CascadeMatrices                     cullMatrices;
+		std::array<glm::ivec3, MaxCascades> origins;   // центры проекций каскадов в пространстве света, в текселях
+		std::array<float, MaxCascades>      extents{}; // половина стороны проекции, при которой посчитан origins
+		glm::vec3                           direction{ 0.0f };
+		uint32_t                            staticVersion{ 0 };
+		uint8_t                             computedMask{ 0 }; // каскады с посчитанной проекцией
+		uint8_t                             reprojectMask{ 0 }; // каскады, которым в этом кадре нужна новая проекция
+		uint8_t                             staticMask{ 0 };   // каскады с верной статикой в m_staticFBO
+		bool                                hasDynamicCasters{ false };
+	};
+
 	bool initProgram();
-	bool initFBO();
-	void drawScene(const glm::mat4& lightSpaceMatrix, const GameWorldDataO& worldData);
+	bool initFBO(Framebuffer& fbo);
+	void resetCache();
+	void computeCascades(const glm::mat4& cameraView, const glm::mat4& cameraProjection);
+	// проекция посчитана для текущего направления и размера, и часть пирамиды камеры не вышла за запас
+	bool isCascadeValid(size_t light, size_t cascade) const;
+	// true - проекция каскада сдвинулась (или посчитана впервые) и его статику нужно перерисовать
+	bool reprojectCascade(size_t light, size_t cascade, const glm::vec3& lightDirection);
+	// объекты в пирамидах каскадов mask с маской каскадов, false - нет ни одного
+	bool collectCasters(const CascadeMatrices& cullMatrices, uint8_t mask, SceneObjects objects, const GameWorldDataO& worldData);
+	void drawCasters(const CascadeMatrices& matrices, const GameWorldDataO& worldData);
 
-	ProgramHandle                                       m_program{ 0 };
-	int                                          m_mvpMatrixId{ -1 };
-	int                                          m_hasAlbedoMapId{ -1 };
+	ProgramHandle                                      m_program{ 0 };
+	int                                                m_modelMatrixId{ -1 };
+	int                                                m_cascadeMaskId{ -1 };
+	std::array<int, MaxCascades>                       m_cascadeMatrixId;
+	int                                                m_hasAlbedoMapId{ -1 };
 
-	ShadowQuality                                m_shadowQuality;
-	float                                        m_orthoDimension;
-	glm::mat4                                    m_orthoProjection; // for directional lights
+	ShadowQuality                                      m_shadowQuality;
+	size_t                                             m_numCascades{ MaxCascades };
 
-	std::array<Framebuffer, MaxDirectionalLight> m_depthFBO;
-	std::array<glm::mat4, MaxDirectionalLight>   m_lightSpaceMatrix;
-};
\ No newline at end of file
+	// части пирамиды камеры в мировых координатах - общие для всех источников
+	std::array<glm::vec3, MaxCascades>                 m_cascadeCenters;
+	std::array<float, MaxCascades>                     m_cascadeRadii{};
+	std::array<float, MaxCascades>                     m_cascadeExtents{}; // половина стороны проекции: радиус и запас
+	std::array<float, MaxCascades>                     m_cascadeSplits{};
+	std::array<float, MaxCascades>                     m_cascadeTexelSizes{};
+
+	std::array<Framebuffer, MaxDirectionalLight>       m_depthFBO;  // создается при первом использовании источника
+	std::array<Framebuffer, MaxDirectionalLight>       m_staticFBO; // только статические объекты
+	std::array<CascadeMatrices, MaxDirectionalLight>   m_cascadeMatrices;
+	std::array<LightCache, MaxDirectionalLight>        m_lightCache;
+	ShadowUpdateScheduler                              m_scheduler; // id - источник * MaxCascades + каскад
+
+	std::vector<uint32_t>                              m_visible;
+	std::vector<uint8_t>                               m_cascadeMask; // по индексу объекта: бит i - объект в пирамиде каскада i
+	std::vector<uint32_t>                              m_casters;
+};
@@ -4,25 +4,47 @@
 #include "NanoLog.h"
 #include "NanoWindow.h"
 //=============================================================================
+namespace
+{
+	constexpr float ZNear = 0.01f;
+	constexpr float ZFar = 1000.0f;
+
+	// 0-4 - текстуры материала, дальше - каскады теней направленных источников и буферы кластеров
+	constexpr unsigned DirLightTextureUnit = 5;
+	constexpr unsigned ClusterLightsTextureUnit = DirLightTextureUnit + MaxDirectionalLight;
+	constexpr unsigned ClusterTableTextureUnit = ClusterLightsTextureUnit + 1;
+	constexpr unsigned ClusterIndicesTextureUnit = ClusterLightsTextureUnit + 2;
+} // namespace
+//=============================================================================
 bool RPMainScene::Init(uint16_t framebufferWidth, uint16_t framebufferHeight)
 {
 	setSize(framebufferWidth, framebufferHeight);
 	if (!initProgram())
 		return false;
+	if (!initDepthProgram())
+		return false;
 	if (!initFBO())
 		return false;
+	if (!m_lightClusters.Init())
+		return false;
 
 	SamplerStateInfo samperCI{};
 	samperCI.minFilter = TextureFilter::Nearest;
 	samperCI.magFilter = TextureFilter::Nearest;
 	m_sampler = CreateSamplerState(samperCI);
 
+	m_depthPrePass.Init();
+
 	return true;
 }
 //=============================================================================
 void RPMainScene::Close()
 {
+	m_depthPrePass.Close();
+	m_lightClusters.Close();
+	m_occlusionDebug.Close();
 	m_fbo.Destroy();
+	glDeleteProgram(m_depthProgram.handle);
 	glDeleteProgram(m_program.handle);
 }
 //=============================================================================
@@ -34,43 +56,77 @@ void RPMainScene::Draw(const RPDirectionalLightsShadowMap& rpShadowMap, const Ga
 	glClearColor(0.3f, 0.4f, 0.9f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	glUseProgram(m_program.handle);
-	SetUniform(m_projectionMatrixId, m_perspective);
-	SetUniform(m_viewMatrixId, gameData.camera->GetViewMatrix());
-	SetUniform(m_camPosId, gameData.camera->Position);
+	const glm::mat4 viewProj = m_perspective * gameData.camera->GetViewMatrix();
+	gameData.objectTree.Cull(Frustum(viewProj), m_visible, CullingView::Camera);
+	if (EnableOcclusionCulling)
+		cullOccluded(gameData, viewProj);
 
-	int textureOffset{ 5 };
-	for (int i = 0; i < gameData.numDirLights; ++i)
+	// перерисовка измеряется в первом проходе, который пишет глубину
+	const uint32_t numPixels = static_cast<uint32_t>(m_framebufferWidth) * m_framebufferHeight;
+	const bool depthPrePass = m_depthPrePass.IsEnabled();
+	glBindSampler(0, m_sampler.handle);
+	if (depthPrePass)
 	{
-		const auto* light = gameData.dirLights[i];
-
-		std::string prefix = "dirLight[" + std::to_string(i) + "].";
-		SetUniform(GetUniformLocation(m_program, prefix + "direction"), light->direction);
-		SetUniform(GetUniformLocation(m_program, prefix + "color"), light->color);
-		SetUniform(GetUniformLocation(m_program, prefix + "depthMap"), textureOffset);
-		SetUniform(GetUniformLocation(m_program, prefix + "lightSpaceMatrix"), rpShadowMap.GetLightSpaceMatrix(i));
-
-		rpShadowMap.BindDepthTexture(i, textureOffset);
-
-		textureOffset++;
+		m_depthPrePass.BeginMeasure();
+		drawDepth(gameData);
+		m_depthPrePass.EndMeasure(numPixels);
 	}
-	SetUniform(GetUniformLocation(m_program, "dirLightCount"), (int)gameData.numDirLights);
 
-	for (int i = 0; i < gameData.numPointLights; ++i)
+	bindFrame(rpShadowMap, gameData);
+	if (depthPrePass)
 	{
-		const auto* light = gameData.pointLights[i];
-
-		std::string prefix = "pointLight[" + std::to_string(i) + "].";
-		SetUniform(GetUniformLocation(m_program, prefix + "position"), light->position);
-		SetUniform(GetUniformLocation(m_program, prefix + "color"), light->color);
+		// глубина уже готова - освещение считается только для видимого фрагмента
+		glDepthFunc(GL_EQUAL);
+		glDepthMask(GL_FALSE);
+		drawOpaque(gameData);
+		glDepthMask(GL_TRUE);
+		glDepthFunc(GL_LESS);
 	}
-	SetUniform(GetUniformLocation(m_program, "pointLightCount"), (int)gameData.numPointLights);
+	else
+	{
+		m_depthPrePass.BeginMeasure();
+		drawOpaque(gameData);
+		m_depthPrePass.EndMeasure(numPixels);
+	}
+	if (collectTransparent(gameData))
+		drawTransparent(gameData);
+	glBindSampler(0, 0);
+}
+//=============================================================================
+void RPMainScene::DrawTransparent(const RPDirectionalLightsShadowMap& rpShadowMap, const GameWorldDataO& gameData)
+{
+	gameData.objectTree.Cull(Frustum(m_perspective * gameData.camera->GetViewMatrix()), m_visible, CullingView::Camera);
+	if (!collectTransparent(gameData))
+		return;
+
+	m_fbo.Bind();
+	glEnable(GL_DEPTH_TEST);
+	glViewport(0, 0, static_cast<int>(m_framebufferWidth), static_cast<int>(m_framebufferHeight));
+
+	bindFrame(rpShadowMap, gameData);
 
 	glBindSampler(0, m_sampler.handle);
-	drawScene(gameData);
+	drawTransparent(gameData);
 	glBindSampler(0, 0);
 }
 //=============================================================================
+void RPMainScene::CollectLights(const GameWorldDataO& gameData, std::vector<ClusteredLight>& lights)
+{
+	lights.clear();
+	for (size_t i = 0; i < gameData.numPointLights; i++)
+	{
+		const PointLight* light = gameData.pointLights[i];
+		const glm::vec3 color = light->color * light->intensity;
+		lights.push_back(ClusteredLight::Point(light->position, color, ClusteredLight::GetRange(color)));
+	}
+	for (size_t i = 0; i < gameData.numSpotLights; i++)
+	{
+		const SpotLight* light = gameData.spotLights[i];
+		const glm::vec3 color = light->color * light->intensity;
+		lights.push_back(ClusteredLight::Spot(light->position, light->direction, color, ClusteredLight::GetRange(color), light->cutOff, light->outerCutOff));
+	}
+}
+//=============================================================================
 void RPMainScene::Resize(uint16_t framebufferWidth, uint16_t framebufferHeight)
 {
 	if (m_framebufferWidth == framebufferWidth && m_framebufferHeight == framebufferHeight)
@@ -79,7 +135,98 @@ void RPMainScene::Resize(uint16_t framebufferWidth, uint16_t framebufferHeight)
 	m_fbo.Resize(m_framebufferWidth, m_framebufferHeight);
 }
 //=============================================================================
-void RPMainScene::drawScene(const GameWorldDataO& gameData)
+void RPMainScene::UpdateLights(const GameWorldDataO& gameData)
+{
+	CollectLights(gameData, m_clusterLights);
+	m_lightClusters.Update(m_clusterLights, gameData.camera->GetViewMatrix(), m_perspective, ZNear, ZFar);
+}
+//=============================================================================
+void RPMainScene::bindFrame(const RPDirectionalLightsShadowMap& rpShadowMap, const GameWorldDataO& gameData)
+{
+	glUseProgram(m_program.handle);
+	SetUniform(m_projectionMatrixId, m_perspective);
+	SetUniform(m_viewMatrixId, gameData.camera->GetViewMatrix());
+	SetUniform(m_camPosId, gameData.camera->Position);
+
+	rpShadowMap.SetLightUniforms(m_program, gameData, DirLightTextureUnit);
+
+	m_lightClusters.Bind(ClusterLightsTextureUnit, ClusterTableTextureUnit, ClusterIndicesTextureUnit);
+	SetUniform(m_clusterTileScaleId, LightClusters::GetTileScale(m_framebufferWidth, m_framebufferHeight));
+	SetUniform(m_clusterDepthParamsId, m_lightClusters.GetDepthParams());
+}
+//=============================================================================
+void RPMainScene::drawDepth(const GameWorldDataO& gameData)
+{
+	glUseProgram(m_depthProgram.handle);
+	SetUniform(m_depthProjectionMatrixId, m_perspective);
+	SetUniform(m_depthViewMatrixId, gameData.camera->GetViewMatrix());
+
+	for (const uint32_t i : m_visible)
+	{
+		const GameObjectO* go = gameData.gameObjects[i];
+		if (go->IsTransparent()) continue;
+
+		SetUniform(m_depthModelMatrixId, go->modelMat);
+		for (const auto& mesh : go->model->GetMeshes())
+		{
+			if (!isMeshVisible(go, mesh, EnableOcclusionCulling))
+				continue;
+
+			// альфа-тест - только у мешей с картой альбедо, остальные идут с ранним тестом глубины
+			const auto& material = mesh.GetPbrMaterial();
+			const Texture2DHandle albedoTex = material ? material->albedoTexture.id : Texture2DHandle{ 0 };
+			SetUniform(m_depthHasAlbedoMapId, IsValid(albedoTex));
+			BindTexture2D(0, albedoTex);
+
+			mesh.Draw(GL_TRIANGLES);
+		}
+	}
+}
+//=============================================================================
+void RPMainScene::drawOpaque(const GameWorldDataO& gameData)
+{
+	for (const uint32_t i : m_visible)
+	{
+		if (!gameData.gameObjects[i]->IsTransparent())
+			drawObject(gameData, i, EnableOcclusionCulling);
+	}
+}
+//=============================================================================
+bool RPMainScene::collectTransparent(const GameWorldDataO& gameData)
+{
+	const glm::mat4 view = gameData.camera->GetViewMatrix();
+	m_transparent.clear();
+	for (const uint32_t i : m_visible)
+	{
+		const GameObjectO* go = gameData.gameObjects[i];
+		if (!go->IsTransparent()) continue;
+		const AABB box = go->GetAABB().GetTransformed(go->modelMat);
+		m_transparent.emplace_back((view * glm::vec4((box.min + box.max) * 0.5f, 1.0f)).z, i);
+	}
+	// дальние первыми: z вида отрицательный
+	std::sort(m_transparent.begin(), m_transparent.end());
+	return !m_transparent.empty();
+}
+//=============================================================================
+void RPMainScene::drawTransparent(const GameWorldDataO& gameData)
+{
+	// смешивание с уже нарисованным, глубина проверяется, но не пишется
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glDepthMask(GL_FALSE);
+
+	for (const auto& [depth, i] : m_transparent)
+	{
+		SetUniform(m_opacityId, gameData.gameObjects[i]->opacity);
+		drawObject(gameData, i, false);
+	}
+	SetUniform(m_opacityId, 1.0f);
+
+	glDepthMask(GL_TRUE);
+	glDisable(GL_BLEND);
+}
+//=============================================================================
+void RPMainScene::drawObject(const GameWorldDataO& gameData, uint32_t index, bool testOcclusion)
 {
 	Texture2DHandle albedoTex{ 0 };
 	Texture2DHandle normalTex{ 0 };
@@ -87,51 +234,72 @@ void RPMainScene::drawScene(const GameWorldDataO& gameData)
 	Texture2DHandle aoTex{ 0 };
 	Texture2DHandle emissiveTex{ 0 };
 
-	for (size_t i = 0; i < gameData.numGameObject; i++)
+	const GameObjectO* go = gameData.gameObjects[index];
+	SetUniform(m_modelMatrixId, go->modelMat);
+
+	const auto& meshes = go->model->GetMeshes();
+	for (const auto& mesh : meshes)
 	{
-		if (!gameData.gameObjects[i] || !gameData.gameObjects[i]->visible)
+		if (!isMeshVisible(go, mesh, testOcclusion))
 			continue;
 
-		SetUniform(m_modelMatrixId, gameData.gameObjects[i]->modelMat);
-
-		const auto& meshes = gameData.gameObjects[i]->model.GetMeshes();
-		for (const auto& mesh : meshes)
+		const auto& material = mesh.GetPbrMaterial();
+		albedoTex.handle = 0;
+		normalTex.handle = 0;
+		metallicRoughnessTex.handle = 0;
+		aoTex.handle = 0;
+		emissiveTex.handle = 0;
+		if (material)
 		{
-			const auto& material = mesh.GetPbrMaterial();
-			albedoTex.handle = 0;
-			normalTex.handle = 0;
-			metallicRoughnessTex.handle = 0;
-			aoTex.handle = 0;
-			emissiveTex.handle = 0;
-			if (material)
-			{
-				albedoTex = material->albedoTexture.id;
-				normalTex = material->normalTexture.id;
-				metallicRoughnessTex = material->metallicRoughnessTexture.id;
-			}
-
-			SetUniform(m_hasAlbedoMapId, IsValid(albedoTex));
-			SetUniform(m_hasNormalMapId, IsValid(normalTex));
-			SetUniform(m_hasMetallicRoughnessMapId, IsValid(metallicRoughnessTex));
-			SetUniform(m_hasAOMapId, IsValid(aoTex));
-			SetUniform(m_hasEmissiveMapId, IsValid(emissiveTex));
+			albedoTex = material->albedoTexture.id;
+			normalTex = material->normalTexture.id;
+			metallicRoughnessTex = material->metallicRoughnessTexture.id;
+		}
 
-			BindTexture2D(0, albedoTex);
-			BindTexture2D(1, normalTex);
-			BindTexture2D(2, metallicRoughnessTex);
-			BindTexture2D(3, aoTex);
-			BindTexture2D(4, emissiveTex);
+		SetUniform(m_hasAlbedoMapId, IsValid(albedoTex));
+		SetUniform(m_hasNormalMapId, IsValid(normalTex));
+		SetUniform(m_hasMetallicRoughnessMapId, IsValid(metallicRoughnessTex));
+		SetUniform(m_hasAOMapId, IsValid(aoTex));
+		SetUniform(m_hasEmissiveMapId, IsValid(emissiveTex));
 
-			mesh.Draw(GL_TRIANGLES);
-		}
+		BindTexture2D(0, albedoTex);
+		BindTexture2D(1, normalTex);
+		BindTexture2D(2, metallicRoughnessTex);
+		BindTexture2D(3, aoTex);
+		BindTexture2D(4, emissiveTex);
+
+		mesh.Draw(GL_TRIANGLES);
 	}
 }
 //=============================================================================
+void RPMainScene::cullOccluded(const GameWorldDataO& gameData, const glm::mat4& viewProj)
+{
+	m_occlusion.Begin(viewProj);
+	for (const uint32_t i : m_visible)
+	{
+		const GameObjectO* go = gameData.gameObjects[i];
+		if (!go->isOccluder) continue;
+		for (const auto& mesh : go->model->GetMeshes())
+			m_occlusion.AddOccluder(mesh, go->modelMat);
+	}
+	m_occlusion.End();
+
+	m_occlusion.Cull(m_visible, [&](uint32_t i) { return gameData.gameObjects[i]->GetAABB().GetTransformed(gameData.gameObjects[i]->modelMat); });
+
+	if (ShowOcclusionBuffer)
+		m_occlusionDebug.Draw(m_occlusion);
+}
+//=============================================================================
+bool RPMainScene::isMeshVisible(const GameObjectO* go, const Mesh& mesh, bool testOcclusion) const
+{
+	return !testOcclusion || go->model->GetMeshes().size() <= 1 || m_occlusion.IsVisible(mesh.GetAABB().GetTransformed(go->modelMat));
+}
+//=============================================================================
 bool RPMainScene::initProgram()
 {
 	const std::vector<std::string> defines = { 
 		std::string("MAX_DIR_LIGHTS ") + std::to_string(MaxDirectionalLight),
-		std::string("MAX_POINT_LIGHTS ") + std::to_string(MaxPointLight),
+		std::string("MAX_CASCADES ") + std::to_string(RPDirectionalLightsShadowMap::MaxCascades),
 
 		std::string("MAX_LIGHTS ") + std::to_string(MaxDirectionalLight /*+ MaxSpotLight + MaxPointLight*/),
 	};
@@ -175,6 +343,15 @@ bool RPMainScene::initProgram()
 	m_camPosId = GetUniformLocation(m_program, "camPos");
 	assert(m_camPosId > -1);
 
+	SetUniform(GetUniformLocation(m_program, "clusterLights"), (int)ClusterLightsTextureUnit);
+	SetUniform(GetUniformLocation(m_program, "clusterTable"), (int)ClusterTableTextureUnit);
+	SetUniform(GetUniformLocation(m_program, "clusterLightIndices"), (int)ClusterIndicesTextureUnit);
+	SetUniform(GetUniformLocation(m_program, "clusterGrid"), glm::ivec3(LightClusters::GridX, LightClusters::GridY, LightClusters::GridZ));
+	m_clusterTileScaleId = GetUniformLocation(m_program, "clusterTileScale");
+	assert(m_clusterTileScaleId > -1);
+	m_clusterDepthParamsId = GetUniformLocation(m_program, "clusterDepthParams");
+	assert(m_clusterDepthParamsId > -1);
+
 
 	m_hasAlbedoMapId = GetUniformLocation(m_program, "hasAlbedoMap");
 	assert(m_hasAlbedoMapId > -1);
@@ -202,7 +379,8 @@ bool RPMainScene::initFBO()
 	fboInfo.colorAttachments[0].dataType = DataType::UnsignedByte;
 
 	fboInfo.depthAttachment = DepthAttachment();
-	fboInfo.depthAttachment->type = AttachmentType::RenderBuffer;
+	fboInfo.depthAttachment->type = AttachmentType::Texture;
+	fboInfo.depthAttachment->stencil = true; // тот же формат, что у G-буфера: отложенный путь копирует его глубину сюда
 
 	fboInfo.width = m_framebufferWidth;
 	fboInfo.height = m_framebufferHeight;
@@ -213,11 +391,37 @@ bool RPMainScene::initFBO()
 	return true;
 }
 //=============================================================================
+bool RPMainScene::initDepthProgram()
+{
+	m_depthProgram = LoadShaderProgram("data/shaders/depthPrePass/vertex.glsl", "data/shaders/depthPrePass/fragment.glsl");
+	if (!m_depthProgram.handle)
+	{
+		Fatal("Scene Depth PrePass Shader failed!");
+		return false;
+	}
+	glUseProgram(m_depthProgram.handle);
+
+	m_depthProjectionMatrixId = GetUniformLocation(m_depthProgram, "projectionMatrix");
+	assert(m_depthProjectionMatrixId > -1);
+	m_depthViewMatrixId = GetUniformLocation(m_depthProgram, "viewMatrix");
+	assert(m_depthViewMatrixId > -1);
+	m_depthModelMatrixId = GetUniformLocation(m_depthProgram, "modelMatrix");
+	assert(m_depthModelMatrixId > -1);
+	m_depthHasAlbedoMapId = GetUniformLocation(m_depthProgram, "hasAlbedoMap");
+	assert(m_depthHasAlbedoMapId > -1);
+	SetUniform(GetUniformLocation(m_depthProgram, "albedoMap"), 0);
+
+	glUseProgram(0);
+
+	return true;
+}
+//=============================================================================
 void RPMainScene::setSize(uint16_t framebufferWidth, uint16_t framebufferHeight)
 {
 	m_framebufferWidth = framebufferWidth;
 	m_framebufferHeight = framebufferHeight;
 	const float aspect = (float)m_framebufferWidth / (float)m_framebufferHeight;
-	m_perspective = glm::perspective(glm::radians(60.0f), aspect, 0.01f, 1000.0f);
+	m_perspective = glm::perspective(glm::radians(60.0f), aspect, ZNear, ZFar);
+	m_occlusion.Resize(OcclusionBuffer::DefaultWidth, static_cast<uint32_t>(OcclusionBuffer::DefaultWidth / aspect));
 }
 //=============================================================================
\ No newline at end of file
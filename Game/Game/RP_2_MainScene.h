@@ -1,9 +1,13 @@
 ﻿#pragma once
 
 #include "Framebuffer.h"
+#include "NanoOcclusion.h"
+#include "NanoClusteredLighting.h"
+#include "NanoDepthPrePass.h"
 
 class RPDirectionalLightsShadowMap;
 struct GameWorldDataO;
+struct GameObjectO;
 
 class RPMainScene final
 {
@@ -13,18 +17,44 @@ public:
 
 	void Resize(uint16_t framebufferWidth, uint16_t framebufferHeight);
 
+	// прямой путь: все объекты, непрозрачные, затем полупрозрачные от дальних к ближним
 	void Draw(const RPDirectionalLightsShadowMap& rpShadowMap, const GameWorldDataO& gameData);
+	// отложенный путь: только полупрозрачные поверх уже освещенного кадра и глубины G-буфера в m_fbo
+	void DrawTransparent(const RPDirectionalLightsShadowMap& rpShadowMap, const GameWorldDataO& gameData);
+
+	// кластеры источников строятся один раз за кадр до проходов, Draw и DrawTransparent их только привязывают
+	void UpdateLights(const GameWorldDataO& gameData);
+
+	// точечные и прожекторы кадра в общем виде для кластеров и объемов отложенного освещения
+	static void CollectLights(const GameWorldDataO& gameData, std::vector<ClusteredLight>& lights);
+
+	// предварительный проход глубины прямого пути для непрозрачных объектов
+	void SetDepthPrePass(DepthPrePassMode mode) { m_depthPrePass.SetMode(mode); }
+	DepthPrePassMode GetDepthPrePass() const { return m_depthPrePass.GetMode(); }
 
 	const Framebuffer& GetFBO() const { return m_fbo; }
+	Framebuffer& GetFBO() { return m_fbo; }
 	GLuint GetFBOId() const { return m_fbo.GetId(); }
 	uint16_t GetWidth() const { return m_framebufferWidth; }
 	uint16_t GetHeight() const { return m_framebufferHeight; }
+	const glm::mat4& GetProjection() const { return m_perspective; }
 
 private:
 	bool initProgram();
+	bool initDepthProgram();
 	bool initFBO();
 	void setSize(uint16_t framebufferWidth, uint16_t framebufferHeight);
-	void drawScene(const GameWorldDataO& gameData);
+	void bindFrame(const RPDirectionalLightsShadowMap& rpShadowMap, const GameWorldDataO& gameData);
+	void drawDepth(const GameWorldDataO& gameData);
+	void drawOpaque(const GameWorldDataO& gameData);
+	// false - в m_visible нет полупрозрачных
+	bool collectTransparent(const GameWorldDataO& gameData);
+	void drawTransparent(const GameWorldDataO& gameData);
+	void drawObject(const GameWorldDataO& gameData, uint32_t index, bool testOcclusion);
+	void cullOccluded(const GameWorldDataO& gameData, const glm::mat4& viewProj);
+	// части больших моделей (уровня) проверяются буфером перекрытия отдельно. Общая проверка для проходов глубины и цвета -
+	// иначе при GL_EQUAL в кадре остаются дыры
+	bool isMeshVisible(const GameObjectO* go, const Mesh& mesh, bool testOcclusion) const;
 
 	uint16_t  m_framebufferWidth{ 0 };
 	uint16_t  m_framebufferHeight{ 0 };
@@ -35,7 +65,8 @@ private:
 	int       m_viewMatrixId{ -1 };
 	int       m_modelMatrixId{ -1 };
 	int       m_camPosId{ -1 };
-
+	int       m_clusterTileScaleId{ -1 };
+	int       m_clusterDepthParamsId{ -1 };
 
 	int       m_hasAlbedoMapId{ -1 };
 	int       m_hasNormalMapId{ -1 };
@@ -44,7 +75,22 @@ private:
 	int       m_hasEmissiveMapId{ -1 };
 	int       m_opacityId{ -1 };
 
+	ProgramHandle    m_depthProgram{ 0 };
+	int       m_depthProjectionMatrixId{ -1 };
+	int       m_depthViewMatrixId{ -1 };
+	int       m_depthModelMatrixId{ -1 };
+	int       m_depthHasAlbedoMapId{ -1 };
+	DepthPrePassSelector m_depthPrePass;
+
 	Framebuffer m_fbo;
 
 	SamplerHandle m_sampler{ 0 };
+
+	std::vector<uint32_t> m_visible;
+	std::vector<std::pair<float, uint32_t>> m_transparent; // глубина вида, объект
+	OcclusionBuffer       m_occlusion;
+	OcclusionDebugView    m_occlusionDebug;
+
+	LightClusters               m_lightClusters;
+	std::vector<ClusteredLight> m_clusterLights;
 };
\ No newline at end of file
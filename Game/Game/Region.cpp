@@ -68,11 +68,11 @@ void Region::Init()
 
 	meshCI[0] = CreateHorizontalQuad();
 
-	model.model.Create(meshCI);
+	model.model = models::Create("region", std::move(meshCI));
 }
 //=============================================================================
 void Region::Close()
 {
-	model.model.Free();
+	model.model.reset();
 }
 //=============================================================================
\ No newline at end of file
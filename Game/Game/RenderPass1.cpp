@@ -82,14 +82,12 @@ void OldRenderPass1::SetShadowQuality(ShadowQuality quality)
 //=============================================================================
 void OldRenderPass1::drawScene(const glm::mat4& lightSpaceMatrix, const GameWorldData& worldData)
 {
-	for (size_t i = 0; i < worldData.numOldGameObject; i++)
+	worldData.objectTree.Cull(Frustum(lightSpaceMatrix), m_visible, CullingView::Shadow);
+	for (const uint32_t i : m_visible)
 	{
-		if (!worldData.oldGameObjects[i] || !worldData.oldGameObjects[i]->visible)
-			continue;
-
 		SetUniform(m_mvpMatrixId, lightSpaceMatrix * worldData.oldGameObjects[i]->modelMat);
 
-		const auto& meshes = worldData.oldGameObjects[i]->model.GetMeshes();
+		const auto& meshes = worldData.oldGameObjects[i]->model->GetMeshes();
 		for (const auto& mesh : meshes)
 		{
 			const auto& material = mesh.GetMaterial();
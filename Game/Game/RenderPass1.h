@@ -48,4 +48,5 @@ private:
 
 	std::array<Framebuffer, MaxDirectionalLight> m_depthFBO;
 	std::array<glm::mat4, MaxDirectionalLight>   m_lightSpaceMatrix;
+	std::vector<uint32_t>                        m_visible;
 };
\ No newline at end of file
@@ -132,14 +132,15 @@ void OldRenderPass2::drawScene(const GameWorldData& gameData)
 
 	// TODO: heightmap textuere
 
-	for (size_t i = 0; i < gameData.numOldGameObject; i++)
-	{
-		if (!gameData.oldGameObjects[i] || !gameData.oldGameObjects[i]->visible)
-			continue;
+	const glm::vec3 cameraPosition = gameData.oldCamera->Position;
+	const float projectionScale = 0.5f * static_cast<float>(m_framebufferHeight) * m_perspective[1][1];
 
+	gameData.objectTree.Cull(Frustum(m_perspective * gameData.oldCamera->GetViewMatrix()), m_visible, CullingView::Camera);
+	for (const uint32_t i : m_visible)
+	{
 		SetUniform(m_modelMatrixId, gameData.oldGameObjects[i]->modelMat);
 
-		const auto& meshes = gameData.oldGameObjects[i]->model.GetMeshes();
+		const auto& meshes = gameData.oldGameObjects[i]->model->GetMeshes();
 		for (const auto& mesh : meshes)
 		{
 			const auto& material = mesh.GetMaterial();
@@ -148,6 +149,11 @@ void OldRenderPass2::drawScene(const GameWorldData& gameData)
 			normalTex.handle = 0;
 			if (material)
 			{
+				const float screenSize = textures::EstimateScreenSize(mesh.GetAABB(), gameData.oldGameObjects[i]->modelMat, cameraPosition, projectionScale);
+				for (const auto& texture : material->diffuseTextures)  textures::RequestScreenSize(texture, screenSize);
+				for (const auto& texture : material->specularTextures) textures::RequestScreenSize(texture, screenSize);
+				for (const auto& texture : material->normalTextures)   textures::RequestScreenSize(texture, screenSize);
+
 				if (!material->diffuseTextures.empty())  diffuseTex = material->diffuseTextures[0].id;
 				if (!material->specularTextures.empty()) specularTex = material->specularTextures[0].id;
 				if (!material->normalTextures.empty())   normalTex = material->normalTextures[0].id;
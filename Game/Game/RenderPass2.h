@@ -44,4 +44,6 @@ private:
 	Framebuffer   m_fbo;
 
 	SamplerHandle m_sampler{ 0 };
+
+	std::vector<uint32_t> m_visible;
 };
\ No newline at end of file
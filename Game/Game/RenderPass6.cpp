@@ -3,7 +3,7 @@
 #include "NanoIO.h"
 #include "NanoOpenGL3Advance.h"
 #include "NanoLog.h"
-#include "NanoRenderMesh.h"
+#include "NanoFullscreenQuad.h"
 //=============================================================================
 bool RenderPass6::Init(uint16_t framebufferWidth, uint16_t framebufferHeight)
 {
@@ -37,24 +37,6 @@ bool RenderPass6::Init(uint16_t framebufferWidth, uint16_t framebufferHeight)
 	if (!m_fbo.Create(fboInfo))
 		return false;
 
-	std::vector<QuadVertex> vertices = {
-		{glm::vec2(-1.0f,  1.0f), glm::vec2(0.0f, 1.0f)},
-		{glm::vec2(-1.0f, -1.0f), glm::vec2(0.0f, 0.0f)},
-		{glm::vec2(1.0f, -1.0f), glm::vec2(1.0f, 0.0f)},
-		{glm::vec2(1.0f, -1.0f), glm::vec2(1.0f, 0.0f)},
-		{glm::vec2(1.0f,  1.0f), glm::vec2(1.0f, 1.0f)},
-		{glm::vec2(-1.0f,  1.0f), glm::vec2(0.0f, 1.0f)},
-	};
-
-	GLuint currentVBO = GetCurrentBuffer(BufferTarget::Array);
-	m_vbo = CreateBuffer(BufferTarget::Array, BufferUsage::StaticDraw, vertices.size() * sizeof(QuadVertex), vertices.data());
-	glGenVertexArrays(1, &m_vao);
-	glBindVertexArray(m_vao);
-	glBindBuffer(GL_ARRAY_BUFFER, m_vbo.handle);
-	QuadVertex::SetVertexAttributes();
-	glBindVertexArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, currentVBO);
-
 	glUseProgram(0);
 
 	return true;
@@ -93,7 +75,6 @@ void RenderPass6::Draw(const Framebuffer* colorFBO, const Framebuffer* SSAOFBO)
 		SSAOFBO->BindColorTexture(0, 2);
 	}
 
-	glBindVertexArray(m_vao);
-	glDrawArrays(GL_TRIANGLES, 0, 6);
+	fullscreenQuad::Draw();
 }
 //=============================================================================
\ No newline at end of file
@@ -90,6 +90,14 @@ void Scene::Draw()
 {
 	updateSize();
 
+	for (size_t i = 0; i < m_maxEnts; i++)
+	{
+		const Entity2* ent = m_entities[i];
+		if (ent->visible && ent->model)
+			m_objectTree.Update(ent, static_cast<uint32_t>(i), ent->GetAABB().GetTransformed(ent->modelMat), ent->isStatic);
+	}
+	m_objectTree.EndUpdate();
+
 	{
 		glEnable(GL_DEPTH_TEST);
 
@@ -225,7 +233,7 @@ void Scene::directionalShadowPass()
 		SetUniform(m_shadowMappingShaderViewMatrixId, lightView);
 
 		// draw scene
-		drawScene(drawScenePass::ShadowMapping);
+		drawScene(drawScenePass::ShadowMapping, m_orthoProjection * lightView);
 	}
 
 	for (int i{ 0 }; i < m_spotLights.size(); ++i)
@@ -254,7 +262,7 @@ void Scene::directionalShadowPass()
 		// draw scene
 		glEnable(GL_CULL_FACE);
 		glCullFace(GL_BACK);
-		drawScene(drawScenePass::ShadowMapping);
+		drawScene(drawScenePass::ShadowMapping, spotProj * lightView);
 	}
 
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -364,14 +372,14 @@ void Scene::colorMultisamplePass()
 		textureOffset++;
 	}
 
-	drawScene(drawScenePass::BlinnPhong);
+	drawScene(drawScenePass::BlinnPhong, m_perspective * m_camera->GetViewMatrix());
 
 	if (m_gridAxis) m_gridAxis->Draw(m_perspective, m_camera->GetViewMatrix());
 
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 //=============================================================================
-void Scene::drawScene(drawScenePass scenePass)
+void Scene::drawScene(drawScenePass scenePass, const glm::mat4& viewProj)
 {
 	GLuint shader = 0;
 	int modelMatrixId = -1;
@@ -391,7 +399,8 @@ void Scene::drawScene(drawScenePass scenePass)
 	ModelDrawInfo drawInfo;
 	drawInfo.bindMaterials = true;
 	drawInfo.mode = GL_TRIANGLES;
-	for (size_t i = 0; i < m_maxEnts; i++)
+	m_objectTree.Cull(Frustum(viewProj), m_visible, scenePass == drawScenePass::ShadowMapping ? CullingView::Shadow : CullingView::Camera);
+	for (const uint32_t i : m_visible)
 	{
 		if (scenePass == drawScenePass::BlinnPhong)
 		{
@@ -402,7 +411,7 @@ void Scene::drawScene(drawScenePass scenePass)
 		if (modelMatrixId >= 0)  SetUniform(modelMatrixId, m_entities[i]->modelMat);
 		if (normalMatrixId >= 0) SetUniform(normalMatrixId, glm::mat3(glm::transpose(glm::inverse(m_entities[i]->modelMat))));
 		glBindSampler(0, m_sampler.handle);
-		m_entities[i]->model.tDraw(drawInfo);
+		m_entities[i]->model->tDraw(drawInfo);
 	}
 }
 //=============================================================================
\ No newline at end of file
@@ -19,11 +19,12 @@ enum class SHADOW_QUALITY
 
 struct Entity2 final
 {
-	const AABB& GetAABB() const noexcept { return model.GetAABB(); }
+	const AABB& GetAABB() const noexcept { return model->GetAABB(); }
 
-	Model     model;
+	ModelRef  model;
 	glm::mat4 modelMat{ glm::mat4(1.0f) };
 	bool      visible{ true };
+	bool      isStatic{ false }; // не двигается - попадает в статическое дерево культинга
 };
 
 class Scene final
@@ -55,7 +56,7 @@ private:
 	void updateSize();
 	void directionalShadowPass();
 	void colorMultisamplePass();
-	void drawScene(drawScenePass scenePass);
+	void drawScene(drawScenePass scenePass, const glm::mat4& viewProj);
 
 	//GLState                       m_state;
 
@@ -80,6 +81,8 @@ private:
 
 	std::vector<Entity2*>         m_entities;
 	size_t                        m_maxEnts{ 0 };
+	SceneTree                     m_objectTree; // видимые сущности кадра, id - индекс в m_entities
+	std::vector<uint32_t>         m_visible;
 
 	std::vector<DirectionalLightO> m_directionalLights;
 	std::vector<SpotLightO>        m_spotLights;
@@ -36,6 +36,7 @@ namespace
 
 	GameCamera cameraGame;
 	GameModel modelLevel;
+	GameModel modelBoxField; // экземпляры, отсекаются на GPU
 	GameDirectionalLight* directionalLight;
 	GamePointLight* pointLight1;
 	GamePointLight* pointLight2;
@@ -49,6 +50,8 @@ void GameApp()
 	{
 		if (!engine::Init(1600, 900, "Game"))
 			return;
+		// подробные мипы грузит RenderPass2 по экранному размеру мешей
+		textures::EnableStreaming(true);
 
 		scene.Init();
 
@@ -58,6 +61,23 @@ void GameApp()
 
 		modelLevel.LoadModel("data/models/ForgottenPlains/Forgotten_Plains_Demo.obj");
 		modelLevel.SetPosition(glm::vec3(-30.0f, 0.0f, 15.0f));
+		modelLevel.GetData().isStatic = true;
+
+		modelBoxField.GetData().model = models::CreateBox();
+		{
+			constexpr int FieldSize = 100;
+			std::vector<glm::mat4> transforms;
+			transforms.reserve(FieldSize * FieldSize);
+			for (int z = 0; z < FieldSize; z++)
+			{
+				for (int x = 0; x < FieldSize; x++)
+				{
+					const glm::vec3 position(-75.0f + x * 1.5f, 0.25f, -5.0f - z * 1.5f);
+					transforms.push_back(glm::scale(glm::translate(glm::mat4(1.0f), position), glm::vec3(0.5f)));
+				}
+			}
+			modelBoxField.SetInstances(transforms);
+		}
 
 		directionalLight = new GameDirectionalLight(glm::vec3(-5.0f, -5.0f, 5.0f), glm::vec3(1.0f, 0.8f, 0.8f), 2.0f);
 		directionalLight->SetPosition(glm::vec3(-5.0f, -5.0f, 5.0f));
@@ -77,6 +97,7 @@ void GameApp()
 				if (input::IsKeyDown(RGFW_s)) camera.ProcessKeyboard(CameraBackward, engine::GetDeltaTime());
 				if (input::IsKeyDown(RGFW_a)) camera.ProcessKeyboard(CameraLeft, engine::GetDeltaTime());
 				if (input::IsKeyDown(RGFW_d)) camera.ProcessKeyboard(CameraRight, engine::GetDeltaTime());
+				if (input::IsKeyPressed(RGFW_F6)) scene.SetDepthPrePass(static_cast<DepthPrePassMode>((static_cast<int>(scene.GetDepthPrePass()) + 1) % (static_cast<int>(DepthPrePassMode::Auto) + 1)));
 
 				if (input::IsMouseDown(RGFW_mouseRight))
 				{
@@ -91,6 +112,7 @@ void GameApp()
 
 			scene.Bind(&cameraGame);
 			scene.Bind(&modelLevel);
+			scene.Bind(&modelBoxField);
 			scene.Bind(directionalLight);
 			scene.Bind(pointLight1);
 			scene.Bind(pointLight2);
@@ -108,6 +130,7 @@ void GameApp()
 	{
 		puts(exc.what());
 	}
+	modelBoxField.Close();
 	engine::Close();
 }
 //=============================================================================
\ No newline at end of file
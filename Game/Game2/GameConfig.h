@@ -4,6 +4,18 @@ inline float ScaleScreen = 1.0f;
 
 inline bool EnableSSAO = false;
 
+// тени: статические модели кэшируются и перерисовываются только при их изменении или сдвиге света.
+// Точечные источники ближе ShadowUpdateDistance к камере обновляются каждый кадр, дальние - не больше ShadowUpdateBudget за кадр по очереди
+inline bool EnableShadowCache = true;
+inline size_t ShadowUpdateBudget = 2;
+inline float ShadowUpdateDistance = 20.0f;
+// все карты теней - тайлы одного атласа. Наименьший тайл - для далеких точечных источников и при нехватке места
+constexpr unsigned ShadowAtlasSize = 4096u;
+constexpr unsigned ShadowAtlasMinTile = 64u;
+// точечные источники с тайлом грани не больше ParaboloidShadowMaxTile рисуют тень в два параболоида вместо шести граней куба
+inline bool EnableParaboloidShadows = true;
+inline unsigned ParaboloidShadowMaxTile = 128u;
+
 constexpr size_t MaxLights = 16u;
 
 constexpr size_t MaxDirectionalLight = 4u;
@@ -3,12 +3,39 @@
 //=============================================================================
 bool GameModel::LoadModel(const std::string& fileName)
 {
-	if (!m_data.model.Load(fileName, ModelMaterialType::BlinnPhong))
+	m_data.model = models::Load(fileName, ModelMaterialType::BlinnPhong);
+	if (!m_data.model)
 		return false;
 
 	return true;
 }
 //=============================================================================
+bool GameModel::SetInstances(std::span<const glm::mat4> transforms)
+{
+	assert(m_data.model);
+
+	if (m_instances.GetMaxInstances() < transforms.size())
+	{
+		m_instances.Close();
+		if (!m_instances.Init(transforms.size()))
+			return false;
+	}
+	m_instances.SetInstances(transforms);
+
+	m_instancesBounds = AABB();
+	for (const auto& transform : transforms)
+		m_instancesBounds.CombineAABB(m_data.model->GetAABB().GetTransformed(transform));
+
+	m_data.isInstancedModel = true;
+	return true;
+}
+//=============================================================================
+void GameModel::Close()
+{
+	m_instances.Close();
+	m_data.isInstancedModel = false;
+}
+//=============================================================================
 void GameModel::SetupParameters(ProgramHandle program)
 {
 	switch (m_data.faceVisibility)
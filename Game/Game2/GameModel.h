@@ -17,7 +17,7 @@ enum class FaceVisibility : uint8_t
 
 struct GameModelData final
 {
-	Model          model;
+	ModelRef       model;
 
 	glm::vec3      diffuseColor{ 1.0f };
 	float          specularity{ 1.0f };
@@ -27,9 +27,10 @@ struct GameModelData final
 	float          tileV{ 1.0f };
 	
 	bool           visible{ true };
+	bool           isStatic{ false }; //   -     
 	bool           castShadows{ true };
 	bool           receiveShadows{ true };
-	bool           isInstancedModel{ false };
+	bool           isInstancedModel{ false }; //  SetInstances:   ,     
 
 	bool           alphaTest{ false };
 	bool           transparency{ false };
@@ -50,8 +51,18 @@ public:
 
 	void SetupParameters(ProgramHandle program);
 
+	//   ,    .   GPU,     .
+	//    .   OpenGL,   Close
+	bool SetInstances(std::span<const glm::mat4> transforms);
+	void Close();
+
 	GameModelData& GetData() { return m_data; }
+	GPUInstanceCulling& GetInstances() { return m_instances; }
+	//    
+	const AABB& GetInstancesBounds() const { return m_instancesBounds; }
 
 private:
-	GameModelData m_data;
+	GameModelData      m_data;
+	GPUInstanceCulling m_instances;
+	AABB               m_instancesBounds;
 };
\ No newline at end of file
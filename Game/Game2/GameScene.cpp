@@ -131,6 +131,15 @@ void GameScene::beginDraw()
 
 	m_rpMainScene.Resize(wndWidth * ScaleScreen, wndHeight * ScaleScreen);
 	m_rpComposite.Resize(wndWidth, wndHeight);
+
+	for (size_t i = 0; i < m_data.countGameModels; i++)
+	{
+		GameModel* model = m_data.gameModels[i];
+		// экземпляры отсекаются на GPU, в дереве их нет
+		if (model && model->GetData().visible && model->GetData().model && model->IsActive() && !model->GetData().isInstancedModel)
+			m_data.objectTree.Update(model, static_cast<uint32_t>(i), model->GetData().model->GetAABB().GetTransformed(model->GetTransform()->GetWorldMatrix()), model->GetData().isStatic);
+	}
+	m_data.objectTree.EndUpdate();
 }
 //=============================================================================
 void GameScene::draw()
@@ -146,7 +155,7 @@ void GameScene::draw()
 	// 1.) Render Pass: render depth of scene to texture (from light's perspective)
 	if (m_data.countGameDirectionalLights > 0 || m_data.countGamePointLights > 0)
 	{
-		m_shadowMap.RenderShadows(m_data);
+		m_shadowMap.RenderShadows(m_data, m_rpMainScene.GetProjection());
 	}
 
 	//================================================================================
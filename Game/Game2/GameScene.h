@@ -22,6 +22,9 @@ public:
 	void Bind(GameDirectionalLight* go);
 	void Bind(GamePointLight* go);
 
+	void SetDepthPrePass(DepthPrePassMode mode) { m_rpMainScene.SetDepthPrePass(mode); }
+	DepthPrePassMode GetDepthPrePass() const { return m_rpMainScene.GetDepthPrePass(); }
+
 
 
 	// OLD
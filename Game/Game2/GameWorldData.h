@@ -80,6 +80,8 @@ struct GameWorldData final
 	size_t                             countGameDirectionalLights{ 0 };
 	std::vector<GamePointLight*>       gamePointLights;
 	size_t                             countGamePointLights{ 0 };
+	// видимые модели кадра в деревьях AABB (id - индекс в gameModels). Обновляются в начале кадра, общие для всех видов
+	SceneTree                          objectTree;
 
 	// old
 	Camera*                          oldCamera{ nullptr };
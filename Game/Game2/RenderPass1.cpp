@@ -6,6 +6,7 @@ bool RenderPass1::Init(ShadowQuality shadowQuality)
 {
 	m_shadowQuality = shadowQuality;
 	m_pointLightProj = glm::perspective(glm::radians(90.0f), 1.0f, 1.0f, m_shadowFarPlane);
+	m_atlas.Init(ShadowAtlasSize, ShadowAtlasMinTile);
 
 	if (!initProgram())
 		return false;
@@ -22,96 +23,348 @@ void RenderPass1::Close()
 		glDeleteProgram(m_programDirLight.handle);
 	if (m_programPointLight.handle)
 		glDeleteProgram(m_programPointLight.handle);
-
-	for (size_t i = 0; i < m_depthFBODirLights.size(); i++)
-	{
-		m_depthFBODirLights[i].Destroy();
-	}
-
-	for (size_t i = 0; i < m_depthFBOPointLights.size(); i++)
-	{
-		m_depthFBOPointLights[i].Destroy();
-	}
+	if (m_atlasUBO.handle)
+		glDeleteBuffers(1, &m_atlasUBO.handle);
+	m_atlasUBO = { 0 };
+
+	m_atlasFBO.Destroy();
+	m_staticAtlasFBO.Destroy();
+	resetTiles();
+	resetCache();
 }
 //=============================================================================
-void RenderPass1::RenderShadows(const GameWorldData& worldData)
+void RenderPass1::RenderShadows(const GameWorldData& worldData, const glm::mat4& cameraProjection)
 {
 	if (m_shadowQuality == ShadowQuality::Off) return;
 
 	size_t numDirLights = worldData.countGameDirectionalLights;
-	if (numDirLights >= m_depthFBODirLights.size())
+	if (numDirLights >= MaxDirectionalLight)
 	{
 		Warning("Num Dir Light bigger num");
-		numDirLights = m_depthFBODirLights.size() - 1;
+		numDirLights = MaxDirectionalLight - 1;
 	}
 	size_t numPointLights = worldData.countGamePointLights;
-	if (numPointLights >= m_depthFBOPointLights.size())
+	if (numPointLights >= MaxPointLight)
 	{
 		Warning("Num Point Light bigger num");
-		numPointLights = m_depthFBOPointLights.size() - 1;
+		numPointLights = MaxPointLight - 1;
+	}
+
+	// тайлы атласа. Сначала освобождаются тайлы выключенных источников и сменивших размер, потом выделяются новые -
+	// направленным первыми, им нужен наибольший тайл
+	const glm::vec3 cameraPosition = worldData.activeCamera ? worldData.activeCamera->GetPosition() : glm::vec3(0.0f);
+	const uint32_t maxDirLightTile = std::min(static_cast<uint32_t>(m_shadowQuality), ShadowAtlasSize / 2);
+	for (size_t i = 0; i < MaxDirectionalLight; i++)
+	{
+		auto* light = i < numDirLights ? worldData.gameDirectionalLights[i] : nullptr;
+		const bool active = light && light->GetCastShadows() && light->IsActive();
+		requestTiles(m_dirLightTiles[i], active ? maxDirLightTile : 0);
+	}
+	for (size_t i = 0; i < MaxPointLight; i++)
+	{
+		auto* light = i < numPointLights ? worldData.gamePointLights[i] : nullptr;
+		const bool active = light && light->GetCastShadows() && light->IsActive();
+		requestTiles(m_pointLightTiles[i], active ? getPointLightTileSize(light, cameraPosition, cameraProjection) : 0);
+	}
+	// новый тайл пуст - карта рисуется заново, в том числе статика
+	for (size_t i = 0; i < MaxDirectionalLight; i++)
+	{
+		if (allocateTiles(m_dirLightTiles[i], 1, m_dirLightTiles[i].requestedSize))
+			m_dirLightCache[i] = {};
+	}
+	for (size_t i = 0; i < MaxPointLight; i++)
+	{
+		// маленькому тайлу точности куба не нужно - два параболоида вдвое большего размера вместо шести граней
+		ShadowTiles& tiles = m_pointLightTiles[i];
+		const bool paraboloid = EnableParaboloidShadows && tiles.requestedSize <= ParaboloidShadowMaxTile;
+		if (tiles.numRects != 0 && tiles.IsParaboloid() != paraboloid)
+			freeTiles(tiles);
+		if (allocateTiles(tiles, paraboloid ? 2 : 6, paraboloid ? tiles.requestedSize * 2 : tiles.requestedSize))
+			m_pointLightCache[i] = {};
+	}
+
+	// направленный свет и точечные рядом с камерой - каждый кадр, дальние - по очереди, чаще более близкие.
+	// Сдвинувшийся источник или еще не нарисованная карта обновляются сразу
+	m_scheduler.Begin(ShadowUpdateBudget);
+	for (size_t i = 0; i < numDirLights; i++)
+	{
+		if (!HasDirLightShadow(i)) continue;
+
+		m_scheduler.Add(static_cast<uint32_t>(i), 1.0f);
 	}
+	for (size_t i = 0; i < numPointLights; i++)
+	{
+		auto* light = worldData.gamePointLights[i];
+		if (!HasPointLightShadow(i)) continue;
+
+		const ShadowCache& cache = m_pointLightCache[i];
+		const bool moved = !cache.rendered || cache.lightMatrix != glm::translate(glm::mat4(1.0f), light->GetPosition());
+		const float distance = glm::distance(cameraPosition, light->GetPosition());
+		m_scheduler.Add(static_cast<uint32_t>(MaxDirectionalLight + i), ShadowUpdateDistance / std::max(distance, 0.001f), moved);
+	}
+	m_scheduler.Schedule();
 
 	glEnable(GL_DEPTH_TEST);
 	glEnable(GL_CULL_FACE);
 	glCullFace(GL_BACK);
-	glViewport(0, 0, static_cast<int>(m_shadowQuality), static_cast<int>(m_shadowQuality));
 
 	glUseProgram(m_programDirLight.handle);
 	for (size_t i = 0; i < numDirLights; i++)
 	{
 		auto* light = worldData.gameDirectionalLights[i];
-		if (!light || !light->GetCastShadows() || !light->IsActive()) continue;
+		if (!m_scheduler.IsScheduled(static_cast<uint32_t>(i))) continue;
 
-		m_depthFBODirLights[i].Bind();
-		glClear(GL_DEPTH_BUFFER_BIT);
-
-		drawScene(light, worldData);
+		renderShadowMap(light, light->GetLightTransformMatrix(), m_dirLightTiles[i].GetRects(), m_dirLightCache[i], worldData);
 	}
 
 	glUseProgram(m_programPointLight.handle);
 	for (size_t i = 0; i < numPointLights; i++)
 	{
 		auto* light = worldData.gamePointLights[i];
-		if (!light || !light->GetCastShadows() || !light->IsActive()) continue;
+		if (!m_scheduler.IsScheduled(static_cast<uint32_t>(MaxDirectionalLight + i))) continue;
 
-		m_depthFBOPointLights[i].Bind();
-		glClear(GL_DEPTH_BUFFER_BIT);
+		renderShadowMap(light, glm::translate(glm::mat4(1.0f), light->GetPosition()), m_pointLightTiles[i].GetRects(), m_pointLightCache[i], worldData);
+	}
+
+	// матрицы и тайлы всех источников с тенью, в том числе не обновлявшихся в этом кадре
+	for (size_t i = 0; i < MaxDirectionalLight; i++)
+	{
+		if (!HasDirLightShadow(i)) continue;
+
+		m_atlasData.dirLightViewProj[i] = worldData.gameDirectionalLights[i]->GetLightTransformMatrix();
+		m_atlasData.dirLightAtlasRect[i] = m_atlas.GetScaleBiasUV(m_dirLightTiles[i].rects[0]);
+	}
+	for (size_t i = 0; i < MaxPointLight; i++)
+	{
+		if (!HasPointLightShadow(i)) continue;
 
-		drawScene(light, worldData);
+		getPointLightFaceMatrices(worldData.gamePointLights[i]->GetPosition(), &m_atlasData.pointLightFaceViewProj[i * 6]);
+		for (size_t face = 0; face < m_pointLightTiles[i].numRects; face++)
+			m_atlasData.pointLightAtlasRect[i * 6 + face] = m_atlas.GetScaleBiasUV(m_pointLightTiles[i].rects[face]);
+		m_atlasData.pointLightShadowParams[i].x = m_pointLightTiles[i].IsParaboloid() ? 1.0f : 0.0f;
 	}
+	BufferSubData(m_atlasUBO, BufferTarget::Uniform, 0, sizeof(ShadowAtlasData), &m_atlasData);
 }
 //=============================================================================
 void RenderPass1::SetShadowQuality(ShadowQuality quality)
 {
 	if (m_shadowQuality == quality) return;
 
+	// наибольший размер тайла изменился - тайлы выделяются заново
 	m_shadowQuality = quality;
-	if (m_shadowQuality != ShadowQuality::Off)
+	resetTiles();
+	resetCache();
+}
+//=============================================================================
+void RenderPass1::BindShadowAtlas(unsigned slot) const
+{
+	m_atlasFBO.BindDepthTexture(slot);
+	glBindBufferBase(GL_UNIFORM_BUFFER, ShadowAtlasBinding, m_atlasUBO.handle);
+}
+//=============================================================================
+void RenderPass1::resetCache()
+{
+	m_dirLightCache.fill({});
+	m_pointLightCache.fill({});
+	m_scheduler.Reset();
+}
+//=============================================================================
+void RenderPass1::resetTiles()
+{
+	m_atlas.Clear();
+	m_dirLightTiles.fill({});
+	m_pointLightTiles.fill({});
+}
+//=============================================================================
+void RenderPass1::requestTiles(ShadowTiles& tiles, uint32_t size)
+{
+	// небольшие изменения размера не перераспределяют тайл: уменьшение - только вчетверо
+	if (size == tiles.requestedSize) return;
+	if (size != 0 && tiles.requestedSize != 0 && size < tiles.requestedSize && size * 4 > tiles.requestedSize) return;
+
+	freeTiles(tiles);
+	tiles.requestedSize = size;
+}
+//=============================================================================
+bool RenderPass1::allocateTiles(ShadowTiles& tiles, uint32_t numRects, uint32_t size)
+{
+	if (tiles.requestedSize == 0 || tiles.numRects != 0) return false;
+
+	for (size = std::min(size, ShadowAtlasSize); size >= ShadowAtlasMinTile; size /= 2)
 	{
-		for (size_t i = 0; i < m_depthFBODirLights.size(); i++)
-			m_depthFBODirLights[i].Resize(static_cast<uint16_t>(m_shadowQuality), static_cast<uint16_t>(m_shadowQuality));
+		uint32_t numAllocated = 0;
+		while (numAllocated < numRects && m_atlas.Allocate(size, tiles.rects[numAllocated]))
+			numAllocated++;
+		if (numAllocated == numRects)
+		{
+			tiles.numRects = numRects;
+			return true;
+		}
 
-		for (size_t i = 0; i < m_depthFBOPointLights.size(); i++)
-			m_depthFBOPointLights[i].Resize(static_cast<uint16_t>(m_shadowQuality), static_cast<uint16_t>(m_shadowQuality));
+		freeTiles(tiles);
 	}
+	return false;
+}
+//=============================================================================
+void RenderPass1::freeTiles(ShadowTiles& tiles)
+{
+	for (const auto& rect : tiles.rects)
+		m_atlas.Free(rect);
+	tiles.rects.fill({});
+	tiles.numRects = 0;
+}
+//=============================================================================
+uint32_t RenderPass1::getPointLightTileSize(GamePointLight* light, const glm::vec3& cameraPosition, const glm::mat4& cameraProjection) const
+{
+	// доля половины высоты экрана, которую занимает сфера влияния источника
+	const float radius = std::min(light->GetAreaOfInfluence(), m_shadowFarPlane);
+	const float distance = std::max(glm::distance(cameraPosition, light->GetPosition()), 0.001f);
+	const float coverage = radius * cameraProjection[1][1] / distance;
+
+	const uint32_t maxTile = std::min(static_cast<uint32_t>(m_shadowQuality), ShadowAtlasSize / 4);
+	const uint32_t size = std::bit_ceil(static_cast<uint32_t>(std::min(coverage, 1.0f) * static_cast<float>(maxTile)));
+	return std::clamp(size, ShadowAtlasMinTile, maxTile);
 }
 //=============================================================================
-void RenderPass1::drawScene(GameDirectionalLight* currentLight, const GameWorldData& worldData)
+void RenderPass1::getPointLightFaceMatrices(const glm::vec3& position, glm::mat4* matrices) const
 {
-	for (size_t i = 0; i < worldData.countGameModels; i++)
+	matrices[0] = m_pointLightProj * glm::lookAt(position, position + glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f));
+	matrices[1] = m_pointLightProj * glm::lookAt(position, position + glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f));
+	matrices[2] = m_pointLightProj * glm::lookAt(position, position + glm::vec3( 0.0f,  1.0f,  0.0f), glm::vec3(0.0f,  0.0f,  1.0f));
+	matrices[3] = m_pointLightProj * glm::lookAt(position, position + glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f, -1.0f));
+	matrices[4] = m_pointLightProj * glm::lookAt(position, position + glm::vec3( 0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f,  0.0f));
+	matrices[5] = m_pointLightProj * glm::lookAt(position, position + glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f));
+}
+//=============================================================================
+void RenderPass1::clearTiles(std::span<const ShadowAtlasRect> tiles) const
+{
+	glEnable(GL_SCISSOR_TEST);
+	for (const auto& tile : tiles)
 	{
-		if (!worldData.gameModels[i] || !worldData.gameModels[i]->GetData().visible)
-			continue;
-		if (!worldData.gameModels[i]->IsActive())
-			continue;
-		if (!worldData.gameModels[i]->GetData().castShadows)
-			continue;
+		glScissor(tile.x, tile.y, tile.size, tile.size);
+		glClear(GL_DEPTH_BUFFER_BIT);
+	}
+	glDisable(GL_SCISSOR_TEST);
+}
+//=============================================================================
+template<typename T>
+void RenderPass1::renderShadowMap(T* light, const glm::mat4& lightMatrix, std::span<const ShadowAtlasRect> tiles, ShadowCache& cache, const GameWorldData& worldData)
+{
+	const uint32_t staticVersion = worldData.objectTree.GetStaticVersion();
+	if (!cache.rendered || cache.lightMatrix != lightMatrix || cache.staticVersion != staticVersion)
+		cache.hasStatic = false;
+	cache.lightMatrix = lightMatrix;
+	cache.staticVersion = staticVersion;
+	cache.rendered = true;
+
+	const uint8_t allFaces = static_cast<uint8_t>((1u << tiles.size()) - 1);
+	if (!EnableShadowCache)
+	{
+		m_atlasFBO.Bind();
+		clearTiles(tiles);
+		if (cullCasters(light, tiles, worldData, SceneObjects::All))
+			drawCasters(light, tiles, allFaces, worldData);
+		cache.hasStatic = false;
+		return;
+	}
 
-		glm::mat4 lightSpaceMatrix = currentLight->GetLightTransformMatrix();
+	// статический атлас повторяет раскладку основного, у источника там те же тайлы
+	const bool rebuildStatic = !cache.hasStatic;
+	if (rebuildStatic)
+	{
+		if (!m_staticAtlasFBO.GetId() && !createAtlasFBO(m_staticAtlasFBO)) return;
 
+		m_staticAtlasFBO.Bind();
+		clearTiles(tiles);
+		if (cullCasters(light, tiles, worldData, SceneObjects::Static))
+			drawCasters(light, tiles, allFaces, worldData);
+		cache.hasStatic = true;
+	}
+
+	// динамические модели - поверх копии статики. Грань, где их нет ни сейчас, ни в прошлый раз, при неизменной статике уже верна
+	const uint8_t dynamicFaces = cullCasters(light, tiles, worldData, SceneObjects::Dynamic);
+	const uint8_t dirtyFaces = rebuildStatic ? allFaces : static_cast<uint8_t>(dynamicFaces | cache.dynamicFaces);
+	if (dirtyFaces)
+	{
+		for (size_t face = 0; face < tiles.size(); face++)
+		{
+			if (dirtyFaces & (1u << face))
+				m_atlasFBO.CopyDepth(m_staticAtlasFBO, tiles[face].x, tiles[face].y, tiles[face].size, tiles[face].size);
+		}
+		drawCasters(light, tiles, dirtyFaces, worldData);
+	}
+	cache.dynamicFaces = dynamicFaces;
+}
+//=============================================================================
+uint8_t RenderPass1::cullCasters(GameDirectionalLight* currentLight, std::span<const ShadowAtlasRect> /*tiles*/, const GameWorldData& worldData, SceneObjects objects)
+{
+	worldData.objectTree.Cull(Frustum(currentLight->GetLightTransformMatrix()), m_visible, CullingView::Shadow, objects);
+	std::erase_if(m_visible, [&](uint32_t i) { return !worldData.gameModels[i]->GetData().castShadows; });
+	m_visibleFaces.assign(m_visible.size(), 1);
+	return m_visible.empty() ? 0 : 1;
+}
+//=============================================================================
+uint8_t RenderPass1::cullCasters(GamePointLight* currentLight, std::span<const ShadowAtlasRect> tiles, const GameWorldData& worldData, SceneObjects objects)
+{
+	// все грани - в сфере дальности тени
+	const glm::vec3 lightPosition = currentLight->GetPosition();
+	worldData.objectTree.Cull(lightPosition, m_shadowFarPlane, m_visible, CullingView::Shadow, objects);
+
+	// грани, которые задевает бокс модели: пирамиды граней куба или полусферы -Y/+Y параболоида
+	const bool paraboloid = tiles.size() == 2;
+	Frustum faceFrustums[6];
+	if (!paraboloid)
+	{
+		glm::mat4 faceMatrices[6];
+		getPointLightFaceMatrices(lightPosition, faceMatrices);
+		for (size_t face = 0; face < 6; face++)
+			faceFrustums[face].Set(faceMatrices[face]);
+	}
+
+	m_visibleFaces.resize(m_visible.size());
+	size_t numVisible = 0;
+	uint8_t allFaces = 0;
+	for (const uint32_t i : m_visible)
+	{
+		if (!worldData.gameModels[i]->GetData().castShadows) continue;
+
+		const AABB box = worldData.gameModels[i]->GetData().model->GetAABB().GetTransformed(worldData.gameModels[i]->GetTransform()->GetWorldMatrix());
+		uint8_t faces = 0;
+		if (paraboloid)
+		{
+			if (box.min.y < lightPosition.y) faces |= 1;
+			if (box.max.y > lightPosition.y) faces |= 2;
+		}
+		else
+		{
+			for (size_t face = 0; face < 6; face++)
+			{
+				if (faceFrustums[face].IsVisible(box))
+					faces |= static_cast<uint8_t>(1u << face);
+			}
+		}
+		if (!faces) continue;
+
+		m_visible[numVisible] = i;
+		m_visibleFaces[numVisible] = faces;
+		numVisible++;
+		allFaces |= faces;
+	}
+	m_visible.resize(numVisible);
+	m_visibleFaces.resize(numVisible);
+	return allFaces;
+}
+//=============================================================================
+void RenderPass1::drawCasters(GameDirectionalLight* currentLight, std::span<const ShadowAtlasRect> tiles, uint8_t /*faces*/, const GameWorldData& worldData)
+{
+	const glm::mat4 lightSpaceMatrix = currentLight->GetLightTransformMatrix();
+	glViewport(tiles[0].x, tiles[0].y, tiles[0].size, tiles[0].size);
+
+	for (const uint32_t i : m_visible)
+	{
 		SetUniform(m_dirLightMvpMatrixId, lightSpaceMatrix * worldData.gameModels[i]->GetTransform()->GetWorldMatrix());
 
-		const auto& meshes = worldData.gameModels[i]->GetData().model.GetMeshes();
+		const auto& meshes = worldData.gameModels[i]->GetData().model->GetMeshes();
 		for (const auto& mesh : meshes)
 		{
 			drawMesh(mesh, m_dirLightHasDiffuseMapId);
@@ -119,43 +372,48 @@ void RenderPass1::drawScene(GameDirectionalLight* currentLight, const GameWorldD
 	}
 }
 //=============================================================================
-void RenderPass1::drawScene(GamePointLight* currentLight, const GameWorldData& worldData)
+void RenderPass1::drawCasters(GamePointLight* currentLight, std::span<const ShadowAtlasRect> tiles, uint8_t faces, const GameWorldData& worldData)
 {
 	const auto& lpos = currentLight->GetPosition();
-	glm::mat4 shadowTransforms[] =
-	{
-		m_pointLightProj * glm::lookAt(lpos, lpos + glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-		m_pointLightProj * glm::lookAt(lpos, lpos + glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-		m_pointLightProj * glm::lookAt(lpos, lpos + glm::vec3( 0.0f,  1.0f,  0.0f), glm::vec3(0.0f,  0.0f,  1.0f)),
-		m_pointLightProj * glm::lookAt(lpos, lpos + glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f, -1.0f)),
-		m_pointLightProj * glm::lookAt(lpos, lpos + glm::vec3( 0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-		m_pointLightProj * glm::lookAt(lpos, lpos + glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f))
-	};
-
-	for (size_t i = 0; i < 6; i++)
+	const bool paraboloid = tiles.size() == 2;
+	if (!paraboloid)
 	{
-		SetUniform(m_pointLightCubeMatricesId[i], shadowTransforms[i]);
+		glm::mat4 shadowTransforms[6];
+		getPointLightFaceMatrices(lpos, shadowTransforms);
+		for (size_t i = 0; i < 6; i++)
+			SetUniform(m_pointLightCubeMatricesId[i], shadowTransforms[i]);
 	}
+
+	// все грани за один проход: геометрический шейдер переносит каждую грань в свой тайл, края грани отсекаются clip distance
+	for (size_t i = 0; i < tiles.size(); i++)
+		SetUniform(m_pointLightFaceRectsId[i], m_atlas.GetScaleBiasNDC(tiles[i]));
+	SetUniform(m_pointLightParaboloidId, paraboloid);
 	SetUniform(m_pointLightLightPosId, lpos);
 	SetUniform(m_pointLightFarPlaneId, m_shadowFarPlane);
 
-	for (size_t i = 0; i < worldData.countGameModels; i++)
+	glViewport(0, 0, static_cast<int>(ShadowAtlasSize), static_cast<int>(ShadowAtlasSize));
+	for (GLenum plane = GL_CLIP_DISTANCE0; plane <= GL_CLIP_DISTANCE3; plane++)
+		glEnable(plane);
+
+	for (size_t k = 0; k < m_visible.size(); k++)
 	{
-		if (!worldData.gameModels[i] || !worldData.gameModels[i]->GetData().visible)
-			continue;
-		if (!worldData.gameModels[i]->IsActive())
-			continue;
-		if (!worldData.gameModels[i]->GetData().castShadows)
-			continue;
+		// модель - только в грани, которые она задевает и которые перерисовываются
+		const uint8_t objectFaces = m_visibleFaces[k] & faces;
+		if (!objectFaces) continue;
 
+		const uint32_t i = m_visible[k];
+		SetUniform(m_pointLightFaceMaskId, static_cast<int>(objectFaces));
 		SetUniform(m_pointLightModelMatrixId, worldData.gameModels[i]->GetTransform()->GetWorldMatrix());
 
-		const auto& meshes = worldData.gameModels[i]->GetData().model.GetMeshes();
+		const auto& meshes = worldData.gameModels[i]->GetData().model->GetMeshes();
 		for (const auto& mesh : meshes)
 		{
 			drawMesh(mesh, m_pointLightHasDiffuseMapId);
 		}
 	}
+
+	for (GLenum plane = GL_CLIP_DISTANCE0; plane <= GL_CLIP_DISTANCE3; plane++)
+		glDisable(plane);
 }
 //=============================================================================
 void RenderPass1::drawMesh(const Mesh& mesh, int hasDiffuseMapId)
@@ -178,26 +436,6 @@ void RenderPass1::drawMesh(const Mesh& mesh, int hasDiffuseMapId)
 	mesh.Draw(GL_TRIANGLES);
 }
 //=============================================================================
-void RenderPass1::BindDirLightDepthTexture(size_t id, unsigned slot) const
-{
-	if (id >= m_depthFBODirLights.size())
-	{
-		Error("Invalid directional light ID");
-		return;
-	}
-	m_depthFBODirLights[id].BindDepthTexture(slot);
-}
-//=============================================================================
-void RenderPass1::BindPointLightDepthTexture(size_t id, unsigned slot) const
-{
-	if (id >= m_depthFBOPointLights.size())
-	{
-		Error("Invalid point light ID");
-		return;
-	}
-	m_depthFBOPointLights[id].BindDepthTexture(slot);
-}
-//=============================================================================
 bool RenderPass1::initProgram()
 {
 	// DIRECTIONAL SHADER
@@ -243,8 +481,15 @@ bool RenderPass1::initProgram()
 		{
 			m_pointLightCubeMatricesId[i] = GetUniformLocation(m_programPointLight, "cubeMatrices[" + std::to_string(i) + "]");
 			assert(m_pointLightCubeMatricesId[i] > -1);
+			m_pointLightFaceRectsId[i] = GetUniformLocation(m_programPointLight, "faceRects[" + std::to_string(i) + "]");
+			assert(m_pointLightFaceRectsId[i] > -1);
 		}
 
+		m_pointLightFaceMaskId = GetUniformLocation(m_programPointLight, "faceMask");
+		assert(m_pointLightFaceMaskId > -1);
+		m_pointLightParaboloidId = GetUniformLocation(m_programPointLight, "paraboloid");
+		assert(m_pointLightParaboloidId > -1);
+
 		m_pointLightLightPosId = GetUniformLocation(m_programPointLight, "lightPos");
 		assert(m_pointLightLightPosId > -1);
 
@@ -259,24 +504,26 @@ bool RenderPass1::initProgram()
 //=============================================================================
 bool RenderPass1::initFBO()
 {
-	FramebufferInfo depthFboInfo;
-	depthFboInfo.width = static_cast<uint16_t>(m_shadowQuality);
-	depthFboInfo.height = static_cast<uint16_t>(m_shadowQuality);
-
-	depthFboInfo.depthAttachment = DepthAttachment{ .type = AttachmentType::Texture };
-	for (size_t i = 0; i < m_depthFBODirLights.size(); i++)
-	{
-		if (!m_depthFBODirLights[i].Create(depthFboInfo))
-			return false;
-	}
+	if (!createAtlasFBO(m_atlasFBO))
+		return false;
 
-	depthFboInfo.depthAttachment = DepthAttachment{ .type = AttachmentType::TextureCubeMap };
-	for (size_t i = 0; i < m_depthFBOPointLights.size(); i++)
+	m_atlasUBO = CreateBuffer(BufferTarget::Uniform, BufferUsage::DynamicDraw, sizeof(ShadowAtlasData), nullptr);
+	if (!m_atlasUBO.handle)
 	{
-		if (!m_depthFBOPointLights[i].Create(depthFboInfo))
-			return false;
+		Fatal("Shadow atlas UBO failed!");
+		return false;
 	}
 
 	return true;
 }
-//=============================================================================
\ No newline at end of file
+//=============================================================================
+bool RenderPass1::createAtlasFBO(Framebuffer& fbo) const
+{
+	FramebufferInfo depthFboInfo;
+	depthFboInfo.width = static_cast<uint16_t>(ShadowAtlasSize);
+	depthFboInfo.height = static_cast<uint16_t>(ShadowAtlasSize);
+	depthFboInfo.depthAttachment = DepthAttachment{ .type = AttachmentType::Texture };
+
+	return fbo.Create(depthFboInfo);
+}
+//=============================================================================
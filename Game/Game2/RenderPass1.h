@@ -16,34 +16,91 @@ enum class ShadowQuality
 
 struct GameWorldData;
 
-/*
-TODO: под каждую карту теней свой FBO. это возможно не эффективно.
-попробовать один FBO c атачем нужных текстур
-или попробовать атачитить массив текстур и выбирать нужное через glFramebufferTextureLayer или glFramebufferTexture с параметром layer 
-*/
-
+// Все карты теней - тайлы одного атласа глубины. Размер тайла - по доле экрана, которую занимает источник:
+// направленный свет - наибольший тайл, грани куба точечного - пропорционально радиусу и расстоянию до камеры.
+// Прямоугольники тайлов и матрицы источников передаются в шейдер через ShadowAtlasUBO
+//
+// Далекие точечные источники (маленький тайл) - двойной параболоид: две полусферы вместо шести граней.
+// Каждая модель рисуется только в грани, которые задевает ее бокс
+//
+// Статические модели рисуются в отдельный кэш карты только при их изменении или сдвиге света, каждый обновляемый кадр
+// кэш копируется в карту и поверх рисуются динамические - только в грани, где они есть сейчас или были в прошлый раз.
+// Карты далеких точечных источников обновляются по очереди в бюджете
 class RenderPass1 final
 {
 public:
 	bool Init(ShadowQuality shadowQuality);
 	void Close();
 
-	void RenderShadows(const GameWorldData& worldData);
+	static constexpr GLuint ShadowAtlasBinding = 0;
 
-	void SetShadowQuality(ShadowQuality quality);
+	// cameraProjection - проекция основного прохода, по ней оценивается размер источника на экране
+	void RenderShadows(const GameWorldData& worldData, const glm::mat4& cameraProjection);
 
-	const auto& GetDepthFBO() const { return m_depthFBODirLights; }
+	// ShadowQuality - наибольший размер тайла
+	void SetShadowQuality(ShadowQuality quality);
 
-	void BindDirLightDepthTexture(size_t id, unsigned slot) const;
-	void BindPointLightDepthTexture(size_t id, unsigned slot) const;
+	// атлас на slot, ShadowAtlasUBO на ShadowAtlasBinding
+	void BindShadowAtlas(unsigned slot) const;
+	bool HasDirLightShadow(size_t id) const { return id < MaxDirectionalLight && m_dirLightTiles[id].rects[0].size > 0; }
+	bool HasPointLightShadow(size_t id) const { return id < MaxPointLight && m_pointLightTiles[id].rects[0].size > 0; }
 
 	float GetShadowFarPlane() const { return m_shadowFarPlane; }
 
 private:
+	// тайлы источника в атласе: у направленного один, у точечного - по грани куба +X,-X,+Y,-Y,+Z,-Z
+	// или две полусферы параболоида -Y,+Y
+	struct ShadowTiles final
+	{
+		std::array<ShadowAtlasRect, 6> rects;
+		uint32_t                       numRects{ 0 };
+		uint32_t                       requestedSize{ 0 }; // при нехватке места выделенные тайлы меньше
+
+		std::span<const ShadowAtlasRect> GetRects() const { return { rects.data(), numRects }; }
+		bool IsParaboloid() const { return numRects == 2; }
+	};
+
+	// std140, повторяет ShadowAtlasUBO в BlinnPhong/fragmentNew.shader. Rect - xy смещение и zw масштаб UV тайла
+	struct ShadowAtlasData final
+	{
+		glm::mat4 dirLightViewProj[MaxDirectionalLight];
+		glm::vec4 dirLightAtlasRect[MaxDirectionalLight];
+		glm::mat4 pointLightFaceViewProj[MaxPointLight * 6];
+		glm::vec4 pointLightAtlasRect[MaxPointLight * 6];
+		glm::vec4 pointLightShadowParams[MaxPointLight]; // x: 1 - двойной параболоид
+	};
+
+	// состояние карты источника между кадрами
+	struct ShadowCache final
+	{
+		glm::mat4 lightMatrix{ 0.0f }; // проекция (положение) источника при последней отрисовке карты
+		uint32_t  staticVersion{ 0 };
+		bool      rendered{ false };
+		bool      hasStatic{ false };  // в статическом буфере - статика для lightMatrix и staticVersion
+		uint8_t   dynamicFaces{ 0 };   // грани с динамическими моделями при последней отрисовке
+	};
+
 	bool initProgram();
 	bool initFBO();
-	void drawScene(GameDirectionalLight* currentLight, const GameWorldData& worldData);
-	void drawScene(GamePointLight* currentLight, const GameWorldData& worldData);
+	bool createAtlasFBO(Framebuffer& fbo) const;
+	void resetCache();
+	void resetTiles();
+	// size - нужный размер тайла, 0 - тень не нужна. Тайлы освобождаются при заметном изменении размера
+	void requestTiles(ShadowTiles& tiles, uint32_t size);
+	// numRects тайлов размером до size, при нехватке места - меньше. false - не нашлось даже наименьших
+	bool allocateTiles(ShadowTiles& tiles, uint32_t numRects, uint32_t size);
+	void freeTiles(ShadowTiles& tiles);
+	uint32_t getPointLightTileSize(GamePointLight* light, const glm::vec3& cameraPosition, const glm::mat4& cameraProjection) const;
+	void getPointLightFaceMatrices(const glm::vec3& position, glm::mat4* matrices) const;
+	void clearTiles(std::span<const ShadowAtlasRect> tiles) const;
+	template<typename T>
+	void renderShadowMap(T* light, const glm::mat4& lightMatrix, std::span<const ShadowAtlasRect> tiles, ShadowCache& cache, const GameWorldData& worldData);
+	// объекты, отбрасывающие тень источника, в m_visible, их грани (бит на тайл) в m_visibleFaces. Возвращает грани всех объектов
+	uint8_t cullCasters(GameDirectionalLight* currentLight, std::span<const ShadowAtlasRect> tiles, const GameWorldData& worldData, SceneObjects objects);
+	uint8_t cullCasters(GamePointLight* currentLight, std::span<const ShadowAtlasRect> tiles, const GameWorldData& worldData, SceneObjects objects);
+	// рисуются только грани faces
+	void drawCasters(GameDirectionalLight* currentLight, std::span<const ShadowAtlasRect> tiles, uint8_t faces, const GameWorldData& worldData);
+	void drawCasters(GamePointLight* currentLight, std::span<const ShadowAtlasRect> tiles, uint8_t faces, const GameWorldData& worldData);
 	void drawMesh(const Mesh& mesh, int hasDiffuseMapId);
 
 	ShadowQuality                                m_shadowQuality;
@@ -57,10 +114,24 @@ private:
 	ProgramHandle                                m_programPointLight{ 0 };
 	int                                          m_pointLightModelMatrixId{ -1 };
 	int                                          m_pointLightCubeMatricesId[6] = { -1 };
+	int                                          m_pointLightFaceRectsId[6] = { -1 };
+	int                                          m_pointLightFaceMaskId{ -1 };
+	int                                          m_pointLightParaboloidId{ -1 };
 	int                                          m_pointLightLightPosId{ -1 };
 	int                                          m_pointLightFarPlaneId{ -1 };
 	int                                          m_pointLightHasDiffuseMapId{ -1 };
 
-	std::array<Framebuffer, MaxDirectionalLight> m_depthFBODirLights;
-	std::array<Framebuffer, MaxPointLight>       m_depthFBOPointLights;
+	Framebuffer                                  m_atlasFBO;
+	Framebuffer                                  m_staticAtlasFBO; // только статические модели, создается при первом использовании
+	ShadowAtlasAllocator                         m_atlas;
+	std::array<ShadowTiles, MaxDirectionalLight> m_dirLightTiles;
+	std::array<ShadowTiles, MaxPointLight>       m_pointLightTiles;
+	ShadowAtlasData                              m_atlasData{};
+	BufferHandle                                 m_atlasUBO{ 0 };
+	std::array<ShadowCache, MaxDirectionalLight> m_dirLightCache;
+	std::array<ShadowCache, MaxPointLight>       m_pointLightCache;
+	ShadowUpdateScheduler                        m_scheduler; // id - направленные, затем точечные источники
+
+	std::vector<uint32_t>                        m_visible;
+	std::vector<uint8_t>                         m_visibleFaces;
 };
\ No newline at end of file
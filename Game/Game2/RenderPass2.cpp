@@ -2,11 +2,29 @@
 #include "RenderPass2.h"
 #include "GameScene.h"
 //=============================================================================
+namespace
+{
+	// 0-4 - текстуры материала, 6 - атлас теней
+	constexpr unsigned InstancesTextureUnit = 5;
+	constexpr unsigned ShadowAtlasTextureUnit = 6;
+	//-------------------------------------------------------------------------
+	// та же текстура, что bindMaterial отдает в colorTex - по ее альфе идет отсечение в обоих проходах
+	Texture2DHandle getColorTexture(const Mesh& mesh)
+	{
+		const auto& material = mesh.GetMaterial();
+		if (material && !material->diffuseTextures.empty() && IsValid(material->diffuseTextures[0]))
+			return material->diffuseTextures[0].id;
+		return Texture2DHandle{ 0 };
+	}
+} // namespace
+//=============================================================================
 bool RenderPass2::Init(uint16_t framebufferWidth, uint16_t framebufferHeight)
 {
 	setSize(framebufferWidth, framebufferHeight);
 	if (!initProgram())
 		return false;
+	if (!initDepthProgram())
+		return false;
 	if (!initFBO())
 		return false;
 
@@ -15,12 +33,16 @@ bool RenderPass2::Init(uint16_t framebufferWidth, uint16_t framebufferHeight)
 	samperCI.magFilter = TextureFilter::Nearest;
 	m_sampler = CreateSamplerState(samperCI);
 
+	m_depthPrePass.Init();
+
 	return true;
 }
 //=============================================================================
 void RenderPass2::Close()
 {
+	m_depthPrePass.Close();
 	m_fbo.Destroy();
+	glDeleteProgram(m_depthProgram.handle);
 	glDeleteProgram(m_program.handle);
 }
 //=============================================================================
@@ -33,6 +55,20 @@ void RenderPass2::Draw(const RenderPass1& rpShadowMap, const GameWorldData& game
 	glClearColor(0.3f, 0.4f, 0.9f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT /*| GL_STENCIL_BUFFER_BIT*/);
 
+	const glm::mat4& view = gameData.oldCamera->GetViewMatrix();
+	cullScene(gameData, Frustum(m_perspective * view));
+
+	// перерисовка измеряется в первом проходе, который пишет глубину
+	const uint32_t numPixels = static_cast<uint32_t>(m_framebufferWidth) * m_framebufferHeight;
+	const bool depthPrePass = m_depthPrePass.IsEnabled();
+	glBindSampler(0, m_sampler.handle);
+	if (depthPrePass)
+	{
+		m_depthPrePass.BeginMeasure();
+		drawDepth(gameData, m_perspective, view);
+		m_depthPrePass.EndMeasure(numPixels);
+	}
+
 	glUseProgram(m_program.handle);
 
 	SetUniform(m_TileUId, 1.0f);
@@ -52,7 +88,8 @@ void RenderPass2::Draw(const RenderPass1& rpShadowMap, const GameWorldData& game
 
 	// TODO: skybox
 
-	int textureOffset{ 6 };
+	rpShadowMap.BindShadowAtlas(ShadowAtlasTextureUnit);
+
 	// Set Directional Lights
 	SetUniform(GetUniformLocation(m_program, "directionalLightsNumber"), (int)gameData.countGameDirectionalLights);
 	for (size_t i = 0; i < gameData.countGameDirectionalLights; i++)
@@ -65,14 +102,8 @@ void RenderPass2::Draw(const RenderPass1& rpShadowMap, const GameWorldData& game
 		SetUniform(GetUniformLocation(m_program, "directionalLights[" + idStr + "].dir"), dir);
 		SetUniform(GetUniformLocation(m_program, "directionalLights[" + idStr + "].color"), light->GetColor());
 		SetUniform(GetUniformLocation(m_program, "directionalLights[" + idStr + "].intensity"), light->GetIntensity());
-		SetUniform(GetUniformLocation(m_program, "directionalLights[" + idStr + "].castShadows"), light->GetCastShadows());
-		if (light->GetCastShadows())
-		{
-			rpShadowMap.BindDirLightDepthTexture(i, textureOffset);
-			SetUniform(GetUniformLocation(m_program, "directionalLights[" + idStr + "].shadowMap"), textureOffset);
-			SetUniform(GetUniformLocation(m_program, "directionalLights[" + idStr + "].lightViewProj"), light->GetLightTransformMatrix());
-			textureOffset++;
-		}
+		// без тайла в атласе (не хватило места) источник светит без тени
+		SetUniform(GetUniformLocation(m_program, "directionalLights[" + idStr + "].castShadows"), light->GetCastShadows() && rpShadowMap.HasDirLightShadow(i));
 	}
 
 	// Set Spot Lights
@@ -97,18 +128,25 @@ void RenderPass2::Draw(const RenderPass1& rpShadowMap, const GameWorldData& game
 		//SetUniform(GetUniformLocation(m_program, "pointLights[" + idStr + "].quadratic"), light->GetQuadratic());
 		//SetUniform(GetUniformLocation(m_program, "pointLights[" + idStr + "].att"), light->GetAtt());
 		
-		SetUniform(GetUniformLocation(m_program, "pointLights[" + idStr + "].castShadows"), light->GetCastShadows());
-		if (light->GetCastShadows())
-		{
-			rpShadowMap.BindPointLightDepthTexture(i, textureOffset);
-			SetUniform(GetUniformLocation(m_program, "pointLights[" + idStr + "].shadowMap"), textureOffset);
-			textureOffset++;
-		}
+		SetUniform(GetUniformLocation(m_program, "pointLights[" + idStr + "].castShadows"), light->GetCastShadows() && rpShadowMap.HasPointLightShadow(i));
 	}
 
 
-	glBindSampler(0, m_sampler.handle);
-	drawScene(gameData, m_perspective, gameData.oldCamera->GetViewMatrix());
+	if (depthPrePass)
+	{
+		// глубина уже готова - освещение считается только для видимого фрагмента
+		glDepthFunc(GL_EQUAL);
+		glDepthMask(GL_FALSE);
+		drawScene(gameData, m_perspective, view);
+		glDepthMask(GL_TRUE);
+		glDepthFunc(GL_LESS);
+	}
+	else
+	{
+		m_depthPrePass.BeginMeasure();
+		drawScene(gameData, m_perspective, view);
+		m_depthPrePass.EndMeasure(numPixels);
+	}
 	glBindSampler(0, 0);
 }
 //=============================================================================
@@ -122,94 +160,169 @@ void RenderPass2::Resize(uint16_t framebufferWidth, uint16_t framebufferHeight)
 	m_fbo.Resize(m_framebufferWidth, m_framebufferHeight);
 }
 //=============================================================================
-void RenderPass2::drawScene(const GameWorldData& gameData, const glm::mat4& proj, const glm::mat4& view)
+void RenderPass2::cullScene(const GameWorldData& gameData, const Frustum& frustum)
 {
-	bool hasDiffuseMap = false;
-	Texture2DHandle diffuseTex{ 0 };
-	bool hasSpecularMap = false;
-	Texture2DHandle specularTex{ 0 };
-	bool hasGlossMap = false;
-	Texture2DHandle glossTex{ 0 };
-	bool hasNormalMap = false;
-	Texture2DHandle normalTex{ 0 };
-	bool hasOpacityMap = false;
-	Texture2DHandle opacityTex{ 0 };
+	gameData.objectTree.Cull(frustum, m_visible, CullingView::Camera);
 
+	// экземпляры отсекаются на GPU, матрицы прошедших шейдер читает из буфера
+	m_visibleInstanced.clear();
 	for (size_t i = 0; i < gameData.countGameModels; i++)
 	{
-		if (!gameData.gameModels[i] || !gameData.gameModels[i]->GetData().visible)
+		GameModel* model = gameData.gameModels[i];
+		if (!model || !model->GetData().isInstancedModel || !model->GetData().visible || !model->GetData().model || !model->IsActive())
 			continue;
-		if (!gameData.gameModels[i]->IsActive())
+		// весь набор вне пирамиды - проход отсечения не нужен
+		if (!frustum.IsVisible(model->GetInstancesBounds()))
 			continue;
 
+		model->GetInstances().Cull(frustum, model->GetData().model->GetAABB());
+		m_visibleInstanced.push_back(static_cast<uint32_t>(i));
+	}
+}
+//=============================================================================
+void RenderPass2::drawDepth(const GameWorldData& gameData, const glm::mat4& proj, const glm::mat4& view)
+{
+	glUseProgram(m_depthProgram.handle);
+
+	for (const uint32_t i : m_visible)
+	{
+		SetUniform(m_depthModelViewProjMatrixId, proj * view * gameData.gameModels[i]->GetTransform()->GetWorldMatrix());
+
+		const auto& meshes = gameData.gameModels[i]->GetData().model->GetMeshes();
+		for (const auto& mesh : meshes)
+		{
+			const Texture2DHandle colorTex = getColorTexture(mesh);
+			SetUniform(m_depthHasColorTexId, IsValid(colorTex));
+			BindTexture2D(0, colorTex);
+			mesh.Draw(GL_TRIANGLES);
+		}
+	}
+
+	SetUniform(m_depthInstancedId, true);
+	SetUniform(m_depthViewMatrixId, view);
+	SetUniform(m_depthProjMatrixId, proj);
+	for (const uint32_t i : m_visibleInstanced)
+	{
+		GameModel* model = gameData.gameModels[i];
+		model->GetInstances().BindInstances(InstancesTextureUnit);
+
+		const auto& meshes = model->GetData().model->GetMeshes();
+		for (size_t j = 0; j < meshes.size() && j < GPUInstanceCulling::MaxCommands; j++)
+		{
+			const Texture2DHandle colorTex = getColorTexture(meshes[j]);
+			SetUniform(m_depthHasColorTexId, IsValid(colorTex));
+			BindTexture2D(0, colorTex);
+			model->GetInstances().Draw(meshes[j], j);
+		}
+	}
+	SetUniform(m_depthInstancedId, false);
+}
+//=============================================================================
+void RenderPass2::drawScene(const GameWorldData& gameData, const glm::mat4& proj, const glm::mat4& view)
+{
+	const glm::vec3 cameraPosition = gameData.oldCamera->Position;
+	const float projectionScale = 0.5f * static_cast<float>(m_framebufferHeight) * proj[1][1];
+
+	for (const uint32_t i : m_visible)
+	{
 		SetUniform(GetUniformLocation(m_program, "material.receiveShadows"), gameData.gameModels[i]->GetData().receiveShadows);
 
 		SetUniform(m_modelMatrixId, gameData.gameModels[i]->GetTransform()->GetWorldMatrix());
 		SetUniform(m_modelViewMatrixId, view * gameData.gameModels[i]->GetTransform()->GetWorldMatrix());
 		SetUniform(m_modelViewProjMatrixId, proj * view * gameData.gameModels[i]->GetTransform()->GetWorldMatrix());
 
-		const auto& meshes = gameData.gameModels[i]->GetData().model.GetMeshes();
+		const auto& meshes = gameData.gameModels[i]->GetData().model->GetMeshes();
 		for (const auto& mesh : meshes)
 		{
-			const auto& material = mesh.GetMaterial();
-			hasDiffuseMap = false;
-			diffuseTex.handle = 0;
-			hasSpecularMap = false;
-			specularTex.handle = 0;
-			hasGlossMap = false;
-			glossTex.handle = 0;
-			hasNormalMap = false;
-			normalTex.handle = 0;
-			hasOpacityMap = false;
-			opacityTex.handle = 0;
-
-			if (material)
-			{
-				if (!material->diffuseTextures.empty() && IsValid(material->diffuseTextures[0]))
-				{
-					hasDiffuseMap = true;
-					diffuseTex = material->diffuseTextures[0].id;
-				}
-				if (!material->specularTextures.empty() && IsValid(material->specularTextures[0]))
-				{
-					hasSpecularMap = true;
-					specularTex = material->specularTextures[0].id;
-				}
-				//if (!material->.empty() && IsValid(material->[0]))
-				{
-					//hasGlossMap = true;
-					//glossTex = material->[0].id;
-				}
-				if (!material->normalTextures.empty() && IsValid(material->normalTextures[0]))
-				{
-					hasNormalMap = true;
-					normalTex = material->normalTextures[0].id;
-				}
-				//if (!material->.empty() && IsValid(material->[0]))
-				{
-					//hasOpacityMap = true;
-					//opacityTex = material->[0].id;
-				}
-			}
-
-			SetUniform(m_hasColorTexId, hasDiffuseMap);
-			BindTexture2D(0, diffuseTex);
-
-			SetUniform(m_hasNormalTexId, hasNormalMap);
-			BindTexture2D(1, normalTex);
-
-			SetUniform(m_hasSpecularTexId, hasSpecularMap);
-			BindTexture2D(2, specularTex);
-
-			SetUniform(m_hasGlossTexId, hasGlossMap);
-			BindTexture2D(3, glossTex);
-
-			SetUniform(m_hasOpacityTexId, hasOpacityMap);
-			BindTexture2D(4, opacityTex);
-
+			const float screenSize = mesh.GetMaterial() ? textures::EstimateScreenSize(mesh.GetAABB(), gameData.gameModels[i]->GetTransform()->GetWorldMatrix(), cameraPosition, projectionScale) : 0.0f;
+			bindMaterial(mesh, screenSize);
 			mesh.Draw(GL_TRIANGLES);
 		}
 	}
+
+	SetUniform(m_instancedId, true);
+	SetUniform(m_viewMatrixId, view);
+	SetUniform(m_projMatrixId, proj);
+	for (const uint32_t i : m_visibleInstanced)
+	{
+		GameModel* model = gameData.gameModels[i];
+		auto& instances = model->GetInstances();
+		instances.BindInstances(InstancesTextureUnit);
+
+		SetUniform(GetUniformLocation(m_program, "material.receiveShadows"), model->GetData().receiveShadows);
+
+		const auto& meshes = model->GetData().model->GetMeshes();
+		for (size_t j = 0; j < meshes.size() && j < GPUInstanceCulling::MaxCommands; j++)
+		{
+			// мипы по ближайшей к камере точке бокса всего набора
+			const float screenSize = meshes[j].GetMaterial() ? textures::EstimateScreenSize(model->GetInstancesBounds(), glm::mat4(1.0f), cameraPosition, projectionScale) : 0.0f;
+			bindMaterial(meshes[j], screenSize);
+			instances.Draw(meshes[j], j);
+		}
+	}
+	SetUniform(m_instancedId, false);
+}
+//=============================================================================
+void RenderPass2::bindMaterial(const Mesh& mesh, float screenSize)
+{
+	bool hasDiffuseMap = false;
+	Texture2DHandle diffuseTex{ 0 };
+	bool hasSpecularMap = false;
+	Texture2DHandle specularTex{ 0 };
+	bool hasGlossMap = false;
+	Texture2DHandle glossTex{ 0 };
+	bool hasNormalMap = false;
+	Texture2DHandle normalTex{ 0 };
+	bool hasOpacityMap = false;
+	Texture2DHandle opacityTex{ 0 };
+
+	if (const auto& material = mesh.GetMaterial(); material)
+	{
+		for (const auto& texture : material->diffuseTextures)  textures::RequestScreenSize(texture, screenSize);
+		for (const auto& texture : material->specularTextures) textures::RequestScreenSize(texture, screenSize);
+		for (const auto& texture : material->normalTextures)   textures::RequestScreenSize(texture, screenSize);
+
+		if (!material->diffuseTextures.empty() && IsValid(material->diffuseTextures[0]))
+		{
+			hasDiffuseMap = true;
+			diffuseTex = material->diffuseTextures[0].id;
+		}
+		if (!material->specularTextures.empty() && IsValid(material->specularTextures[0]))
+		{
+			hasSpecularMap = true;
+			specularTex = material->specularTextures[0].id;
+		}
+		//if (!material->.empty() && IsValid(material->[0]))
+		{
+			//hasGlossMap = true;
+			//glossTex = material->[0].id;
+		}
+		if (!material->normalTextures.empty() && IsValid(material->normalTextures[0]))
+		{
+			hasNormalMap = true;
+			normalTex = material->normalTextures[0].id;
+		}
+		//if (!material->.empty() && IsValid(material->[0]))
+		{
+			//hasOpacityMap = true;
+			//opacityTex = material->[0].id;
+		}
+	}
+
+	SetUniform(m_hasColorTexId, hasDiffuseMap);
+	BindTexture2D(0, diffuseTex);
+
+	SetUniform(m_hasNormalTexId, hasNormalMap);
+	BindTexture2D(1, normalTex);
+
+	SetUniform(m_hasSpecularTexId, hasSpecularMap);
+	BindTexture2D(2, specularTex);
+
+	SetUniform(m_hasGlossTexId, hasGlossMap);
+	BindTexture2D(3, glossTex);
+
+	SetUniform(m_hasOpacityTexId, hasOpacityMap);
+	BindTexture2D(4, opacityTex);
 }
 //=============================================================================
 bool RenderPass2::initProgram()
@@ -275,11 +388,69 @@ bool RenderPass2::initProgram()
 	m_TileVId = GetUniformLocation(m_program, "TileV");
 	assert(m_TileVId > -1);
 
+	m_instancedId = GetUniformLocation(m_program, "instanced");
+	assert(m_instancedId > -1);
+	m_viewMatrixId = GetUniformLocation(m_program, "viewMatrix");
+	assert(m_viewMatrixId > -1);
+	m_projMatrixId = GetUniformLocation(m_program, "projMatrix");
+	assert(m_projMatrixId > -1);
+	// samplerBuffer должен быть на своем блоке и без экземпляров - иначе конфликт типов с sampler2D на блоке 0
+	const int instanceMatricesId = GetUniformLocation(m_program, "instanceMatrices");
+	assert(instanceMatricesId > -1);
+	SetUniform(instanceMatricesId, static_cast<int>(InstancesTextureUnit));
+	SetUniform(m_instancedId, false);
+
+	// матрицы и тайлы источников в атласе теней
+	const int shadowAtlasId = GetUniformLocation(m_program, "shadowAtlas");
+	assert(shadowAtlasId > -1);
+	SetUniform(shadowAtlasId, static_cast<int>(ShadowAtlasTextureUnit));
+	const GLuint shadowAtlasBlockIndex = glGetUniformBlockIndex(m_program.handle, "ShadowAtlasUBO");
+	assert(shadowAtlasBlockIndex != GL_INVALID_INDEX);
+	glUniformBlockBinding(m_program.handle, shadowAtlasBlockIndex, RenderPass1::ShadowAtlasBinding);
+
 	glUseProgram(0); // TODO: возможно вернуть прошлую версию шейдера
 
 	return true;
 }
 //=============================================================================
+bool RenderPass2::initDepthProgram()
+{
+	m_depthProgram = LoadShaderProgram("data/shaders2/DepthPrePassVert.shader", "data/shaders2/DepthPrePassFrag.shader");
+	if (!m_depthProgram.handle)
+	{
+		Fatal("Scene Depth PrePass Shader failed!");
+		return false;
+	}
+	glUseProgram(m_depthProgram.handle);
+
+	m_depthModelViewProjMatrixId = GetUniformLocation(m_depthProgram, "modelViewProjMatrix");
+	assert(m_depthModelViewProjMatrixId > -1);
+	m_depthInstancedId = GetUniformLocation(m_depthProgram, "instanced");
+	assert(m_depthInstancedId > -1);
+	m_depthViewMatrixId = GetUniformLocation(m_depthProgram, "viewMatrix");
+	assert(m_depthViewMatrixId > -1);
+	m_depthProjMatrixId = GetUniformLocation(m_depthProgram, "projMatrix");
+	assert(m_depthProjMatrixId > -1);
+	m_depthHasColorTexId = GetUniformLocation(m_depthProgram, "hasColorTex");
+	assert(m_depthHasColorTexId > -1);
+	m_depthHasOpacityTexId = GetUniformLocation(m_depthProgram, "hasOpacityTex");
+	assert(m_depthHasOpacityTexId > -1);
+
+	SetUniform(GetUniformLocation(m_depthProgram, "colorTex"), 0);
+	SetUniform(GetUniformLocation(m_depthProgram, "opacityTex"), 4);
+	SetUniform(GetUniformLocation(m_depthProgram, "instanceMatrices"), static_cast<int>(InstancesTextureUnit));
+	// тайлинг в основном проходе пока не меняется
+	SetUniform(GetUniformLocation(m_depthProgram, "TileU"), 1.0f);
+	SetUniform(GetUniformLocation(m_depthProgram, "TileV"), 1.0f);
+	SetUniform(m_depthInstancedId, false);
+	// карты прозрачности в материалах пока нет (см. bindMaterial)
+	SetUniform(m_depthHasOpacityTexId, false);
+
+	glUseProgram(0);
+
+	return true;
+}
+//=============================================================================
 bool RenderPass2::initFBO()
 {
 	FramebufferInfo fboInfo;
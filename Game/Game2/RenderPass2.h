@@ -18,12 +18,20 @@ public:
 	GLuint GetFBOId() const { return m_fbo.GetId(); }
 	uint16_t GetWidth() const { return m_framebufferWidth; }
 	uint16_t GetHeight() const { return m_framebufferHeight; }
+	const glm::mat4& GetProjection() const { return m_perspective; }
+
+	void SetDepthPrePass(DepthPrePassMode mode) { m_depthPrePass.SetMode(mode); }
+	DepthPrePassMode GetDepthPrePass() const { return m_depthPrePass.GetMode(); }
 
 private:
 	bool initProgram();
+	bool initDepthProgram();
 	bool initFBO();
 	void setSize(uint16_t framebufferWidth, uint16_t framebufferHeight);
+	void cullScene(const GameWorldData& gameData, const Frustum& frustum);
+	void drawDepth(const GameWorldData& gameData, const glm::mat4& proj, const glm::mat4& view);
 	void drawScene(const GameWorldData& gameData, const glm::mat4& proj, const glm::mat4& view);
+	void bindMaterial(const Mesh& mesh, float screenSize);
 
 	uint16_t      m_framebufferWidth{ 0 };
 	uint16_t      m_framebufferHeight{ 0 };
@@ -35,6 +43,9 @@ private:
 	int           m_modelViewProjMatrixId{ -1 };
 	int           m_TileUId{ -1 };
 	int           m_TileVId{ -1 };
+	int           m_instancedId{ -1 };
+	int           m_viewMatrixId{ -1 };
+	int           m_projMatrixId{ -1 };
 
 	int           m_colorTexId{ -1 };
 	int           m_hasColorTexId{ -1 };
@@ -47,7 +58,20 @@ private:
 	int           m_opacityTexId{ -1 };
 	int           m_hasOpacityTexId{ -1 };
 
+	ProgramHandle m_depthProgram{ 0 };
+	int           m_depthModelViewProjMatrixId{ -1 };
+	int           m_depthInstancedId{ -1 };
+	int           m_depthViewMatrixId{ -1 };
+	int           m_depthProjMatrixId{ -1 };
+	int           m_depthHasColorTexId{ -1 };
+	int           m_depthHasOpacityTexId{ -1 };
+	DepthPrePassSelector m_depthPrePass;
+
 	Framebuffer   m_fbo;
 
 	SamplerHandle m_sampler{ 0 };
+
+	// результаты отсечения кадра общие для прохода глубины и основного
+	std::vector<uint32_t> m_visible;
+	std::vector<uint32_t> m_visibleInstanced;
 };
\ No newline at end of file
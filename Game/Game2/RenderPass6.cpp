@@ -33,24 +33,6 @@ bool RenderPass6::Init(uint16_t framebufferWidth, uint16_t framebufferHeight)
 	if (!m_fbo.Create(fboInfo))
 		return false;
 
-	std::vector<QuadVertex> vertices = {
-		{glm::vec2(-1.0f,  1.0f), glm::vec2(0.0f, 1.0f)},
-		{glm::vec2(-1.0f, -1.0f), glm::vec2(0.0f, 0.0f)},
-		{glm::vec2(1.0f, -1.0f), glm::vec2(1.0f, 0.0f)},
-		{glm::vec2(1.0f, -1.0f), glm::vec2(1.0f, 0.0f)},
-		{glm::vec2(1.0f,  1.0f), glm::vec2(1.0f, 1.0f)},
-		{glm::vec2(-1.0f,  1.0f), glm::vec2(0.0f, 1.0f)},
-	};
-
-	GLuint currentVBO = GetCurrentBuffer(BufferTarget::Array);
-	m_vbo = CreateBuffer(BufferTarget::Array, BufferUsage::StaticDraw, vertices.size() * sizeof(QuadVertex), vertices.data());
-	glGenVertexArrays(1, &m_vao);
-	glBindVertexArray(m_vao);
-	glBindBuffer(GL_ARRAY_BUFFER, m_vbo.handle);
-	QuadVertex::SetVertexAttributes();
-	glBindVertexArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, currentVBO);
-
 	glUseProgram(0);
 
 	SamplerStateInfo samperCI{};
@@ -95,8 +77,7 @@ void RenderPass6::Draw(const Framebuffer* colorFBO, const Framebuffer* SSAOFBO)
 	}
 
 	glBindSampler(0, m_sampler.handle);
-	glBindVertexArray(m_vao);
-	glDrawArrays(GL_TRIANGLES, 0, 6);
+	fullscreenQuad::Draw();
 	glBindSampler(0, 0);
 }
 //=============================================================================
\ No newline at end of file
@@ -89,8 +89,10 @@ void GameApp()
 		camera.MovementSpeed = 10.0f;
 		camera.SetPosition(glm::vec3(0.0f, 2.5f, -1.0f));
 
-		modelLevel.model.Load("data/models/ForgottenPlains/Forgotten_Plains_Demo.obj", ModelMaterialType::BlinnPhong);
+		modelLevel.model = models::Load("data/models/ForgottenPlains/Forgotten_Plains_Demo.obj", ModelMaterialType::BlinnPhong);
 		modelLevel.modelMat = glm::translate(glm::mat4(1.0f), glm::vec3(-30.0f, -10.0f, 15.0f));
+		modelLevel.isStatic = true;
+		modelLevel.isOccluder = true;
 
 		glEnable(GL_CULL_FACE);
 		glCullFace(GL_BACK);
@@ -105,6 +107,7 @@ void GameApp()
 				if (input::IsKeyDown(RGFW_s)) camera.ProcessKeyboard(CameraBackward, engine::GetDeltaTime());
 				if (input::IsKeyDown(RGFW_a)) camera.ProcessKeyboard(CameraLeft, engine::GetDeltaTime());
 				if (input::IsKeyDown(RGFW_d)) camera.ProcessKeyboard(CameraRight, engine::GetDeltaTime());
+				if (input::IsKeyPressed(RGFW_F2)) ShowOcclusionBuffer = !ShowOcclusionBuffer;
 
 				if (input::IsMouseDown(RGFW_mouseRight))
 				{
@@ -187,6 +190,7 @@ void GameApp()
 	}
 
 	geommaps.Close();
+	TileBank::Close();
 	engine::Close();
 }
 //=============================================================================
\ No newline at end of file
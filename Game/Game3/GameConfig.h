@@ -4,6 +4,10 @@ inline float ScaleScreen = 1.0f;
 
 inline bool EnableSSAO = false;
 
+// программный буфер глубины из крупных мешей (isOccluder) отсекает перекрытые объекты основного прохода
+inline bool EnableOcclusionCulling = true;
+inline bool ShowOcclusionBuffer = false; // F2
+
 constexpr size_t MaxLights = 16u;
 
 constexpr size_t MaxDirectionalLight = 4u;
@@ -2,7 +2,11 @@
 
 struct GameModel final
 {
-	Model     model;
+	ModelRef  model;
 	glm::mat4 modelMat{ glm::mat4(1.0f) };
 	bool      visible{ true };
+	bool      isStatic{ false }; // не двигается - попадает в статическое дерево культинга
+	bool      isOccluder{ false }; // крупная непрозрачная геометрия - рисуется в буфер окклюзии
+	// у чанков карты вместо материалов - массив текстур тайлов (TileBank), слой в вершине
+	bool      useTileTextures{ false };
 };
\ No newline at end of file
@@ -54,6 +54,14 @@ void GameScene::beginDraw()
 
 	m_mainScene.Resize(wndWidth, wndHeight);
 	m_composite.Resize(wndWidth, wndHeight);
+
+	for (size_t i = 0; i < m_data.countGameModels; i++)
+	{
+		const GameModel* go = m_data.gameModels[i];
+		if (go && go->visible && go->model)
+			m_data.objectTree.Update(go, static_cast<uint32_t>(i), go->model->GetAABB().GetTransformed(go->modelMat), go->isStatic);
+	}
+	m_data.objectTree.EndUpdate();
 }
 //=============================================================================
 void GameScene::draw()
@@ -30,4 +30,6 @@ struct GameWorldData final
 
 	std::vector<GameModel*> gameModels;
 	size_t                  countGameModels{ 0 };
+	// видимые модели кадра в деревьях AABB (id - индекс в gameModels). Обновляются в начале кадра
+	SceneTree               objectTree;
 };
\ No newline at end of file
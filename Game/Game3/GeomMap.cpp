@@ -4,23 +4,6 @@
 #include "MapLoadObjTile.h"
 #include "Map.h"
 //=============================================================================
-size_t addMeshInfo(std::vector<MeshInfo>& meshInfo, Texture2D texId)
-{
-	for (size_t i = 0; i < meshInfo.size(); i++)
-	{
-		if (meshInfo[i].material->diffuseTextures[0] == texId)
-		{
-			return i;
-		}
-	}
-
-	MeshInfo nmi{};
-	nmi.material = Material();
-	nmi.material->diffuseTextures.push_back(texId);
-	meshInfo.push_back(nmi);
-	return meshInfo.size() - 1;
-}
-//=============================================================================
 inline std::string getFileNameBlock(TileGeometryType type)
 {
 	switch (type)
@@ -54,9 +37,9 @@ bool MapChunk::Init(Map& map)
 {
 	TileInfo tempTile;
 	tempTile.type = TileGeometryType::Block00;
-	tempTile.textureWall = textures::LoadTexture2D("data/tiles/grass01_wall.png", ColorSpace::Linear, true);
-	tempTile.textureCeil = textures::LoadTexture2D("data/tiles/grass01_ceil.png");
-	tempTile.textureFloor = textures::LoadTexture2D("data/tiles/grass01.png");
+	tempTile.textureWall = TileBank::AddTexture("data/tiles/grass01_wall.png", true);
+	tempTile.textureCeil = TileBank::AddTexture("data/tiles/grass01_ceil.png");
+	tempTile.textureFloor = TileBank::AddTexture("data/tiles/grass01.png");
 
 	for (size_t x = 0; x < 11; x++)
 	{
@@ -67,9 +50,9 @@ bool MapChunk::Init(Map& map)
 	}
 
 	tempTile.type = TileGeometryType::Block01;
-	tempTile.textureWall = textures::LoadTexture2D("data/tiles/grass01_wall.png", ColorSpace::Linear, true);
-	tempTile.textureCeil = textures::LoadTexture2D("data/tiles/grass01_ceil.png");
-	tempTile.textureFloor = textures::LoadTexture2D("data/tiles/grass01.png");
+	tempTile.textureWall = TileBank::AddTexture("data/tiles/grass01_wall.png", true);
+	tempTile.textureCeil = TileBank::AddTexture("data/tiles/grass01_ceil.png");
+	tempTile.textureFloor = TileBank::AddTexture("data/tiles/grass01.png");
 	tempTile.rotate = RotateAngleY::Rotate270;
 	map.SetGeomTile(TileBank::AddTileInfo(tempTile), 16, 17, 1);
 	tempTile.rotate = RotateAngleY::Rotate0;
@@ -89,19 +72,18 @@ bool MapChunk::Init(Map& map)
 //=============================================================================
 void MapChunk::Close()
 {
+	m_model.model.reset();
 }
 //=============================================================================
 void MapChunk::RecreateBuffer(Map& map)
 {
-	m_model.model.Free();
 	generateBufferMap(map);
 }
 //=============================================================================
 void MapChunk::generateBufferMap(Map& map)
 {
-	std::vector<MeshInfo> meshInfo;
-	m_vertCount = 0;
-	m_indexCount = 0;
+	// все грани чанка в одном меше - текстура выбирается слоем массива из вершины
+	MeshInfo meshInfo;
 
 	const float mapOffset = MAPCHUNKSIZE / 2.0f;
 	for (size_t iy = 0; iy < MAPCHUNKSIZE; iy++)
@@ -125,23 +107,25 @@ void MapChunk::generateBufferMap(Map& map)
 				blockModelInfo.rotate = getRotateAngle(id.rotate);
 				setVisibleBlock(map, id, blockModelInfo, ix, iy, iz);
 				blockModelInfo.modelPath = getFileNameBlock(id.type);
+				blockModelInfo.layerWall = id.textureWall;
+				blockModelInfo.layerCeil = id.textureCeil;
+				blockModelInfo.layerFloor = id.textureFloor;
 
-				size_t idWall  = addMeshInfo(meshInfo, id.textureWall);
-				size_t idFloor = addMeshInfo(meshInfo, id.textureFloor);
-				size_t idCeil  = addMeshInfo(meshInfo, id.textureCeil);
-
-				AddObjModel(blockModelInfo, meshInfo[idWall], meshInfo[idCeil], meshInfo[idFloor]);
+				AddObjModel(blockModelInfo, meshInfo);
 			}
 		}
 	}
 
-	for (size_t i = 0; i < meshInfo.size(); i++)
-	{
-		m_vertCount += meshInfo[i].vertices.size();
-		m_indexCount += meshInfo[i].indices.size();
-	}
+	m_vertCount = meshInfo.vertices.size();
+	m_indexCount = meshInfo.indices.size();
 
-	m_model.model.Create(meshInfo);
+	// геометрия чанка меняется при редактировании - своя модель вне кеша, старая удаляется с последней ссылкой. Пустой чанк Create пропустит
+	auto model = std::make_shared<Model>();
+	model->Create(std::vector<MeshInfo>{ std::move(meshInfo) });
+	m_model.model = std::move(model);
+	m_model.useTileTextures = true;
+	m_model.isStatic = true;
+	m_model.isOccluder = true;
 }
 //=============================================================================
 bool testVisBlock(Map& map, TileGeometryType tile, size_t x, size_t y, size_t z)
@@ -1,7 +1,82 @@
 ﻿#include "stdafx.h"
 #include "GeomTileMap.h"
 //=============================================================================
+struct TileTexture final
+{
+	bool operator==(const TileTexture&) const noexcept = default;
+
+	std::string fileName;
+	bool flipVertical{ false };
+};
+//=============================================================================
 std::vector<TileInfo> TileInfoCache;
+std::vector<TileTexture> TileTextures;
+Texture2DArrayHandle TileTextureArray;
+bool TileTextureArrayDirty = false;
+//=============================================================================
+// пиксели слоя RGBA8. Не загрузилась или другой размер - белый слой, чтобы не сбить номера остальных
+std::vector<uint8_t> loadTileTexture(const TileTexture& texture, int& width, int& height)
+{
+	stbi_set_flip_vertically_on_load(texture.flipVertical);
+	int w, h, nrComponents;
+	stbi_uc* pixels = stbi_load(texture.fileName.c_str(), &w, &h, &nrComponents, 4);
+	if (!pixels || (width > 0 && (w != width || h != height)))
+	{
+		stbi_image_free(pixels);
+		Error("Failed to load tile texture " + texture.fileName + (pixels ? ": size differs from first tile texture" : ""));
+		if (width <= 0) width = height = 1;
+		return std::vector<uint8_t>(size_t(width) * height * 4, 255);
+	}
+	width = w;
+	height = h;
+	std::vector<uint8_t> result(pixels, pixels + size_t(w) * h * 4);
+	stbi_image_free(pixels);
+	return result;
+}
+//=============================================================================
+Texture2DArrayHandle buildTextureArray()
+{
+	int width = 0, height = 0;
+	std::vector<std::vector<std::vector<uint8_t>>> layers(TileTextures.size());
+	for (size_t i = 0; i < TileTextures.size(); i++)
+	{
+		std::vector<uint8_t> pixels = loadTileTexture(TileTextures[i], width, height);
+		const MipSettings mipSettings{
+			.filter = MipFilter::Box,
+			.alphaCutoff = mipmap::IsCutout(pixels.data(), uint32_t(width), uint32_t(height), 4) ? mipmap::DefaultAlphaCutoff : 0.0f
+		};
+		layers[i] = mipmap::Generate(pixels.data(), uint32_t(width), uint32_t(height), 4, mipSettings);
+	}
+
+	Texture2DArrayHandle textureArray = CreateTexture2DArray(InternalFormat::RGBA8, unsigned(width), unsigned(height), unsigned(layers.size()), PixelFormat::Rgba, PixelType::UnsignedByte);
+	if (!IsValid(textureArray))
+		return {};
+
+	const GLuint currentTexture = GetCurrentTexture(GL_TEXTURE_2D_ARRAY);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray.handle);
+	const size_t numLevels = layers[0].size();
+	for (size_t level = 0; level < numLevels; level++)
+	{
+		const GLsizei levelWidth = std::max(1, width >> level);
+		const GLsizei levelHeight = std::max(1, height >> level);
+		if (level > 0)
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, GLint(level), GL_RGBA8, levelWidth, levelHeight, GLsizei(layers.size()), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		for (size_t layer = 0; layer < layers.size(); layer++)
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, GLint(level), 0, 0, GLint(layer), levelWidth, levelHeight, 1, GL_RGBA, GL_UNSIGNED_BYTE, layers[layer][level].data());
+	}
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, GLint(numLevels - 1));
+	glBindTexture(GL_TEXTURE_2D_ARRAY, currentTexture);
+
+	TextureConfig texConfig{
+		.minFilter = TextureFilter::LinearMipmapLinear,
+		.magFilter = TextureFilter::Linear,
+		.generateMipmaps = false
+	};
+	SetTextureParameters(textureArray, texConfig);
+
+	Debug("Tile texture array: " + std::to_string(layers.size()) + " layers " + std::to_string(width) + "x" + std::to_string(height));
+	return textureArray;
+}
 //=============================================================================
 size_t TileBank::AddTileInfo(const TileInfo& temp)
 {
@@ -21,4 +96,37 @@ const TileInfo& TileBank::GetTileInfo(size_t id)
 	assert(id < TileInfoCache.size());
 	return TileInfoCache[id];
 }
+//=============================================================================
+uint32_t TileBank::AddTexture(const std::string& fileName, bool flipVertical)
+{
+	const TileTexture texture{ .fileName = fileName, .flipVertical = flipVertical };
+	for (size_t i = 0; i < TileTextures.size(); i++)
+	{
+		if (TileTextures[i] == texture)
+		{
+			return static_cast<uint32_t>(i);
+		}
+	}
+	TileTextures.push_back(texture);
+	TileTextureArrayDirty = true;
+	return static_cast<uint32_t>(TileTextures.size() - 1);
+}
+//=============================================================================
+Texture2DArrayHandle TileBank::GetTextureArray()
+{
+	if (TileTextureArrayDirty)
+	{
+		Destroy(TileTextureArray);
+		TileTextureArray = buildTextureArray();
+		TileTextureArrayDirty = false;
+	}
+	return TileTextureArray;
+}
+//=============================================================================
+void TileBank::Close()
+{
+	Destroy(TileTextureArray);
+	TileTextures.clear();
+	TileInfoCache.clear();
+}
 //=============================================================================
\ No newline at end of file
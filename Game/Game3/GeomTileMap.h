@@ -29,9 +29,10 @@ struct TileInfo final
 
 	TileGeometryType type{};
 	glm::vec4 color{ 1.0f };
-	Texture2D textureFloor;
-	Texture2D textureCeil;
-	Texture2D textureWall;
+	// слои массива текстур TileBank
+	uint32_t textureFloor{ 0 };
+	uint32_t textureCeil{ 0 };
+	uint32_t textureWall{ 0 };
 	RotateAngleY rotate{ RotateAngleY::Rotate0 };
 };
 
@@ -42,4 +43,10 @@ namespace TileBank
 	size_t AddTileInfo(const TileInfo& temp);
 
 	const TileInfo& GetTileInfo(size_t id);
+
+	// Все текстуры тайлов лежат в одном Texture2DArray - чанк карты рисуется одним вызовом. Возвращает слой
+	uint32_t AddTexture(const std::string& fileName, bool flipVertical = false);
+	// массив пересобирается, если после прошлого вызова добавились текстуры. Размер слоев - по первой текстуре
+	Texture2DArrayHandle GetTextureArray();
+	void Close();
 } // namespace TileBank
\ No newline at end of file
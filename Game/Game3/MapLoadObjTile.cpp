@@ -2,31 +2,11 @@
 #include "MapLoadObjTile.h"
 // TODO: можно еще сильнее кешировать - хранить уже обработанные модификаторами вершины
 //=============================================================================
-// Структура для хранения данных модели
-struct ObjModelData
-{
-	tinyobj::attrib_t attrib;
-	std::vector<tinyobj::shape_t> shapes;
-	std::vector<tinyobj::material_t> materials;
-};
-//=============================================================================
 // Глобальный кэш моделей
-static std::unordered_map<std::string, ObjModelData> model_cache;
-//=============================================================================
-struct IndexLess
-{
-	bool operator()(const tinyobj::index_t& a, const tinyobj::index_t& b) const
-	{
-		if (a.vertex_index != b.vertex_index) return a.vertex_index < b.vertex_index;
-		if (a.texcoord_index != b.texcoord_index) return a.texcoord_index < b.texcoord_index;
-		return a.normal_index < b.normal_index;
-	}
-};
+static std::unordered_map<std::string, ObjData> model_cache;
 //=============================================================================
-void ProcessModelData(const ObjModelData& model_data, const BlockModelInfo& modelInfo, MeshInfo& meshWall, MeshInfo& meshCeil, MeshInfo& meshFloor)
+void ProcessModelData(const ObjData& model_data, const BlockModelInfo& modelInfo, MeshInfo& mesh)
 {
-	glm::mat4 rotation_matrix(1.0f);
-
 	glm::mat4 rot_x(1.0f);
 	if (modelInfo.rotate.x != 0.0f)
 	{
@@ -54,204 +34,90 @@ void ProcessModelData(const ObjModelData& model_data, const BlockModelInfo& mode
 		rot_z[1][1] = cosf(modelInfo.rotate.z);
 	}
 
-	const auto& attrib = model_data.attrib;
-	const auto& shapes = model_data.shapes;
-
-	// Проходим по всем формам (мешам)
-	for (size_t s = 0; s < shapes.size(); s++)
+	glm::mat4 rotation_matrix(1.0f);
+	if (modelInfo.rotate.x != 0.0f) // Вращение вокруг X (pitch)
+		rotation_matrix = rot_x * rotation_matrix;
+	if (modelInfo.rotate.y != 0.0f) // Вращение вокруг Y (yaw)
+		rotation_matrix = rot_y * rotation_matrix;
+	if (modelInfo.rotate.z != 0.0f) // Вращение вокруг Z (roll)
+		rotation_matrix = rot_z * rotation_matrix;
+
+	// Проходим по всем группам (мешам). Вершины в группе уже без дублей
+	for (const auto& group : model_data.groups)
 	{
-		const auto& name = shapes[s].name;
-		std::vector<MeshVertex>* vertices = nullptr;
-		std::vector<unsigned int>* indices = nullptr;
+		const auto& name = group.objectName;
+		uint32_t layer = modelInfo.layerWall;
 
 		if (name == "bottom")
 		{
 			if (!modelInfo.bottomVisible) continue;
-
-			vertices = &meshCeil.vertices;
-			indices = &meshCeil.indices;
+			layer = modelInfo.layerCeil;
 		}
 		else if (name == "top")
 		{
 			if (!modelInfo.topVisible) continue;
-
-			vertices = &meshFloor.vertices;
-			indices = &meshFloor.indices;
+			layer = modelInfo.layerFloor;
 		}
 		else if (name == "left")
 		{
 			if (!modelInfo.leftVisible) continue;
-
-			vertices = &meshWall.vertices;
-			indices = &meshWall.indices;
 		}
 		else if (name == "right")
 		{
 			if (!modelInfo.rightVisible) continue;
-
-			vertices = &meshWall.vertices;
-			indices = &meshWall.indices;
 		}
 		else if (name == "forward")
 		{
 			if (!modelInfo.forwardVisible) continue;
-
-			vertices = &meshWall.vertices;
-			indices = &meshWall.indices;
 		}
 		else if (name == "back")
 		{
 			if (!modelInfo.backVisible) continue;
-
-			vertices = &meshWall.vertices;
-			indices = &meshWall.indices;
-		}
-		else
-		{
-			vertices = &meshWall.vertices;
-			indices = &meshWall.indices;
 		}
 
-		// Используем std::map с пользовательской функцией сравнения для tinyobj::index_t
-		std::map<tinyobj::index_t, unsigned int, IndexLess> vertex_cache;
-
-		for (size_t f = 0; f < shapes[s].mesh.indices.size(); f += 3)
+		const unsigned int baseIndex = static_cast<unsigned int>(mesh.vertices.size());
+		mesh.vertices.reserve(mesh.vertices.size() + group.mesh.vertices.size());
+		for (const auto& srcVertex : group.mesh.vertices)
 		{
-			// Получаем 3 индекса для треугольника
-			tinyobj::index_t idx0 = shapes[s].mesh.indices[f + 0];
-			tinyobj::index_t idx1 = shapes[s].mesh.indices[f + 1];
-			tinyobj::index_t idx2 = shapes[s].mesh.indices[f + 2];
+			MeshVertex vertex = srcVertex;
 
-			// Инвертируем порядок, чтобы изменить winding (CW <-> CCW)
-			// Было: idx0, idx1, idx2
-			// Стало: idx0, idx2, idx1
-			//const std::array<tinyobj::index_t, 3> reversed_indices = { idx0, idx2, idx1 };
-			const std::array<tinyobj::index_t, 3> reversed_indices = { idx0, idx1, idx2 };
+			// Применяем вращение к позиции и сдвигаем в позицию center
+			vertex.position = glm::vec3(rotation_matrix * glm::vec4(srcVertex.position, 1.0f)) + modelInfo.center;
 
-			for (const auto& idx : reversed_indices)
-			{
-				// Проверяем, была ли уже такая вершина обработана
-				auto it = vertex_cache.find(idx);
-				if (it == vertex_cache.end())
-				{
-					// Новая вершина
-					MeshVertex vertex{};
+			// Применяем ту же матрицу вращения к нормали
+			if (srcVertex.normal != glm::vec3(0.0f))
+				vertex.normal = glm::normalize(glm::vec3(rotation_matrix * glm::vec4(srcVertex.normal, 0.0f)));
 
-					// Позиция
-					if (idx.vertex_index >= 0 && static_cast<size_t>(idx.vertex_index) * 3 + 2 < attrib.vertices.size())
-					{
-						// Исходная позиция
-						glm::vec3 pos = glm::vec3(
-							attrib.vertices[3 * idx.vertex_index + 0],
-							attrib.vertices[3 * idx.vertex_index + 1],
-							attrib.vertices[3 * idx.vertex_index + 2]
-						);
+			vertex.tangent = glm::vec3(static_cast<float>(layer), 0.0f, 0.0f);
 
-						rotation_matrix = glm::mat4(1.0f);
-						if (modelInfo.rotate.x != 0.0f) // Вращение вокруг X (pitch)
-							rotation_matrix = rot_x * rotation_matrix;
-						if (modelInfo.rotate.y != 0.0f) // Вращение вокруг Y (yaw)
-							rotation_matrix = rot_y * rotation_matrix;
-						if (modelInfo.rotate.z != 0.0f) // Вращение вокруг Z (roll)
-							rotation_matrix = rot_z * rotation_matrix;
-
-						// Применяем вращение к позиции
-						glm::vec4 rotated_pos = rotation_matrix * glm::vec4(pos, 1.0f);
-
-						// Сдвигаем в позицию center
-						vertex.position = glm::vec3(rotated_pos) + modelInfo.center;
-					}
-					else
-					{
-						vertex.position = modelInfo.center; // Если индекс неверный, используем центр
-					}
-
-					// Нормаль
-					if (idx.normal_index >= 0 && static_cast<size_t>(idx.normal_index) * 3 + 2 < attrib.normals.size())
-					{
-						glm::vec3 normal = glm::vec3(
-							attrib.normals[3 * idx.normal_index + 0],
-							attrib.normals[3 * idx.normal_index + 1],
-							attrib.normals[3 * idx.normal_index + 2]
-						);
-						// Применяем ту же матрицу вращения к нормали
-						glm::vec4 rotated_normal = rotation_matrix * glm::vec4(normal, 0.0f);
-						vertex.normal = glm::vec3(rotated_normal);
-
-						// Нормализуем, если нужно
-						vertex.normal = glm::normalize(vertex.normal);
-					}
-
-					// UV-координаты
-					if (idx.texcoord_index >= 0 && static_cast<size_t>(idx.texcoord_index) * 2 + 1 < attrib.texcoords.size())
-					{
-						vertex.texCoord.x = attrib.texcoords[2 * idx.texcoord_index + 0];
-						vertex.texCoord.y = attrib.texcoords[2 * idx.texcoord_index + 1];
-					}
-
-					// Цвет (установим по умолчанию, так как OBJ обычно не хранит цвет вершины)
-					vertex.color = glm::vec3(1.0f, 1.0f, 1.0f);
-
-					// Тангент и битангент (установим по умолчанию, так как их нужно вычислять отдельно)
-					vertex.tangent = glm::vec3(0.0f, 0.0f, 0.0f);
-					vertex.bitangent = glm::vec3(0.0f, 0.0f, 0.0f);
-
-					// Добавляем вершину в массив
-					unsigned int new_index = static_cast<unsigned int>(vertices->size());
-					vertices->push_back(vertex);
-
-					// Сохраняем индекс новой вершины в кэше
-					vertex_cache[idx] = new_index;
-
-					// Добавляем индекс в массив индексов
-					indices->push_back(new_index);
-				}
-				else
-				{
-					// Добавляем индекс из кэша
-					indices->push_back(it->second);
-				}
-			}
+			mesh.vertices.push_back(vertex);
 		}
+
+		mesh.indices.reserve(mesh.indices.size() + group.mesh.indices.size());
+		for (const auto index : group.mesh.indices)
+			mesh.indices.push_back(baseIndex + index);
 	}
 }
 //=============================================================================
-void AddObjModel(const BlockModelInfo& modelInfo, MeshInfo& meshWall, MeshInfo& meshCeil, MeshInfo& meshFloor)
+void AddObjModel(const BlockModelInfo& modelInfo, MeshInfo& mesh)
 {
 	// Проверяем, есть ли модель в кэше
 	auto it = model_cache.find(modelInfo.modelPath);
-	if (it != model_cache.end())
+	if (it == model_cache.end())
 	{
-		// Используем кэшированные данные
-		const auto& cached_data = it->second;
-		ProcessModelData(cached_data, modelInfo, meshWall, meshCeil, meshFloor);
-	}
-	else
-	{
-		// Загружаем модель и сохраняем в кэш
-		tinyobj::attrib_t attrib;
-		std::vector<tinyobj::shape_t> shapes;
-		std::vector<tinyobj::material_t> materials;
-		std::string warn, err;
-		bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, modelInfo.modelPath.c_str());
-		if (!ret)
+		// Загружаем модель и сохраняем в кэш. Материалы тайлов задаются через TileInfo
+		// Заготовка от AssetCooker грузится без разбора текста
+		ObjData model_data;
+		const std::string cookedPath = cooked::GetCookedPath(modelInfo.modelPath, cooked::TileExtension);
+		const bool loadCooked = cooked::IsUpToDate(modelInfo.modelPath, cookedPath) && cooked::LoadObjData(cookedPath, model_data);
+		if (!loadCooked && !obj::Load(modelInfo.modelPath, model_data, { .loadMaterials = false }))
 		{
-			Fatal("Error loading OBJ file: " + err);
+			Fatal("Error loading OBJ file: " + modelInfo.modelPath);
 			return;
 		}
-		if (!warn.empty())
-		{
-			Warning("TinyObjLoader Warning: " + warn);
-		}
-
-		// Сохраняем данные в кэш
-		ObjModelData model_data;
-		model_data.attrib = attrib;
-		model_data.shapes = shapes;
-		model_data.materials = materials;
-		model_cache[modelInfo.modelPath] = model_data;
-
-		ProcessModelData(model_data, modelInfo, meshWall, meshCeil, meshFloor);
+		it = model_cache.emplace(modelInfo.modelPath, std::move(model_data)).first;
 	}
+
+	ProcessModelData(it->second, modelInfo, mesh);
 }
 //=============================================================================
\ No newline at end of file
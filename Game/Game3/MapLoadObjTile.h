@@ -8,6 +8,11 @@ struct BlockModelInfo final
 	glm::vec3 center{ 0.0f };
 	glm::vec3 rotate{ 0.0f }; // Порядок вращения: Z (roll), Y (yaw), X (pitch) в радианах
 
+	// слои массива текстур TileBank
+	uint32_t layerWall{ 0 };
+	uint32_t layerCeil{ 0 };
+	uint32_t layerFloor{ 0 };
+
 	bool forwardVisible{ true };
 	bool backVisible{ true };
 	bool rightVisible{ true };
@@ -16,4 +21,5 @@ struct BlockModelInfo final
 	bool bottomVisible{ true };
 };
 
-void AddObjModel(const BlockModelInfo& modelInfo, MeshInfo& meshWall, MeshInfo& meshCeil, MeshInfo& meshFloor);
\ No newline at end of file
+// Касательные тайлам не нужны: в tangent.x вершины пишется слой текстуры грани
+void AddObjModel(const BlockModelInfo& modelInfo, MeshInfo& mesh);
\ No newline at end of file
@@ -1,6 +1,7 @@
 ﻿#include "stdafx.h"
 #include "RenderPass2.h"
 #include "GameScene.h"
+#include "GeomTileMap.h"
 #include "NanoLog.h"
 #include "NanoWindow.h"
 //=============================================================================
@@ -25,6 +26,7 @@ bool RenderPass2::Init(uint16_t framebufferWidth, uint16_t framebufferHeight)
 //=============================================================================
 void RenderPass2::Close()
 {
+	m_occlusionDebug.Close();
 	m_mapGrid.Close();
 	m_fbo.Destroy();
 	glDeleteProgram(m_program.handle);
@@ -45,8 +47,10 @@ void RenderPass2::Draw(const GameWorldData& gameData)
 	SetUniform(GetUniformLocation(m_program, "viewPos"), gameData.camera->Position);
 	
 	glBindSampler(0, m_sampler.handle);
+	glBindSampler(1, m_sampler.handle);
 	drawScene(gameData);
 	glBindSampler(0, 0);
+	glBindSampler(1, 0);
 
 	//glDisable(GL_DEPTH_TEST);
 	m_mapGrid.Draw(m_perspective, gameData.camera->GetViewMatrix());
@@ -65,16 +69,37 @@ void RenderPass2::drawScene(const GameWorldData& gameData)
 	bool hasDiffuseMap = false;
 	Texture2DHandle diffuseTex{ 0 };
 
-	for (size_t i = 0; i < gameData.countGameModels; i++)
-	{
-		if (!gameData.gameModels[i] || !gameData.gameModels[i]->visible)
-			continue;
+	// массив пересобирается при добавлении текстур - берется заново каждый кадр, а не хранится в чанках
+	const Texture2DArrayHandle tileTextures = TileBank::GetTextureArray();
 
+	const glm::mat4 viewProj = m_perspective * gameData.camera->GetViewMatrix();
+	gameData.objectTree.Cull(Frustum(viewProj), m_visible, CullingView::Camera);
+	if (EnableOcclusionCulling)
+		cullOccluded(gameData, viewProj);
+
+	for (const uint32_t i : m_visible)
+	{
 		SetUniform(GetUniformLocation(m_program, "modelMatrix"), gameData.gameModels[i]->modelMat);
 
-		const auto& meshes = gameData.gameModels[i]->model.GetMeshes();
+		// чанк карты - один меш, текстуры тайлов из массива
+		const bool useTileTextures = gameData.gameModels[i]->useTileTextures && IsValid(tileTextures);
+		SetUniform(GetUniformLocation(m_program, "hasTileTextures"), useTileTextures);
+		if (useTileTextures)
+		{
+			SetUniform(GetUniformLocation(m_program, "hasDiffuseTex"), false);
+			BindTexture2DArray(1, tileTextures);
+			for (const auto& mesh : gameData.gameModels[i]->model->GetMeshes())
+				mesh.Draw(GL_TRIANGLES);
+			continue;
+		}
+
+		const auto& meshes = gameData.gameModels[i]->model->GetMeshes();
 		for (const auto& mesh : meshes)
 		{
+			// части больших моделей (уровня) проверяются отдельно
+			if (EnableOcclusionCulling && meshes.size() > 1 && !m_occlusion.IsVisible(mesh.GetAABB().GetTransformed(gameData.gameModels[i]->modelMat)))
+				continue;
+
 			const auto& material = mesh.GetMaterial();
 			diffuseTex.handle = 0;
 			if (material)
@@ -93,6 +118,25 @@ void RenderPass2::drawScene(const GameWorldData& gameData)
 	}
 }
 //=============================================================================
+void RenderPass2::cullOccluded(const GameWorldData& gameData, const glm::mat4& viewProj)
+{
+	m_occlusion.Begin(viewProj);
+	for (const uint32_t i : m_visible)
+	{
+		const GameModel* go = gameData.gameModels[i];
+		// тайлы с альфа-тестом (решетки, листва) - по материалу меша чанка этого не видно, текстуры в массиве TileBank
+		if (!go->isOccluder || go->useTileTextures) continue;
+		for (const auto& mesh : go->model->GetMeshes())
+			m_occlusion.AddOccluder(mesh, go->modelMat);
+	}
+	m_occlusion.End();
+
+	m_occlusion.Cull(m_visible, [&](uint32_t i) { return gameData.gameModels[i]->model->GetAABB().GetTransformed(gameData.gameModels[i]->modelMat); });
+
+	if (ShowOcclusionBuffer)
+		m_occlusionDebug.Draw(m_occlusion);
+}
+//=============================================================================
 bool RenderPass2::initProgram()
 {
 	m_program = LoadShaderProgram("data/shaders3/mainVert.shader", "data/shaders3/mainFrag.shader");
@@ -106,6 +150,7 @@ bool RenderPass2::initProgram()
 	int diffuseMap = GetUniformLocation(m_program, "diffuseTexture");
 	assert(diffuseMap > -1);
 	SetUniform(diffuseMap, 0);
+	SetUniform(GetUniformLocation(m_program, "tileTextures"), 1);
 	
 	glUseProgram(0); // TODO: возможно вернуть прошлую версию шейдера
 
@@ -139,5 +184,6 @@ void RenderPass2::setSize(uint16_t framebufferWidth, uint16_t framebufferHeight)
 	m_framebufferHeight = framebufferHeight;
 	const float aspect = (float)m_framebufferWidth / (float)m_framebufferHeight;
 	m_perspective = glm::perspective(glm::radians(60.0f), aspect, 0.01f, 1000.0f);
+	m_occlusion.Resize(OcclusionBuffer::DefaultWidth, static_cast<uint32_t>(OcclusionBuffer::DefaultWidth / aspect));
 }
 //=============================================================================
\ No newline at end of file
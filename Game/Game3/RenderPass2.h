@@ -21,6 +21,7 @@ private:
 	bool initFBO();
 	void setSize(uint16_t framebufferWidth, uint16_t framebufferHeight);
 	void drawScene(const GameWorldData& gameData);
+	void cullOccluded(const GameWorldData& gameData, const glm::mat4& viewProj);
 
 	uint16_t      m_framebufferWidth{ 0 };
 	uint16_t      m_framebufferHeight{ 0 };
@@ -33,5 +34,9 @@ private:
 
 	SamplerHandle m_sampler{ 0 };
 
+	std::vector<uint32_t> m_visible;
+	OcclusionBuffer       m_occlusion;
+	OcclusionDebugView    m_occlusionDebug;
+
 	MapGrid m_mapGrid;
 };
\ No newline at end of file
@@ -4,7 +4,6 @@
 #include "GameConfig.h"
 #include "Engine/stdafx.h"
 
-#include "tiny_obj_loader/tiny_obj_loader.h"
 
 #include <Engine/NanoCore.h>
 #include <Engine/NanoIO.h>
@@ -16,6 +15,9 @@
 #include <Engine/NanoRender.h>
 #include <Engine/NanoRenderGeometryGen.h>
 #include <Engine/NanoRenderModel.h>
+#include <Engine/NanoObjLoader.h>
+#include <Engine/NanoCookedAssets.h>
+#include <Engine/NanoMipmap.h>
 
 #include <Engine/Transform.h>
 #include <Engine/NanoScene.h>
@@ -0,0 +1,139 @@
+// Lighting shared by the forward pass (fragment.glsl) and the deferred passes (deferredDirectional/, deferredLight/).
+// Everything is in world space. Requires MAX_DIR_LIGHTS and MAX_CASCADES.
+#include "../pbrCore.glsl"
+#include "../clusteredLights.glsl"
+
+// Light structures
+struct DirLight
+{
+	vec3 direction;
+	vec3 color;
+	sampler2DArrayShadow shadowMap; // слой - каскад
+	mat4 cascadeMatrix[MAX_CASCADES];
+};
+
+uniform int dirLightCount;
+uniform DirLight dirLight[MAX_DIR_LIGHTS];
+
+// каскады теней направленного света: дальние границы по глубине вида, размер текселя в мировых единицах
+uniform int cascadeCount;
+uniform float cascadeSplits[MAX_CASCADES];
+uniform float cascadeTexelSize[MAX_CASCADES];
+uniform float cascadeFade; // доля каскада у дальнего края, в которой он смешивается со следующим
+
+float sampleCascade(DirLight light, int cascade, vec3 worldPos, vec3 N)
+{
+	// смещение по нормали на размер текселя каскада вместо большого bias - нет акне и отрыва тени
+	vec3 offsetPos = worldPos + N * cascadeTexelSize[cascade] * 1.5;
+	vec3 projCoords = (light.cascadeMatrix[cascade] * vec4(offsetPos, 1.0)).xyz * 0.5 + 0.5;
+	if (projCoords.z > 1.0)
+		return 0.0;
+
+	float bias = 0.0002;
+
+	// PCF: каждая выборка - аппаратное сравнение с билинейной фильтрацией
+	float lit = 0.0;
+	vec2 texelSize = 1.0 / vec2(textureSize(light.shadowMap, 0).xy);
+	for(int x = -1; x <= 1; ++x)
+	{
+		for(int y = -1; y <= 1; ++y)
+		{
+			lit += texture(light.shadowMap, vec4(projCoords.xy + vec2(x, y) * texelSize, float(cascade), projCoords.z - bias));
+		}
+	}
+	return 1.0 - lit / 9.0;
+}
+
+float calculateShadow(DirLight light, vec3 worldPos, vec3 N, float viewDepth)
+{
+	int cascade = 0;
+	while (cascade < cascadeCount && viewDepth > cascadeSplits[cascade])
+		cascade++;
+	if (cascade >= cascadeCount)
+		return 0.0;
+
+	float shadow = sampleCascade(light, cascade, worldPos, N);
+
+	// у дальнего края каскад плавно переходит в следующий, последний - в отсутствие тени
+	float splitNear = cascade == 0 ? 0.0 : cascadeSplits[cascade - 1];
+	float fadeStart = mix(cascadeSplits[cascade], splitNear, cascadeFade);
+	float blend = smoothstep(fadeStart, cascadeSplits[cascade], viewDepth);
+	if (blend > 0.0)
+	{
+		float nextShadow = cascade + 1 < cascadeCount ? sampleCascade(light, cascade + 1, worldPos, N) : 0.0;
+		shadow = mix(shadow, nextShadow, blend);
+	}
+	return shadow;
+}
+
+vec3 calculateDirLight(DirLight light, vec3 N, vec3 V, vec3 albedo, float metallic, float roughness, vec3 F0)
+{
+	// Light direction
+	vec3 L = normalize(-light.direction);
+
+	// Half vector
+	vec3 H = normalize(V + L);
+
+	// Calculate radiance (no attenuation for directional lights)
+	vec3 radiance = light.color;
+
+	// Cook-Torrance BRDF
+	float NDF = DistributionGGX(N, H, roughness);
+	float G = GeometrySmith(N, V, L, roughness);
+	vec3 F = fresnelSchlick(max(dot(H, V), 0.0), F0);
+
+	// Calculate specular component
+	vec3 numerator = NDF * G * F;
+	float denominator = 4.0 * max(dot(N, V), 0.0) * max(dot(N, L), 0.0) + 0.0001;
+	vec3 specular = numerator / denominator;
+
+	// Energy conservation
+	vec3 ks = F;
+	vec3 kD = vec3(1.0) - ks;
+	kD *= 1.0 - metallic; // Metals have no diffuse reflections
+
+	// Scale by NdotL
+	float NdotL = max(dot(N, L), 0.0);
+
+	// Combine diffuse and specular
+	return (kD * albedo / PI + specular) * radiance * NdotL;
+}
+
+// point and spot lights from the cluster list: spot is a point light with a cone factor
+vec3 CalcClusterLight(ClusterLight light, vec3 N, vec3 fragPos, vec3 V, vec3 albedo, float metallic, float roughness, vec3 F0)
+{
+	vec3 toLight = light.position - fragPos;
+	float distance = length(toLight);
+	if (distance >= light.range)
+		return vec3(0.0);
+
+	// Light direction
+	vec3 L = toLight / max(distance, 0.0001);
+
+	// Half vector
+	vec3 H = normalize(V + L);
+
+	float attenuation = getClusterLightAttenuation(distance, light.range) * getClusterSpotFactor(light, L);
+	vec3 radiance = light.color * attenuation;
+
+	// Cook-Torrance BRDF
+	float NDF = DistributionGGX(N, H, roughness);
+	float G = GeometrySmith(N, V, L, roughness);
+	vec3 F = fresnelSchlick(max(dot(H, V), 0.0), F0);
+
+	// Calculate specular component
+	vec3 numerator = NDF * G * F;
+	float denominator = 4.0 * max(dot(N, V), 0.0) * max(dot(N, L), 0.0) + 0.0001;
+	vec3 specular = numerator / denominator;
+
+	// Energy conservation
+	vec3 ks = F;
+	vec3 kD = vec3(1.0) - ks;
+	kD *= 1.0 - metallic; // Metals have no diffuse reflections
+
+	// Scale by NdotL
+	float NdotL = max(dot(N, L), 0.0);
+
+	// Combine diffuse and specular
+	return (kD * albedo / PI + specular) * radiance * NdotL;
+}
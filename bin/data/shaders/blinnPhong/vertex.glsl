@@ -19,6 +19,9 @@ out VS_OUT {
 	vec3 Normal;
 } vs_out;
 
+// must match depthPrePass/vertex.glsl: with the depth pre-pass this pass tests depth with GL_EQUAL
+invariant gl_Position;
+
 void main()
 {
 	// Calculate world position
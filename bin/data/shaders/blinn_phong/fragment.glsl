@@ -63,8 +63,9 @@ void calculateNormal()
 {
 	if(material.hasNormal == 1)
 	{
-		Normal = texture(normalTexture, fsTexCoord).rgb;
-		Normal = normalize(Normal * 2.0f - 1.0f); // преобразуем из [0,1] в [-1,1]
+		// z восстанавливается из xy - в BC5 хранятся только два канала
+		Normal.xy = texture(normalTexture, fsTexCoord).rg * 2.0f - 1.0f; // преобразуем из [0,1] в [-1,1]
+		Normal.z = sqrt(max(1.0f - dot(Normal.xy, Normal.xy), 0.0f));
 		Normal = normalize(fsTBN * Normal);
 	}
 	else
@@ -0,0 +1,65 @@
+// Clustered forward lighting, see LightClusters (NanoClusteredLighting.h).
+// Lights: 3 RGBA32F texels each - position/range, color/spotScale, direction/spotOffset.
+// Cluster table: RG32UI (first index, count). Light indices: R16UI.
+uniform samplerBuffer clusterLights;
+uniform usamplerBuffer clusterTable;
+uniform usamplerBuffer clusterLightIndices;
+
+uniform ivec3 clusterGrid;        // tiles x, tiles y, depth slices
+uniform vec2 clusterTileScale;    // tiles per pixel
+uniform vec3 clusterDepthParams;  // first slice depth, log-depth scale, log-depth bias
+
+struct ClusterLight
+{
+	vec3 position;
+	float range;
+	vec3 color;
+	float spotScale;
+	vec3 direction;
+	float spotOffset;
+};
+//----------------------------------------------------------------------------
+int getClusterSlice(float viewDepth)
+{
+	if (viewDepth < clusterDepthParams.x)
+		return 0;
+	int slice = int(max(log(viewDepth) * clusterDepthParams.y + clusterDepthParams.z, 0.0)) + 1;
+	return min(slice, clusterGrid.z - 1);
+}
+//----------------------------------------------------------------------------
+int getClusterIndex(vec2 fragCoord, float viewDepth)
+{
+	ivec2 tile = clamp(ivec2(fragCoord * clusterTileScale), ivec2(0), clusterGrid.xy - 1);
+	return (getClusterSlice(viewDepth) * clusterGrid.y + tile.y) * clusterGrid.x + tile.x;
+}
+//----------------------------------------------------------------------------
+// x - first index in clusterLightIndices, y - number of lights
+uvec2 getClusterLights(int cluster)
+{
+	return texelFetch(clusterTable, cluster).xy;
+}
+//----------------------------------------------------------------------------
+ClusterLight fetchClusterLight(uint listIndex)
+{
+	int i = int(texelFetch(clusterLightIndices, int(listIndex)).r) * 3;
+	vec4 t0 = texelFetch(clusterLights, i);
+	vec4 t1 = texelFetch(clusterLights, i + 1);
+	vec4 t2 = texelFetch(clusterLights, i + 2);
+	return ClusterLight(t0.xyz, t0.w, t1.xyz, t1.w, t2.xyz, t2.w);
+}
+//----------------------------------------------------------------------------
+// inverse square falloff windowed to reach exactly zero at range
+float getClusterLightAttenuation(float distance, float range)
+{
+	float ratio = distance / range;
+	float ratio2 = ratio * ratio;
+	float window = clamp(1.0 - ratio2 * ratio2, 0.0, 1.0);
+	return window * window / max(distance * distance, 0.001);
+}
+//----------------------------------------------------------------------------
+// toLight - normalized direction from the surface to the light
+float getClusterSpotFactor(ClusterLight light, vec3 toLight)
+{
+	return clamp(dot(-toLight, light.direction) * light.spotScale + light.spotOffset, 0.0, 1.0);
+}
+//----------------------------------------------------------------------------
@@ -0,0 +1,36 @@
+#version 330 core
+
+#include "../blinnPhong/lighting.glsl"
+#include "../geometry/gbuffer.glsl"
+
+// ambient, emission and directional lights with cascaded shadows for every G-buffer pixel
+uniform vec3 camPos;
+
+uniform sampler2D ssaoSampler;
+uniform bool useSSAO;
+
+layout(location = 0) out vec4 FragColor;
+
+void main()
+{
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	Surface s = readSurface(pixel);
+
+	vec3 viewDir = normalize(camPos - s.worldPos);
+	vec3 F0 = mix(vec3(0.04), s.albedo, s.metallic);
+
+	vec3 currentLightColor = vec3(0.0);
+	for (int i = 0; i < dirLightCount; i++)
+	{
+		float shadow = calculateShadow(dirLight[i], s.worldPos, s.normal, s.viewDepth);
+		currentLightColor += calculateDirLight(dirLight[i], s.normal, viewDir, s.albedo, s.metallic, s.roughness, F0) * (1.0 - shadow);
+	}
+
+	// screen-space AO darkens only the ambient term
+	float ao = s.ao;
+	if (useSSAO)
+		ao *= texelFetch(ssaoSampler, pixel, 0).r;
+	vec3 ambient = vec3(0.03) * s.albedo * ao;
+
+	FragColor = vec4(ambient + currentLightColor + s.emissive, 1.0);
+}
\ No newline at end of file
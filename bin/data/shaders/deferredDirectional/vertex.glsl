@@ -0,0 +1,10 @@
+#version 330 core
+
+layout(location = 0) in vec2 vertexPosition;
+layout(location = 1) in vec2 vertexUV;
+
+void main()
+{
+	// on the far plane: with GL_GREATER only pixels covered by the G-buffer pass are shaded, the background is skipped
+	gl_Position = vec4(vertexPosition, 1.0, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#version 330 core
+
+#include "../blinnPhong/lighting.glsl"
+#include "../geometry/gbuffer.glsl"
+
+// one point or spot light over the pixels marked in the stencil by its volume, blended additively
+uniform vec3 camPos;
+uniform vec4 lightData[3]; // packed as ClusteredLight: position/range, color/spotScale, direction/spotOffset
+
+layout(location = 0) out vec4 FragColor;
+
+void main()
+{
+	Surface s = readSurface(ivec2(gl_FragCoord.xy));
+	ClusterLight light = ClusterLight(lightData[0].xyz, lightData[0].w, lightData[1].xyz, lightData[1].w, lightData[2].xyz, lightData[2].w);
+
+	vec3 viewDir = normalize(camPos - s.worldPos);
+	vec3 F0 = mix(vec3(0.04), s.albedo, s.metallic);
+
+	FragColor = vec4(CalcClusterLight(light, s.normal, s.worldPos, viewDir, s.albedo, s.metallic, s.roughness, F0), 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,11 @@
+#version 330 core
+
+layout(location = 0) in vec3 vertexPosition;
+
+uniform mat4 viewProjMatrix;
+uniform mat4 modelMatrix;
+
+void main()
+{
+	gl_Position = viewProjMatrix * modelMatrix * vec4(vertexPosition, 1.0);
+}
\ No newline at end of file
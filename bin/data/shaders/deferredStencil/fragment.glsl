@@ -0,0 +1,6 @@
+#version 330 core
+
+// stencil pass of the light volumes (vertex shader - deferredLight/vertex.glsl), color writes are masked
+void main()
+{
+}
\ No newline at end of file
@@ -0,0 +1,14 @@
+#version 330 core
+
+in vec2 TexCoords;
+
+// depth only; the alpha test must match blinnPhong/fragment.glsl or the main pass leaves holes
+uniform bool hasAlbedoMap;
+uniform sampler2D albedoMap;
+
+const float alphaTestThreshold = 0.1;
+
+void main()
+{
+	if (hasAlbedoMap && texture(albedoMap, TexCoords).a < alphaTestThreshold) discard;
+}
\ No newline at end of file
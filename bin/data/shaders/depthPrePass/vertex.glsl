@@ -0,0 +1,20 @@
+#version 330 core
+
+layout(location = 0) in vec3 vertexPosition;
+layout(location = 3) in vec2 vertexTexCoord;
+
+uniform mat4 projectionMatrix;
+uniform mat4 viewMatrix;
+uniform mat4 modelMatrix;
+
+out vec2 TexCoords;
+
+// the main pass tests depth with GL_EQUAL: gl_Position must be computed exactly as in blinnPhong/vertex.glsl
+invariant gl_Position;
+
+void main()
+{
+	vec4 worldPos = modelMatrix * vec4(vertexPosition, 1.0);
+	TexCoords = vertexTexCoord;
+	gl_Position = projectionMatrix * viewMatrix * worldPos;
+}
\ No newline at end of file
@@ -1,7 +1,10 @@
 #version 330 core
 
+#include "packing.glsl"
+
+// G-buffer layout: see RPGeometry.h. Position is not stored, readers reconstruct it from depth
 in VS_OUT {
-	vec3 FragPos;
+	vec3 VertColor;
 	vec2 TexCoords;
 	mat3 TBN;
 	vec3 Normal;
@@ -9,37 +12,55 @@ in VS_OUT {
 
 struct Material
 {
-	vec3 color_diffuse;
-	vec3 color_specular;
-	vec3 color_ambient;
-	float opacity;
-	float shininess;
-	int hasDiffuse;
-	int hasSpecular;
-	int hasNormal;
-	int nbTextures;
+	sampler2D albedoMap;
+	sampler2D normalMap;
+	sampler2D metallicRoughnessMap;
+	sampler2D aoMap;
+	sampler2D emissiveMap;
 };
 
+uniform bool hasAlbedoMap;
+uniform bool hasNormalMap;
+uniform bool hasMetallicRoughnessMap;
+uniform bool hasAOMap;
+uniform bool hasEmissiveMap;
+
 uniform Material material;
 
-uniform sampler2D diffuseTexture;
-uniform sampler2D specularTexture;
-uniform sampler2D normalTexture;
+const float alphaTestThreshold = 0.1;
+const float defaultMetallic = 0.0;
+const float defaultRoughness = 0.5;
+const float defaultAO = 1.0;
 
-layout(location = 0) out vec3 gPosition;
-layout(location = 1) out vec3 Normal;
+layout(location = 0) out vec2 gNormal;
+layout(location = 1) out vec4 gAlbedo;
+layout(location = 2) out vec2 gMaterial;
+layout(location = 3) out vec3 gEmissive;
 
 void main()
 {
-	gPosition.rgb = fs_in.FragPos;
-	if(material.hasNormal == 1)
+	// same material inputs as the forward pass (blinnPhong/fragment.glsl)
+	vec4 albedo = vec4(fs_in.VertColor, 1.0);
+	if (hasAlbedoMap)
+		albedo = texture(material.albedoMap, fs_in.TexCoords) * albedo;
+	if (albedo.a < alphaTestThreshold) discard;
+
+	vec3 metallicRoughness = hasMetallicRoughnessMap ? texture(material.metallicRoughnessMap, fs_in.TexCoords).rgb : vec3(0.0, defaultRoughness, defaultMetallic);
+	float ao = hasAOMap ? texture(material.aoMap, fs_in.TexCoords).r : defaultAO;
+
+	if (hasNormalMap)
 	{
-		Normal = texture(normalTexture, fs_in.TexCoords).rgb;
-		Normal = normalize(Normal * 2.0f - 1.0f);
-		Normal = normalize(fs_in.TBN * Normal);
+		// z is reconstructed from xy: BC5 normal maps store only two channels
+		vec3 normalMap;
+		normalMap.xy = texture(material.normalMap, fs_in.TexCoords).rg * 2.0 - 1.0;
+		normalMap.z = sqrt(max(1.0 - dot(normalMap.xy, normalMap.xy), 0.0));
+		gNormal = encodeNormal(normalize(fs_in.TBN * normalMap));
 	}
 	else
 	{
-		Normal = normalize(fs_in.Normal);
+		gNormal = encodeNormal(normalize(fs_in.Normal));
 	}
+	gAlbedo = vec4(albedo.rgb, ao);
+	gMaterial = vec2(metallicRoughness.b, metallicRoughness.g);
+	gEmissive = hasEmissiveMap ? texture(material.emissiveMap, fs_in.TexCoords).rgb : vec3(0.0);
 }
\ No newline at end of file
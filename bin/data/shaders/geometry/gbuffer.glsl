@@ -0,0 +1,44 @@
+#include "packing.glsl"
+
+// Reads the RPGeometry G-buffer. View-space position is rebuilt from depth, normal is octahedral-packed in view space;
+// lighting is done in world space.
+uniform sampler2D gDepth;
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedo;
+uniform sampler2D gMaterial;
+uniform sampler2D gEmissive;
+
+uniform mat4 invViewMatrix;
+uniform mat4 invProjectionMatrix;
+
+struct Surface
+{
+	vec3 worldPos;
+	vec3 normal;
+	float viewDepth;
+	vec3 albedo;
+	float ao;
+	float metallic;
+	float roughness;
+	vec3 emissive;
+};
+//----------------------------------------------------------------------------
+Surface readSurface(ivec2 pixel)
+{
+	vec2 uv = (vec2(pixel) + 0.5) / vec2(textureSize(gDepth, 0));
+	vec3 viewPos = viewPosFromDepth(uv, texelFetch(gDepth, pixel, 0).r, invProjectionMatrix);
+	vec4 albedoAO = texelFetch(gAlbedo, pixel, 0);
+	vec2 metallicRoughness = texelFetch(gMaterial, pixel, 0).rg;
+
+	Surface s;
+	s.worldPos = (invViewMatrix * vec4(viewPos, 1.0)).xyz;
+	s.normal = normalize(mat3(invViewMatrix) * decodeNormal(texelFetch(gNormal, pixel, 0).rg));
+	s.viewDepth = -viewPos.z;
+	s.albedo = albedoAO.rgb;
+	s.ao = albedoAO.a;
+	s.metallic = metallicRoughness.r;
+	s.roughness = metallicRoughness.g;
+	s.emissive = texelFetch(gEmissive, pixel, 0).rgb;
+	return s;
+}
+//----------------------------------------------------------------------------
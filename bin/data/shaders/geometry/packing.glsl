@@ -0,0 +1,49 @@
+// G-buffer packing helpers shared by the geometry pass and its readers (deferred lighting, SSAO).
+
+// octahedral normal encoding: unit vector -> [0,1]^2, stored in an RG16 unorm target
+vec2 octWrap(vec2 v)
+{
+	return (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+//----------------------------------------------------------------------------
+vec2 encodeNormal(vec3 n)
+{
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	n.xy = n.z >= 0.0 ? n.xy : octWrap(n.xy);
+	return n.xy * 0.5 + 0.5;
+}
+//----------------------------------------------------------------------------
+vec3 decodeNormal(vec2 f)
+{
+	f = f * 2.0 - 1.0;
+	vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+	float t = clamp(-n.z, 0.0, 1.0);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+	return normalize(n);
+}
+//----------------------------------------------------------------------------
+// positive view-space distance from the depth buffer value (perspective projection)
+float linearizeDepth(float depth, mat4 projection)
+{
+	return projection[3][2] / (depth * 2.0 - 1.0 + projection[2][2]);
+}
+//----------------------------------------------------------------------------
+// linearizeDepth of the far plane, i.e. of the cleared background
+float linearFarDepth(mat4 projection)
+{
+	return projection[3][2] / (1.0 + projection[2][2]);
+}
+//----------------------------------------------------------------------------
+// view-space position from a linear depth at uv in [0,1]
+vec3 viewPosFromLinearDepth(vec2 uv, float linearDepth, mat4 projection)
+{
+	return vec3((uv * 2.0 - 1.0) / vec2(projection[0][0], projection[1][1]) * linearDepth, -linearDepth);
+}
+//----------------------------------------------------------------------------
+// view-space position from the depth buffer value at uv (both in [0,1])
+vec3 viewPosFromDepth(vec2 uv, float depth, mat4 invProjection)
+{
+	vec4 p = invProjection * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+	return p.xyz / p.w;
+}
+//----------------------------------------------------------------------------
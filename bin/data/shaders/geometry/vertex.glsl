@@ -12,7 +12,7 @@ uniform mat4 viewMatrix;
 uniform mat4 modelMatrix;
 
 out VS_OUT {
-	vec3 FragPos;
+	vec3 VertColor;
 	vec2 TexCoords;
 	mat3 TBN;
 	vec3 Normal;
@@ -29,7 +29,7 @@ mat3 computeTBN()
 
 void main()
 {
-	vs_out.FragPos = vec3(viewMatrix * modelMatrix * vec4(vertexPosition, 1.0f));
+	vs_out.VertColor = vertexColor;
 	vs_out.TexCoords = vertexTexCoord;
 	
 	// compute TBN matrix
@@ -0,0 +1,31 @@
+#version 330 core
+
+// вершинный шейдер не может выбросить вершину - прошедшие отсечение пропускает геометрический, transform feedback пишет их подряд
+layout (points) in;
+layout (points, max_vertices = 1) out;
+
+in VS_OUT {
+	vec4 column0;
+	vec4 column1;
+	vec4 column2;
+	vec4 column3;
+	flat int visible;
+} gs_in[];
+
+out vec4 outColumn0;
+out vec4 outColumn1;
+out vec4 outColumn2;
+out vec4 outColumn3;
+
+void main()
+{
+	if (gs_in[0].visible == 0)
+		return;
+
+	outColumn0 = gs_in[0].column0;
+	outColumn1 = gs_in[0].column1;
+	outColumn2 = gs_in[0].column2;
+	outColumn3 = gs_in[0].column3;
+	EmitVertex();
+	EndPrimitive();
+}
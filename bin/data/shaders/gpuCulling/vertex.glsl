@@ -0,0 +1,43 @@
+#version 330 core
+
+// мировая матрица экземпляра по столбцам
+layout (location = 0) in vec4 instanceColumn0;
+layout (location = 1) in vec4 instanceColumn1;
+layout (location = 2) in vec4 instanceColumn2;
+layout (location = 3) in vec4 instanceColumn3;
+
+// нормали смотрят внутрь пирамиды
+uniform vec4 frustumPlanes[6];
+// ограничивающая сфера модели в ее координатах: xyz - центр, w - радиус
+uniform vec4 localSphere;
+
+out VS_OUT {
+	vec4 column0;
+	vec4 column1;
+	vec4 column2;
+	vec4 column3;
+	flat int visible;
+} vs_out;
+
+void main()
+{
+	mat4 model = mat4(instanceColumn0, instanceColumn1, instanceColumn2, instanceColumn3);
+
+	vec3 center = (model * vec4(localSphere.xyz, 1.0)).xyz;
+	// радиус растет на наибольший масштаб по осям
+	float scale = sqrt(max(max(dot(model[0].xyz, model[0].xyz), dot(model[1].xyz, model[1].xyz)), dot(model[2].xyz, model[2].xyz)));
+	float radius = localSphere.w * scale;
+
+	int visible = 1;
+	for (int i = 0; i < 6; i++)
+	{
+		if (dot(frustumPlanes[i].xyz, center) + frustumPlanes[i].w < -radius)
+			visible = 0;
+	}
+
+	vs_out.column0 = instanceColumn0;
+	vs_out.column1 = instanceColumn1;
+	vs_out.column2 = instanceColumn2;
+	vs_out.column3 = instanceColumn3;
+	vs_out.visible = visible;
+}
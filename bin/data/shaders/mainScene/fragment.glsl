@@ -49,8 +49,9 @@ layout(location = 0) out vec4 FragColor;
 
 vec3 ComputeNormal(vec2 texCoords, vec3 normal, sampler2D normalMap, mat3 TBN)
 {
-    normal = texture(normalMap, texCoords).rgb;
-    normal = normalize(normal * 2.0 - 1.0);
+    // z is reconstructed from xy: BC5 normal maps store only two channels
+    normal.xy = texture(normalMap, texCoords).rg * 2.0 - 1.0;
+    normal.z = sqrt(max(1.0 - dot(normal.xy, normal.xy), 0.0));
     normal = normalize(TBN * normal);
     return normal;
 }
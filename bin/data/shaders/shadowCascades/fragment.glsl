@@ -0,0 +1,12 @@
+#version 330 core
+
+in vec2 fragTexCoord;
+
+uniform sampler2D albedoTexture;
+uniform bool hasAlbedoMap;
+
+void main()
+{
+	if (hasAlbedoMap && texture(albedoTexture, fragTexCoord).a < 0.1f)
+		discard;
+}
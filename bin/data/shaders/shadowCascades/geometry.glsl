@@ -0,0 +1,29 @@
+#version 330 core
+
+// треугольник копируется в слой каждого каскада, в пирамиду которого попал объект
+layout(triangles) in;
+layout(triangle_strip, max_vertices = 3 * MAX_CASCADES) out;
+
+uniform mat4 cascadeMatrix[MAX_CASCADES];
+uniform int cascadeMask;
+
+in vec2 geomTexCoord[];
+out vec2 fragTexCoord;
+
+void main()
+{
+	for (int c = 0; c < MAX_CASCADES; c++)
+	{
+		if ((cascadeMask & (1 << c)) == 0)
+			continue;
+
+		for (int i = 0; i < 3; i++)
+		{
+			gl_Layer = c;
+			fragTexCoord = geomTexCoord[i];
+			gl_Position = cascadeMatrix[c] * gl_in[i].gl_Position;
+			EmitVertex();
+		}
+		EndPrimitive();
+	}
+}
@@ -0,0 +1,14 @@
+#version 330 core
+
+layout(location = 0) in vec3 vertexPosition;
+layout(location = 3) in vec2 vertexTexCoord;
+
+uniform mat4 modelMatrix;
+
+out vec2 geomTexCoord;
+
+void main()
+{
+	geomTexCoord = vertexTexCoord;
+	gl_Position = modelMatrix * vec4(vertexPosition, 1.0f);
+}
@@ -1,15 +1,22 @@
 #version 330 core
 
+#include "../geometry/packing.glsl"
+
 in vec2 TexCoords;
 
-uniform sampler2D gPosition;
-uniform sampler2D gNormal;
+// level of the SSAO depth chain at the AO resolution: linear view depth and packed view normal
+uniform sampler2D viewDepth;
+uniform sampler2D viewNormal;
 uniform sampler2D texNoise;
 
-uniform vec3 samples[64];
+// static kernel (RPSSAO::initKernel), any power-of-two prefix covers all radii
+layout(std140) uniform SSAOKernel
+{
+	vec4 samples[64];
+};
+uniform int kernelSize;
 
 // parameters (you'd probably want to use them as uniforms to more easily tweak the effect)
-int kernelSize = 64;
 float radius = 0.5;
 float bias = 0.025;
 
@@ -20,9 +27,17 @@ layout(location = 0) out float FragColor;
 
 void main()
 {
+	ivec2 size = textureSize(viewDepth, 0);
+	float depth = texelFetch(viewDepth, ivec2(gl_FragCoord.xy), 0).r;
+	if (depth >= linearFarDepth(projection)) // background
+	{
+		FragColor = 1.0;
+		return;
+	}
+
 	// get input for SSAO algorithm
-	vec3 fragPos = texture(gPosition, TexCoords).xyz;
-	vec3 normal = normalize(texture(gNormal, TexCoords).rgb);
+	vec3 fragPos = viewPosFromLinearDepth(TexCoords, depth, projection);
+	vec3 normal = decodeNormal(texelFetch(viewNormal, ivec2(gl_FragCoord.xy), 0).rg);
 	vec3 randomVec = normalize(texture(texNoise, TexCoords * noiseScale).xyz);
 	// create TBN change-of-basis matrix: from tangent-space to view-space
 	vec3 tangent = normalize(randomVec - normal * dot(randomVec, normal));
@@ -33,7 +48,7 @@ void main()
 	for(int i = 0; i < kernelSize; ++i)
 	{
 		// get sample position
-		vec3 sample = TBN * samples[i]; // from tangent to view-space
+		vec3 sample = TBN * samples[i].xyz; // from tangent to view-space
 		sample = fragPos + sample * radius;
 
 		// project sample position (to sample texture) (to get position on screen/texture)
@@ -43,13 +58,14 @@ void main()
 		offset.xy = offset.xy * 0.5 + 0.5; // transform to range 0.0 - 1.0
 
 		// get sample depth
-		float sampleDepth = texture(gPosition, offset.xy).z; // get depth value of kernel sample
+		ivec2 samplePixel = clamp(ivec2(offset.xy * vec2(size)), ivec2(0), size - 1);
+		float sampleDepth = -texelFetch(viewDepth, samplePixel, 0).r; // get depth value of kernel sample
 
 		// range check & accumulate
 		float rangeCheck = smoothstep(0.0, 1.0, radius / abs(fragPos.z - sampleDepth));
 		occlusion += (sampleDepth >= sample.z + bias ? 1.0 : 0.0) * rangeCheck;
 	}
-	occlusion = 1.0 - (occlusion / kernelSize);
+	occlusion = 1.0 - (occlusion / float(kernelSize));
 
 	FragColor = occlusion;
 }
\ No newline at end of file
@@ -2,22 +2,34 @@
 
 in vec2 TexCoords;
 
+// one axis of the separable depth-aware blur at the AO resolution: gaussian weights fall off with the relative
+// depth difference, so AO does not bleed across silhouettes
 uniform sampler2D ssaoInput;
+uniform sampler2D viewDepth; // SSAO depth chain level of the same resolution
+uniform ivec2 direction;
+
+const int BlurRadius = 4;
+const float BlurSigma = 2.0;
+const float DepthSharpness = 32.0;
 
 layout(location = 0) out float FragColor;
 
 void main()
 {
-	vec2 texelSize = 1.0 / vec2(textureSize(ssaoInput, 0));
-    float result = 0.0;
-    for (int x = -2; x < 2; ++x) 
-    {
-        for (int y = -2; y < 2; ++y) 
-        {
-            vec2 offset = vec2(float(x), float(y)) * texelSize;
-            result += texture(ssaoInput, TexCoords + offset).r;
-        }
-    }
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	ivec2 maxPixel = textureSize(ssaoInput, 0) - 1;
+	float centerDepth = texelFetch(viewDepth, pixel, 0).r;
+
+	float result = 0.0;
+	float totalWeight = 0.0;
+	for (int i = -BlurRadius; i <= BlurRadius; i++)
+	{
+		ivec2 samplePixel = clamp(pixel + direction * i, ivec2(0), maxPixel);
+		float depthDelta = abs(texelFetch(viewDepth, samplePixel, 0).r - centerDepth) / centerDepth;
+		float weight = exp(-float(i * i) / (2.0 * BlurSigma * BlurSigma) - depthDelta * DepthSharpness);
+		result += texelFetch(ssaoInput, samplePixel, 0).r * weight;
+		totalWeight += weight;
+	}
 
-	FragColor = result / (4.0 * 4.0);
+	FragColor = result / totalWeight;
 }
\ No newline at end of file
@@ -0,0 +1,41 @@
+#version 330 core
+
+#include "../geometry/packing.glsl"
+
+// one level of the SSAO depth chain: linear view depth and packed view normal.
+// ratio 2 keeps the closest of each 2x2 source block, ratio 1 copies; the first level linearizes the G-buffer depth
+uniform sampler2D sourceDepth;
+uniform sampler2D sourceNormal;
+uniform bool linearize;
+uniform int ratio;
+uniform mat4 projection;
+
+layout(location = 0) out float Depth;
+layout(location = 1) out vec2 Normal;
+
+void main()
+{
+	ivec2 base = ivec2(gl_FragCoord.xy) * ratio;
+	ivec2 maxPixel = textureSize(sourceDepth, 0) - 1;
+
+	float closestDepth = 1e30;
+	ivec2 closest = base;
+	for (int y = 0; y < ratio; y++)
+	{
+		for (int x = 0; x < ratio; x++)
+		{
+			ivec2 pixel = min(base + ivec2(x, y), maxPixel);
+			float depth = texelFetch(sourceDepth, pixel, 0).r;
+			if (linearize)
+				depth = linearizeDepth(depth, projection);
+			if (depth < closestDepth)
+			{
+				closestDepth = depth;
+				closest = pixel;
+			}
+		}
+	}
+
+	Depth = closestDepth;
+	Normal = texelFetch(sourceNormal, closest, 0).rg;
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#version 330 core
+
+#include "../geometry/packing.glsl"
+
+in vec2 TexCoords;
+
+// bilateral upsample of the blurred AO to the full resolution: bilinear weights of the 4 nearest low-res texels
+// are scaled down by their depth difference to the full-res pixel
+uniform sampler2D ssaoInput;
+uniform sampler2D lowDepth; // linear depth of the AO resolution level
+uniform sampler2D gDepth;   // full-res G-buffer depth
+uniform mat4 projection;
+
+const float DepthEpsilon = 0.001;
+
+layout(location = 0) out float FragColor;
+
+void main()
+{
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	float depth = linearizeDepth(texelFetch(gDepth, pixel, 0).r, projection);
+
+	ivec2 lowSize = textureSize(ssaoInput, 0);
+	vec2 lowPos = TexCoords * vec2(lowSize) - 0.5;
+	ivec2 base = ivec2(floor(lowPos));
+	vec2 f = fract(lowPos);
+
+	float result = 0.0;
+	float totalWeight = 0.0;
+	for (int i = 0; i < 4; i++)
+	{
+		ivec2 offset = ivec2(i & 1, i >> 1);
+		ivec2 lowPixel = clamp(base + offset, ivec2(0), lowSize - 1);
+		vec2 bilinear = mix(1.0 - f, f, vec2(offset));
+		float depthDelta = abs(texelFetch(lowDepth, lowPixel, 0).r - depth) / depth;
+		float weight = bilinear.x * bilinear.y / (DepthEpsilon + depthDelta);
+		result += texelFetch(ssaoInput, lowPixel, 0).r * weight;
+		totalWeight += weight;
+	}
+
+	FragColor = totalWeight > 0.0 ? result / totalWeight : texelFetch(ssaoInput, clamp(base, ivec2(0), lowSize - 1), 0).r;
+}
\ No newline at end of file
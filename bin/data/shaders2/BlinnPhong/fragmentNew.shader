@@ -9,8 +9,6 @@ struct DirectionalLight
 	float intensity;
 
 	bool castShadows;
-	sampler2D shadowMap;
-	mat4 lightViewProj;
 };
 
 struct PointLight
@@ -25,7 +23,6 @@ struct PointLight
 	float att;
 
 	bool castShadows;
-	samplerCube shadowMap;
 };
 
 struct SpotLight
@@ -87,6 +84,17 @@ uniform PointLight pointLights[MAX_POINT_LIGHTS];
 uniform int spotLightsNumber;
 uniform SpotLight spotLights[MAX_SPOT_LIGHTS];
 
+// all shadow maps are tiles of one atlas. Rect: xy - offset, zw - scale of the tile in atlas UV
+uniform sampler2D shadowAtlas;
+layout(std140) uniform ShadowAtlasUBO
+{
+	mat4 dirLightViewProj[MAX_DIR_LIGHTS];
+	vec4 dirLightAtlasRect[MAX_DIR_LIGHTS];
+	mat4 pointLightFaceViewProj[MAX_POINT_LIGHTS * 6]; // faces +X,-X,+Y,-Y,+Z,-Z
+	vec4 pointLightAtlasRect[MAX_POINT_LIGHTS * 6];
+	vec4 pointLightShadowParams[MAX_POINT_LIGHTS]; // x: 1 - dual paraboloid, hemispheres -Y,+Y in the first two rects
+};
+
 uniform float shadowsFarPlane;
 uniform float ambientStrength;
 uniform vec3 ambientColor;
@@ -116,18 +124,29 @@ float computeAttenuation(vec3 lightPos, float att)
 	//return 1.0 / (constant + lin * d + quad * (d * d)); OLD METHOD
 }
 
-float computeShadow(sampler2D shadowMap, mat4 lightViewProj, vec3 lightDir)
+// uv in [0,1] of the tile; kept half a texel inside so neighbouring tiles are never read
+float sampleShadowAtlas(vec4 rect, vec2 uv)
+{
+	vec2 halfTexel = 0.5 / (rect.zw * vec2(textureSize(shadowAtlas, 0)));
+	uv = clamp(uv, halfTexel, 1.0 - halfTexel);
+	return texture(shadowAtlas, rect.xy + uv * rect.zw).r;
+}
+
+float computeShadow(int light, vec3 lightDir)
 {
-	vec4 pos_lightSpace = lightViewProj * vec4(fs_in.modelPos, 1.0);
+	vec4 pos_lightSpace = dirLightViewProj[light] * vec4(fs_in.modelPos, 1.0);
 
 	// perform perspective divide
 
 	vec3 projCoords = pos_lightSpace.xyz / pos_lightSpace.w;
 	// transform to [0,1] range
 	projCoords = projCoords * 0.5 + 0.5;
+	// outside the light's map
+	if (any(lessThan(projCoords.xy, vec2(0.0))) || any(greaterThan(projCoords.xy, vec2(1.0))))
+		return 0.0;
 
 	// get closest depth value from light's perspective (using [0,1] range fragPosLight as coords)
-	float closestDepth = texture(shadowMap, projCoords.xy).r;
+	float closestDepth = sampleShadowAtlas(dirLightAtlasRect[light], projCoords.xy);
 	// get depth of current fragment from light's perspective
 	float currentDepth = projCoords.z;
 	// check whether current frag pos is in shadow
@@ -142,12 +161,35 @@ float computeShadow(sampler2D shadowMap, mat4 lightViewProj, vec3 lightDir)
 	//return lightDir.x;
 }
 
-float computePointShadow(samplerCube shadowMap ,vec3 lightPos)
+float computePointShadow(int light, vec3 lightPos)
 {
 	// get vector between fragment position and light position
 	vec3 fragToLight = fs_in.modelPos - lightPos;
-	// use the light to fragment vector to sample from the depth map    
-	float closestDepth = texture(shadowMap, fragToLight).r;
+	float closestDepth;
+	if (pointLightShadowParams[light].x > 0.5)
+	{
+		// hemisphere by the sign of y, same projection as PointLightShadowGeom
+		vec3 v = normalize(fragToLight);
+		int h = v.y < 0.0 ? 0 : 1;
+		float s = h == 0 ? -1.0 : 1.0;
+		vec2 p = vec2(s * v.x, v.z) / (1.0 + s * v.y);
+		closestDepth = sampleShadowAtlas(pointLightAtlasRect[light * 6 + h], p * 0.5 + 0.5);
+	}
+	else
+	{
+		// cube face by the major axis, then the face tile in the atlas
+		vec3 absDir = abs(fragToLight);
+		int face;
+		if (absDir.x >= absDir.y && absDir.x >= absDir.z)
+			face = fragToLight.x > 0.0 ? 0 : 1;
+		else if (absDir.y >= absDir.z)
+			face = fragToLight.y > 0.0 ? 2 : 3;
+		else
+			face = fragToLight.z > 0.0 ? 4 : 5;
+		int index = light * 6 + face;
+		vec4 pos_lightSpace = pointLightFaceViewProj[index] * vec4(fs_in.modelPos, 1.0);
+		closestDepth = sampleShadowAtlas(pointLightAtlasRect[index], pos_lightSpace.xy / pos_lightSpace.w * 0.5 + 0.5);
+	}
 	// it is currently in linear range between [0,1]. Re-transform back to original value
 	closestDepth *= shadowsFarPlane;
 	// now get current linear depth as the length between the fragment and light position
@@ -162,7 +204,7 @@ float computePointShadow(samplerCube shadowMap ,vec3 lightPos)
 	return shadow;
 }
 
-vec3 shadePointLight(vec3 lightPos, vec3 color, float intensity,float att, samplerCube shadowMap, vec3 worldPos, bool castShadows)
+vec3 shadePointLight(vec3 lightPos, vec3 color, float intensity,float att, int light, vec3 worldPos, bool castShadows)
 {
 	//Diffuse
 	vec3 L = normalize(lightPos - fs_in.pos);
@@ -182,7 +224,7 @@ vec3 shadePointLight(vec3 lightPos, vec3 color, float intensity,float att, sampl
 	//Shadow 
 	float shadow;
 	(material.receiveShadows && castShadows) 
-		? shadow = computePointShadow(shadowMap, worldPos) 
+		? shadow = computePointShadow(light, worldPos) 
 		: shadow = 0.0;
 
 	vec3 result = (1.0 - shadow) * (diffuse + specular) * albedo.rgb;
@@ -190,7 +232,7 @@ vec3 shadePointLight(vec3 lightPos, vec3 color, float intensity,float att, sampl
 	return result;
 }
 
-vec3 shadeDirectionalLight(vec3 lightDir, vec3 color, float intensity, sampler2D shadowMap, mat4 lightViewProj, bool castShadows)
+vec3 shadeDirectionalLight(vec3 lightDir, vec3 color, float intensity, int light, bool castShadows)
 {
 	//Diffuse
 	vec3 L = normalize(lightDir);
@@ -205,7 +247,7 @@ vec3 shadeDirectionalLight(vec3 lightDir, vec3 color, float intensity, sampler2D
 	//Shadow 
 	float shadow;
 	(material.receiveShadows && castShadows) 
-		? shadow = computeShadow(shadowMap, lightViewProj, L) 
+		? shadow = computeShadow(light, L) 
 		: shadow = 0.0;
 
 	vec3 result = (1.0 - shadow) * (diffuse + specular) * albedo.rgb;
@@ -227,12 +269,12 @@ vec3 shade()
 
 	for (int i = 0; i < directionalLightsNumber; i++)
 	{
-		result += shadeDirectionalLight(directionalLights[i].dir, directionalLights[i].color, directionalLights[i].intensity, directionalLights[i].shadowMap, directionalLights[i].lightViewProj, directionalLights[i].castShadows);
+		result += shadeDirectionalLight(directionalLights[i].dir, directionalLights[i].color, directionalLights[i].intensity, i, directionalLights[i].castShadows);
 	}
 
 	for (int i = 0; i < pointsLightsNumber; i++)
 	{
-		result += shadePointLight(pointLights[i].pos, pointLights[i].color, pointLights[i].intensity, pointLights[i].att, pointLights[i].shadowMap, pointLights[i].modelPos, pointLights[i].castShadows);
+		result += shadePointLight(pointLights[i].pos, pointLights[i].color, pointLights[i].intensity, pointLights[i].att, i, pointLights[i].modelPos, pointLights[i].castShadows);
 	}
 
 	//for (int i = 0; i < spotLightsNumber; i++) {
@@ -242,9 +284,16 @@ vec3 shade()
 	return result;
 }
 
+// z is reconstructed from xy: BC5 normal maps store only two channels
+vec3 unpackNormalMap(vec2 encoded)
+{
+	vec2 xy = encoded * 2.0 - 1.0;
+	return vec3(xy, sqrt(max(1.0 - dot(xy, xy), 0.0)));
+}
+
 void main()
 {
-	material.hasNormalTex ? N = normalize(fs_in.TBN * (texture(material.normalTex, fs_in.texCoords).rgb * 2.0 - 1.0)) : N = fs_in.normal;
+	material.hasNormalTex ? N = normalize(fs_in.TBN * unpackNormalMap(texture(material.normalTex, fs_in.texCoords).rg)) : N = fs_in.normal;
 	material.hasColorTex ? albedo = texture(material.colorTex, fs_in.texCoords) : albedo = vec4(material.baseColor, 1.0);
 	material.hasSpecularTex ? specularity = texture(material.specularTex, fs_in.texCoords).r : specularity = material.specularity;
 	material.hasGlossTex ? shininess = texture(material.glossTex, fs_in.texCoords).r : shininess = material.shininess;
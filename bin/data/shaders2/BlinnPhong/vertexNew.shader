@@ -7,10 +7,19 @@ layout(location = 3) in vec2 vertexTexCoord;
 layout(location = 4) in vec3 vertexTangent;
 layout(location = 5) in vec3 vertexBitangent;
 
+// совпадает с DepthPrePassVert.shader до бита - после предварительного прохода глубина проверяется через GL_EQUAL
+invariant gl_Position;
+
 uniform mat4 modelMatrix;
 uniform mat4 modelViewMatrix;
 uniform mat4 modelViewProjMatrix;
 
+// экземпляры, прошедшие отсечение на GPU (GPUInstanceCulling): мировая матрица - 4 texel (столбца) на экземпляр
+uniform bool instanced;
+uniform samplerBuffer instanceMatrices;
+uniform mat4 viewMatrix;
+uniform mat4 projMatrix;
+
 uniform float TileU;
 uniform float TileV;
 
@@ -25,22 +34,33 @@ out VS_OUT {
 
 void main()
 {
+	mat4 model = modelMatrix;
+	mat4 modelView = modelViewMatrix;
+	mat4 modelViewProj = modelViewProjMatrix;
+	if (instanced)
+	{
+		int texel = gl_InstanceID * 4;
+		model = mat4(texelFetch(instanceMatrices, texel), texelFetch(instanceMatrices, texel + 1), texelFetch(instanceMatrices, texel + 2), texelFetch(instanceMatrices, texel + 3));
+		modelView = viewMatrix * model;
+		modelViewProj = projMatrix * modelView;
+	}
+
 	vs_out.vertColor = vertexColor;
 
 	vs_out.texCoords = vertexTexCoord;
 	vs_out.texCoords.x *= TileU;
 	vs_out.texCoords.y *= TileV;
 
-	vs_out.pos = (modelViewMatrix * vec4(vertexPosition, 1.0)).xyz;
-	vs_out.modelPos = (modelMatrix * vec4(vertexPosition, 1.0)).xyz;
+	vs_out.pos = (modelView * vec4(vertexPosition, 1.0)).xyz;
+	vs_out.modelPos = (model * vec4(vertexPosition, 1.0)).xyz;
 
-	vec3 T = -normalize(vec3(modelViewMatrix * vec4(vertexTangent, 0.0)));
-	vec3 N = normalize(vec3(modelViewMatrix * vec4(vertexNormal, 0.0)));
+	vec3 T = -normalize(vec3(modelView * vec4(vertexTangent, 0.0)));
+	vec3 N = normalize(vec3(modelView * vec4(vertexNormal, 0.0)));
 	vec3 B = cross(N, T);
 
 	vs_out.TBN = mat3(T, B, N);
 
-	vs_out.normal = mat3(transpose(inverse(modelViewMatrix))) * vertexNormal;
+	vs_out.normal = mat3(transpose(inverse(modelView))) * vertexNormal;
 
-	gl_Position = modelViewProjMatrix * vec4(vertexPosition, 1.0f);
+	gl_Position = modelViewProj * vec4(vertexPosition, 1.0f);
 }
\ No newline at end of file
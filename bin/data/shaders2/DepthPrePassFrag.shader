@@ -0,0 +1,17 @@
+#version 330 core
+
+in vec2 fragTexCoord;
+
+// same alpha test as BlinnPhong/fragmentNew.shader, otherwise the main pass leaves holes
+uniform bool hasColorTex;
+uniform sampler2D colorTex;
+uniform bool hasOpacityTex;
+uniform sampler2D opacityTex;
+
+const float alphaClippingThreshold = 0.1;
+
+void main()
+{
+	if (hasColorTex && texture(colorTex, fragTexCoord).a < alphaClippingThreshold) discard;
+	if (hasOpacityTex && texture(opacityTex, fragTexCoord).r <= 0.0) discard;
+}
\ No newline at end of file
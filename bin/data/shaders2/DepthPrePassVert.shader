@@ -0,0 +1,34 @@
+#version 330 core
+
+layout(location = 0) in vec3 vertexPosition;
+layout(location = 3) in vec2 vertexTexCoord;
+
+// gl_Position must be computed exactly as in BlinnPhong/vertexNew.shader: the main pass tests depth with GL_EQUAL
+invariant gl_Position;
+
+uniform mat4 modelViewProjMatrix;
+
+uniform bool instanced;
+uniform samplerBuffer instanceMatrices;
+uniform mat4 viewMatrix;
+uniform mat4 projMatrix;
+
+uniform float TileU;
+uniform float TileV;
+
+out vec2 fragTexCoord;
+
+void main()
+{
+	mat4 modelViewProj = modelViewProjMatrix;
+	if (instanced)
+	{
+		int texel = gl_InstanceID * 4;
+		mat4 model = mat4(texelFetch(instanceMatrices, texel), texelFetch(instanceMatrices, texel + 1), texelFetch(instanceMatrices, texel + 2), texelFetch(instanceMatrices, texel + 3));
+		mat4 modelView = viewMatrix * model;
+		modelViewProj = projMatrix * modelView;
+	}
+
+	fragTexCoord = vec2(vertexTexCoord.x * TileU, vertexTexCoord.y * TileV);
+	gl_Position = modelViewProj * vec4(vertexPosition, 1.0f);
+}
\ No newline at end of file
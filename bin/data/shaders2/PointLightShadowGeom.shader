@@ -4,6 +4,13 @@ layout(triangles) in;
 layout(triangle_strip, max_vertices = 18) out;
 
 uniform mat4 cubeMatrices[6];
+// face tile in the shadow atlas: xy - scale, zw - offset in atlas NDC
+uniform vec4 faceRects[6];
+// faces the model touches: bit per cube face +X,-X,+Y,-Y,+Z,-Z or per paraboloid hemisphere -Y,+Y
+uniform int faceMask;
+// dual paraboloid: two hemispheres instead of six cube faces
+uniform bool paraboloid;
+uniform vec3 lightPos;
 
 in VS_OUT{
 	vec2 texCoord;
@@ -15,18 +22,80 @@ out GS_OUT{
 
 out vec4 FragPos;
 
-void main()
+void emitCubeFaces()
 {
 	for (int face = 0; face < 6; ++face)
 	{
-		gl_Layer = face; // built-in variable that specifies to which face we render.
+		if ((faceMask & (1 << face)) == 0)
+			continue;
+
+		vec4 p[3];
+		for (int i = 0; i < 3; ++i)
+			p[i] = cubeMatrices[face] * gl_in[i].gl_Position;
+
+		// whole triangle outside one side of the face frustum
+		if ((p[0].x > p[0].w && p[1].x > p[1].w && p[2].x > p[2].w) || (p[0].x < -p[0].w && p[1].x < -p[1].w && p[2].x < -p[2].w) ||
+			(p[0].y > p[0].w && p[1].y > p[1].w && p[2].y > p[2].w) || (p[0].y < -p[0].w && p[1].y < -p[1].w && p[2].y < -p[2].w))
+			continue;
+
+		for (int i = 0; i < 3; ++i)
+		{
+			FragPos = gl_in[i].gl_Position;
+			// clip to the face edges, otherwise the triangle spills into neighbouring tiles
+			gl_ClipDistance[0] = p[i].w - p[i].x;
+			gl_ClipDistance[1] = p[i].w + p[i].x;
+			gl_ClipDistance[2] = p[i].w - p[i].y;
+			gl_ClipDistance[3] = p[i].w + p[i].y;
+			gl_Position = vec4(p[i].xy * faceRects[face].xy + faceRects[face].zw * p[i].w, p[i].zw);
+			gs_out.texCoord = gs_in[i].texCoord;
+			EmitVertex();
+		}
+		EndPrimitive();
+	}
+}
+
+// hemisphere h looks along -Y (0) or +Y (1) with +Z up. The projection is per vertex, so large triangles bend -
+// acceptable for the small far lights this mode is used for
+void emitParaboloids()
+{
+	for (int h = 0; h < 2; ++h)
+	{
+		if ((faceMask & (1 << h)) == 0)
+			continue;
+
+		float s = h == 0 ? -1.0 : 1.0;
+		vec3 v[3];
+		float d[3];
+		for (int i = 0; i < 3; ++i)
+		{
+			v[i] = normalize(gl_in[i].gl_Position.xyz - lightPos);
+			d[i] = s * v[i].y;
+		}
+		// whole triangle in the other hemisphere
+		if (d[0] < 0.0 && d[1] < 0.0 && d[2] < 0.0)
+			continue;
+
 		for (int i = 0; i < 3; ++i)
 		{
 			FragPos = gl_in[i].gl_Position;
-			gl_Position = cubeMatrices[face] * FragPos;
+			vec2 p = vec2(s * v[i].x, v[i].z) / max(1.0 + d[i], 0.01);
+			gl_ClipDistance[0] = d[i];
+			gl_ClipDistance[1] = 1.0;
+			gl_ClipDistance[2] = 1.0;
+			gl_ClipDistance[3] = 1.0;
+			// depth is written by the fragment shader as distance to the light
+			gl_Position = vec4(p * faceRects[h].xy + faceRects[h].zw, 0.0, 1.0);
 			gs_out.texCoord = gs_in[i].texCoord;
 			EmitVertex();
 		}
 		EndPrimitive();
 	}
-}
\ No newline at end of file
+}
+
+void main()
+{
+	if (paraboloid)
+		emitParaboloids();
+	else
+		emitCubeFaces();
+}
@@ -24,12 +24,15 @@ in VS_OUT {
 	vec3 fragPos;
 	vec3 normal;
 	vec2 texCoords;
+	flat float tileLayer;
 } fs_in;
 
 const float alphaClippingThreshold = 0.1;
 
 uniform sampler2D diffuseTexture;
 uniform bool hasDiffuseTex;
+uniform sampler2DArray tileTextures;
+uniform bool hasTileTextures;
 
 //uniform SphereLight sphereLight[4];
 //uniform Fog fog;
@@ -84,6 +87,8 @@ void main()
 	vec4 diffuse = vec4(fs_in.vertColor, 1.0);
 	if (hasDiffuseTex) 
 		diffuse = texture(diffuseTexture, fs_in.texCoords) * diffuse;
+	else if (hasTileTextures)
+		diffuse = texture(tileTextures, vec3(fs_in.texCoords, fs_in.tileLayer)) * diffuse;
 	if (diffuse.a < alphaClippingThreshold) discard;
 
 	float distance = length(viewPos - fs_in.fragPos);
@@ -4,7 +4,7 @@ layout(location = 0) in vec3 vertexPosition;
 layout(location = 1) in vec3 vertexColor;
 layout(location = 2) in vec3 vertexNormal;
 layout(location = 3) in vec2 vertexTexCoord;
-layout(location = 4) in vec3 vertexTangent;
+layout(location = 4) in vec3 vertexTangent; // for map chunks x is the tile texture layer
 layout(location = 5) in vec3 vertexBitangent;
 
 uniform mat4 projectionMatrix;
@@ -16,6 +16,7 @@ out VS_OUT {
 	vec3 fragPos;
 	vec3 normal;
 	vec2 texCoords;
+	flat float tileLayer;
 } vs_out;
 
 void main()
@@ -23,6 +24,7 @@ void main()
 	vs_out.vertColor = vertexColor;
 	vs_out.fragPos = vec3(modelMatrix * vec4(vertexPosition, 1.0));
 	vs_out.texCoords = vertexTexCoord;
+	vs_out.tileLayer = vertexTangent.x;
 	vs_out.normal = normalize(mat3(transpose(inverse(modelMatrix))) * vertexNormal);
 	gl_Position = projectionMatrix * viewMatrix * modelMatrix * vec4(vertexPosition, 1.0f);
 }
\ No newline at end of file